@@ -41,6 +41,7 @@
 #define SCIDBAPI_H_
 
 #include <stdint.h>
+#include <map>
 #include <queue>
 
 #include "array/Array.h"
@@ -53,6 +54,12 @@ namespace scidb
 
 typedef std::queue<Warning> WarningsQueue;
 
+/**
+ * Values of the $placeholders of a query, by placeholder name (without the '$').
+ * Each value is a constant AFL expression, e.g. "5", "-2.5", "'text'" or "datetime('2014-01-01 00:00:00')".
+ */
+typedef std::map<std::string, std::string> QueryParameters;
+
 /**
  * Query execution statistic
  */
@@ -76,6 +83,7 @@ public:
     uint64_t executionTime;  // In milliseconds
     std::string explainLogical;
     std::string explainPhysical; // Every executed physical plan separated by ';'
+    std::string explainAnalyze; // The profile of every executed physical plan separated by ';', see CONFIG_PROFILE_QUERIES
 
     std::vector<std::string> plugins; /**< a list of plugins containing UDT in result array */
     std::vector< boost::shared_ptr<Array> > mappingArrays;
@@ -133,6 +141,17 @@ public:
      */
     virtual void prepareQuery(const std::string& queryString, bool afl, const std::string& programOptions, QueryResult& queryResult, void* connection = NULL) const = 0;
 
+    /**
+     * Prepare a query string with $placeholders. Throws exception if an error occurred.
+     * The coordinator reuses the physical plan of an earlier execution of the same query string
+     * with parameters of the same types, if the arrays it reads have not changed since.
+     * @param queryString a string with query on scidb language.
+     * @param parameters the values bound to the placeholders of the query.
+     * @param queryResult a reference to QueryResult structure with description of query execution result.
+     * @param connection is handle to connection returned by connect method.
+     */
+    virtual void prepareQuery(const std::string& queryString, bool afl, const std::string& programOptions, const QueryParameters& parameters, QueryResult& queryResult, void* connection = NULL) const = 0;
+
     /**
      * Execute a query string. Throws exception if an error occurred.
      * @param queryString a string with query on scidb language.
@@ -524,6 +524,31 @@ public:
      */
      virtual void writeItem(const  Value& item) = 0;
 
+    /**
+     * Write a run of cells at consecutive logical positions within the chunk,
+     * i.e. the row-major positions (overlap included) computed by CoordinatesMapper::coord2pos().
+     * @param start logical position of the first cell
+     * @param count number of cells
+     * @param values count fixed-size values of the attribute type stored back to back
+     *        (one byte per value for bool); ignored for the empty bitmap attribute
+     * @param nulls NULL if no value is missing, otherwise count flags, non-zero for a missing value
+     * @note The iterator position is undefined afterwards; call setPosition() before the next writeItem().
+     * @note The default implementation sets the position and writes one cell at a time;
+     *       iterators which build the chunk payload directly override it.
+     */
+    virtual void writeItems(position_t start, size_t count, void const* values, uint8_t const* nulls);
+
+    /**
+     * Write the cells of src from its current position to its end, as a SEQUENTIAL_WRITE copy does.
+     * Fixed size, non-boolean values are gathered into runs of consecutive positions and written with
+     * writeItems(), so that lazily computed chunks (such as those of build or apply) are materialized
+     * without a setPosition() and writeItem() per cell. Tile and vector mode copies, and null values
+     * with a missing reason, are written cell by cell.
+     * @param src iterator over the source chunk, with the positions of this chunk
+     * @return the number of cells written
+     */
+    size_t copyItems(ConstChunkIterator& src);
+
     /**
      * Save all changes done in the chunk
      */
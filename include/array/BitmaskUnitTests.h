@@ -46,6 +46,7 @@ CPPUNIT_TEST(testIterator);
 CPPUNIT_TEST(testCopy);
 CPPUNIT_TEST(testBoolPayload);
 CPPUNIT_TEST(testAppender);
+CPPUNIT_TEST(testBulkAppend);
 CPPUNIT_TEST_SUITE_END();
 
 
@@ -410,6 +411,52 @@ public:
         ++iter;
         CPPUNIT_ASSERT(iter.end());
    }
+
+    void testBulkAppend()
+    {
+        int32_t const values[] = { 7, 1, 1, 2, 3, 4, 4, 4, 5, 0, 0, 6, 7, 7, 8 };
+        uint8_t const nulls[]  = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 0, 0, 0 };
+        size_t const n = sizeof(values) / sizeof(values[0]);
+
+        // Split the input in two calls so that runs continue across a call boundary.
+        RLEPayload bulk(8*sizeof(int32_t));
+        RLEPayload::append_iterator a1(&bulk);
+        Value v;
+        v.setInt32(7);
+        a1.add(v);
+        a1.add(reinterpret_cast<char const*>(values), nulls, 6);
+        a1.add(reinterpret_cast<char const*>(values + 6), nulls + 6, n - 6);
+        a1.flush();
+
+        RLEPayload single(8*sizeof(int32_t));
+        RLEPayload::append_iterator a2(&single);
+        a2.add(v);
+        for (size_t i = 0; i < n; i++) {
+            if (nulls[i]) {
+                v.setNull(0);
+            } else {
+                v.setInt32(values[i]);
+            }
+            a2.add(v);
+        }
+        a2.flush();
+
+        CPPUNIT_ASSERT(bulk.count() == n + 1);
+        CPPUNIT_ASSERT(bulk.nSegments() <= single.nSegments());
+        ConstRLEPayload::iterator i1 = bulk.getIterator();
+        ConstRLEPayload::iterator i2 = single.getIterator();
+        Value v1, v2;
+        while (!i2.end()) {
+            CPPUNIT_ASSERT(!i1.end());
+            i1.getItem(v1);
+            i2.getItem(v2);
+            CPPUNIT_ASSERT(v1.isNull() == v2.isNull());
+            CPPUNIT_ASSERT(v1.isNull() || v1.getInt32() == v2.getInt32());
+            ++i1;
+            ++i2;
+        }
+        CPPUNIT_ASSERT(i1.end());
+    }
 };
 
 
@@ -33,9 +33,11 @@
 #include <array/Array.h>
 #include <vector>
 #include <map>
+#include <deque>
 #include <assert.h>
 #include <boost/shared_ptr.hpp>
 #include <boost/weak_ptr.hpp>
+#include <boost/function.hpp>
 #include <boost/shared_array.hpp>
 #include <query/Query.h>
 #include <util/FileIO.h>
@@ -43,6 +45,10 @@
 #include <util/CoordinatesMapper.h>
 #include <array/Tile.h>
 #include <util/DataStore.h>
+#include <util/Event.h>
+#include <util/Job.h>
+#include <util/JobQueue.h>
+#include <util/ThreadPool.h>
 
 using namespace std;
 using namespace boost;
@@ -51,41 +57,142 @@ namespace scidb
 {
     /**
      * Structure to share mem chunks.
+     *
+     * The chunks are hashed to NUM_SHARDS shards, each with its own mutex and LRU, so that
+     * pinning and unpinning a chunk in memory only takes the mutex of its shard. The memory in use
+     * is counted atomically against the threshold of the whole cache. The cache mutex is only taken
+     * to load a chunk, to cancel background work on it, to queue a prefetch and to swap out.
+     *
+     * When the cache grows past its threshold, LRU chunks are handed to a background writer,
+     * which compresses them and writes them to the datastore of their array until the cache
+     * is back under the low watermark. Threads only wait for the writer when it falls behind
+     * by more than the high watermark. The same thread reads chunks back ahead of a sequential
+     * scan (see prefetchChunk()).
+     *
+     * Lock order: the cache mutex, then shard mutexes. Nothing waits while holding a shard mutex.
      */
     class SharedMemCache
     {
+    public:
+        static const size_t NUM_SHARDS = 16;
+
+        /**
+         * Pin statistics of a shard, as listed by list('mem cache').
+         */
+        struct ShardStatistics
+        {
+            size_t   shard;
+            uint64_t lruChunks;      // unpinned chunks in memory
+            uint64_t pins;           // pins of a chunk not in use
+            uint64_t slowPins;       // pins that needed the cache mutex
+            uint64_t lockWaits;      // times the shard mutex was found taken
+            uint64_t cacheLockWaits; // times the cache mutex was found taken on behalf of the shard
+        };
+
     private:
-        // The LRU of LruMemChunk objects.
-        MemChunkLru _theLru;
+        /**
+         * The chunks hashed to a shard: their LRU, access counts and sizes at last unpin
+         * are protected by the shard mutex.
+         */
+        struct Shard
+        {
+            Mutex _mutex;
+            MemChunkLru _lru;
+            uint64_t _pins;
+            uint64_t _slowPins;
+            uint64_t _lockWaits;
+            uint64_t _cacheLockWaits;   // protected by the cache mutex
+
+            Shard() : _pins(0), _slowPins(0), _lockWaits(0), _cacheLockWaits(0) {}
+        };
+        Shard _shards[NUM_SHARDS];
+        size_t _nextVictimShard;
 
-        uint64_t _usedMemSize;
+        uint64_t _usedMemSize;          // updated atomically
         uint64_t _usedMemThreshold;
         Mutex _mutex;
         size_t _swapNum;
         size_t _loadsNum;
+        size_t _prefetchNum;
         uint64_t _genCount;
         DataStores _datastores;
         static SharedMemCache _sharedMemCache;
 
+        /**
+         * Background writer state, protected by _mutex.
+         */
+        std::deque<LruMemChunk*> _spillQueue;
+        std::deque<LruMemChunk*> _prefetchQueue;
+        uint64_t _spillQueuedSize;  // bytes of the chunks queued for or being spilled
+        Event _workEvent;           // wakes up the background writer
+        Event _doneEvent;           // signalled whenever the background writer finishes a chunk
+        bool _running;
+        boost::shared_ptr<JobQueue> _queue;
+        boost::shared_ptr<ThreadPool> _threadPool;
+
+        class BackgroundJob : public Job
+        {
+        private:
+            SharedMemCache* _cache;
+
+        public:
+            BackgroundJob(SharedMemCache* cache):
+                Job(boost::shared_ptr<Query>()),
+                _cache(cache)
+            {}
+
+            virtual void run();
+        };
+        boost::shared_ptr<BackgroundJob> _backgroundJob;
+
+        void startBackgroundWriter();
+        void runBackgroundWriter();
+        void waitForWriter();
+        void cancelBackgroundWork(LruMemChunk& chunk);
+        void setBackgroundState(LruMemChunk& chunk, LruMemChunk::BackgroundState state);
+        LruMemChunk* popVictim(LruMemChunk::BackgroundState state);
+        void endSpill(LruMemChunk& chunk, bool written);
+        void writeChunk(LruMemChunk& chunk);
+        void readChunk(LruMemChunk& chunk, char* buf);
+        bool isPrefetchable(LruMemChunk const& chunk) const;
+
     public:
         SharedMemCache();
+        ~SharedMemCache();
         void pinChunk(LruMemChunk& chunk);
         void unpinChunk(LruMemChunk& chunk);
         void swapOut();
         void deleteChunk(LruMemChunk& chunk);
         void cleanupArray(MemArray &array);
+
+        /**
+         * Ask the background writer to read a swapped out chunk back into memory,
+         * provided that it fits under the threshold. A hint only: it does nothing if the chunk
+         * is in memory, in use, or if there is no background writer.
+         */
+        void prefetchChunk(LruMemChunk& chunk);
         static SharedMemCache& getInstance() {
             return _sharedMemCache;
         }
 
         /**
-         * Get the LRU.
+         * @return the shard of a chunk, a hash of its address
+         */
+        static size_t getShardOf(LruMemChunk const* chunk);
+
+        /**
+         * Get the LRU of a shard.
          * @return a reference to the LRU object.
          */
-        static MemChunkLru& getLru() {
-            return _sharedMemCache._theLru;
+        static MemChunkLru& getLru(size_t shard) {
+            return _sharedMemCache._shards[shard]._lru;
         }
 
+        /**
+         * List the pin statistics of the shards.
+         */
+        void listShards(boost::function<void (ShardStatistics const&)>& f);
+
         uint64_t getUsedMemSize() const {
             return _sharedMemCache._usedMemSize;
         }
@@ -98,6 +205,10 @@ namespace scidb
             return _loadsNum;
         }
 
+        size_t getPrefetchNum() const {
+            return _prefetchNum;
+        }
+
         /**
          * Initialize the datastores used for the temporary disk storage needed
          * by mem arrays.
@@ -106,6 +217,13 @@ namespace scidb
          */
         void initSharedMemCache(uint64_t memThreshold, const char* basePath);
 
+        /**
+         * Stop the background writer and wait for it, giving the queued chunks back.
+         * Called at shutdown: not from the destructor, the job queue and the thread pool of the
+         * writer may be gone by the time the static instance is destroyed.
+         */
+        void stopBackgroundWriter();
+
         /**
          * Update the memory threshold.
          */
@@ -124,7 +242,7 @@ namespace scidb
         }
 
         /**
-         * Debugging aid: compute the size of the chunks on the LRU list.
+         * Debugging aid: compute the size of the chunks on the LRU lists.
          * @return the sum of the sizes of the chunks in the LRU. Note: chunks that are currently pinned are not accounted for here.
          */
         uint64_t computeSizeOfLRU();
@@ -290,7 +290,12 @@ namespace scidb
 
     private:
         /**
-         * Iterator indicating the position of the chunk in the LRU cache.
+         * The shard of the SharedMemCache the chunk belongs to.
+         */
+        size_t       _shard;
+
+        /**
+         * Iterator indicating the position of the chunk in the LRU of its shard.
          */
         MemChunkLruIterator _whereInLru;
 
@@ -309,6 +314,24 @@ namespace scidb
          */
         size_t       _dsAlloc;
 
+        /**
+         * The size of the chunk image in the datastore; less than size if the image is compressed.
+         */
+        size_t       _dsSize;
+
+        /**
+         * Work of the SharedMemCache background writer on this chunk, if any.
+         */
+        enum BackgroundState
+        {
+            BG_IDLE,
+            BG_SPILL_QUEUED,
+            BG_SPILLING,
+            BG_PREFETCH_QUEUED,
+            BG_LOADING
+        };
+        BackgroundState _bgState;
+
         /**
          * The size of the chunk the last time we pinned or unPinned it. If you follow proper prodecure, the chunk size should
          * only change at unPin time; hence the name.
@@ -321,6 +344,12 @@ namespace scidb
          */
         LruMemChunk();
 
+        /**
+         * Copy a chunk not in use, as std::map does on insertion.
+         * The copy belongs to the shard of its own address and is not in LRU.
+         */
+        LruMemChunk(LruMemChunk const& other);
+
         ~LruMemChunk();
 
         /**
@@ -671,6 +700,7 @@ namespace scidb
         bool isEmpty();
         Value& getItem();
         void writeItem(const Value& item);
+        void writeItems(position_t start, size_t count, void const* values, uint8_t const* nulls);
         void flush();
         bool setPosition(Coordinates const& pos);
 
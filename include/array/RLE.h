@@ -1289,6 +1289,14 @@ class RLEPayload : public ConstRLEPayload
         explicit append_iterator(size_t bitSize);
         void flush();
         void add(Value const& v, uint64_t count = 1);
+        /**
+         * Add @param count fixed-size values stored back to back at @param values.
+         * Runs of equal values become same-value segments, runs of distinct values are
+         * copied into the payload with one memcpy each.
+         * @param nulls NULL or @param count flags, non-zero for a missing value (reason 0)
+         * @pre the payload is neither boolean nor of a varying size type
+         */
+        void add(char const* values, uint8_t const* nulls, uint64_t count);
         /**
          * add not more than @param limit values from @param inputIterator
          * Flag @param setupPrevVal just a workaround for bug with mixed
@@ -915,5 +915,329 @@ namespace scidb {
         }
     };
 
+    /**
+     * @return an iterator serving getData() calls from the given one,
+     *         which does not need to support getData() itself
+     */
+    inline boost::shared_ptr<ConstChunkIterator>
+    makeTileConstChunkIterator(boost::shared_ptr<ConstChunkIterator> const& iterator)
+    {
+        return boost::make_shared<TileConstChunkIterator<boost::shared_ptr<ConstChunkIterator> > >(
+            iterator, boost::shared_ptr<Query>());
+    }
+
+    /**
+     * Base of the operator chunk iterators that build the tiles returned by getData()
+     * directly from the tiles of their inputs, so that a pipeline of such operators
+     * (filter, apply, between, join, ...) hands tiles from one operator to the next
+     * instead of making a chain of virtual calls per cell.
+     *
+     * A subclass implements getTiles(); all the getData() flavors, as well as
+     * getLogicalPosition() and setPosition(position_t), are implemented in terms of it
+     * and of the cell interface. getTiles() may throw SCIDB_LE_UNREACHABLE_CODE if the
+     * iteration mode does not allow it, TileConstChunkIterator then falls back to cells.
+     * As ConstChunkIterator requires, getData() advances the cell position past the
+     * returned tile, so getTiles() must read its inputs with iterators of its own.
+     *
+     * @param Base ConstChunkIterator or one of its subclasses
+     */
+    template<class Base>
+    class TileOutputChunkIterator : public Base
+    {
+    public:
+        TileOutputChunkIterator()
+        {
+        }
+
+        template<class Arg1, class Arg2>
+        TileOutputChunkIterator(Arg1 const& arg1, Arg2 const& arg2)
+        : Base(arg1, arg2)
+        {
+        }
+
+        /// @see ConstChunkIterator
+        virtual const Coordinates& getData(scidb::Coordinates& offset,
+                                           size_t maxValues,
+                                           boost::shared_ptr<BaseTile>& tileData,
+                                           boost::shared_ptr<BaseTile>& tileCoords)
+        {
+            if (!offset.empty()) {
+                const CoordinatesMapper* mapper = (*this);
+                position_t next = getData(mapper->coord2pos(offset), maxValues, tileData, tileCoords);
+                if (next < 0) {
+                    offset.clear();
+                } else {
+                    mapper->pos2coord(next, offset);
+                }
+            }
+            return offset;
+        }
+
+        /// @see ConstChunkIterator
+        virtual position_t getData(position_t logicalOffset,
+                                   size_t maxValues,
+                                   boost::shared_ptr<BaseTile>& tileData,
+                                   boost::shared_ptr<BaseTile>& tileCoords)
+        {
+            position_t next = getTiles(logicalOffset, maxValues, tileData, tileCoords);
+            advance(logicalOffset, next, tileCoords);
+            return next;
+        }
+
+        /// @see ConstChunkIterator
+        virtual const Coordinates& getData(scidb::Coordinates& offset,
+                                           size_t maxValues,
+                                           boost::shared_ptr<BaseTile>& tileData)
+        {
+            boost::shared_ptr<BaseTile> tileCoords;
+            return getData(offset, maxValues, tileData, tileCoords);
+        }
+
+        /// @see ConstChunkIterator
+        virtual position_t getData(position_t logicalOffset,
+                                   size_t maxValues,
+                                   boost::shared_ptr<BaseTile>& tileData)
+        {
+            boost::shared_ptr<BaseTile> tileCoords;
+            return getData(logicalOffset, maxValues, tileData, tileCoords);
+        }
+
+        /// @see ConstChunkIterator
+        virtual operator const CoordinatesMapper* () const
+        {
+            if (!_mapper) {
+                _mapper.reset(new CoordinatesMapper(const_cast<TileOutputChunkIterator*>(this)->getChunk()));
+            }
+            return _mapper.get();
+        }
+
+        /// @see ConstChunkIterator
+        virtual position_t getLogicalPosition()
+        {
+            const CoordinatesMapper* mapper = (*this);
+            return mapper->coord2pos(this->getPosition());
+        }
+
+        /// @see ConstChunkIterator
+        using Base::setPosition;
+        virtual bool setPosition(position_t pos)
+        {
+            const CoordinatesMapper* mapper = (*this);
+            mapper->pos2coord(pos, _coords);
+            return this->setPosition(_coords);
+        }
+
+    protected:
+        /**
+         * Build the tiles of at most maxValues elements starting at logicalOffset.
+         * @see ConstChunkIterator::getData(position_t, size_t, boost::shared_ptr<BaseTile>&, boost::shared_ptr<BaseTile>&)
+         */
+        virtual position_t getTiles(position_t logicalOffset,
+                                    size_t maxValues,
+                                    boost::shared_ptr<BaseTile>& tileData,
+                                    boost::shared_ptr<BaseTile>& tileCoords) = 0;
+
+        /// @return the logical positions of a tile of coordinates
+        static const ArrayEncoding<position_t>& getPositions(BaseTile& tileCoords)
+        {
+            return *safe_dynamic_cast<ArrayEncoding<position_t>*>(tileCoords.getEncoding());
+        }
+
+        /// @return an empty tile of coordinates of this chunk
+        boost::shared_ptr<BaseTile> newCoordinatesTile(size_t maxValues) const
+        {
+            const CoordinatesMapper* mapper = (*this);
+            MapperProvider provider(mapper);
+            boost::shared_ptr<BaseTile> tile =
+                TileFactory::getInstance()->construct("scidb::Coordinates", BaseEncoding::ARRAY, &provider);
+            tile->initialize();
+            tile->reserve(maxValues);
+            return tile;
+        }
+
+        /// @return an empty data tile of the given type
+        static boost::shared_ptr<BaseTile> newDataTile(TypeId const& type, size_t maxValues)
+        {
+            boost::shared_ptr<BaseTile> tile = TileFactory::getInstance()->construct(type, BaseEncoding::RLE);
+            tile->initialize();
+            tile->reserve(maxValues);
+            return tile;
+        }
+
+        /**
+         * Read the tile of nValues elements of another attribute of the input
+         * that goes along an input tile starting at logicalOffset.
+         */
+        static void getAlignedTile(boost::shared_ptr<ConstChunkIterator>& tileIterator,
+                                   position_t logicalOffset,
+                                   size_t nValues,
+                                   boost::shared_ptr<BaseTile>& tileData)
+        {
+            tileIterator->getData(logicalOffset, nValues, tileData);
+            if (!tileData || tileData->size() != nValues) {
+                // not laid out like the input, let TileConstChunkIterator fall back to cells
+                throw SYSTEM_EXCEPTION(SCIDB_SE_INTERNAL, SCIDB_LE_UNREACHABLE_CODE)
+                    << "TileOutputChunkIterator::getAlignedTile";
+            }
+        }
+
+    private:
+        /**
+         * Move the cell position to next, or past the last element of the tile at the end
+         * of the chunk. Without a tile, the position is that of logicalOffset, if any.
+         */
+        void advance(position_t logicalOffset, position_t next, boost::shared_ptr<BaseTile> const& tileCoords)
+        {
+            if (next >= 0) {
+                setPosition(next);
+            } else if (tileCoords && !tileCoords->empty()) {
+                const ArrayEncoding<position_t>& positions = getPositions(*tileCoords);
+                if (setPosition(positions.at(positions.size() - 1))) {
+                    ++(*this);
+                }
+            } else {
+                setPosition(logicalOffset);
+            }
+        }
+
+        class MapperProvider : public CoordinatesMapperProvider
+        {
+        public:
+            MapperProvider(const CoordinatesMapper* mapper) : _mapper(mapper)
+            {
+            }
+            virtual operator const CoordinatesMapper* () const
+            {
+                return _mapper;
+            }
+        private:
+            const CoordinatesMapper* _mapper;
+        };
+
+        mutable boost::shared_ptr<CoordinatesMapper> _mapper;
+        Coordinates _coords;
+    };
+
+    /**
+     * Base of the operator chunk iterators which return a subset of the cells of their input,
+     * e.g. filter() or between(). getData() reads tiles from the input and keeps the elements
+     * picked by selectTile().
+     */
+    template<class Base>
+    class TileSelectingChunkIterator : public TileOutputChunkIterator<Base>
+    {
+    public:
+        TileSelectingChunkIterator()
+        : _inIndex(0),
+          _inNext(-1)
+        {
+        }
+
+        template<class Arg1, class Arg2>
+        TileSelectingChunkIterator(Arg1 const& arg1, Arg2 const& arg2)
+        : TileOutputChunkIterator<Base>(arg1, arg2),
+          _inIndex(0),
+          _inNext(-1)
+        {
+        }
+
+    protected:
+        /**
+         * @return the input iterator to read the tiles from,
+         *         or NULL if the current iteration mode does not allow getData()
+         */
+        virtual boost::shared_ptr<ConstChunkIterator> getTileInput() = 0;
+
+        /**
+         * Mark the elements of an input tile that belong to the output.
+         * @param tileData the input data
+         * @param positions the logical positions of the input elements
+         * @param selected [OUT] one flag per element, all false on entry
+         */
+        virtual void selectTile(BaseTile& tileData,
+                                const ArrayEncoding<position_t>& positions,
+                                std::vector<char>& selected) = 0;
+
+        /**
+         * The input tile is read with maxValues elements and buffered:
+         * the next call picks it up where this one stopped, and the position
+         * returned is always that of a selected element.
+         */
+        virtual position_t getTiles(position_t logicalOffset,
+                                    size_t maxValues,
+                                    boost::shared_ptr<BaseTile>& tileData,
+                                    boost::shared_ptr<BaseTile>& tileCoords)
+        {
+            if (!_tileInput) {
+                boost::shared_ptr<ConstChunkIterator> input = getTileInput();
+                if (!input) {
+                    throw SYSTEM_EXCEPTION(SCIDB_SE_INTERNAL, SCIDB_LE_UNREACHABLE_CODE)
+                        << "TileSelectingChunkIterator::getTiles";
+                }
+                _tileInput = makeTileConstChunkIterator(input);
+            }
+            if (_inData && this->getPositions(*_inCoords).at(_inIndex) != logicalOffset) {
+                _inData.reset();
+                _inCoords.reset();
+            }
+            const TypeId& type = this->getChunk().getAttributeDesc().getType();
+            boost::shared_ptr<BaseTile> outData = this->newDataTile(type, maxValues);
+            boost::shared_ptr<BaseTile> outCoords = this->newCoordinatesTile(maxValues);
+            ArrayEncoding<position_t>* outPositions =
+                safe_dynamic_cast<ArrayEncoding<position_t>*>(outCoords->getEncoding());
+
+            position_t next = -1;
+            while (next < 0) {
+                if (!_inData) {
+                    if (logicalOffset < 0) {
+                        break;
+                    }
+                    _inNext = _tileInput->getData(logicalOffset, maxValues, _inData, _inCoords);
+                    if (!_inData || _inData->empty()) {
+                        _inData.reset();
+                        _inCoords.reset();
+                        break;
+                    }
+                    _inIndex = 0;
+                    _selected.assign(_inData->size(), 0);
+                    selectTile(*_inData, this->getPositions(*_inCoords), _selected);
+                }
+                const ArrayEncoding<position_t>& inPositions = this->getPositions(*_inCoords);
+                for (size_t n = _inData->size(); _inIndex < n; ++_inIndex) {
+                    if (!_selected[_inIndex]) {
+                        continue;
+                    }
+                    if (outPositions->size() == maxValues) {
+                        next = inPositions.at(_inIndex);
+                        break;
+                    }
+                    _inData->at(_inIndex, _value);
+                    outData->push_back(_value);
+                    outPositions->push_back(inPositions.at(_inIndex));
+                }
+                if (next < 0) {
+                    logicalOffset = _inNext;
+                    _inData.reset();
+                    _inCoords.reset();
+                }
+            }
+            outData->finalize();
+            outCoords->finalize();
+            tileData.swap(outData);
+            tileCoords.swap(outCoords);
+            return next;
+        }
+
+    private:
+        boost::shared_ptr<ConstChunkIterator> _tileInput;
+        /// The input tile being consumed
+        boost::shared_ptr<BaseTile> _inData;
+        boost::shared_ptr<BaseTile> _inCoords;
+        size_t _inIndex;
+        position_t _inNext;
+        std::vector<char> _selected;
+        Value _value;
+    };
+
 } //scidb namespace
 #endif //__TILE_ITERATOR_ADAPTERS__
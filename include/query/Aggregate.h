@@ -136,6 +136,19 @@ public:
         return false;
     }
 
+    /**
+     * Take the constant arguments that follow the input attribute in the call, e.g. the 0.9 of
+     * approxquantile(a, 0.9). Called once on every instance created for a call, before any state
+     * is initialized. By default an aggregate takes no argument.
+     */
+    virtual void setArguments(std::vector<double> const& arguments)
+    {
+        if (!arguments.empty())
+        {
+            throw USER_EXCEPTION(SCIDB_SE_SYNTAX, SCIDB_LE_WRONG_AGGREGATE_ARGUMENTS_COUNT);
+        }
+    }
+
     virtual void initializeState(Value& state) = 0;
 
     /**
@@ -205,8 +218,130 @@ public:
 
     virtual void merge(Value& dstState, Value const& srcState)  = 0;
     virtual void finalResult(Value& result, Value const& state) = 0;
+
+    /**
+     * Size of the flat state of this aggregate.
+     * A flat state is a fixed-size, trivially copyable structure. Grouped aggregation keeps
+     * flat states in contiguous arrays, one state per group, and accumulates whole payloads
+     * into them without going through a Value per cell.
+     * @return the size of one flat state in bytes, or 0 if flat states are not supported.
+     */
+    virtual size_t getFlatStateSize() const
+    {
+        return 0;
+    }
+
+    /**
+     * Initialize a flat state, the counterpart of initializeState().
+     */
+    virtual void initializeFlatState(char* state)
+    {
+        throw SYSTEM_EXCEPTION(SCIDB_SE_INTERNAL, SCIDB_LE_ILLEGAL_OPERATION) << "flat aggregate state";
+    }
+
+    /**
+     * Accumulate the values of a tile into an array of flat states.
+     * Null values are skipped unless ignoreNulls() is false.
+     * @param states array of flat states, getFlatStateSize() bytes each, indexed by group
+     * @param seen   one flag per group; set once the state of the group has received a value
+     * @param tile   the input values
+     * @param groups for each position of the tile, the group of the cell or NO_FLAT_GROUP
+     *               if the cell must not be accumulated
+     */
+    virtual void accumulatePayloadFlat(char* states, uint8_t* seen, ConstRLEPayload const* tile, size_t const* groups)
+    {
+        throw SYSTEM_EXCEPTION(SCIDB_SE_INTERNAL, SCIDB_LE_ILLEGAL_OPERATION) << "flat aggregate state";
+    }
+
+    /**
+     * Convert a flat state to the Value state understood by merge() and finalResult().
+     * @param state [out] the Value state
+     * @param flat  the flat state
+     * @param seen  the seen flag of the group, as maintained by accumulatePayloadFlat()
+     */
+    virtual void getFlatState(Value& state, char const* flat, bool seen)
+    {
+        throw SYSTEM_EXCEPTION(SCIDB_SE_INTERNAL, SCIDB_LE_ILLEGAL_OPERATION) << "flat aggregate state";
+    }
+
+    /**
+     * Group index marking the tile positions that accumulatePayloadFlat() must skip.
+     */
+    static const size_t NO_FLAT_GROUP = static_cast<size_t>(-1);
 };
 
+/**
+ * First-value initialization of a flat state; only aggregates that are initialized by their
+ * first value (min, max) need it.
+ */
+template<template <typename TS, typename TSR> class A, typename T, typename TR, bool initByFirst>
+struct FlatStateFirstValue
+{
+    static void init(typename A<T, TR>::State& state, T const& value)
+    {}
+};
+
+template<template <typename TS, typename TSR> class A, typename T, typename TR>
+struct FlatStateFirstValue<A, T, TR, true>
+{
+    static void init(typename A<T, TR>::State& state, T const& value)
+    {
+        A<T, TR>::init(state, value);
+    }
+};
+
+/**
+ * The flat state kernel shared by BaseAggregate and BaseAggregateInitByFirst.
+ * Runs of a repeated-value segment that fall into the same group are folded into a single
+ * multAggregate() call; all other values go through aggregate() on the state of their group.
+ */
+template<template <typename TS, typename TSR> class A, typename T, typename TR, bool initByFirst>
+void accumulateFlatPayload(char* states, uint8_t* seen, ConstRLEPayload const* tile, size_t const* groups)
+{
+    typedef typename A<T, TR>::State State;
+    State* s = reinterpret_cast<State*>(states);
+    for (size_t i = 0, n = tile->nSegments(); i < n; i++)
+    {
+        const RLEPayload::Segment& v = tile->getSegment(i);
+        if (v._null)
+            continue;
+        const position_t end = v._pPosition + v.length();
+        if (v._same) {
+            T value = getPayloadValue<T>(tile, v._valueIndex);
+            position_t p = v._pPosition;
+            while (p < end) {
+                const size_t g = groups[p];
+                position_t runEnd = p + 1;
+                while (runEnd < end && groups[runEnd] == g) {
+                    ++runEnd;
+                }
+                if (g != Aggregate::NO_FLAT_GROUP) {
+                    if (initByFirst && !seen[g]) {
+                        FlatStateFirstValue<A, T, TR, initByFirst>::init(s[g], value);
+                    }
+                    seen[g] = 1;
+                    A<T, TR>::multAggregate(s[g], value, runEnd - p);
+                }
+                p = runEnd;
+            }
+        } else {
+            size_t valueIndex = v._valueIndex;
+            for (position_t p = v._pPosition; p < end; p++, valueIndex++) {
+                const size_t g = groups[p];
+                if (g == Aggregate::NO_FLAT_GROUP) {
+                    continue;
+                }
+                T value = getPayloadValue<T>(tile, valueIndex);
+                if (initByFirst && !seen[g]) {
+                    FlatStateFirstValue<A, T, TR, initByFirst>::init(s[g], value);
+                }
+                seen[g] = 1;
+                A<T, TR>::aggregate(s[g], value);
+            }
+        }
+    }
+}
+
 template<template <typename TS, typename TSR> class A, typename T, typename TR, bool asterisk = false>
 class BaseAggregate: public Aggregate
 {
@@ -288,6 +423,28 @@ public:
             result.setNull(-1);
         }
     }
+
+    size_t getFlatStateSize() const
+    {
+        return sizeof(typename A<T, TR>::State);
+    }
+
+    void initializeFlatState(char* state)
+    {
+        A<T, TR>::init(*reinterpret_cast<typename A<T, TR>::State*>(state));
+    }
+
+    void accumulatePayloadFlat(char* states, uint8_t* seen, ConstRLEPayload const* tile, size_t const* groups)
+    {
+        accumulateFlatPayload<A, T, TR, false>(states, seen, tile, groups);
+    }
+
+    void getFlatState(Value& state, char const* flat, bool seen)
+    {
+        state.setVector(sizeof(typename A<T, TR>::State));
+        memcpy(state.data(), flat, sizeof(typename A<T, TR>::State));
+        state.setNull(-1);
+    }
 };
 
 template<template <typename TS, typename TSR> class A, typename T, typename TR, bool asterisk = false>
@@ -405,6 +562,35 @@ public:
             result.setNull(-1);
         }
     }
+
+    size_t getFlatStateSize() const
+    {
+        return sizeof(typename A<T, TR>::State);
+    }
+
+    void initializeFlatState(char* state)
+    {
+        //The state is set from the first value, see accumulateFlatPayload().
+        memset(state, 0, sizeof(typename A<T, TR>::State));
+    }
+
+    void accumulatePayloadFlat(char* states, uint8_t* seen, ConstRLEPayload const* tile, size_t const* groups)
+    {
+        accumulateFlatPayload<A, T, TR, true>(states, seen, tile, groups);
+    }
+
+    void getFlatState(Value& state, char const* flat, bool seen)
+    {
+        if (!seen)
+        {
+            //Same meaning as in initializeState(): the group exists but has no value yet.
+            state.setNull(1);
+            return;
+        }
+        state.setVector(sizeof(typename A<T, TR>::State));
+        memcpy(state.data(), flat, sizeof(typename A<T, TR>::State));
+        state.setNull(-1);
+    }
 };
 
 class CountingAggregate : public Aggregate
@@ -216,6 +216,23 @@ public:
         return _bindings;
     }
 
+    /**
+     * @return true if the expression was compiled from a logical expression with query parameters
+     */
+    bool hasParameters() const {
+        return !_parameters.empty();
+    }
+
+    /**
+     * Replace the value of a query parameter the expression was compiled with.
+     * The value is converted to the type the expression expects at the parameter,
+     * so it must be of the type the parameter had at compilation.
+     * @param name the name of the parameter, without the leading '$'
+     * @param type the type of value
+     * @param value the new value of the parameter
+     */
+    void bindParameter(const std::string& name, const TypeId& type, const Value& value);
+
     void addVariableInfo(const std::string& name, const TypeId& type);
 
 private:
@@ -290,6 +307,29 @@ private:
     };
     std::vector<ArgProp> _props; /**< a vector of argument properties for right compilation and optimizations */
 
+    /**
+     * Where the value of a query parameter goes in _eargs
+     */
+    struct ParameterSlot
+    {
+        std::string name;
+        size_t index;
+
+        ParameterSlot(): index(0) {
+        }
+
+        ParameterSlot(const std::string& n, size_t i): name(n), index(i) {
+        }
+
+        template<class Archive>
+        void serialize(Archive& ar, const unsigned int version)
+        {
+            ar & name;
+            ar & index;
+        }
+    };
+    std::vector<ParameterSlot> _parameters;
+
     /**
      * The method resolves attribute or dimension reference
      *
@@ -367,6 +407,7 @@ public:
         ar & _contextNo;
         ar & _props;
         ar & _eargs;
+        ar & _parameters;
         ar & _functions;
         ar & _supportsVectorMode;
         ar & _compiled;
@@ -132,6 +132,33 @@ private:
 };
 
 
+/**
+ * A $placeholder of a prepared query, bound to a value of the query parameters.
+ * It behaves like a constant, except that compiled expressions remember where its value went,
+ * so that a cached physical plan can be re-bound to other values of the same type.
+ */
+class Parameter : public Constant
+{
+public:
+    Parameter(const boost::shared_ptr<ParsingContext>& parsingContext, const std::string& name,
+              const Value& value, const TypeId& type): Constant(parsingContext, value, type), _name(name)
+    {
+    }
+
+    /**
+     * @return the name of the placeholder, without the leading '$'
+     */
+    const std::string& getName() const {
+        return _name;
+    }
+
+    virtual void toString(std::ostream &str, int indent = 0) const;
+
+private:
+    std::string _name;
+};
+
+
 class Function : public LogicalExpression
 {
 public:
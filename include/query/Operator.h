@@ -48,6 +48,7 @@
 #include <boost/format.hpp>
 #include <boost/serialization/serialization.hpp>
 #include <boost/serialization/shared_ptr.hpp>
+#include <boost/serialization/vector.hpp>
 #include <boost/serialization/export.hpp>
 #include <boost/unordered_map.hpp>
 
@@ -739,11 +740,13 @@ class OperatorParamAggregateCall: public OperatorParam
             const boost::shared_ptr<ParsingContext>& parsingContext,
             const std::string& aggregateName,
             boost::shared_ptr <OperatorParam> const& inputAttribute,
-            const std::string& alias):
+            const std::string& alias,
+            std::vector<double> const& arguments = std::vector<double>()):
         OperatorParam(PARAM_AGGREGATE_CALL, parsingContext),
         _aggregateName(aggregateName),
         _inputAttribute(inputAttribute),
-        _alias(alias)
+        _alias(alias),
+        _arguments(arguments)
     {}
 
     std::string const& getAggregateName() const
@@ -766,10 +769,19 @@ class OperatorParamAggregateCall: public OperatorParam
         return _alias;
     }
 
+    /**
+     * @return the constant arguments following the input attribute, e.g. the fraction of approxquantile(a, 0.9)
+     */
+    std::vector<double> const& getArguments() const
+    {
+        return _arguments;
+    }
+
   private:
     std::string _aggregateName;
     boost::shared_ptr <OperatorParam> _inputAttribute;
     std::string _alias;
+    std::vector<double> _arguments;
 
   public:
     template<class Archive>
@@ -779,6 +791,7 @@ class OperatorParamAggregateCall: public OperatorParam
         ar & _aggregateName;
         ar & _inputAttribute;
         ar & _alias;
+        ar & _arguments;
     }
 
     /**
@@ -1961,6 +1974,18 @@ class PhysicalOperator
 
     virtual ~PhysicalOperator(){}
 
+    /**
+     * [Admission API]
+     * Whether the operator materializes, sorts or spills a large part of its input,
+     * so that a query using it should reserve its memory budget before it runs.
+     * Such operators hide this with their own static isMemoryHungry() returning true;
+     * it is read through their factory before any operator is instantiated.
+     */
+    static bool isMemoryHungry()
+    {
+        return false;
+    }
+
     const std::string& getLogicalName() const
     {
         return _logicalName;
@@ -2274,6 +2299,11 @@ class BasePhysicalOperatorFactory
 
     virtual boost::shared_ptr<PhysicalOperator> createPhysicalOperator(const PhysicalOperator::Parameters& parameters, const ArrayDesc& schema) = 0;
 
+    /**
+     * @return PhysicalOperator::isMemoryHungry() of the operators this factory creates
+     */
+    virtual bool isMemoryHungry() const = 0;
+
 protected:
     void registerFactory();
 
@@ -2300,6 +2330,11 @@ class PhysicalOperatorFactory: public BasePhysicalOperatorFactory
     {
         return boost::shared_ptr<PhysicalOperator>(new T(_logicalName, _physicalName, parameters, schema));
     }
+
+    bool isMemoryHungry() const
+    {
+        return T::isMemoryHungry();
+    }
 };
 
 template<class T>
@@ -78,6 +78,10 @@ public:
 
     bool hasLogicalOperator(const std::string &logicalOperatorName);
 
+    // @return true if any physical operator of the logical operator is memory-hungry,
+    // false if the logical operator has none
+    bool isMemoryHungry(const std::string& logicalName);
+
     const PluginObjects& getOperatorLibraries() {
         return _operatorLibraries;
     }
@@ -90,6 +90,8 @@ class RemoteArray;
 class RemoteMergedArray;
 class MessageDesc;
 class ReplicationContext;
+struct QueryParamMap;
+struct CachedPlan;
 
 const size_t MAX_BARRIERS = 2;
 
@@ -316,6 +318,11 @@ class Query : public boost::enable_shared_from_this<Query>
     void invokeErrorHandlers(std::deque< boost::shared_ptr<ErrorHandler> >& errorHandlers);
 
     void destroy();
+
+    /**
+     * Write the trace events of the query on this instance, if tracing is on
+     */
+    void dumpTrace();
     static void destroyFinalizer(const boost::shared_ptr<Query>& q)
     {
         assert(q);
@@ -377,6 +384,8 @@ class Query : public boost::enable_shared_from_this<Query>
      */
     bool _doesExclusiveArrayAccess;
 
+    bool _parameterValuesUsed;
+
     /**
     * cache for the ProGrid, which depends only on numInstances
     */
@@ -503,6 +512,29 @@ class Query : public boost::enable_shared_from_this<Query>
         return _arena;
     }
 
+    /**
+     * Return the number of bytes currently allocated from this query's arena,
+     * including the arenas of its operators.
+     */
+    size_t getMemoryUsage() const;
+
+    /**
+     * Return the per-query memory budget (bytes) set by CONFIG_QUERY_MEMORY_BUDGET, 0 if unlimited.
+     */
+    static size_t getMemoryBudget();
+
+    /**
+     * Return how much working memory a spill-capable operator of this query may hold before
+     * spilling: the preferred amount, reduced to what is left of the query's memory budget
+     * once the query gets close to it, but never below MIN_SPILL_THRESHOLD.
+     */
+    size_t getSpillThreshold(size_t preferred) const;
+
+    /**
+     * The least working memory getSpillThreshold() hands out.
+     */
+    static const size_t MIN_SPILL_THRESHOLD = 1*MiB;
+
     /**
      *  Return true if the query completed successfully and was committed.
      */
@@ -559,6 +591,33 @@ class Query : public boost::enable_shared_from_this<Query>
      */
     std::string queryString;
 
+    /**
+     * The values of the $placeholders in queryString, if the client bound any.
+     */
+    boost::shared_ptr<const QueryParamMap> queryParams;
+
+    /**
+     * The coordinator's entry of the query in the plan cache, set while preparing the query if its plan
+     * can be cached. If the entry has a physical plan, it was cached by an earlier execution of the same
+     * query, and is executed instead of optimizing the logical plan. Otherwise the plan the query executes
+     * is cached under the entry's key.
+     */
+    boost::shared_ptr<const CachedPlan> cachedPlan;
+
+    /**
+     * Note that the value of a query parameter was used while planning, for example to infer a schema,
+     * so that the plan holds only for these parameter values.
+     */
+    void markParameterValuesUsed()
+    {
+        _parameterValuesUsed = true;
+    }
+
+    bool areParameterValuesUsed() const
+    {
+        return _parameterValuesUsed;
+    }
+
     boost::shared_ptr<Array> getCurrentResultArray()
     {
         ScopedMutexLock cs(errorMutex);
@@ -624,14 +683,34 @@ class Query : public boost::enable_shared_from_this<Query>
     boost::shared_ptr<SystemCatalog::LockDesc>
     requestLock(boost::shared_ptr<SystemCatalog::LockDesc>& lock);
 
+    /**
+     * @return the array locks requested so far
+     */
+    QueryLocks getRequestedLocks()
+    {
+        ScopedMutexLock cs(errorMutex);
+        return _requestedLocks;
+    }
+
     void addPhysicalPlan(boost::shared_ptr<PhysicalPlan> physicalPlan)
     {
+        ScopedMutexLock cs(errorMutex);
         _physicalPlans.push_back(physicalPlan);
     }
 
+    bool hasPhysicalPlan() const
+    {
+        return !_physicalPlans.empty();
+    }
+
+    /**
+     * @return the plan executed last, NULL before the first one; list('operator profiles')
+     * reads it from another thread
+     */
     boost::shared_ptr<PhysicalPlan> getCurrentPhysicalPlan()
     {
-        return _physicalPlans.back();
+        ScopedMutexLock cs(errorMutex);
+        return _physicalPlans.empty() ? boost::shared_ptr<PhysicalPlan>() : _physicalPlans.back();
     }
 
     /**
@@ -1082,6 +1161,7 @@ class ReplicationContext
     Mutex _mutex;
     QueueMap _inboundQueues;
     boost::weak_ptr<Query> _query;
+    QueryID _queryId;
     static ReplicationManager* _replicationMngr;
 
  public:
@@ -1092,7 +1172,7 @@ class ReplicationContext
      */
     explicit ReplicationContext(const boost::shared_ptr<Query>& query, size_t nInstances);
     /// Destructor
-    virtual ~ReplicationContext() {}
+    virtual ~ReplicationContext();
 
     /**
      * Set up and start an inbound replication queue
@@ -1109,7 +1189,8 @@ class ReplicationContext
     void enqueueInbound(ArrayID arrId, boost::shared_ptr<Job>& job);
 
     /**
-     * Wait until all replicas originated on THIS instance have been written to the REMOTE instances
+     * Wait until all replicas originated on THIS instance have been written to the REMOTE instances,
+     * including the replicas whose wait CachedStorage has deferred to this point
      * @param arrId array ID to identify the replicas
      */
     void replicationSync(ArrayID arrId);
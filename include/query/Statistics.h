@@ -31,13 +31,141 @@
 #ifndef STATISTIC_H_
 #define STATISTIC_H_
 
+#include <algorithm>
 #include <string>
 #include <stdint.h>
+#include <string.h>
 #include <boost/shared_ptr.hpp>
 
 namespace scidb
 {
 
+class Query;
+
+/**
+ * Execution counters of a node of the physical plan, as shown by explain analyze and
+ * list('operator profiles').
+ *
+ * Every thread working for the operator adds to its own slot: the slots are striped by thread
+ * and padded so that the counters of two slots never share a cache line. Reading a counter
+ * sums the slots, except PEAK_MEMORY which is a maximum.
+ */
+class OperatorProfile
+{
+public:
+    enum Counter
+    {
+        WALL_TIME = 0,  /**< microseconds in execute() and in the array iterators of the result */
+        CPU_TIME,       /**< thread CPU microseconds, in the same scope */
+        CHUNKS_IN,      /**< chunks pulled from the inputs */
+        CELLS_IN,       /**< cells of the chunks pulled from the inputs, when their count is known */
+        CHUNKS_OUT,     /**< chunks pulled from the result */
+        CELLS_OUT,      /**< cells of the chunks pulled from the result, when their count is known */
+        BYTES_READ,     /**< bytes read from disk */
+        BYTES_WRITTEN,  /**< bytes written to disk, spilled or stored */
+        BYTES_SENT,     /**< bytes sent to other instances */
+        PEAK_MEMORY,    /**< the largest memory usage of the query seen while the operator ran */
+        NUM_COUNTERS    // must be last
+    };
+
+    OperatorProfile()
+    {
+        memset(_slots, 0, sizeof(_slots));
+    }
+
+    void add(Counter counter, uint64_t value)
+    {
+        if (counter == PEAK_MEMORY) {
+            setMax(counter, value);
+        } else {
+            __sync_add_and_fetch(&_slots[getSlot()].counters[counter], value);
+        }
+    }
+
+    void setMax(Counter counter, uint64_t value)
+    {
+        volatile uint64_t& max = _slots[getSlot()].counters[counter];
+        uint64_t current = max;
+        while (current < value) {
+            uint64_t const seen = __sync_val_compare_and_swap(&max, current, value);
+            if (seen == current) {
+                break;
+            }
+            current = seen;
+        }
+    }
+
+    uint64_t get(Counter counter) const
+    {
+        uint64_t result = 0;
+        for (size_t i = 0; i < NUM_SLOTS; i++) {
+            uint64_t const value = _slots[i].counters[counter];
+            result = (counter == PEAK_MEMORY) ? std::max(result, value) : result + value;
+        }
+        return result;
+    }
+
+    /**
+     * @param[out] totals the NUM_COUNTERS counters
+     */
+    void getTotals(uint64_t* totals) const
+    {
+        for (size_t c = 0; c < NUM_COUNTERS; c++) {
+            totals[c] = get(Counter(c));
+        }
+    }
+
+    /**
+     * Add the counters of another instance.
+     * @param totals the NUM_COUNTERS counters
+     */
+    void merge(const uint64_t* totals)
+    {
+        for (size_t c = 0; c < NUM_COUNTERS; c++) {
+            add(Counter(c), totals[c]);
+        }
+    }
+
+    /**
+     * @return the name of a counter, as used by list('operator profiles')
+     */
+    static const char* getCounterName(Counter counter);
+
+private:
+    static const size_t NUM_SLOTS = 16;
+    static const size_t CACHE_LINE_SIZE = 64;
+
+    struct Slot
+    {
+        volatile uint64_t counters[NUM_COUNTERS];
+        char padding[CACHE_LINE_SIZE];
+    };
+
+    /**
+     * @return the slot of the calling thread
+     */
+    static size_t getSlot();
+
+    Slot _slots[NUM_SLOTS];
+};
+
+/**
+ * Adds the wall and CPU time of a scope, and the memory usage of the query at its end,
+ * to an OperatorProfile.
+ */
+class ProfileTimer
+{
+public:
+    ProfileTimer(OperatorProfile& profile, const Query* query);
+    ~ProfileTimer();
+
+private:
+    OperatorProfile& _profile;
+    const Query* _query;
+    uint64_t _wallStart;
+    uint64_t _cpuStart;
+};
+
 /**
  * The class describes statistics of query execution for every operator.
  * Every operator will have a field of this type and provides it for
@@ -48,6 +176,10 @@ class Statistics
 public:
     uint64_t executionTime; /**< In milliseconds */
     std::string explainPhysical; /**< Every executed physical plan separated by ';' */
+    std::string explainAnalyze; /**< The profile of every executed physical plan */
+
+    /** The profile of the plan node of the operator, NULL outside of operators */
+    OperatorProfile* profile;
 
     // network
     volatile uint64_t sentSize;  /**< A number of sent bytes */
@@ -69,7 +201,7 @@ public:
     volatile uint64_t allocatedSize;  /**< A number of allocated bytes */
     volatile uint64_t allocatedChunks; /**< A number of allocated chunks */
 
-    Statistics(): executionTime(0),
+    Statistics(): executionTime(0), profile(NULL),
         sentSize(0), sentMessages(0), receivedSize(0), receivedMessages(0),
         writtenSize(0), writtenChunks(0), readSize(0), readChunks(0),
         pinnedSize(0), pinnedChunks(0),
@@ -80,6 +212,12 @@ public:
 
 std::ostream& writeStatistics(std::ostream& os, const Statistics& s, size_t tab);
 
+/**
+ * Write the counters of an OperatorProfile on one line.
+ * @param totals the NUM_COUNTERS counters
+ */
+std::ostream& writeProfile(std::ostream& os, const uint64_t* totals);
+
 #ifndef __APPLE__
 extern __thread Statistics* currentStatistics;
 #else
@@ -134,6 +272,17 @@ class ThreadContext {
 extern ThreadContext<Statistics> currentStatistics;
 #endif
 
+/**
+ * Count a value in the profile of the operator the calling thread works for, if any.
+ */
+inline void addToCurrentProfile(OperatorProfile::Counter counter, uint64_t value)
+{
+    Statistics* statistics = currentStatistics;
+    if (statistics && statistics->profile) {
+        statistics->profile->add(counter, value);
+    }
+}
+
 class StatisticsScope
 {
 private:
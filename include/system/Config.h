@@ -132,7 +132,19 @@ enum
     CONFIG_REDIM_CHUNKSIZE,
     CONFIG_MAX_OPEN_FDS,
     CONFIG_PREALLOCATE_SHM,
-    CONFIG_INSTALL_ROOT
+    CONFIG_INSTALL_ROOT,
+    CONFIG_FLAT_AGGREGATE_LIMIT,
+    CONFIG_ADMISSION_MEMORY_LIMIT,
+    CONFIG_QUERY_MEMORY_BUDGET,
+    CONFIG_NUMA_AFFINITY,
+    CONFIG_GEMM_IN_PROCESS_LIMIT,
+    CONFIG_PLAN_CACHE_SIZE,
+    CONFIG_CATALOG_CACHE_SIZE,
+    CONFIG_LAZY_CHUNK_MAP,
+    CONFIG_REPLICATION_COMPRESSION,
+    CONFIG_PROFILE_QUERIES,
+    CONFIG_TRACE,
+    CONFIG_TRACE_PATH
 };
 
 enum RepartAlgorithm
@@ -319,6 +331,9 @@ public:
         const boost::any &value = boost::any(),
         bool required = true);
 
+    /**
+     * Add a function called with every option set by parse() or setOptionValue()
+     */
     void addHook(void (*hook)(int32_t));
 
     void parse(int argc, char **argv, const char* configFileName);
@@ -31,6 +31,7 @@
 #ifndef SYSINFO_H
 #define SYSINFO_H
 
+#include <vector>
 #include "system/Constants.h"
 
 namespace scidb
@@ -54,6 +55,23 @@ public:
 
     static int getNumberOfCPUs();
     static int getCPUCacheSize(int level);
+
+    /**
+     * @return the number of NUMA nodes of the host, as reported by /sys/devices/system/node.
+     * Hosts without that information are reported as a single node holding all the CPUs.
+     */
+    static int getNumberOfNUMANodes();
+
+    /**
+     * @return the CPUs of a NUMA node
+     * @param node a node number below getNumberOfNUMANodes()
+     */
+    static std::vector<int> const& getNUMANodeCPUs(int node);
+
+    /**
+     * @return the NUMA node of the CPU the calling thread is running on, 0 if it is unknown
+     */
+    static int getCurrentNUMANode();
 };    
 
 } //namespace
@@ -54,6 +54,7 @@ namespace pqxx
 
 namespace scidb
 {
+class CatalogCache;
 class Mutex;
 class PhysicalBoundaries;
 
@@ -393,6 +394,21 @@ public:
      */
     VersionID getLastVersion(const ArrayID id);
 
+    /**
+     * Read the catalog version, which every metadata update increments, and drop the
+     * metadata cached by this instance if it has moved.
+     * The coordinator sends it to the workers with the physical plan of a query.
+     * @return the current value of cluster.catalog_version
+     */
+    uint64_t getCatalogVersion();
+
+    /**
+     * Drop the metadata cached by this instance if it was read before the given catalog version.
+     * Called by a worker with the version sent by the coordinator, before the query reads metadata.
+     * @param[in] catalogVersion the catalog version read by the coordinator of the query
+     */
+    void validateCache(uint64_t catalogVersion);
+
     /**
      * Get array id of oldest version of array
      * @param[in] id array ID
@@ -571,6 +587,7 @@ private:
     VersionID _createNewVersion(const ArrayID id, const ArrayID version_array_id);
     void _deleteVersion(const ArrayID arrayID, const VersionID versionID);
     VersionID _getLastVersion(const ArrayID id);
+    uint64_t _getCatalogVersion();
     ArrayID _getOldestArrayVersion(const ArrayID id);
     VersionID _lookupVersionByTimestamp(const ArrayID id, const uint64_t timestamp);
     std::vector<VersionDesc> _getArrayVersions(const ArrayID array_id);
@@ -599,6 +616,9 @@ private:
     // be locked with this mutex while system catalog using PostgreSQL as storage.
     static Mutex _pgLock;
 
+    /// Metadata read by queries, validated against cluster.catalog_version
+    CatalogCache* _cache;
+
     friend class Singleton<SystemCatalog>;
 
     int _reconnectTries;
@@ -250,6 +250,15 @@ namespace scidb
          */
         int fstat(struct stat* st);
 
+        /**
+         * Advise the kernel of the expected access pattern to a range of the file
+         * @param offs start of the range
+         * @param len length of the range, 0 for the rest of the file
+         * @param advice one of the POSIX_FADV_* values
+         * @return 0 on success or an error number
+         */
+        int fadvise(uint64_t offs, uint64_t len, int advice);
+
         /**
          * Mark file to be removed on last close
          */
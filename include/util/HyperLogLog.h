@@ -0,0 +1,300 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file HyperLogLog.h
+ *
+ * @brief Building blocks of a mergeable HyperLogLog++ cardinality sketch.
+ *
+ * The sketch follows S. Heule, M. Nunkesser, A. Hall, "HyperLogLog in Practice" (2013):
+ * a 64-bit hash, a sparse representation used while the number of distinct values is
+ * small, and a dense register array once the sparse list would be larger than the
+ * registers. All routines work on raw memory so that the sketch can live inside an
+ * aggregate state Value without extra indirection.
+ *
+ * Sketch image layout:
+ *   Header, followed by either
+ *   - SPARSE: Header::nEntries uint32_t entries sorted by register index, one per index, or
+ *   - DENSE:  NUM_REGISTERS uint8_t registers.
+ */
+
+#ifndef HYPER_LOG_LOG_H_
+#define HYPER_LOG_LOG_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#include <../extern/MurmurHash/MurmurHash3.h>
+
+namespace scidb
+{
+
+class HyperLogLog
+{
+public:
+    /** Number of hash bits selecting a dense register. */
+    static const uint32_t PRECISION = 14;
+
+    /** Number of hash bits selecting a sparse register. */
+    static const uint32_t SPARSE_PRECISION = 25;
+
+    static const uint32_t NUM_REGISTERS = 1 << PRECISION;
+
+    /**
+     * A sparse sketch is converted to dense once it holds more entries than this,
+     * i.e. once the sparse list would take as many bytes as the registers.
+     */
+    static const uint32_t MAX_SPARSE_ENTRIES = NUM_REGISTERS / sizeof(uint32_t);
+
+    enum Format
+    {
+        SPARSE = 1,
+        DENSE  = 2
+    };
+
+    /**
+     * Sketch image header. Sized so that an empty sketch still does not fit into
+     * the builtin buffer of a Value, which lets Value::setVector() grow it with realloc.
+     */
+    struct Header
+    {
+        uint32_t format;
+        uint32_t nEntries;
+        uint64_t reserved;
+    };
+
+    static size_t sparseSize(size_t nEntries)
+    {
+        return sizeof(Header) + nEntries * sizeof(uint32_t);
+    }
+
+    static size_t denseSize()
+    {
+        return sizeof(Header) + NUM_REGISTERS;
+    }
+
+    static void initialize(Header* header)
+    {
+        header->format = SPARSE;
+        header->nEntries = 0;
+        header->reserved = 0;
+    }
+
+    static uint32_t* entries(Header* header)
+    {
+        return reinterpret_cast<uint32_t*>(header + 1);
+    }
+
+    static uint32_t const* entries(Header const* header)
+    {
+        return reinterpret_cast<uint32_t const*>(header + 1);
+    }
+
+    static uint8_t* registers(Header* header)
+    {
+        return reinterpret_cast<uint8_t*>(header + 1);
+    }
+
+    static uint8_t const* registers(Header const* header)
+    {
+        return reinterpret_cast<uint8_t const*>(header + 1);
+    }
+
+    /**
+     * 64-bit hash of the bytes of a value. Values of up to eight bytes (all fixed-size
+     * numeric types) are hashed with a single finalization mix; longer values go
+     * through MurmurHash3.
+     */
+    static uint64_t hash(void const* data, size_t size)
+    {
+        if (size <= sizeof(uint64_t)) {
+            uint64_t key = 0;
+            memcpy(&key, data, size);
+            return fmix(static_cast<uint64_t>(key ^ (BIG_CONSTANT(0x9e3779b97f4a7c15) * (size + 1))));
+        }
+        uint64_t h[2];
+        MurmurHash3_x64_128(data, static_cast<int>(size), SEED, h);
+        return h[0];
+    }
+
+    /**
+     * Encode a hash as a sparse entry: the SPARSE_PRECISION top bits select the
+     * register, the low 6 bits hold the rank of the remaining bits.
+     * Entries order by register index first, then by rank.
+     */
+    static uint32_t encode(uint64_t hash)
+    {
+        uint32_t const index = static_cast<uint32_t>(hash >> (64 - SPARSE_PRECISION));
+        return (index << 6) | rank(hash, SPARSE_PRECISION);
+    }
+
+    static uint32_t denseIndex(uint64_t hash)
+    {
+        return static_cast<uint32_t>(hash >> (64 - PRECISION));
+    }
+
+    /**
+     * Position of the leftmost one bit of the hash past the first 'precision' bits,
+     * counted from one. A hash with no such bit gets 65 - precision.
+     */
+    static uint8_t rank(uint64_t hash, uint32_t precision)
+    {
+        uint64_t const w = (hash << precision) | (BIG_CONSTANT(1) << (precision - 1));
+        return static_cast<uint8_t>(__builtin_clzll(w) + 1);
+    }
+
+    /**
+     * Dense register and rank of a sparse entry. Both are identical to what the
+     * dense encoding of the original hash would produce.
+     */
+    static void decode(uint32_t entry, uint32_t& index, uint8_t& r)
+    {
+        uint32_t const sparseIndex = entry >> 6;
+        uint32_t const extraBits = SPARSE_PRECISION - PRECISION;
+        uint32_t const extra = sparseIndex & ((1 << extraBits) - 1);
+        index = sparseIndex >> extraBits;
+        if (extra != 0) {
+            r = static_cast<uint8_t>(__builtin_clz(extra) - (32 - extraBits) + 1);
+        } else {
+            r = static_cast<uint8_t>(extraBits + (entry & 0x3F));
+        }
+    }
+
+    static void addDense(uint8_t* regs, uint64_t hash)
+    {
+        uint32_t const j = denseIndex(hash);
+        uint8_t const r = rank(hash, PRECISION);
+        if (regs[j] < r) {
+            regs[j] = r;
+        }
+    }
+
+    static void addSparseToDense(uint8_t* regs, uint32_t const* entries, size_t nEntries)
+    {
+        for (size_t i = 0; i < nEntries; i++) {
+            uint32_t j;
+            uint8_t r;
+            decode(entries[i], j, r);
+            if (regs[j] < r) {
+                regs[j] = r;
+            }
+        }
+    }
+
+    static void mergeDense(uint8_t* dst, uint8_t const* src)
+    {
+        for (size_t i = 0; i < NUM_REGISTERS; i++) {
+            dst[i] = std::max(dst[i], src[i]);
+        }
+    }
+
+    /**
+     * Keep only the highest rank per register of a sorted entry list.
+     * @return the new number of entries
+     */
+    static size_t normalize(uint32_t* entries, size_t nEntries)
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < nEntries; i++) {
+            if (n != 0 && (entries[n-1] >> 6) == (entries[i] >> 6)) {
+                entries[n-1] = entries[i];
+            } else {
+                entries[n++] = entries[i];
+            }
+        }
+        return n;
+    }
+
+    /**
+     * Merge two sorted, normalized entry lists into out, which must have room for na + nb entries.
+     * @return the number of entries written
+     */
+    static size_t mergeSparse(uint32_t const* a, size_t na, uint32_t const* b, size_t nb, uint32_t* out)
+    {
+        size_t i = 0, j = 0, n = 0;
+        while (i < na && j < nb) {
+            uint32_t const ia = a[i] >> 6;
+            uint32_t const ib = b[j] >> 6;
+            if (ia < ib) {
+                out[n++] = a[i++];
+            } else if (ib < ia) {
+                out[n++] = b[j++];
+            } else {
+                out[n++] = std::max(a[i++], b[j++]);
+            }
+        }
+        while (i < na) {
+            out[n++] = a[i++];
+        }
+        while (j < nb) {
+            out[n++] = b[j++];
+        }
+        return n;
+    }
+
+    /**
+     * Estimate from a sparse sketch: linear counting over 2^SPARSE_PRECISION registers,
+     * which is practically exact in the range the sparse format is used for.
+     */
+    static double estimateSparse(size_t nEntries)
+    {
+        double const m = static_cast<double>(1 << SPARSE_PRECISION);
+        return m * log(m / (m - static_cast<double>(nEntries)));
+    }
+
+    /**
+     * Estimate from dense registers: the raw HyperLogLog estimate, replaced by linear
+     * counting in the small range where the raw estimate is biased.
+     */
+    static double estimateDense(uint8_t const* regs)
+    {
+        double const m = NUM_REGISTERS;
+        double sum = 0;
+        size_t zeros = 0;
+        for (size_t i = 0; i < NUM_REGISTERS; i++) {
+            sum += ldexp(1.0, -static_cast<int>(regs[i]));
+            zeros += (regs[i] == 0);
+        }
+        double const alpha = 0.7213 / (1 + 1.079 / m);
+        double const e = alpha * m * m / sum;
+        if (zeros != 0 && e <= 2.5 * m) {
+            return m * log(m / static_cast<double>(zeros));
+        }
+        return e;
+    }
+
+    static double estimate(Header const* header)
+    {
+        return header->format == DENSE
+            ? estimateDense(registers(header))
+            : estimateSparse(header->nEntries);
+    }
+
+private:
+    static const uint32_t SEED = 0x5C1DB;
+};
+
+} //namespace scidb
+
+#endif /* HYPER_LOG_LOG_H_ */
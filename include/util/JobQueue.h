@@ -31,45 +31,156 @@
 #ifndef JOBQUEUE_H_
 #define JOBQUEUE_H_
 
+#include <algorithm>
 #include <list>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <boost/function.hpp>
 #include <boost/shared_ptr.hpp>
 
 #include "Job.h"
 #include "Mutex.h"
+#include "Event.h"
 #include "Semaphore.h"
-#include "RWLock.h"
 
 
 namespace scidb
 {
 
+class WorkDeque;
+class InjectionRing;
 
+/**
+ * The queue of jobs of a thread pool, scheduled by work stealing.
+ *
+ * Every pool thread attached to the queue owns a Chase-Lev deque. A job pushed by a pool
+ * thread goes to the bottom of its own deque and is normally run by the same thread, most
+ * recent first; idle threads steal the oldest jobs from the top of the other deques, trying
+ * the threads of their own NUMA node first. Jobs pushed by any other thread go to a lock-free
+ * injection ring of their priority lane. A thread looks for work in this order: the high
+ * priority lane, its own deque, the normal lane, the other deques.
+ *
+ * A job that a pool thread pushes again while running it (to wait for something and retry)
+ * goes to the normal lane instead of the deque, so that it queues behind the jobs already
+ * waiting rather than being popped again right away by the same thread.
+ *
+ * An idle thread spins briefly, then sleeps on a semaphore of its own; a push wakes at most
+ * one sleeper and takes no lock when nobody sleeps.
+ */
 class JobQueue
 {
+public:
+    enum Priority
+    {
+        HIGH_PRIORITY = 0,
+        NORMAL_PRIORITY,
+        NUM_PRIORITIES // must be last
+    };
+
+    /**
+     * Scheduling counters, summed over the workers. They are read without synchronization
+     * and are meant for monitoring only.
+     */
+    struct Statistics
+    {
+        size_t   depth;      ///< jobs currently queued
+        size_t   workers;    ///< pool threads attached to the queue
+        uint64_t injected;   ///< jobs pushed by threads outside the pool
+        uint64_t spawned;    ///< jobs pushed by pool threads onto their own deques
+        uint64_t localPops;  ///< jobs taken by pool threads from their own deques
+        uint64_t steals;     ///< jobs taken from the deque of another pool thread
+        uint64_t nodeSteals; ///< the part of steals taken from a thread of the same NUMA node
+        uint64_t sleeps;     ///< times a pool thread found no job and went to sleep
+    };
+
+    /**
+     * @param nNodes the number of NUMA nodes the pool threads are spread over;
+     *        stealing prefers the threads of the thief's own node when it is above 1
+     */
+    JobQueue(size_t nNodes = 1);
+
+    ~JobQueue();
+
+    size_t getSize() const
+    {
+        return static_cast<size_t>(_size);
+    }
+
+    /**
+     * Add new job to the end of the normal priority lane, or to the deque of the calling pool thread
+     * unless the job is the one that thread is running.
+     */
+    void pushJob(boost::shared_ptr<Job> job);
+
+    /// Add new job to the high priority lane, ahead of all the other jobs
+    void pushHighPriorityJob(boost::shared_ptr<Job> job);
+
+    /**
+     * Get the next job. If there is none, the method waits.
+     */
+    boost::shared_ptr<Job> popJob();
+
+    /**
+     * Give the calling thread its own deque. Called once by every pool thread before its first popJob().
+     */
+    void attachWorker();
+
+    Statistics getStatistics() const;
+
+    void setName(std::string const& name)
+    {
+        _name = name;
+    }
+
+    std::string const& getName() const
+    {
+        return _name;
+    }
+
+    /**
+     * Call a visitor on every existing queue.
+     */
+    static void listQueues(boost::function<void(JobQueue const&)> const& visitor);
+
 private:
-    std::list< boost::shared_ptr<Job> > _queue;
-	Mutex _queueMutex;
-	Semaphore _queueSemaphore;
+    JobQueue(const JobQueue&);
+    JobQueue& operator=(const JobQueue&);
 
-public:
-	JobQueue();
+    static const size_t MAX_WORKERS = 1024;
+    static const size_t INJECTION_RING_SIZE = 4096;
+
+    void inject(boost::shared_ptr<Job> const& job, Priority priority);
+    boost::shared_ptr<Job>* popInjected(Priority priority);
+    boost::shared_ptr<Job>* steal(WorkDeque* thief);
+    boost::shared_ptr<Job>* tryPop(WorkDeque* self);
+    void wakeUp();
+    void sleep();
+
+    std::string _name;
+    uint64_t _id;
+    size_t const _nNodes;
+
+    /// jobs queued; incremented before a job becomes visible, decremented when a job is taken
+    volatile int64_t _size;
+
+    WorkDeque* volatile _workers[MAX_WORKERS];
+    volatile size_t _nWorkers;
 
-        size_t getSize()
-        {
-            return _queue.size();
-        }
+    InjectionRing* _rings[NUM_PRIORITIES];
 
-	/// Add new job to the end of queue
-	void pushJob(boost::shared_ptr<Job> job);
+    /// jobs that did not fit into the rings
+    std::list< boost::shared_ptr<Job> > _overflow[NUM_PRIORITIES];
+    volatile size_t _overflowSize[NUM_PRIORITIES];
+    Mutex _overflowMutex;
 
-	// Add new job to the beginning of queue
-	void pushHighPriorityJob(boost::shared_ptr<Job> job);
+    volatile uint64_t _injected;
+    volatile uint64_t _sleeps;
 
-        /**
-         * Get next job from the beginning of the queue
-         * If there is next element the method waits
-         */
-        boost::shared_ptr<Job> popJob();
+    /// the semaphores of the sleeping threads, the most recent last; _sleepers is their number
+    Mutex _sleepMutex;
+    std::vector<Semaphore*> _idle;
+    volatile size_t _sleepers;
 };
 
 
@@ -0,0 +1,255 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file KllSketch.h
+ *
+ * @brief Building blocks of a mergeable KLL quantile sketch over doubles.
+ *
+ * The sketch follows Z. Karnin, K. Lang, E. Liberty, "Optimal Quantile Approximation
+ * in Streams" (2016). Items live in a hierarchy of compactors; an item at level h
+ * stands for 2^h input values. When the sketch exceeds its capacity, the lowest full
+ * level is sorted and every other item is promoted to the level above. With K = 200
+ * the normalized rank error is about 1.7%, independent of the number of values, and
+ * the sketch never holds more than about 3*K items.
+ *
+ * Sketch image layout:
+ *   Header, followed by Header::nItems doubles, grouped by level from the top level
+ *   down to level 0, so that new values are appended at the end of the image.
+ *   Callers own the memory and must make room for the items they append or merge.
+ */
+
+#ifndef KLL_SKETCH_H_
+#define KLL_SKETCH_H_
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <../extern/MurmurHash/MurmurHash3.h>
+
+namespace scidb
+{
+
+class KllSketch
+{
+public:
+    /** Capacity of the top level. */
+    static const uint32_t K = 200;
+
+    /** Smallest capacity of any level. */
+    static const uint32_t MIN_LEVEL_CAPACITY = 2;
+
+    /** Enough levels for K * 2^32 values. */
+    static const uint32_t MAX_LEVELS = 32;
+
+    struct Header
+    {
+        uint64_t n;
+        uint32_t nItems;
+        uint32_t nLevels;
+        uint32_t levelSize[MAX_LEVELS];
+    };
+
+    static size_t imageSize(size_t nItems)
+    {
+        return sizeof(Header) + nItems * sizeof(double);
+    }
+
+    static void initialize(Header* header)
+    {
+        memset(header, 0, sizeof(Header));
+        header->nLevels = 1;
+    }
+
+    static double* items(Header* header)
+    {
+        return reinterpret_cast<double*>(header + 1);
+    }
+
+    static double const* items(Header const* header)
+    {
+        return reinterpret_cast<double const*>(header + 1);
+    }
+
+    /**
+     * Number of values that may be appended before the sketch has to compact.
+     */
+    static size_t freeSpace(Header const* header)
+    {
+        size_t const capacity = totalCapacity(header);
+        return capacity > header->nItems ? capacity - header->nItems : 0;
+    }
+
+    /**
+     * Append values to level 0 and compact as needed.
+     * The image must have room for header->nItems + count items.
+     */
+    static void append(Header* header, double const* values, size_t count)
+    {
+        memcpy(items(header) + header->nItems, values, count * sizeof(double));
+        header->nItems += static_cast<uint32_t>(count);
+        header->levelSize[0] += static_cast<uint32_t>(count);
+        header->n += count;
+        compress(header);
+    }
+
+    /**
+     * Merge src into dst level by level and compact as needed.
+     * The dst image must have room for dst->nItems + src->nItems items.
+     */
+    static void merge(Header* dst, Header const* src)
+    {
+        uint32_t const nLevels = std::max(dst->nLevels, src->nLevels);
+        std::vector<double> merged(dst->nItems + src->nItems);
+        double const* d = items(dst) + dst->nItems;
+        double const* s = items(src) + src->nItems;
+        size_t end = merged.size();
+
+        // Walk both images from level 0 upwards, filling the result from the back.
+        for (uint32_t h = 0; h < nLevels; h++) {
+            uint32_t const nd = h < dst->nLevels ? dst->levelSize[h] : 0;
+            uint32_t const ns = h < src->nLevels ? src->levelSize[h] : 0;
+            d -= nd;
+            s -= ns;
+            end -= nd + ns;
+            std::copy(d, d + nd, merged.begin() + end);
+            std::copy(s, s + ns, merged.begin() + end + nd);
+            dst->levelSize[h] = nd + ns;
+        }
+        if (!merged.empty()) {
+            memcpy(items(dst), &merged[0], merged.size() * sizeof(double));
+        }
+        dst->nItems = static_cast<uint32_t>(merged.size());
+        dst->nLevels = nLevels;
+        dst->n += src->n;
+        compress(dst);
+    }
+
+    /**
+     * Value at normalized rank q in [0, 1]: the smallest retained item whose
+     * weighted rank reaches q * n.
+     * @pre header->nItems > 0
+     */
+    static double quantile(Header const* header, double q)
+    {
+        std::vector<std::pair<double, uint64_t> > weighted;
+        weighted.reserve(header->nItems);
+        double const* item = items(header) + header->nItems;
+        for (uint32_t h = 0; h < header->nLevels; h++) {
+            item -= header->levelSize[h];
+            for (uint32_t i = 0; i < header->levelSize[h]; i++) {
+                weighted.push_back(std::make_pair(item[i], static_cast<uint64_t>(1) << h));
+            }
+        }
+        std::sort(weighted.begin(), weighted.end());
+
+        uint64_t total = 0;
+        for (size_t i = 0; i < weighted.size(); i++) {
+            total += weighted[i].second;
+        }
+        double const target = q * static_cast<double>(total);
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < weighted.size(); i++) {
+            cumulative += weighted[i].second;
+            if (static_cast<double>(cumulative) >= target) {
+                return weighted[i].first;
+            }
+        }
+        return weighted.back().first;
+    }
+
+private:
+    static uint32_t levelCapacity(Header const* header, uint32_t h)
+    {
+        double capacity = K;
+        for (uint32_t depth = header->nLevels - 1 - h; depth > 0; depth--) {
+            capacity = capacity * 2 / 3;
+        }
+        // MIN_LEVEL_CAPACITY is copied: std::max() binds references, and the constant has no definition
+        return std::max(uint32_t(MIN_LEVEL_CAPACITY), static_cast<uint32_t>(capacity));
+    }
+
+    static size_t totalCapacity(Header const* header)
+    {
+        size_t capacity = 0;
+        for (uint32_t h = 0; h < header->nLevels; h++) {
+            capacity += levelCapacity(header, h);
+        }
+        return capacity;
+    }
+
+    static void compress(Header* header)
+    {
+        while (header->nItems > totalCapacity(header)) {
+            uint32_t h = 0;
+            while (header->levelSize[h] < levelCapacity(header, h)) {
+                h++;
+            }
+            compact(header, h);
+        }
+    }
+
+    /**
+     * Sort level h and promote every other item, starting at a pseudo-random offset,
+     * to level h + 1. An odd item out stays at level h.
+     */
+    static void compact(Header* header, uint32_t h)
+    {
+        if (h + 1 == header->nLevels) {
+            assert(header->nLevels < MAX_LEVELS);
+            header->levelSize[header->nLevels++] = 0;
+        }
+        size_t start = 0;
+        for (uint32_t l = header->nLevels - 1; l > h; l--) {
+            start += header->levelSize[l];
+        }
+        double* level = items(header) + start;
+        size_t const size = header->levelSize[h];
+        size_t const pairs = size / 2;
+        size_t const odd = size & 1;
+        std::sort(level, level + size);
+
+        size_t const offset = fmix(header->n ^ (static_cast<uint64_t>(h) << 56)) & 1;
+        double const leftover = level[size - 1];
+        for (size_t j = 0; j < pairs; j++) {
+            level[j] = level[2 * j + offset];
+        }
+        if (odd) {
+            level[pairs] = leftover;
+        }
+        double* tail = level + size;
+        double* end = items(header) + header->nItems;
+        memmove(level + pairs + odd, tail, (end - tail) * sizeof(double));
+
+        header->levelSize[h + 1] += static_cast<uint32_t>(pairs);
+        header->levelSize[h] = static_cast<uint32_t>(odd);
+        header->nItems -= static_cast<uint32_t>(pairs);
+    }
+};
+
+} //namespace scidb
+
+#endif /* KLL_SKETCH_H_ */
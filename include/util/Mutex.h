@@ -32,10 +32,12 @@
 #define MUTEX_H_
 
 #include "assert.h"
+#include <errno.h>
 #include <stdlib.h>
 #include <pthread.h>
 
 #include "system/Exceptions.h"
+#include "util/Tracer.h"
 
 
 namespace scidb
@@ -65,6 +67,13 @@ private:
 
     pthread_mutex_t _mutex;
 
+    void _lock()
+    {
+        if (pthread_mutex_lock(&_mutex)) {
+            throw SYSTEM_EXCEPTION(SCIDB_SE_INTERNAL, SCIDB_LE_OPERATION_FAILED) << "pthread_mutex_lock";
+        }
+    }
+
   public:
     void checkForDeadlock() { 
 #ifndef __APPLE__
@@ -97,9 +106,31 @@ private:
 
     void lock()
     {
-        if (pthread_mutex_lock(&_mutex)) {
-            throw SYSTEM_EXCEPTION(SCIDB_SE_INTERNAL, SCIDB_LE_OPERATION_FAILED) << "pthread_mutex_lock";
+        if (Tracer::isEnabled()) {
+            if (tryLock()) {
+                return;
+            }
+            // Trace only the waits for a mutex held by another thread
+            TraceScope wait(Tracer::MUTEX_WAIT, reinterpret_cast<uintptr_t>(this));
+            _lock();
+        } else {
+            _lock();
+        }
+    }
+
+    /**
+     * @return true if the mutex is now locked, false if another thread holds it
+     */
+    bool tryLock()
+    {
+        const int rc = pthread_mutex_trylock(&_mutex);
+        if (rc == EBUSY) {
+            return false;
+        }
+        if (rc) {
+            throw SYSTEM_EXCEPTION(SCIDB_SE_INTERNAL, SCIDB_LE_OPERATION_FAILED) << "pthread_mutex_trylock";
         }
+        return true;
     }
 
     void unlock()
@@ -37,6 +37,7 @@
 #include <pthread.h>
 #include "system/Exceptions.h"
 #include "Event.h"
+#include "util/Tracer.h"
 
 namespace scidb
 {
@@ -74,9 +75,12 @@ public:
         if (_currentWriter == pthread_self()) { 
             _nested += 1;
         } else { 
-            while (_pendingWriters || _currentWriter) {
-                if (!_noWriter.wait(_mutex, errorChecker)) { 
-                    return false;
+            if (_pendingWriters || _currentWriter) {
+                TraceScope wait(Tracer::RWLOCK_WAIT, reinterpret_cast<uintptr_t>(this), "read");
+                while (_pendingWriters || _currentWriter) {
+                    if (!_noWriter.wait(_mutex, errorChecker)) { 
+                        return false;
+                    }
                 }
             }
             assert(!_currentWriter);
@@ -125,15 +129,18 @@ public:
         } else { 
             PendingWriter writer(*this);
             
-            while (_readers > 0) {
-                if (!_noReaders.wait(_mutex, errorChecker)) { 
-                    return false;
+            if (_readers > 0 || _currentWriter) {
+                TraceScope wait(Tracer::RWLOCK_WAIT, reinterpret_cast<uintptr_t>(this), "write");
+                while (_readers > 0) {
+                    if (!_noReaders.wait(_mutex, errorChecker)) { 
+                        return false;
+                    }
                 }
-            }
-            
-            while (_currentWriter) {
-                if (!_noWriter.wait(_mutex, errorChecker)) { 
-                    return false;
+                
+                while (_currentWriter) {
+                    if (!_noWriter.wait(_mutex, errorChecker)) { 
+                        return false;
+                    }
                 }
             }
             
@@ -57,8 +57,16 @@ private:
     std::vector< boost::shared_ptr<Job> > _currentJobs;
     bool _shutdown;
     size_t _threadCount;
+    bool _numaAffinity;
     boost::shared_ptr<Semaphore> _terminatedThreads;
 
+    /**
+     * Bind the calling pool thread to the CPUs of its NUMA node, if the pool was created
+     * with NUMA affinity and the host has more than one node.
+     * @param index the index of the thread in the pool; threads are spread over the nodes round-robin
+     */
+    void bindToNUMANode(size_t index);
+
 public:
 
     class InvalidArgumentException: public SystemException
@@ -104,9 +112,12 @@ public:
 	 *
 	 * @param queue an object of queue from which pool
 	 * will be process jobs.
+	 * @param numaAffinity if true, the threads are spread over the NUMA nodes and bound to them.
+	 * Give such a pool a queue created with the number of nodes, so that its idle threads
+	 * steal from the threads of their own node first.
          * @throws scidb::ThreadPool::InvalidArgumentException if the threadCount <= 0
 	 */
-	ThreadPool(size_t threadCount, boost::shared_ptr<JobQueue> queue);
+	ThreadPool(size_t threadCount, boost::shared_ptr<JobQueue> queue, bool numaAffinity = false);
 
 	/**
 	 * Start the threads in the pool. It can be called only once.
@@ -0,0 +1,146 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file Tracer.h
+ *
+ * @brief Timestamped events kept in per-thread ring buffers, dumped as Chrome trace JSON.
+ *
+ * Every thread records into its own ring buffer without taking any lock, the oldest events
+ * being overwritten. Nothing is recorded while tracing is off (the trace option, which can be
+ * changed with setopt()). When a query ends with tracing on, every instance writes the events
+ * of the query, and the unattributed events that overlap it, to trace-path as a JSON array
+ * that chrome://tracing and Perfetto load. The files of the instances can be concatenated
+ * (e.g. jq -s add) to see the whole cluster: the events are stamped with the wall clock and
+ * use the physical instance ID as process ID.
+ *
+ * This header is included by Mutex.h and must not depend on anything that locks.
+ */
+
+#ifndef TRACER_H_
+#define TRACER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include <iosfwd>
+
+namespace scidb
+{
+
+class Tracer
+{
+public:
+    enum EventType
+    {
+        JOB = 0,            /**< a job run by a JobQueue thread, labelled with its type */
+        MUTEX_WAIT,         /**< waiting for a Mutex held by another thread, arg is the mutex */
+        RWLOCK_WAIT,        /**< waiting for an RWLock, arg is the lock */
+        CHUNK_FETCH,        /**< reading a chunk from disk, arg is the bytes read */
+        CHUNK_DECOMPRESS,   /**< decompressing a chunk, arg is the compressed size */
+        SG_SEND,            /**< sending a query message, arg is the bytes sent */
+        SG_RECEIVE,         /**< storing a chunk received by scatter/gather, arg is the compressed size */
+        SPILL,              /**< writing a MemArray chunk to its temporary file, arg is the bytes written */
+        NUM_EVENT_TYPES     // must be last
+    };
+
+    static bool isEnabled()
+    {
+        return _enabled;
+    }
+
+    static void setEnabled(bool enabled);
+
+    /**
+     * @return the wall clock in microseconds, the time base of Chrome traces
+     */
+    static uint64_t now()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return uint64_t(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+    }
+
+    /**
+     * Record an event of the calling thread, attributed to its current query.
+     * @param start the start of the event, from now()
+     * @param end the end of the event, from now()
+     * @param arg a value shown with the event
+     * @param label a string with static storage shown with the event, or NULL
+     */
+    static void record(EventType type, uint64_t start, uint64_t end, uint64_t arg, const char* label);
+
+    /**
+     * Set the query the events of the calling thread are attributed to, 0 for none.
+     */
+    static void setCurrentQueryID(uint64_t queryID);
+
+    /**
+     * Write the events of a query as a Chrome trace JSON array.
+     * @param queryID the query
+     * @param from the start of the query: the unattributed events ending before are left out
+     * @param pid the process ID of the events, e.g. the instance ID
+     */
+    static void dump(std::ostream& out, uint64_t queryID, uint64_t from, uint64_t pid);
+
+    static const char* getEventName(EventType type);
+
+private:
+    static volatile bool _enabled;
+};
+
+/**
+ * Records an event covering a scope, if tracing was on when the scope was entered.
+ */
+class TraceScope
+{
+public:
+    TraceScope(Tracer::EventType type, uint64_t arg = 0, const char* label = NULL)
+    : _start(Tracer::isEnabled() ? Tracer::now() : 0),
+      _type(type),
+      _arg(arg),
+      _label(label)
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (_start) {
+            Tracer::record(_type, _start, Tracer::now(), _arg, _label);
+        }
+    }
+
+    void setArg(uint64_t arg)
+    {
+        _arg = arg;
+    }
+
+private:
+    uint64_t const _start;
+    Tracer::EventType const _type;
+    uint64_t _arg;
+    const char* const _label;
+};
+
+} //namespace scidb
+
+#endif /* TRACER_H_ */
@@ -36,6 +36,7 @@
 #include "array/MemArray.h"
 #include "array/RLE.h"
 #include "array/AllocationBuffer.h"
+#include "util/CoordinatesMapper.h"
 #include "system/Exceptions.h"
 #include "query/FunctionDescription.h"
 #include "query/TypeSystem.h"
@@ -293,17 +294,7 @@ namespace scidb
             bool vectorMode = src->supportsVectorMode() && dst->supportsVectorMode();
             src->setVectorMode(vectorMode);
             dst->setVectorMode(vectorMode);
-            size_t count = 0;
-            while (!src->end()) {
-                if (!dst->setPosition(src->getPosition())) {
-                    Coordinates const& pos = src->getPosition();
-                    dst->setPosition(pos);
-                    throw SYSTEM_EXCEPTION(SCIDB_SE_MERGE, SCIDB_LE_OPERATION_FAILED) << "setPosition";
-                }
-                dst->writeItem(src->getItem());
-                count += 1;
-                ++(*src);
-            }
+            size_t count = dst->copyItems(*src);
             if (!vectorMode && !getArrayDesc().hasOverlap()) {
                 materializedChunk->setCount(count);
             }
@@ -659,6 +650,96 @@ namespace scidb
             throw SYSTEM_EXCEPTION(SCIDB_SE_INTERNAL, SCIDB_LE_ILLEGAL_OPERATION) << "setVectorMode";
     }
 
+    void ChunkIterator::writeItems(position_t start, size_t count, void const* values, uint8_t const* nulls)
+    {
+        ConstChunk const& chunk = getChunk();
+        AttributeDesc const& attr = chunk.getAttributeDesc();
+        size_t const size = TypeLibrary::getType(attr.getType()).byteSize();
+        if (size == 0) {
+            throw SYSTEM_EXCEPTION(SCIDB_SE_INTERNAL, SCIDB_LE_ILLEGAL_OPERATION) << "writeItems of a variable size attribute";
+        }
+        CoordinatesMapper mapper(chunk);
+        Coordinates pos;
+        Value item;
+        if (attr.isEmptyIndicator()) {
+            item.setBool(true);
+        }
+        char const* src = static_cast<char const*>(values);
+        for (size_t i = 0; i < count; i++) {
+            mapper.pos2coord(start + i, pos);
+            if (!setPosition(pos)) {
+                throw USER_EXCEPTION(SCIDB_SE_EXECUTION, SCIDB_LE_OPERATION_FAILED) << "setPosition";
+            }
+            if (!attr.isEmptyIndicator()) {
+                if (nulls != NULL && nulls[i]) {
+                    item.setNull();
+                } else {
+                    item.setData(src + i*size, size);
+                }
+            }
+            writeItem(item);
+        }
+    }
+
+    size_t ChunkIterator::copyItems(ConstChunkIterator& src)
+    {
+        const size_t MAX_RUN = 1024; // cells gathered before a writeItems()
+
+        ConstChunk const& chunk = getChunk();
+        AttributeDesc const& attr = chunk.getAttributeDesc();
+        Type const& type = TypeLibrary::getType(attr.getType());
+        size_t const size = type.byteSize();
+        bool const bulk = !((getMode() | src.getMode()) & TILE_MODE)
+            && !(supportsVectorMode() && src.supportsVectorMode())
+            && !attr.isEmptyIndicator() && !type.variableSize() && type.bitSize() > 1;
+
+        size_t count = 0;
+        CoordinatesMapper mapper(chunk);
+        vector<char> values(bulk ? MAX_RUN*size : 0);
+        vector<uint8_t> nulls(bulk ? MAX_RUN : 0);
+        bool hasNulls = false;
+        position_t start = 0;
+        size_t n = 0;
+        for (; !src.end(); ++src) {
+            Coordinates const& coords = src.getPosition();
+            Value const& item = src.getItem();
+            if (bulk && (!item.isNull() ? item.size() == size : item.getMissingReason() == 0)) {
+                position_t const pos = mapper.coord2pos(coords);
+                if (n != 0 && (pos != start + position_t(n) || n == MAX_RUN)) {
+                    writeItems(start, n, &values[0], hasNulls ? &nulls[0] : NULL);
+                    n = 0;
+                    hasNulls = false;
+                }
+                if (n == 0) {
+                    start = pos;
+                }
+                if (item.isNull()) {
+                    nulls[n] = 1;
+                    hasNulls = true;
+                } else {
+                    nulls[n] = 0;
+                    memcpy(&values[n*size], item.data(), size);
+                }
+                n += 1;
+            } else {
+                if (n != 0) {
+                    writeItems(start, n, &values[0], hasNulls ? &nulls[0] : NULL);
+                    n = 0;
+                    hasNulls = false;
+                }
+                if (!setPosition(coords)) {
+                    throw SYSTEM_EXCEPTION(SCIDB_SE_MERGE, SCIDB_LE_OPERATION_FAILED) << "setPosition";
+                }
+                writeItem(item);
+            }
+            count += 1;
+        }
+        if (n != 0) {
+            writeItems(start, n, &values[0], hasNulls ? &nulls[0] : NULL);
+        }
+        return count;
+    }
+
     Coordinates const& ConstChunkIterator::getFirstPosition()
     {
         return getChunk().getFirstPosition((getMode() & IGNORE_OVERLAPS) == 0);
@@ -1189,15 +1270,7 @@ namespace scidb
                     bool vectorMode = src->supportsVectorMode() && dst->supportsVectorMode();
                     src->setVectorMode(vectorMode);
                     dst->setVectorMode(vectorMode);
-                    size_t count = 0;
-                    while (!src->end()) {
-                        if (!emptyableToNonEmptyable) {
-                            count += 1;
-                        }
-                        dst->setPosition(src->getPosition());
-                        dst->writeItem(src->getItem());
-                        ++(*src);
-                    }
+                    size_t count = dst->copyItems(*src);
                     if (!vectorMode && !(src->getMode() & ChunkIterator::TILE_MODE) && !chunk.getArrayDesc().hasOverlap()) {
                         if (emptyableToNonEmptyable) {
                             count = outChunk.getNumberOfElements(false); // false = no overlap
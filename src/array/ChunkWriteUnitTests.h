@@ -0,0 +1,257 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/*
+ * @file ChunkWriteUnitTests.h
+ *
+ * @brief Tests of the bulk writes of chunk iterators: writeItems() and copyItems().
+ */
+
+#ifndef CHUNK_WRITE_UNIT_TESTS_H_
+#define CHUNK_WRITE_UNIT_TESTS_H_
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "array/MemArray.h"
+#include "array/Metadata.h"
+#include "query/Query.h"
+#include "system/Cluster.h"
+#include "util/CoordinatesMapper.h"
+
+using namespace scidb;
+
+class ChunkWriteTests: public CppUnit::TestFixture
+{
+CPPUNIT_TEST_SUITE(ChunkWriteTests);
+CPPUNIT_TEST(testWriteItems);
+CPPUNIT_TEST(testWriteItemsEmptyable);
+CPPUNIT_TEST(testCopyItems);
+CPPUNIT_TEST_SUITE_END();
+
+private:
+    enum
+    {
+        SIDE = 100,         // cells of the arrays, the last chunk is partial
+        CHUNK = 40,         // chunk interval
+        RUN = 7             // cells per writeItems()
+    };
+
+    boost::shared_ptr<Query> _query;
+
+    /// Runs of equal values, distinct values and nulls, which fall across the writeItems() calls
+    static int32_t valueAt(Coordinate x)
+    {
+        return x % 10 < 4 ? 5 : int32_t(x * 3);
+    }
+
+    static bool isNullAt(Coordinate x)
+    {
+        return x % 13 == 12 || x % 13 == 0;
+    }
+
+    /// Cells left empty in an emptyable array
+    static bool isEmptyAt(Coordinate x)
+    {
+        return x % 9 == 4;
+    }
+
+    static ArrayDesc makeDesc(bool emptyable)
+    {
+        Attributes attrs(emptyable ? 2 : 1);
+        attrs[0] = AttributeDesc(0, "a", TID_INT32, AttributeDesc::IS_NULLABLE, 0);
+        if (emptyable) {
+            attrs[1] = AttributeDesc(1, DEFAULT_EMPTY_TAG_ATTRIBUTE_NAME, TID_INDICATOR, AttributeDesc::IS_EMPTY_INDICATOR, 0);
+        }
+        Dimensions dims(1);
+        dims[0] = DimensionDesc("x", 0, SIDE - 1, CHUNK, 0);
+        return ArrayDesc(emptyable ? "emptyable" : "dense", attrs, dims);
+    }
+
+    /**
+     * Fill the non-empty cells of the first attribute with setPosition() and writeItem(),
+     * or with writeItems() over the runs of consecutive non-empty cells, RUN cells at a time
+     */
+    boost::shared_ptr<Array> makeArray(ArrayDesc const& desc, bool bulk)
+    {
+        bool const emptyable = desc.getEmptyBitmapAttribute() != NULL;
+        boost::shared_ptr<MemArray> array(new MemArray(desc, _query));
+        boost::shared_ptr<ArrayIterator> arrayIterator = array->getIterator(0);
+        Coordinates chunkPos(1);
+        Coordinates pos(1);
+        Value value(TypeLibrary::getType(TID_INT32));
+        for (chunkPos[0] = 0; chunkPos[0] < SIDE; chunkPos[0] += CHUNK) {
+            Chunk& chunk = arrayIterator->newChunk(chunkPos);
+            boost::shared_ptr<ChunkIterator> chunkIterator =
+                chunk.getIterator(_query, ChunkIterator::SEQUENTIAL_WRITE);
+            CoordinatesMapper mapper(chunk);
+            Coordinate const end = std::min<Coordinate>(chunkPos[0] + CHUNK, SIDE);
+            std::vector<int32_t> values;
+            std::vector<uint8_t> nulls;
+            for (pos[0] = chunkPos[0]; pos[0] < end; pos[0]++) {
+                if (emptyable && isEmptyAt(pos[0])) {
+                    continue;
+                }
+                if (!bulk) {
+                    if (isNullAt(pos[0])) {
+                        value.setNull();
+                    } else {
+                        value.setInt32(valueAt(pos[0]));
+                    }
+                    CPPUNIT_ASSERT(chunkIterator->setPosition(pos));
+                    chunkIterator->writeItem(value);
+                    continue;
+                }
+                values.push_back(valueAt(pos[0]));
+                nulls.push_back(isNullAt(pos[0]));
+                if (values.size() == RUN || pos[0] + 1 == end || (emptyable && isEmptyAt(pos[0] + 1))) {
+                    Coordinates first(1, pos[0] + 1 - values.size());
+                    chunkIterator->writeItems(mapper.coord2pos(first), values.size(), &values[0], &nulls[0]);
+                    values.clear();
+                    nulls.clear();
+                }
+            }
+            chunkIterator->flush();
+        }
+        return array;
+    }
+
+    /**
+     * Check that two arrays have the same cells, values and missing reasons
+     */
+    void checkSame(boost::shared_ptr<Array> const& expected, boost::shared_ptr<Array> const& actual)
+    {
+        boost::shared_ptr<ConstArrayIterator> i1 = expected->getConstIterator(0);
+        boost::shared_ptr<ConstArrayIterator> i2 = actual->getConstIterator(0);
+        size_t nCells = 0;
+        for (; !i1->end(); ++(*i1), ++(*i2)) {
+            CPPUNIT_ASSERT(!i2->end());
+            CPPUNIT_ASSERT(i1->getPosition() == i2->getPosition());
+            boost::shared_ptr<ConstChunkIterator> c1 = i1->getChunk().getConstIterator(ChunkIterator::IGNORE_EMPTY_CELLS);
+            boost::shared_ptr<ConstChunkIterator> c2 = i2->getChunk().getConstIterator(ChunkIterator::IGNORE_EMPTY_CELLS);
+            for (; !c1->end(); ++(*c1), ++(*c2)) {
+                CPPUNIT_ASSERT(!c2->end());
+                CPPUNIT_ASSERT(c1->getPosition() == c2->getPosition());
+                Value const& v1 = c1->getItem();
+                Value const& v2 = c2->getItem();
+                CPPUNIT_ASSERT(v1.isNull() == v2.isNull());
+                if (v1.isNull()) {
+                    CPPUNIT_ASSERT(v1.getMissingReason() == v2.getMissingReason());
+                } else {
+                    CPPUNIT_ASSERT(v1.getInt32() == v2.getInt32());
+                }
+                nCells += 1;
+            }
+            CPPUNIT_ASSERT(c2->end());
+        }
+        CPPUNIT_ASSERT(i2->end());
+        CPPUNIT_ASSERT(nCells > 0);
+    }
+
+public:
+    void setUp()
+    {
+        boost::shared_ptr<const InstanceLiveness> liveness(Cluster::getInstance()->getInstanceLiveness());
+        int32_t longErrorCode = SCIDB_E_NO_ERROR;
+        _query = Query::createFakeQuery(0, 0, liveness, &longErrorCode);
+        if (longErrorCode != SCIDB_E_NO_ERROR &&
+            longErrorCode != SCIDB_LE_INVALID_FUNCTION_ARGUMENT) {
+            // NetworkManager::createWorkQueue() may complain about a null queue,
+            // which does not matter since the network is not used
+            throw SYSTEM_EXCEPTION(SCIDB_LE_UNKNOWN_ERROR, longErrorCode);
+        }
+    }
+
+    void tearDown()
+    {
+        Query::destroyFakeQuery(_query.get());
+        _query.reset();
+    }
+
+    /// A MemChunk written by runs is the one written cell by cell
+    void testWriteItems()
+    {
+        ArrayDesc const desc = makeDesc(false);
+        checkSame(makeArray(desc, false), makeArray(desc, true));
+    }
+
+    /// The runs of an emptyable chunk also fill its empty bitmap
+    void testWriteItemsEmptyable()
+    {
+        ArrayDesc const desc = makeDesc(true);
+        checkSame(makeArray(desc, false), makeArray(desc, true));
+    }
+
+    /// A chunk copied by copyItems() is its source, missing reasons included
+    void testCopyItems()
+    {
+        ArrayDesc const desc = makeDesc(true);
+        boost::shared_ptr<MemArray> source(new MemArray(desc, _query));
+        boost::shared_ptr<ArrayIterator> sourceIterator = source->getIterator(0);
+        Coordinates chunkPos(1, 0);
+        Coordinates pos(1);
+        Value value(TypeLibrary::getType(TID_INT32));
+        {
+            Chunk& chunk = sourceIterator->newChunk(chunkPos);
+            boost::shared_ptr<ChunkIterator> chunkIterator =
+                chunk.getIterator(_query, ChunkIterator::SEQUENTIAL_WRITE);
+            for (pos[0] = 0; pos[0] < CHUNK; pos[0]++) {
+                if (isEmptyAt(pos[0])) {
+                    continue;
+                }
+                if (pos[0] % 11 == 3) {
+                    value.setNull(2);
+                } else if (isNullAt(pos[0])) {
+                    value.setNull();
+                } else {
+                    value.setInt32(valueAt(pos[0]));
+                }
+                CPPUNIT_ASSERT(chunkIterator->setPosition(pos));
+                chunkIterator->writeItem(value);
+            }
+            chunkIterator->flush();
+        }
+
+        boost::shared_ptr<MemArray> copy(new MemArray(desc, _query));
+        {
+            boost::shared_ptr<ConstArrayIterator> src = source->getConstIterator(0);
+            boost::shared_ptr<ArrayIterator> copyIterator = copy->getIterator(0);
+            Chunk& chunk = copyIterator->newChunk(chunkPos);
+            boost::shared_ptr<ConstChunkIterator> srcChunk =
+                src->getChunk().getConstIterator(ChunkIterator::IGNORE_EMPTY_CELLS);
+            boost::shared_ptr<ChunkIterator> dstChunk =
+                chunk.getIterator(_query, ChunkIterator::SEQUENTIAL_WRITE);
+            CPPUNIT_ASSERT(dstChunk->copyItems(*srcChunk) == src->getChunk().count());
+            dstChunk->flush();
+        }
+        checkSame(source, copy);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ChunkWriteTests);
+
+#endif /* CHUNK_WRITE_UNIT_TESTS_H_ */
@@ -706,14 +706,7 @@ void MaterializedArray::materialize(const shared_ptr<Query>& query,
         bool vectorMode = src->supportsVectorMode() && dst->supportsVectorMode();
         src->setVectorMode(vectorMode);
         dst->setVectorMode(vectorMode);
-        size_t count = 0;
-        while (!src->end()) {
-            if (!dst->setPosition(src->getPosition()))
-                throw SYSTEM_EXCEPTION(SCIDB_SE_MERGE, SCIDB_LE_OPERATION_FAILED) << "setPosition";
-            dst->writeItem(src->getItem());
-            count += 1;
-            ++(*src);
-        }
+        size_t count = dst->copyItems(*src);
         if (!vectorMode && !(src->getMode() & ChunkIterator::TILE_MODE) && !chunk.getArrayDesc().hasOverlap()) {
             materializedChunk.setCount(count);
         }
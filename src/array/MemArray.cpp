@@ -30,9 +30,13 @@
  * @author others
  */
 
+#include <zlib.h>
+#include <algorithm>
+#include <boost/scoped_array.hpp>
 #include <log4cxx/logger.h>
 #include <util/Platform.h>
 #include <util/FileIO.h>
+#include <util/Tracer.h>
 #include <array/MemArray.h>
 #include <system/Exceptions.h>
 #include <system/Config.h>
@@ -52,6 +56,13 @@ namespace scidb
 
     const bool _sDebug = false;
 
+    /**
+     * The SharedMemCache spills down to the low watermark once it grows past its threshold,
+     * and threads needing memory wait for the background writer above the high watermark.
+     */
+    const uint64_t SPILL_LOW_WATERMARK_PERCENT = 80;
+    const uint64_t SPILL_HIGH_WATERMARK_PERCENT = 120;
+
     // Logger for operator. static to prevent visibility of variable outside of file
     static log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("scidb.array.memarray"));
 
@@ -158,12 +169,54 @@ namespace scidb
      */
 
     SharedMemCache::SharedMemCache() :
+        _nextVictimShard(0),
         _usedMemSize(0),
         _usedMemThreshold(DEFAULT_MEM_THRESHOLD * MiB), /*<< must be rewritten after config load */
         _swapNum(0),
         _loadsNum(0),
-        _genCount(0)
+        _prefetchNum(0),
+        _genCount(0),
+        _spillQueuedSize(0),
+        _running(false)
+    {
+    }
+
+    SharedMemCache::~SharedMemCache()
+    {
+    }
+
+    size_t SharedMemCache::getShardOf(LruMemChunk const* chunk)
+    {
+        // Chunks are far more than 64 bytes apart: mix the bits above
+        uint64_t const hash = (reinterpret_cast<uintptr_t>(chunk) >> 6) * 0x9E3779B97F4A7C15ULL;
+        return (hash >> 32) % NUM_SHARDS;
+    }
+
+    namespace
     {
+        /**
+         * Lock a mutex, counting the times it is found taken by another thread.
+         * The counter must be protected by the mutex.
+         */
+        class CountingMutexLock
+        {
+        public:
+            CountingMutexLock(Mutex& mutex, uint64_t& waits) : _mutex(mutex)
+            {
+                if (!_mutex.tryLock()) {
+                    _mutex.lock();
+                    ++waits;
+                }
+            }
+
+            ~CountingMutexLock()
+            {
+                _mutex.unlock();
+            }
+
+        private:
+            Mutex& _mutex;
+        };
     }
 
     /* Initialize the datastores used for the temporary disk storage needed
@@ -174,110 +227,415 @@ namespace scidb
         _usedMemThreshold = memThreshold;
         _datastores.initDataStores(basePath);
         _datastores.clearAllDataStores();
+        startBackgroundWriter();
+    }
+
+    void SharedMemCache::startBackgroundWriter()
+    {
+        ScopedMutexLock cs(_mutex);
+        if (_running) {
+            return;
+        }
+        _queue = boost::shared_ptr<JobQueue>(new JobQueue());
+        _queue->setName("memarray spill");
+        _threadPool = boost::shared_ptr<ThreadPool>(new ThreadPool(1, _queue));
+        _threadPool->start();
+        _running = true;
+        _backgroundJob.reset(new BackgroundJob(this));
+        _queue->pushJob(_backgroundJob);
+    }
+
+    void SharedMemCache::stopBackgroundWriter()
+    {
+        {
+            ScopedMutexLock cs(_mutex);
+            if (!_running) {
+                return;
+            }
+            _running = false;
+            _workEvent.signal();
+        }
+        if (!_backgroundJob->wait()) {
+            LOG4CXX_ERROR(logger, "SharedMemCache: error on stopping the background writer");
+        }
+    }
+
+    void SharedMemCache::BackgroundJob::run()
+    {
+        _cache->runBackgroundWriter();
+    }
+
+    /*
+     * The background writer runs with _mutex held, and releases it while doing I/O.
+     * A chunk in state BG_SPILLING or BG_LOADING belongs to the writer: it is neither on the LRU
+     * nor in use, and pinChunk(), deleteChunk() and cleanupArray() wait until the writer is done with it.
+     */
+    void SharedMemCache::runBackgroundWriter()
+    {
+        ScopedMutexLock cs(_mutex);
+        while (_running) {
+            if (!_spillQueue.empty()) {
+                LruMemChunk& chunk = *_spillQueue.front();
+                _spillQueue.pop_front();
+                assert(chunk._bgState == LruMemChunk::BG_SPILL_QUEUED);
+                setBackgroundState(chunk, LruMemChunk::BG_SPILLING);
+                bool written = false;
+                _mutex.unlock();
+                try {
+                    writeChunk(chunk);
+                    written = true;
+                } catch (std::exception const& e) {
+                    LOG4CXX_ERROR(logger, "SharedMemCache: failed to spill a chunk: " << e.what());
+                }
+                _mutex.lock();
+                _spillQueuedSize -= chunk.size;
+                endSpill(chunk, written);
+                _doneEvent.signal();
+            } else if (!_prefetchQueue.empty()) {
+                LruMemChunk& chunk = *_prefetchQueue.front();
+                _prefetchQueue.pop_front();
+                assert(chunk._bgState == LruMemChunk::BG_PREFETCH_QUEUED);
+                if (chunk.getData() != NULL || _usedMemSize + chunk.size > _usedMemThreshold) {
+                    setBackgroundState(chunk, LruMemChunk::BG_IDLE);
+                    continue;
+                }
+                setBackgroundState(chunk, LruMemChunk::BG_LOADING);
+                boost::shared_array<char> data;
+                _mutex.unlock();
+                try {
+                    data.reset(new char[chunk.size]);
+                    readChunk(chunk, data.get());
+                } catch (std::exception const& e) {
+                    LOG4CXX_ERROR(logger, "SharedMemCache: failed to prefetch a chunk: " << e.what());
+                    data.reset();
+                }
+                _mutex.lock();
+                {
+                    ScopedMutexLock ss(_shards[chunk._shard]._mutex);
+                    if (data) {
+                        chunk.data = data;
+                        chunk._sizeAtLastUnPin = chunk.size;
+                        __sync_add_and_fetch(&_usedMemSize, chunk.size);
+                        ++_prefetchNum;
+                        if (chunk._accessCount == 0) {
+                            chunk.pushToLru();
+                        }
+                    }
+                    chunk._bgState = LruMemChunk::BG_IDLE;
+                }
+                _doneEvent.signal();
+            } else {
+                Event::ErrorChecker noChecker;
+                _workEvent.wait(_mutex, noChecker);
+            }
+        }
+
+        // Give the queued chunks back
+        while (!_spillQueue.empty()) {
+            LruMemChunk& chunk = *_spillQueue.front();
+            _spillQueue.pop_front();
+            _spillQueuedSize -= chunk.size;
+            endSpill(chunk, false);
+        }
+        while (!_prefetchQueue.empty()) {
+            setBackgroundState(*_prefetchQueue.front(), LruMemChunk::BG_IDLE);
+            _prefetchQueue.pop_front();
+        }
+        _doneEvent.signal();
+    }
+
+    void SharedMemCache::waitForWriter()
+    {
+        // this function must be called under _mutex lock, and no shard lock
+        Event::ErrorChecker noChecker;
+        _doneEvent.wait(_mutex, noChecker);
+    }
+
+    void SharedMemCache::setBackgroundState(LruMemChunk& chunk, LruMemChunk::BackgroundState state)
+    {
+        // this function must be called under _mutex lock;
+        // the shard lock makes the state visible to the pins that do not take _mutex
+        ScopedMutexLock ss(_shards[chunk._shard]._mutex);
+        chunk._bgState = state;
+    }
+
+    void SharedMemCache::cancelBackgroundWork(LruMemChunk& chunk)
+    {
+        // this function must be called under _mutex lock, and no shard lock
+        switch (chunk._bgState) {
+        case LruMemChunk::BG_SPILL_QUEUED:
+            _spillQueue.erase(std::find(_spillQueue.begin(), _spillQueue.end(), &chunk));
+            _spillQueuedSize -= chunk.size;
+            setBackgroundState(chunk, LruMemChunk::BG_IDLE);
+            break;
+        case LruMemChunk::BG_PREFETCH_QUEUED:
+            _prefetchQueue.erase(std::find(_prefetchQueue.begin(), _prefetchQueue.end(), &chunk));
+            setBackgroundState(chunk, LruMemChunk::BG_IDLE);
+            break;
+        default:
+            while (chunk._bgState != LruMemChunk::BG_IDLE) {
+                waitForWriter();
+            }
+        }
+    }
+
+    LruMemChunk* SharedMemCache::popVictim(LruMemChunk::BackgroundState state)
+    {
+        // this function must be called under _mutex lock
+        // Take the LRU chunks of the shards in turn
+        for (size_t i = 0; i < NUM_SHARDS; ++i) {
+            Shard& shard = _shards[_nextVictimShard];
+            _nextVictimShard = (_nextVictimShard + 1) % NUM_SHARDS;
+
+            ScopedMutexLock ss(shard._mutex);
+            LruMemChunk* victim = NULL;
+            if (!shard._lru.pop(victim)) {
+                continue;
+            }
+            assert(victim!=NULL);
+            assert(victim->_accessCount == 0);
+            assert(victim->getData() != NULL);
+            assert(!victim->isEmpty());
+            victim->prune();
+            victim->_bgState = state;
+            MemArray* array = (MemArray*)victim->array;
+            if (!array->_datastore) {
+                array->_datastore = _datastores.getDataStore(_genCount++);
+            }
+            return victim;
+        }
+        return NULL;
+    }
+
+    void SharedMemCache::endSpill(LruMemChunk& chunk, bool written)
+    {
+        // this function must be called under _mutex lock
+        ScopedMutexLock ss(_shards[chunk._shard]._mutex);
+        if (written) {
+            __sync_sub_and_fetch(&_usedMemSize, chunk.size); //chunk is not pinned, so the size is correct
+            ++_swapNum;
+            chunk.free();
+        } else if (chunk._accessCount == 0) {
+            // keep the chunk in memory; it may be picked again later
+            chunk.pushToLru();
+        }
+        chunk._bgState = LruMemChunk::BG_IDLE;
+    }
+
+    void SharedMemCache::writeChunk(LruMemChunk& chunk)
+    {
+        TraceScope trace(Tracer::SPILL);
+        // Compress the image with the fastest zlib level; keep it raw if that does not pay off.
+        MemArray* array = (MemArray*)chunk.array;
+        char const* image = (char const*)chunk.getData();
+        size_t imageSize = chunk.size;
+        uLongf packedSize = compressBound(chunk.size);
+        boost::scoped_array<char> packed(new char[packedSize]);
+        if (compress2((Bytef*)packed.get(), &packedSize, (Bytef const*)image, chunk.size, Z_BEST_SPEED) == Z_OK
+            && packedSize < chunk.size) {
+            image = packed.get();
+            imageSize = packedSize;
+        }
+
+        size_t overhead = array->_datastore->getOverhead();
+        if (chunk._dsOffset < 0 || (chunk._dsAlloc - overhead < imageSize)) {
+            if (chunk._dsOffset >= 0)
+            {
+                LOG4CXX_TRACE(logger, "SharedMemCache::writeChunk : freeing chunk at offset " <<
+                              chunk._dsOffset);
+                array->_datastore->freeChunk(chunk._dsOffset, chunk._dsAlloc);
+            }
+            chunk._dsOffset = array->_datastore->allocateSpace(imageSize, chunk._dsAlloc);
+        }
+        array->_datastore->writeData(chunk._dsOffset, image, imageSize, chunk._dsAlloc);
+        chunk._dsSize = imageSize;
+        trace.setArg(imageSize);
+    }
+
+    void SharedMemCache::readChunk(LruMemChunk& chunk, char* buf)
+    {
+        TraceScope trace(Tracer::CHUNK_FETCH, chunk._dsSize, "mem cache");
+        assert(chunk._dsOffset >= 0);
+        const MemArray* array = (const MemArray*)chunk.array;
+        assert(array->_datastore);
+        if (chunk._dsSize == chunk.size) {
+            array->_datastore->readData(chunk._dsOffset, buf, chunk.size);
+            return;
+        }
+        boost::scoped_array<char> packed(new char[chunk._dsSize]);
+        array->_datastore->readData(chunk._dsOffset, packed.get(), chunk._dsSize);
+        uLongf unpackedSize = chunk.size;
+        if (uncompress((Bytef*)buf, &unpackedSize, (Bytef const*)packed.get(), chunk._dsSize) != Z_OK
+            || unpackedSize != chunk.size) {
+            throw SYSTEM_EXCEPTION(SCIDB_SE_STORAGE, SCIDB_LE_OPERATION_FAILED) << "uncompress";
+        }
     }
 
     /*
      * Some notes:
      *  The LRU contains only chunks that are currently in-memory AND not pinned (access count 0).
-     *  Invariant: if a chunk is on the LRU, its access count is 0; also if a chunk's access count is 0, it's on the LRU.
+     *  Invariant: if a chunk is on the LRU, its access count is 0; also if a chunk's access count is 0 and it is in memory,
+     *  it's on the LRU or queued for spilling.
      *  Invariant: if a chunk is on the LRU, its size equals _sizeAtLastUnPin.
      *  If a chunk is pinned, it could be accessed, or modified. We know nothing about its real "size". We only know "_sizeAtLastUnPin".
-     *  _usedMemSize is the sum of the sizes of all the pinned chunks AND all the chunks on the LRU.
+     *  _usedMemSize is the sum of the sizes of all the pinned chunks, all the chunks on the LRU and all the chunks
+     *  queued for spilling.
      * -AP 1/30/13
+     *
+     *  The access count, the LRU position and _sizeAtLastUnPin of a chunk are protected by the mutex of its shard.
+     *  Its data (while not pinned) and its background state only change under both _mutex and the shard mutex,
+     *  so the pin of a chunk in memory and without background work only needs the shard mutex.
      */
 
     void SharedMemCache::pinChunk(LruMemChunk &chunk)
     {
-        ScopedMutexLock cs(_mutex);
-        if (chunk._accessCount++ == 0) {
-            chunk._sizeAtLastUnPin = chunk.size;  //mostly redundant. just in case someone is doing something clever
-            if (chunk.getData() == NULL) {
-                if (_usedMemSize > _usedMemThreshold) {
-                    swapOut();
-                }
-                if (chunk.size != 0) {
-                    assert(chunk._dsOffset >= 0);
-                    chunk.data.reset(new char[chunk.size]);
-                    if (!chunk.getData())
-                        throw SYSTEM_EXCEPTION(SCIDB_SE_NO_MEMORY, SCIDB_LE_CANT_ALLOCATE_MEMORY);
-                    const MemArray* array = (const MemArray*)chunk.array;
-                    assert(array->_datastore);
-                    array->_datastore->readData(chunk._dsOffset, chunk.getData(), chunk.size);
-                    ++_loadsNum;
-                    _usedMemSize += chunk.size;
-                }
-            } else {
-                assert(!chunk.isEmpty());
+        Shard& shard = _shards[chunk._shard];
+        {
+            CountingMutexLock ss(shard._mutex, shard._lockWaits);
+            if (chunk._accessCount > 0) {
+                ++chunk._accessCount;
+                return;
+            }
+            ++shard._pins;
+            if (chunk._bgState == LruMemChunk::BG_IDLE && (chunk.getData() != NULL || chunk.size == 0)) {
+                ++chunk._accessCount;
+                chunk._sizeAtLastUnPin = chunk.size;  //mostly redundant. just in case someone is doing something clever
                 chunk.removeFromLru();
+                return;
             }
+            ++shard._slowPins;
+        }
+
+        // The chunk is swapped out or the background writer has it
+        CountingMutexLock cs(_mutex, shard._cacheLockWaits);
+        if (chunk.getData() == NULL && _usedMemSize > _usedMemThreshold) {
+            swapOut();
+        }
+        cancelBackgroundWork(chunk);
+        boost::shared_array<char> data;
+        if (chunk.getData() == NULL && chunk.size != 0) {
+            // nobody else can pin the chunk until it is in memory: they need _mutex
+            assert(chunk._dsOffset >= 0);
+            data.reset(new char[chunk.size]);
+            readChunk(chunk, data.get());
+            ++_loadsNum;
+            __sync_add_and_fetch(&_usedMemSize, chunk.size);
+        }
+        ScopedMutexLock ss(shard._mutex);
+        if (data) {
+            chunk.data = data;
+        }
+        if (chunk._accessCount++ == 0) {
+            chunk._sizeAtLastUnPin = chunk.size;
+            // off the LRU already if it was queued for spilling or prefetched while being pinned
+            chunk.removeFromLru();
         }
     }
 
     void SharedMemCache::unpinChunk(LruMemChunk &chunk)
     {
-        ScopedMutexLock cs(_mutex);
-        assert(chunk._accessCount > 0);
-        if (--chunk._accessCount == 0) {
+        Shard& shard = _shards[chunk._shard];
+        uint64_t usedMemSize = 0;
+        {
+            CountingMutexLock ss(shard._mutex, shard._lockWaits);
+            assert(chunk._accessCount > 0);
+            if (--chunk._accessCount != 0) {
+                return;
+            }
             //if chunk was changed, its size could be different
             //subtract OLD size and add NEW size to _usedMemSize to account for the delta
-            assert(_usedMemSize >= chunk._sizeAtLastUnPin);
-            _usedMemSize -= chunk._sizeAtLastUnPin;
             if (chunk.getData() == NULL)
             {
                 assert(chunk.size == 0);
+                __sync_sub_and_fetch(&_usedMemSize, chunk._sizeAtLastUnPin);
                 chunk._sizeAtLastUnPin = 0;
+                return;
             }
-            else
-            {
-                _usedMemSize += chunk.size;
-                chunk._sizeAtLastUnPin = chunk.size;
-                assert(chunk.isEmpty());
-                chunk.pushToLru();
-                if (_usedMemSize > _usedMemThreshold) {
-                    swapOut();
-                }
+            usedMemSize = __sync_add_and_fetch(&_usedMemSize, chunk.size - chunk._sizeAtLastUnPin);
+            chunk._sizeAtLastUnPin = chunk.size;
+            assert(chunk.isEmpty());
+            chunk.pushToLru();
+        }
+        if (usedMemSize > _usedMemThreshold) {
+            CountingMutexLock cs(_mutex, shard._cacheLockWaits);
+            if (_usedMemSize > _usedMemThreshold) {
+                swapOut();
             }
         }
     }
 
     void SharedMemCache::swapOut()
     {
-        // this function must be called under _mutex lock
-        while (!_theLru.empty() && _usedMemSize > _usedMemThreshold) {
-
+        // this function must be called under _mutex lock, and no shard lock
+        if (!_running) {
+            // no background writer: spill synchronously
             LruMemChunk* victim = NULL;
-            bool popped = _theLru.pop(victim);
-            SCIDB_ASSERT(popped);
-            assert(victim!=NULL);
-            assert(victim->_accessCount == 0);
-            assert(victim->getData() != NULL);
-            assert(!victim->isEmpty());
-            victim->prune();
-            _usedMemSize -= victim->size; //victim is not pinned, so the size is correct
-            MemArray* array = (MemArray*)victim->array;
-            if (!array->_datastore) {
-                array->_datastore = _datastores.getDataStore(_genCount++);
-            }
-            size_t overhead = array->_datastore->getOverhead();
-            if (victim->_dsOffset < 0 || (victim->_dsAlloc - overhead < victim->size)) {
-                if (victim->_dsOffset >= 0)
-                {
-                    LOG4CXX_TRACE(logger, "SharedMemCache::swapOut : freeing chunk at offset " << 
-                                  victim->_dsOffset);
-                    array->_datastore->freeChunk(victim->_dsOffset, victim->_dsAlloc);
+            while (_usedMemSize > _usedMemThreshold
+                   && (victim = popVictim(LruMemChunk::BG_SPILLING)) != NULL) {
+                try {
+                    writeChunk(*victim);
+                } catch (Exception const&) {
+                    endSpill(*victim, false);
+                    throw;
                 }
-                victim->_dsOffset = array->_datastore->allocateSpace(victim->size, victim->_dsAlloc);
+                endSpill(*victim, true);
             }
-            array->_datastore->writeData(victim->_dsOffset, victim->getData(), victim->size, victim->_dsAlloc);
-            ++_swapNum;
-            victim->free();
+            SCIDB_ASSERT(sizeCoherent());
+            return;
+        }
+
+        // Queue LRU chunks until the cache will be down to the low watermark once they are written
+        uint64_t const lowWatermark = _usedMemThreshold / 100 * SPILL_LOW_WATERMARK_PERCENT;
+        LruMemChunk* victim = NULL;
+        while (_usedMemSize > _spillQueuedSize + lowWatermark
+               && (victim = popVictim(LruMemChunk::BG_SPILL_QUEUED)) != NULL) {
+            _spillQueue.push_back(victim);
+            _spillQueuedSize += victim->size; //victim is not pinned, so the size is correct
+        }
+        if (!_spillQueue.empty()) {
+            _workEvent.signal();
+        }
+
+        // Only wait for the writer when it falls too far behind
+        uint64_t const highWatermark = _usedMemThreshold / 100 * SPILL_HIGH_WATERMARK_PERCENT;
+        while (_usedMemSize > highWatermark && _spillQueuedSize != 0) {
+            waitForWriter();
         }
         SCIDB_ASSERT(sizeCoherent());
     }
 
+    bool SharedMemCache::isPrefetchable(LruMemChunk const& chunk) const
+    {
+        // must be called under the shard lock of the chunk
+        return _running && chunk._bgState == LruMemChunk::BG_IDLE && chunk._accessCount == 0
+            && chunk.getData() == NULL && chunk.size != 0 && chunk._dsOffset >= 0
+            && _usedMemSize + chunk.size <= _usedMemThreshold;
+    }
+
+    void SharedMemCache::prefetchChunk(LruMemChunk& chunk)
+    {
+        Shard& shard = _shards[chunk._shard];
+        {
+            // The next chunk of a scan is usually in memory: do not take _mutex for it
+            CountingMutexLock ss(shard._mutex, shard._lockWaits);
+            if (!isPrefetchable(chunk)) {
+                return;
+            }
+        }
+        CountingMutexLock cs(_mutex, shard._cacheLockWaits);
+        ScopedMutexLock ss(shard._mutex);
+        if (isPrefetchable(chunk)) {
+            chunk._bgState = LruMemChunk::BG_PREFETCH_QUEUED;
+            _prefetchQueue.push_back(&chunk);
+            _workEvent.signal();
+        }
+    }
+
     void SharedMemCache::deleteChunk(LruMemChunk &chunk)
     {
         ScopedMutexLock cs(_mutex);
+        cancelBackgroundWork(chunk);
+        ScopedMutexLock ss(_shards[chunk._shard]._mutex);
         assert(chunk._accessCount == 0);
         chunk.removeFromLru();
     }
@@ -286,11 +644,16 @@ namespace scidb
     {
         ScopedMutexLock cs(_mutex);
         for (map<Address, LruMemChunk>::iterator i = array._chunks.begin(); i != array._chunks.end(); i++)
+        {
+            cancelBackgroundWork(i->second);
+        }
+        for (map<Address, LruMemChunk>::iterator i = array._chunks.begin(); i != array._chunks.end(); i++)
         {
             LruMemChunk &chunk = i->second;
+            ScopedMutexLock ss(_shards[chunk._shard]._mutex);
             if (chunk.getData() != NULL) {
                 //chunk could be pinned or just on the LRU.
-                _usedMemSize -= chunk._sizeAtLastUnPin;
+                __sync_sub_and_fetch(&_usedMemSize, chunk._sizeAtLastUnPin);
             }
             if (chunk._accessCount > 0) {
                 LOG4CXX_DEBUG(logger, "Warning: accessCount is " << chunk._accessCount
@@ -312,15 +675,38 @@ namespace scidb
         }
     }
 
+    void SharedMemCache::listShards(boost::function<void (ShardStatistics const&)>& f)
+    {
+        ScopedMutexLock cs(_mutex);
+        for (size_t i = 0; i < NUM_SHARDS; ++i) {
+            Shard& shard = _shards[i];
+            ShardStatistics stats;
+            {
+                ScopedMutexLock ss(shard._mutex);
+                stats.shard = i;
+                stats.lruChunks = shard._lru.size();
+                stats.pins = shard._pins;
+                stats.slowPins = shard._slowPins;
+                stats.lockWaits = shard._lockWaits;
+                stats.cacheLockWaits = shard._cacheLockWaits;
+            }
+            f(stats);
+        }
+    }
+
     uint64_t SharedMemCache::computeSizeOfLRU()
     {
-        list<LruMemChunk*>::iterator iter = _theLru.begin();
         size_t res = 0;
-        while (iter != _theLru.end())
+        for (size_t i = 0; i < NUM_SHARDS; ++i)
         {
-            LruMemChunk* ch = (*iter);
-            res += ch->_sizeAtLastUnPin;
-            ++iter;
+            ScopedMutexLock ss(_shards[i]._mutex);
+            list<LruMemChunk*>::iterator iter = _shards[i]._lru.begin();
+            while (iter != _shards[i]._lru.end())
+            {
+                LruMemChunk* ch = (*iter);
+                res += ch->_sizeAtLastUnPin;
+                ++iter;
+            }
         }
         return res;
     }
@@ -375,6 +761,13 @@ namespace scidb
         position();
         ++curr;
         setCurrent();
+        if (currChunk) {
+            // A sequential scan: have the next chunk of the attribute read back ahead of use
+            map<Address, LruMemChunk>::iterator next = curr;
+            if (++next != last && next->second.addr.attId == addr.attId) {
+                SharedMemCache::getInstance().prefetchChunk(next->second);
+            }
+        }
     }
 
     Coordinates const& MemArrayIterator::getPosition()
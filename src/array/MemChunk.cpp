@@ -415,14 +415,33 @@ namespace scidb
     //
     // LruMemChunk
     //
-    LruMemChunk::LruMemChunk(): _whereInLru(SharedMemCache::getLru().end())
+    LruMemChunk::LruMemChunk():
+        _shard(SharedMemCache::getShardOf(this)),
+        _whereInLru(SharedMemCache::getLru(_shard).end())
     {
         _dsOffset = -1;
         _dsAlloc = 0;
+        _dsSize = 0;
+        _bgState = BG_IDLE;
         _accessCount = 0;
         _sizeAtLastUnPin = 0;
     }
 
+    LruMemChunk::LruMemChunk(LruMemChunk const& other):
+        MemChunk(other),
+        _shard(SharedMemCache::getShardOf(this)),
+        _whereInLru(SharedMemCache::getLru(_shard).end())
+    {
+        assert(other.isEmpty());
+        assert(other._accessCount == 0);
+        _dsOffset = other._dsOffset;
+        _dsAlloc = other._dsAlloc;
+        _dsSize = other._dsSize;
+        _bgState = BG_IDLE;
+        _accessCount = 0;
+        _sizeAtLastUnPin = other._sizeAtLastUnPin;
+    }
+
     LruMemChunk::~LruMemChunk()
     {
         // If exception is raised during update of array, then access counter may be non zero
@@ -431,26 +450,26 @@ namespace scidb
     }
 
     bool LruMemChunk::isEmpty() const {
-        return _whereInLru == SharedMemCache::getLru().end();
+        return _whereInLru == SharedMemCache::getLru(_shard).end();
     }
 
     /**
      * Take a note that this LruMemChunk has been removed from the Lru.
      */
     void LruMemChunk::prune() {
-        _whereInLru = SharedMemCache::getLru().end();
+        _whereInLru = SharedMemCache::getLru(_shard).end();
     }
 
     void LruMemChunk::removeFromLru() {
         if (!isEmpty()) {
-            SharedMemCache::getLru().erase(_whereInLru);
+            SharedMemCache::getLru(_shard).erase(_whereInLru);
             prune();
         }
     }
 
     void LruMemChunk::pushToLru() {
         assert(isEmpty());
-        _whereInLru = SharedMemCache::getLru().push(this);
+        _whereInLru = SharedMemCache::getLru(_shard).push(this);
     }
 
     bool LruMemChunk::isTemporary() const
@@ -2014,8 +2033,8 @@ RLEConstChunkIterator::RLEConstChunkIterator(ArrayDesc const& desc,
             }
         }
         falseValue.setBool(false);
+        trueValue.setBool(true);
         if (bitmap != NULL && !(iterationMode & NO_EMPTY_CHECK)) {
-            trueValue.setBool(true);
             bitmap->pin();
             mode &= ~TILE_MODE;
             emptyChunkIterator = bitmap->getIterator(query, mode);
@@ -2132,6 +2151,44 @@ RLEConstChunkIterator::RLEConstChunkIterator(ArrayDesc const& desc,
         }
     }
 
+    void RLEChunkIterator::writeItems(position_t start, size_t count, void const* values, uint8_t const* nulls)
+    {
+        // Only a sequential writer of fixed size, non-boolean values (or of the empty bitmap)
+        // can feed the appender directly; everything else goes cell by cell.
+        if ((mode & (TILE_MODE|SEQUENTIAL_WRITE)) != SEQUENTIAL_WRITE
+            || (!isEmptyIndicator && (type.variableSize() || type.bitSize() <= 1))) {
+            ChunkIterator::writeItems(start, count, values, nulls);
+            return;
+        }
+        if (count == 0) {
+            return;
+        }
+        ASSERT_EXCEPTION(start >= prevPos && static_cast<uint64_t>(start) + count <= _logicalChunkSize,
+                         "It is an internal bug in the system that the SEQUENTIAL_WRITE rule is violated.");
+        if (isEmptyIndicator) {
+            if (start != prevPos) {
+                appender.add(falseValue, start - prevPos);
+            }
+            appender.add(trueValue, count);
+        } else {
+            if (nulls != NULL && !attr.isNullable()) {
+                for (size_t i = 0; i < count; i++) {
+                    if (nulls[i]) {
+                        throw USER_EXCEPTION(SCIDB_SE_EXECUTION, SCIDB_LE_ASSIGNING_NULL_TO_NON_NULLABLE);
+                    }
+                }
+            }
+            if (!isEmptyable && start != prevPos) {
+                appender.add(defaultValue, start - prevPos);
+            }
+            appender.add(static_cast<char const*>(values), nulls, count);
+        }
+        prevPos = start + count;
+        if (emptyChunkIterator) {
+            emptyChunkIterator->writeItems(start, count, NULL, NULL);
+        }
+    }
+
     void RLEChunkIterator::flush()
     {
         _needsFlush = false;
@@ -2054,6 +2054,61 @@ uint64_t RLEPayload::append_iterator::add(iterator& ii, uint64_t limit, bool set
         }
     }
 
+    void RLEPayload::append_iterator::add(char const* values, uint8_t const* nulls, uint64_t count)
+    {
+        size_t const size = result->_elemSize;
+        assert(!result->_isBoolean && size != 0);
+        Value item;
+        uint64_t i = 0;
+        while (i < count) {
+            uint64_t j = i + 1;
+            if (nulls != NULL && nulls[i]) {
+                while (j < count && nulls[j]) {
+                    j += 1;
+                }
+                item.setNull();
+                add(item, j - i);
+                i = j;
+                continue;
+            }
+            char const* v = values + i*size;
+            while (j < count && !(nulls != NULL && nulls[j]) && memcmp(v, values + j*size, size) == 0) {
+                j += 1;
+            }
+            item.setData(v, size);
+            add(item, j - i);
+            i = j;
+
+            // Extend with values which differ from their successor: the first of them
+            // differs from *prevVal as well, so they can be appended to a non-same segment as is.
+            while (j < count && !(nulls != NULL && nulls[j])
+                   && (j + 1 == count || (nulls != NULL && nulls[j+1])
+                       || memcmp(values + j*size, values + (j+1)*size, size) != 0)) {
+                j += 1;
+            }
+            if (j == i) {
+                continue;
+            }
+            uint64_t const n = j - i;
+            if (segm._same && segLength > 1) {
+                result->addSegment(segm);
+                segm._pPosition += segLength;
+                segLength = 0;
+                segm._same = (n == 1);
+                segm._valueIndex = valueIndex;
+            } else {
+                segm._same = false;
+            }
+            segLength += n;
+            valueIndex += n;
+            result->_data.resize(result->_dataSize + n*size);
+            memcpy(&result->_data[result->_dataSize], values + i*size, n*size);
+            result->_dataSize += n*size;
+            prevVal->setData(values + (j-1)*size, size);
+            i = j;
+        }
+    }
+
     RLEPayload::append_iterator::~append_iterator()
     {
         delete prevVal;
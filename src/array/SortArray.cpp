@@ -322,7 +322,7 @@ namespace scidb {
         // Init config parameters
         size_t numJobs = inputArray->getSupportedAccess() == Array::RANDOM ?
 	  Config::getInstance()->getOption<int>(CONFIG_PREFETCHED_CHUNKS) : 1;
-        _memLimit = Config::getInstance()->getOption<int>(CONFIG_MERGE_SORT_BUFFER)*MiB;
+        _memLimit = query->getSpillThreshold(Config::getInstance()->getOption<int>(CONFIG_MERGE_SORT_BUFFER)*MiB);
         _nStreams = Config::getInstance()->getOption<int>(CONFIG_MERGE_SORT_NSTREAMS);
         _pipelineLimit = Config::getInstance()->getOption<int>(CONFIG_MERGE_PIPELINE_LIMIT);
 
@@ -180,12 +180,28 @@ public:
         }
     }
 
-    void prepareQuery(const std::string& queryString, bool afl, const std::string&, QueryResult& queryResult, void* connection) const
+    static void setParameters(scidb_msg::Query& record, const QueryParameters& parameters)
+    {
+        for (QueryParameters::const_iterator i = parameters.begin(); i != parameters.end(); ++i)
+        {
+            scidb_msg::Query_Parameter* parameter = record.add_parameters();
+            parameter->set_name(i->first);
+            parameter->set_value(i->second);
+        }
+    }
+
+    void prepareQuery(const std::string& queryString, bool afl, const std::string& programOptions, QueryResult& queryResult, void* connection) const
+    {
+        prepareQuery(queryString, afl, programOptions, QueryParameters(), queryResult, connection);
+    }
+
+    void prepareQuery(const std::string& queryString, bool afl, const std::string&, const QueryParameters& parameters, QueryResult& queryResult, void* connection) const
     {
         StatisticsScope sScope;
         boost::shared_ptr<MessageDesc> queryMessage = boost::make_shared<MessageDesc>(mtPrepareQuery);
         queryMessage->getRecord<scidb_msg::Query>()->set_query(queryString);
         queryMessage->getRecord<scidb_msg::Query>()->set_afl(afl);
+        setParameters(*queryMessage->getRecord<scidb_msg::Query>(), parameters);
 
         std::string programOptions;
         fillProgramOptions(programOptions);
@@ -322,6 +338,7 @@ public:
             queryResult.executionTime = queryResultRecord->execution_time();
             queryResult.explainLogical = queryResultRecord->explain_logical();
             queryResult.explainPhysical = queryResultRecord->explain_physical();
+            queryResult.explainAnalyze = queryResultRecord->explain_analyze();
 
             const ArrayDesc arrayDesc(queryResultRecord->array_name(), attributes, dimensions);
 
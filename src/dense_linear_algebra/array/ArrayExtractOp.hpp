@@ -30,6 +30,7 @@
 // C++
 #include <limits>
 #include <sstream>
+#include <vector>
 
 // boost
 #include <boost/shared_ptr.hpp>
@@ -54,7 +55,15 @@ static log4cxx::LoggerPtr extractOpLogger(log4cxx::Logger::getLogger("scidb.libd
 /// but adds a template parameter abstracting what is to be done with the data, and drops the memory pointer.
 /// In theory, Array::extractData() could be implemented using this template.
 ///
-/// This implementation uses the new tile iterator paradigm, rather than directly accessing the many
+/// Each chunk is gathered into a dense, row-major buffer and handed to the ExtractOp_tt in one call,
+/// ExtractOp_tt::copyBlock(buffer, stride, firstRow, firstCol, nRows, nCols), between blockBegin() and blockEnd().
+/// Cells absent from the chunk are passed as zero.
+/// The buffer is filled by the cheapest means the chunk allows:
+/// - plain (non-RLE, non-sparse, non-emptyable, non-nullable) chunks not clipped by the end of the array
+///   are passed without a copy;
+/// - tiles whose values cover a contiguous run of cells are copied value by value, without decoding coordinates;
+/// - other tiles are scattered cell by cell.
+/// The tiles use the new tile iterator paradigm, rather than directly accessing the many
 /// possible formats of chunk that could be passed to the function.
 
 template<class ExtractOp_tt>
@@ -88,7 +97,12 @@ void extractDataToOp(shared_ptr<scidb::Array> array, scidb::AttributeID attrID,
         throw USER_EXCEPTION(scidb::SCIDB_SE_EXECUTION, scidb::SCIDB_LE_WRONG_ATTRIBUTE_TYPE); // TODO: really WRONG_ATTRIBUTE_SIZE
     }
 
+    // chunks whose data is a plain row-major matrix of values, like those Array::extractData() copies directly
+    const bool maybePlain = !attrDesc.isNullable() &&
+                            arrayDesc.getEmptyBitmapAttribute() == NULL &&
+                            dims[0].getChunkOverlap() == 0 && dims[1].getChunkOverlap() == 0;
 
+    std::vector<Value_t> chunkValues; // reused for all chunks
 
     boost::shared_ptr<scidb::ConstArrayIterator> chunksIt;
     for(chunksIt = array->getConstIterator(/*attrid*/0); ! chunksIt->end(); ++(*chunksIt) ) {
@@ -97,6 +111,25 @@ void extractDataToOp(shared_ptr<scidb::Array> array, scidb::AttributeID attrID,
         scidb::ConstChunk const& chunk = chunksIt->getChunk();
         scidb::Coordinates chunkOrigin(2); chunkOrigin = chunk.getFirstPosition(false);
         scidb::Coordinates chunkLast(2); chunkLast = chunk.getLastPosition(false);
+        const size_t nRows = chunkLast[0] - chunkOrigin[0] + 1;
+        const size_t nCols = chunkLast[1] - chunkOrigin[1] + 1;
+
+        // Like Array::extractData(), only a whole chunk is copied directly: the data of a chunk
+        // clipped by the end of the array need not be laid out over the whole chunk interval
+        const bool wholeChunk = nRows == size_t(dims[0].getChunkInterval()) &&
+                                nCols == size_t(dims[1].getChunkInterval());
+        if (maybePlain && wholeChunk && !chunk.isRLE() && !chunk.isSparse() &&
+            chunk.getSize() >= nRows * nCols * sizeof(Value_t)) {
+            // the chunk data is already a row-major matrix
+            PinBuffer scope(chunk);
+            extractOp.blockBegin();
+            extractOp.copyBlock(reinterpret_cast<const Value_t*>(chunk.getData()), nCols,
+                                chunkOrigin[0], chunkOrigin[1], nRows, nCols);
+            extractOp.blockEnd();
+            continue;
+        }
+
+        chunkValues.assign(nRows * nCols, Value_t(0));
 
         shared_ptr<ConstChunkIterator> itChunk = chunk.getConstIterator();
         if( !dynamic_cast<RLETileConstChunkIterator*>(itChunk.get()) &&
@@ -113,7 +146,6 @@ void extractDataToOp(shared_ptr<scidb::Array> array, scidb::AttributeID attrID,
         // use about 1/2 of L1, the other half is for the destination
         const size_t MAX_VALUES_TO_GET = Sysinfo::INTEL_L1_DATA_CACHE_BYTES/2/sizeof(Value_t);
 
-        extractOp.blockBegin();
         // for all non-zeros in chunk (memory is already zeroed)
         Coordinates coords(2);
         for (position_t offset = itChunk->getLogicalPosition(); offset >= 0; ) {
@@ -141,19 +173,38 @@ void extractDataToOp(shared_ptr<scidb::Array> array, scidb::AttributeID attrID,
             assert(coordTileTyped->size() == tileCoords->size());
             assert(dataTyped->size() == tileData->size());
 
-            for (size_t i=0, n=coordTileTyped->size(); i < n; ++i, ++dataIter) {
-                assert(dataIter != dataTyped->end());
-                if(dataIter.isNull()) {
-                    throw USER_EXCEPTION(scidb::SCIDB_SE_EXECUTION, scidb::SCIDB_LE_CANT_CONVERT_NULL);
+            const size_t n = coordTileTyped->size();
+
+            // cells are in row-major order, so the tile covers a contiguous run of the chunk
+            // exactly when its first and last cells are n-1 cells apart
+            coordTileTyped->at(0, coords);
+            const size_t firstIndex = (coords[0] - chunkOrigin[0]) * nCols + (coords[1] - chunkOrigin[1]);
+            coordTileTyped->at(n-1, coords);
+            const size_t lastIndex = (coords[0] - chunkOrigin[0]) * nCols + (coords[1] - chunkOrigin[1]);
+
+            if (lastIndex - firstIndex == n - 1) {
+                Value_t* dst = &chunkValues[firstIndex];
+                for (size_t i=0; i < n; ++i, ++dataIter) {
+                    assert(dataIter != dataTyped->end());
+                    if(dataIter.isNull()) {
+                        throw USER_EXCEPTION(scidb::SCIDB_SE_EXECUTION, scidb::SCIDB_LE_CANT_CONVERT_NULL);
+                    }
+                    dst[i] = (*dataIter);
+                }
+            } else {
+                for (size_t i=0; i < n; ++i, ++dataIter) {
+                    assert(dataIter != dataTyped->end());
+                    if(dataIter.isNull()) {
+                        throw USER_EXCEPTION(scidb::SCIDB_SE_EXECUTION, scidb::SCIDB_LE_CANT_CONVERT_NULL);
+                    }
+                    coordTileTyped->at(i,coords);
+                    assert(coords.size()==2);
+                    chunkValues[(coords[0] - chunkOrigin[0]) * nCols + (coords[1] - chunkOrigin[1])] = (*dataIter);
                 }
-
-                const Value_t val = (*dataIter);
-
-                coordTileTyped->at(i,coords);
-                assert(coords.size()==2);
-                extractOp(val, coords[0], coords[1]);
             }
         }
+        extractOp.blockBegin();
+        extractOp.copyBlock(&chunkValues[0], nCols, chunkOrigin[0], chunkOrigin[1], nRows, nCols);
         extractOp.blockEnd();
     }
 }
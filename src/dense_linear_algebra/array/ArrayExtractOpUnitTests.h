@@ -0,0 +1,201 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/*
+ * @file ArrayExtractOpUnitTests.h
+ *
+ * @brief Tests of extractDataToOp(), the chunk-at-a-time copy of a matrix to ScaLAPACK.
+ */
+
+#ifndef ARRAY_EXTRACT_OP_UNIT_TESTS_H_
+#define ARRAY_EXTRACT_OP_UNIT_TESTS_H_
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "array/MemArray.h"
+#include "array/Metadata.h"
+#include "query/Query.h"
+#include "system/Cluster.h"
+
+using namespace boost;
+using namespace scidb;
+
+#include "dense_linear_algebra/array/ArrayExtractOp.hpp"
+
+class ArrayExtractOpTests: public CppUnit::TestFixture
+{
+CPPUNIT_TEST_SUITE(ArrayExtractOpTests);
+CPPUNIT_TEST(testPlainChunks);
+CPPUNIT_TEST(testRLEChunks);
+CPPUNIT_TEST_SUITE_END();
+
+private:
+    enum
+    {
+        ROWS = 10,
+        COLS = 7,           // neither size is a multiple of the chunk interval
+        CHUNK = 4
+    };
+
+    boost::shared_ptr<Query> _query;
+
+    /**
+     * An ExtractOp_tt which copies the blocks into a ROWS x COLS row-major matrix,
+     * checking that every cell is copied once.
+     */
+    class MatrixOp
+    {
+    public:
+        MatrixOp() : values(ROWS * COLS, -1), copies(ROWS * COLS, 0), _inBlock(false) {}
+
+        void blockBegin()
+        {
+            CPPUNIT_ASSERT(!_inBlock);
+            _inBlock = true;
+        }
+
+        void blockEnd()
+        {
+            CPPUNIT_ASSERT(_inBlock);
+            _inBlock = false;
+        }
+
+        void copyBlock(const double* src, size_t srcStride, int64_t row, int64_t col, size_t nRows, size_t nCols)
+        {
+            CPPUNIT_ASSERT(_inBlock);
+            CPPUNIT_ASSERT(srcStride >= nCols);
+            CPPUNIT_ASSERT(row + nRows <= size_t(ROWS) && col + nCols <= size_t(COLS));
+            for (size_t r = 0; r < nRows; r++) {
+                for (size_t c = 0; c < nCols; c++) {
+                    size_t const cell = (row + r) * COLS + col + c;
+                    values[cell] = src[r * srcStride + c];
+                    copies[cell]++;
+                }
+            }
+        }
+
+        std::vector<double> values;
+        std::vector<int> copies;
+
+    private:
+        bool _inBlock;
+    };
+
+    static double valueAt(Coordinate row, Coordinate col)
+    {
+        return double(row * 100 + col);
+    }
+
+    /**
+     * @return a ROWS x COLS matrix of valueAt(), in plain or RLE chunks
+     */
+    boost::shared_ptr<Array> makeMatrix(bool rle)
+    {
+        Attributes attrs(1);
+        attrs[0] = AttributeDesc(0, "v", TID_DOUBLE, 0, 0);
+        Dimensions dims(2);
+        dims[0] = DimensionDesc("r", 0, ROWS - 1, CHUNK, 0);
+        dims[1] = DimensionDesc("c", 0, COLS - 1, CHUNK, 0);
+        boost::shared_ptr<MemArray> array(new MemArray(ArrayDesc("matrix", attrs, dims), _query));
+
+        boost::shared_ptr<ArrayIterator> arrayIterator = array->getIterator(0);
+        Coordinates chunkPos(2);
+        Coordinates pos(2);
+        Value value(TypeLibrary::getType(TID_DOUBLE));
+        for (chunkPos[0] = 0; chunkPos[0] < ROWS; chunkPos[0] += CHUNK) {
+            for (chunkPos[1] = 0; chunkPos[1] < COLS; chunkPos[1] += CHUNK) {
+                Chunk& chunk = arrayIterator->newChunk(chunkPos);
+                chunk.setRLE(rle);
+                boost::shared_ptr<ChunkIterator> chunkIterator =
+                    chunk.getIterator(_query, ChunkIterator::SEQUENTIAL_WRITE | ChunkIterator::NO_EMPTY_CHECK);
+                for (pos[0] = chunkPos[0]; pos[0] < std::min<Coordinate>(chunkPos[0] + CHUNK, ROWS); pos[0]++) {
+                    for (pos[1] = chunkPos[1]; pos[1] < std::min<Coordinate>(chunkPos[1] + CHUNK, COLS); pos[1]++) {
+                        value.setDouble(valueAt(pos[0], pos[1]));
+                        CPPUNIT_ASSERT(chunkIterator->setPosition(pos));
+                        chunkIterator->writeItem(value);
+                    }
+                }
+                chunkIterator->flush();
+                CPPUNIT_ASSERT(chunk.isRLE() == rle);
+            }
+        }
+        return array;
+    }
+
+    void checkExtract(bool rle)
+    {
+        boost::shared_ptr<Array> matrix = makeMatrix(rle);
+        Coordinates first(2, 0);
+        Coordinates last(2);
+        last[0] = ROWS - 1;
+        last[1] = COLS - 1;
+        MatrixOp op;
+        extractDataToOp(matrix, 0, first, last, op, _query);
+        for (Coordinate r = 0; r < ROWS; r++) {
+            for (Coordinate c = 0; c < COLS; c++) {
+                CPPUNIT_ASSERT(op.copies[r * COLS + c] == 1);
+                CPPUNIT_ASSERT(op.values[r * COLS + c] == valueAt(r, c));
+            }
+        }
+    }
+
+public:
+    void setUp()
+    {
+        boost::shared_ptr<const InstanceLiveness> liveness(Cluster::getInstance()->getInstanceLiveness());
+        int32_t longErrorCode = SCIDB_E_NO_ERROR;
+        _query = Query::createFakeQuery(0, 0, liveness, &longErrorCode);
+        if (longErrorCode != SCIDB_E_NO_ERROR &&
+            longErrorCode != SCIDB_LE_INVALID_FUNCTION_ARGUMENT) {
+            // NetworkManager::createWorkQueue() may complain about a null queue,
+            // which does not matter since the network is not used
+            throw SYSTEM_EXCEPTION(SCIDB_LE_UNKNOWN_ERROR, longErrorCode);
+        }
+    }
+
+    void tearDown()
+    {
+        Query::destroyFakeQuery(_query.get());
+        _query.reset();
+    }
+
+    /// Whole plain chunks are copied from their data, the edge chunks cell by cell
+    void testPlainChunks()
+    {
+        checkExtract(false);
+    }
+
+    /// RLE chunks are copied a tile at a time
+    void testRLEChunks()
+    {
+        checkExtract(true);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ArrayExtractOpTests);
+
+#endif /* ARRAY_EXTRACT_OP_UNIT_TESTS_H_ */
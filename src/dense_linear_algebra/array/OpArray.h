@@ -56,8 +56,8 @@ static log4cxx::LoggerPtr OP_ARRAY_logger(log4cxx::Logger::getLogger("scidb.line
  *  This template class takes an template operand Op_tt, which
  *  represents a function f(coord), and turn it into an Array
  *  which generates dense chunks by calling the function.
- *  When Op_tt::operator()(row, col) is inline, this is extremely efficient.
- *  [There is also an Op_tt::operator()(index) 1D case]
+ *  Matrix chunks are filled by one call to Op_tt::getBlock(row, col, nRows, nCols, out),
+ *  which fills 'out' row-major; vector chunks by Op_tt::operator()(index) per cell.
  *
  *  It is implemented as a thin wrapper over SplitArray, by overriding
  *  SplitArray::ArrayIterator::getChunk() to fill the values of the chunk
@@ -265,9 +265,11 @@ ConstChunk const& OpArray<Op_tt>::ArrayIterator::getChunk()
                                    << ")"<< std::endl;
         }
 
-        // temporaries to use the chunkIter->setPostion(), value.setDouble() and chunkIter->writeItem() API
+        // each row of the chunk is generated into 'values' and handed to chunkIter->writeItems()
+        // as one run of consecutive positions
+        CoordinatesMapper mapper(chunk);
         Coordinates pos = first;
-        Value value;
+        std::vector<double> values(std::max(colCount, int64_t(1)));
 
         if (nDims==1) {
             if(DBG >= DBG_DETAIL) std::cerr << dbgPrefix << " case nDims 1" << std::endl;
@@ -283,8 +285,10 @@ ConstChunk const& OpArray<Op_tt>::ArrayIterator::getChunk()
                     std::cerr << dbgPrefix << "  ["<< col << "]"
                               << " -> val: " << val << std::endl ;
                 }
-                pos[0] = col ; chunkIter->setPosition(pos);
-                value.setDouble(val); chunkIter->writeItem(value);
+                values[col - first[0]] = val;
+            }
+            if (colCount > 0) {
+                chunkIter->writeItems(mapper.coord2pos(pos), colCount, &values[0], NULL);
             }
         } else {
             assert(nDims==2);
@@ -299,18 +303,20 @@ ConstChunk const& OpArray<Op_tt>::ArrayIterator::getChunk()
                                                     << ")" << std::endl;
             }
             int64_t rowEnd = first[0] + rowCount;
-            int64_t colEnd = first[1] + colCount;
-            // note that SciDB chunks are stored in row-major order, so we
-            // iterate columns in the inner loop.
+            // the whole chunk is fetched from the Op_tt at once, in row-major order as SciDB chunks are stored,
+            // then handed to writeItems() row by row
+            values.resize(std::max(rowCount * colCount, int64_t(1)));
+            _array._op.getBlock(first[0], first[1], rowCount, colCount, &values[0]);
             for(int64_t row = first[0]; row < rowEnd; row++) {
-                for(int64_t col = first[1]; col < colEnd; col++) {
-                    double val = _array._op.operator()(row, col);
-                    if(DBG >= DBG_LOOP_SIMPLE) {
+                if(DBG >= DBG_LOOP_SIMPLE) {
+                    for(int64_t col = first[1]; col < first[1] + colCount; col++) {
                         std::cerr << dbgPrefix << " ["<< row << "," << col << "] "
-                                  << " -> val: " << val << std::endl ;
+                                  << " -> val: " << values[(row - first[0]) * colCount + col - first[1]] << std::endl ;
                     }
-                    pos[0] = row; pos[1] = col ; chunkIter->setPosition(pos);
-                    value.setDouble(val); chunkIter->writeItem(value);
+                }
+                if (colCount > 0) {
+                    pos[0] = row;
+                    chunkIter->writeItems(mapper.coord2pos(pos), colCount, &values[(row - first[0]) * colCount], NULL);
                 }
             }
         }
@@ -0,0 +1,105 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+#ifndef GEMMBLOCKKERNEL_HPP_
+#define GEMMBLOCKKERNEL_HPP_
+
+// header groups:
+// std C++
+#include <algorithm>
+// std C
+#include <stddef.h>
+// de-facto standards
+// SciDB
+// MPI/ScaLAPACK
+// local
+
+namespace scidb
+{
+
+/**
+ * C += alpha * A * B on dense, row-major blocks, as used by the in-process gemm().
+ *
+ * The loops are blocked so that a KC x NC panel of B stays in L2 while the rows of A
+ * stream past it, and four rows of C are updated per pass over a panel row.
+ * The innermost loop runs over contiguous elements of B and C, which the compiler
+ * vectorizes with whatever SIMD width the build targets.
+ *
+ * @param m     rows of A and C
+ * @param n     columns of B and C
+ * @param k     columns of A, rows of B
+ * @param alpha scale of A * B
+ * @param a     the m x k block A, leading dimension lda
+ * @param b     the k x n block B, leading dimension ldb
+ * @param c     the m x n block C, leading dimension ldc, updated in place
+ */
+inline void blockGemm(size_t m, size_t n, size_t k, double alpha,
+                      const double* a, size_t lda,
+                      const double* b, size_t ldb,
+                      double* c, size_t ldc)
+{
+    const size_t KC = 128;      // rows of a panel of B
+    const size_t NC = 256;      // columns of a panel of B: KC*NC doubles = 256 KiB
+
+    for (size_t jj = 0; jj < n; jj += NC) {
+        const size_t nb = std::min(NC, n - jj);
+        for (size_t kk = 0; kk < k; kk += KC) {
+            const size_t kEnd = std::min(kk + KC, k);
+            size_t i = 0;
+            for (; i + 4 <= m; i += 4) {
+                double* __restrict__ c0 = c + i * ldc + jj;
+                double* __restrict__ c1 = c0 + ldc;
+                double* __restrict__ c2 = c1 + ldc;
+                double* __restrict__ c3 = c2 + ldc;
+                const double* a0 = a + i * lda;
+                for (size_t p = kk; p < kEnd; ++p) {
+                    const double a0p = alpha * a0[p];
+                    const double a1p = alpha * a0[p + lda];
+                    const double a2p = alpha * a0[p + 2 * lda];
+                    const double a3p = alpha * a0[p + 3 * lda];
+                    const double* __restrict__ bp = b + p * ldb + jj;
+                    for (size_t j = 0; j < nb; ++j) {
+                        const double bv = bp[j];
+                        c0[j] += a0p * bv;
+                        c1[j] += a1p * bv;
+                        c2[j] += a2p * bv;
+                        c3[j] += a3p * bv;
+                    }
+                }
+            }
+            for (; i < m; ++i) {
+                double* __restrict__ ci = c + i * ldc + jj;
+                const double* ai = a + i * lda;
+                for (size_t p = kk; p < kEnd; ++p) {
+                    const double aip = alpha * ai[p];
+                    const double* __restrict__ bp = b + p * ldb + jj;
+                    for (size_t j = 0; j < nb; ++j) {
+                        ci[j] += aip * bp[j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+} // namespace scidb
+
+#endif // GEMMBLOCKKERNEL_HPP_
@@ -86,7 +86,9 @@ namespace scidb
  ///   DLANameSpace:SCIDB_SE_INFER_SCHEMA:DLA_ERROR10 -- if the chunk sizes in any of the input arrays are not identical (until auto-repart is working)
  ///
  /// @par Notes:
- ///   n/a
+ ///   When the three matrices together are at most gemm-in-process-limit mebibytes (16 by default, 0 to
+ ///   always use ScaLAPACK), the product is computed inside the SciDB instances rather than by ScaLAPACK,
+ ///   and the result is distributed by rows of chunks.
  ///
 class GEMMLogical: public LogicalOperator
 {
@@ -22,8 +22,10 @@
 
 // std C++
 #include <cmath>
+#include <map>
 #include <sstream>
 #include <string>
+#include <vector>
 
 // std C
 #include <time.h>
@@ -46,8 +48,13 @@
 #include <query/Query.h>
 #include <system/BlockCyclic.h>
 #include <system/Cluster.h>
+#include <system/Config.h>
 #include <system/Exceptions.h>
+#include <system/SciDBConfigOptions.h>
+#include <system/Sysinfo.h>
 #include <system/Utils.h>
+#include <util/Job.h>
+#include <util/JobQueue.h>
 #include <util/shm/SharedMemoryIpc.h>
 #include <util/Utility.h>
 
@@ -60,6 +67,7 @@
 #include <dlaScaLA/slaving/pdgemmSlave.hpp>
 
 // locals
+#include "GEMMBlockKernel.hpp"
 #include "GEMMOptions.hpp"
 #include "DLAErrors.h"
 
@@ -83,12 +91,18 @@ static const bool DBG = false;
 /**
  *  A Physical multiply operator implemented using ScaLAPACK
  *  The interesting work is done in invokeMPI(), above
+ *  Matrices small enough for CONFIG_GEMM_IN_PROCESS_LIMIT are multiplied by invokeInProcess() instead
  *
  */
 class GEMMPhysical : public ScaLAPACKPhysical
 {
 public:
 
+    static bool isMemoryHungry()
+    {
+        return true;
+    }
+
     GEMMPhysical(const std::string& logicalName, const std::string& physicalName, const Parameters& parameters, const ArrayDesc& schema)
     :
         ScaLAPACKPhysical(logicalName, physicalName, parameters, schema)
@@ -98,8 +112,33 @@ public:
                                 const GEMMOptions options, shared_ptr<Query>& query,
                                 ArrayDesc& outSchema);
 
+    /**
+     * Multiply inside the instances, without MPI slaves or ScaLAPACK.
+     * A is distributed by rows of chunks and stays in place, C is distributed the same way and
+     * initializes the result, and the chunk columns of B are rotated through all instances,
+     * one redistribute per step (the same rotation spgemm() uses). Every instance multiplies
+     * the blocks it holds with the multithreaded blockGemm() kernel on the operator thread pool.
+     * @return the local part of the result, distributed psByRow, without an empty tag
+     */
+    shared_ptr<Array> invokeInProcess(std::vector< shared_ptr<Array> >& inputArrays,
+                                      const GEMMOptions options, shared_ptr<Query>& query,
+                                      ArrayDesc& outSchema);
+
+    virtual ArrayDistribution getOutputDistribution(const std::vector<ArrayDistribution> & inputDistributions,
+                                                    const std::vector< ArrayDesc> & inputSchemas) const
+    {
+        return ArrayDistribution(useInProcess(inputSchemas) ? psByRow : psScaLAPACK);
+    }
+
     virtual shared_ptr<Array> execute(std::vector< shared_ptr<Array> >& inputArrays, shared_ptr<Query> query);
 private:
+    /**
+     * The MPI launch and the conversion to and from ScaLAPACK layout dominate small and medium
+     * multiplies, so they run in-process when the three matrices together fit into
+     * CONFIG_GEMM_IN_PROCESS_LIMIT.
+     * @return true if the multiply of these matrices should not use ScaLAPACK
+     */
+    static bool useInProcess(const std::vector<ArrayDesc>& inputSchemas);
 };
 
 
@@ -481,6 +520,301 @@ shared_ptr<Array> GEMMPhysical::invokeMPI(std::vector< shared_ptr<Array> >& inpu
 }
 
 
+bool GEMMPhysical::useInProcess(const std::vector<ArrayDesc>& inputSchemas)
+{
+    uint64_t const limit = uint64_t(Config::getInstance()->getOption<int>(CONFIG_GEMM_IN_PROCESS_LIMIT)) * MiB;
+    if (limit == 0) {
+        return false;
+    }
+    uint64_t bytes = 0;
+    for (size_t i = 0; i < inputSchemas.size(); i++) {
+        Dimensions const& dims = inputSchemas[i].getDimensions();
+        bytes += dims[0].getLength() * dims[1].getLength() * sizeof(double);
+    }
+    return bytes <= limit;
+}
+
+namespace
+{
+    typedef std::pair<Coordinate, Coordinate> BlockKey;
+
+    /**
+     * Dense, row-major chunkSize x chunkSize blocks of a matrix, by (row, column) chunk number.
+     * All blocks live in one buffer that keeps its capacity when cleared, so that the rotation
+     * steps reuse it instead of allocating a block per chunk.
+     */
+    class Blocks
+    {
+    public:
+        typedef std::map<BlockKey, size_t> Offsets;
+
+        explicit Blocks(size_t chunkSize) : _blockSize(chunkSize * chunkSize)
+        {
+        }
+
+        /// @return the offset of the block in the buffer, appended zero-filled if missing
+        size_t getOffset(BlockKey const& key)
+        {
+            std::pair<Offsets::iterator, bool> inserted = _offsets.insert(std::make_pair(key, _values.size()));
+            if (inserted.second) {
+                _values.resize(_values.size() + _blockSize, 0.0);
+            }
+            return inserted.first->second;
+        }
+
+        /// @note valid until the next getOffset() of a missing block
+        double* getBlock(size_t offset)
+        {
+            return &_values[offset];
+        }
+
+        double const* getBlock(size_t offset) const
+        {
+            return &_values[offset];
+        }
+
+        /// ordered by row then column
+        Offsets const& getOffsets() const
+        {
+            return _offsets;
+        }
+
+        bool empty() const
+        {
+            return _offsets.empty();
+        }
+
+        /// drop the blocks, keeping the capacity of the buffer
+        void clear()
+        {
+            _offsets.clear();
+            _values.clear();
+        }
+
+        /// drop the blocks and free the buffer
+        void release()
+        {
+            clear();
+            std::vector<double>().swap(_values);
+        }
+
+    private:
+        size_t const _blockSize;
+        Offsets _offsets;
+        std::vector<double> _values;
+    };
+
+    /**
+     * Copy the non-empty cells of the local chunks of a matrix into blocks of chunkSize x chunkSize.
+     * @param transpose store the transpose of the matrix, i.e. swap the chunk numbers and the cell positions
+     * @param scale     multiply every value by it
+     * @param blocks    the blocks, created where missing (zero-filled) and overwritten where the matrix has cells
+     */
+    void loadBlocks(shared_ptr<Array> const& array, size_t chunkSize, bool transpose, double scale, Blocks& blocks)
+    {
+        for (shared_ptr<ConstArrayIterator> arrayIter = array->getConstIterator(0); !arrayIter->end(); ++(*arrayIter)) {
+            Coordinates const& chunkPos = arrayIter->getPosition();
+            Coordinate const row = chunkPos[0] / chunkSize;
+            Coordinate const col = chunkPos[1] / chunkSize;
+            double* block = blocks.getBlock(blocks.getOffset(transpose ? BlockKey(col, row) : BlockKey(row, col)));
+
+            shared_ptr<ConstChunkIterator> chunkIter =
+                arrayIter->getChunk().getConstIterator(ConstChunkIterator::IGNORE_OVERLAPS |
+                                                       ConstChunkIterator::IGNORE_EMPTY_CELLS);
+            for (; !chunkIter->end(); ++(*chunkIter)) {
+                Value const& v = chunkIter->getItem();
+                if (v.isNull()) {
+                    continue;
+                }
+                Coordinates const& pos = chunkIter->getPosition();
+                size_t const r = pos[0] - chunkPos[0];
+                size_t const c = pos[1] - chunkPos[1];
+                block[transpose ? c * chunkSize + r : r * chunkSize + c] = scale * v.getDouble();
+            }
+        }
+    }
+
+    /// a result block and its offset in the result blocks
+    typedef std::vector<std::pair<BlockKey, size_t> > BlockTasks;
+
+    /**
+     * Computes a share of the result blocks of one rotation step: C(r,c) += alpha * A(r,k) * B(k,c) over all k.
+     */
+    class BlockGemmJob : public Job
+    {
+    public:
+        BlockGemmJob(shared_ptr<Query> const& query, size_t chunkSize, double alpha,
+                     Blocks const& left, Blocks const& right, Blocks& result,
+                     BlockTasks const& tasks, size_t first, size_t step)
+        : Job(query),
+          _chunkSize(chunkSize),
+          _alpha(alpha),
+          _left(left),
+          _right(right),
+          _result(result),
+          _tasks(tasks),
+          _first(first),
+          _step(step)
+        {
+        }
+
+        virtual void run()
+        {
+            Blocks::Offsets const& left = _left.getOffsets();
+            Blocks::Offsets const& right = _right.getOffsets();
+            for (size_t t = _first; t < _tasks.size(); t += _step) {
+                Coordinate const row = _tasks[t].first.first;
+                Coordinate const col = _tasks[t].first.second;
+                double* result = _result.getBlock(_tasks[t].second);
+                // walk the chunk row of A
+                for (Blocks::Offsets::const_iterator a = left.lower_bound(BlockKey(row, 0));
+                     a != left.end() && a->first.first == row; ++a) {
+                    Blocks::Offsets::const_iterator b = right.find(BlockKey(a->first.second, col));
+                    if (b == right.end()) {
+                        continue;
+                    }
+                    blockGemm(_chunkSize, _chunkSize, _chunkSize, _alpha,
+                              _left.getBlock(a->second), _chunkSize,
+                              _right.getBlock(b->second), _chunkSize,
+                              result, _chunkSize);
+                }
+            }
+        }
+
+    private:
+        size_t const _chunkSize;
+        double const _alpha;
+        Blocks const& _left;
+        Blocks const& _right;
+        Blocks& _result;
+        BlockTasks const& _tasks;
+        size_t const _first;
+        size_t const _step;
+    };
+}
+
+shared_ptr<Array> GEMMPhysical::invokeInProcess(std::vector< shared_ptr<Array> >& inputArrays,
+                                                const GEMMOptions options, shared_ptr<Query>& query,
+                                                ArrayDesc& outSchema)
+{
+    enum dummy  {R=0, C=1};
+    enum dummy2 {AA=0, BB, CC, NUM_MATRICES};
+
+    LOG4CXX_DEBUG(logger, "GEMMPhysical::invokeInProcess(): begin");
+    if (inputArrays.size() != NUM_MATRICES) {
+        throw (SYSTEM_EXCEPTION(SCIDB_SE_INTERNAL, SCIDB_LE_OPERATION_FAILED)
+                   << "GEMMPhysical::invokeInProcess(): requires 3 input Arrays/matrices.");
+    }
+    for(size_t i=0; i < NUM_MATRICES; i++ ) {
+        checkInputArray(inputArrays[i]);  // check block size constraints, etc
+    }
+
+    // checkScaLAPACKInputs() guarantees that all dimensions start at 0 and share one square chunk size
+    Dimensions const& dimsCC = outSchema.getDimensions();
+    size_t const chunkSize = dimsCC[R].getChunkInterval();
+    Coordinate const nRowChunks = (dimsCC[R].getLength() + chunkSize - 1) / chunkSize;
+    Coordinate const nColChunks = (dimsCC[C].getLength() + chunkSize - 1) / chunkSize;
+
+    // the chunk rows of the result this instance owns under psByRow
+    size_t const nInstances = query->getInstancesCount();
+    Coordinate const rowsPerInstance = (nRowChunks + nInstances - 1) / nInstances;
+    Coordinate const firstRow = std::min(nRowChunks, Coordinate(query->getInstanceID() * rowsPerInstance));
+    Coordinate const endRow = std::min(nRowChunks, firstRow + rowsPerInstance);
+
+    //
+    // result blocks start as beta * C; the chunk rows of C and of op(A) come here by psByRow
+    //
+    Blocks result(chunkSize);
+    {
+        shared_ptr<Array> redistCC = redistribute(inputArrays[CC], query, psByRow);
+        if (options.beta != 0.0) {
+            loadBlocks(redistCC, chunkSize, false, options.beta, result);
+        }
+        inputArrays[CC].reset();
+    }
+    BlockTasks tasks;
+    for (Coordinate row = firstRow; row < endRow; ++row) {
+        for (Coordinate col = 0; col < nColChunks; ++col) {
+            tasks.push_back(std::make_pair(BlockKey(row, col), result.getOffset(BlockKey(row, col))));
+        }
+    }
+
+    Blocks left(chunkSize);
+    {
+        shared_ptr<Array> redistAA = redistribute(inputArrays[AA], query, options.transposeA ? psByCol : psByRow);
+        loadBlocks(redistAA, chunkSize, options.transposeA, 1.0, left);
+        inputArrays[AA].reset();
+    }
+
+    //
+    // rotate the chunk columns of op(B) through the instances
+    //
+    shared_ptr<JobQueue> queue = PhysicalOperator::getGlobalQueueForOperators();
+    size_t const nJobs = std::max(size_t(1), std::min(tasks.size(), size_t(Sysinfo::getNumberOfCPUs())));
+    shared_ptr<Array> rightArray = inputArrays[BB];
+    inputArrays[BB].reset();
+    Blocks right(chunkSize);
+    for (size_t step = 0; step < nInstances; ++step) {
+        rightArray = redistribute(rightArray, query, options.transposeB ? psByRow : psByCol, "",
+                                  ALL_INSTANCES_MASK, shared_ptr<DistributionMapper>(), step);
+        right.clear();
+        loadBlocks(rightArray, chunkSize, options.transposeB, 1.0, right);
+        if (right.empty() || left.empty() || tasks.empty()) {
+            continue;
+        }
+
+        std::vector<shared_ptr<BlockGemmJob> > jobs(nJobs);
+        for (size_t j = 0; j < nJobs; j++) {
+            jobs[j] = shared_ptr<BlockGemmJob>(new BlockGemmJob(query, chunkSize, options.alpha,
+                                                                left, right, result, tasks, j, nJobs));
+            queue->pushJob(jobs[j]);
+        }
+        int errorJob = -1;
+        for (size_t j = 0; j < nJobs; j++) {
+            if (!jobs[j]->wait()) {
+                errorJob = j;
+            }
+        }
+        if (errorJob >= 0) {
+            jobs[errorJob]->rethrow();
+        }
+    }
+    rightArray.reset();
+    right.release();
+    left.release();
+
+    //
+    // write the result blocks out as chunks
+    //
+    shared_ptr<MemArray> output = make_shared<MemArray>(outSchema, query);
+    shared_ptr<ArrayIterator> outputIter = output->getIterator(0);
+    Coordinates chunkPos(2);
+    Coordinates pos(2);
+    Value v;
+    for (size_t t = 0; t < tasks.size(); t++) {
+        chunkPos[R] = tasks[t].first.first * chunkSize;
+        chunkPos[C] = tasks[t].first.second * chunkSize;
+        Coordinate const endR = std::min(chunkPos[R] + Coordinate(chunkSize), Coordinate(dimsCC[R].getLength()));
+        Coordinate const endC = std::min(chunkPos[C] + Coordinate(chunkSize), Coordinate(dimsCC[C].getLength()));
+        double const* block = result.getBlock(tasks[t].second);
+
+        Chunk& chunk = outputIter->newChunk(chunkPos);
+        shared_ptr<ChunkIterator> chunkIter = chunk.getIterator(query, ChunkIterator::SEQUENTIAL_WRITE);
+        for (pos[R] = chunkPos[R]; pos[R] < endR; ++pos[R]) {
+            for (pos[C] = chunkPos[C]; pos[C] < endC; ++pos[C]) {
+                chunkIter->setPosition(pos);
+                v.setDouble(block[(pos[R] - chunkPos[R]) * chunkSize + (pos[C] - chunkPos[C])]);
+                chunkIter->writeItem(v);
+            }
+        }
+        chunkIter->flush();
+    }
+
+    LOG4CXX_DEBUG(logger, "GEMMPhysical::invokeInProcess() end, " << tasks.size() << " result chunks");
+    return output;
+}
+
+
 shared_ptr<Array> GEMMPhysical::execute(std::vector< shared_ptr<Array> >& inputArrays, shared_ptr<Query> query)
 {
     //
@@ -506,7 +840,7 @@ shared_ptr<Array> GEMMPhysical::execute(std::vector< shared_ptr<Array> >& inputA
     GEMMOptions options(namedOptionStr);
 
     //
-    // invokeMPI()
+    // invokeMPI() or invokeInProcess()
     //
 
     // invokeMPI does not manage an empty bitmap yet, but it is specified in _schema.
@@ -515,7 +849,13 @@ shared_ptr<Array> GEMMPhysical::execute(std::vector< shared_ptr<Array> >& inputA
     ArrayDesc schemaNoEmptyTag(_schema.getName(), attrsNoEmptyTag, _schema.getDimensions());
 
     // and now invokeMPI produces an array without empty bitmap except when it is not participating
-    shared_ptr<Array> arrayNoEmptyTag = invokeMPI(inputArrays, options, query, schemaNoEmptyTag);
+    std::vector<ArrayDesc> inputSchemas;
+    for (size_t i = 0; i < inputArrays.size(); i++) {
+        inputSchemas.push_back(inputArrays[i]->getArrayDesc());
+    }
+    shared_ptr<Array> arrayNoEmptyTag = useInProcess(inputSchemas) ?
+        invokeInProcess(inputArrays, options, query, schemaNoEmptyTag) :
+        invokeMPI(inputArrays, options, query, schemaNoEmptyTag);
 
 
     // now we place a wrapper array around arrayNoEmptyTag, that adds a fake emptyTag (true everywhere)
@@ -87,6 +87,11 @@ static const bool DBG = false;
 class SVDPhysical : public ScaLAPACKPhysical
 {
 public:
+    static bool isMemoryHungry()
+    {
+        return true;
+    }
+
     SVDPhysical(const std::string& logicalName, const std::string& physicalName, const Parameters& parameters, const ArrayDesc& schema)
     :
         ScaLAPACKPhysical(logicalName, physicalName, parameters, schema,
@@ -23,6 +23,7 @@
 #define REFORMAT__HPP
 
 // std C++
+#include <algorithm>
 #include <iostream>
 
 // std C
@@ -60,15 +61,44 @@ slpp::desc_t    scidbDistrib(const slpp::desc_t& DESCA);
 void infoG2L_zero_based(slpp::int_t globalRow, slpp::int_t globalCol, const slpp::desc_t& desc,
                         slpp::int_t NPROW, slpp::int_t NPCOL, slpp::int_t MYPROW, slpp::int_t MYPCOL,
                         slpp::int_t& localRowOut, slpp::int_t& localColOut);
+
+///
+/// copy the nRows x nCols matrix src, row-major with leading dimension srcStride,
+/// to dst in column-major order with leading dimension dstStride:
+///     dst[r + c*dstStride] = src[r*srcStride + c]
+/// This is the conversion between a SciDB chunk and a ScaLAPACK block, in either direction
+/// (for the reverse, exchange the roles of rows and columns).
+/// The copy proceeds in small square tiles so that both the strided reads and the strided writes
+/// of a tile stay in L1, even when a block is too large for it.
+///
+inline void copyTransposed(const double* src, size_t srcStride, double* dst, size_t dstStride,
+                           size_t nRows, size_t nCols)
+{
+    const size_t TILE = 32; // 2 x 32 x 32 doubles = 16 KiB
+    for (size_t rr = 0; rr < nRows; rr += TILE) {
+        const size_t rEnd = std::min(rr + TILE, nRows);
+        for (size_t cc = 0; cc < nCols; cc += TILE) {
+            const size_t cEnd = std::min(cc + TILE, nCols);
+            for (size_t c = cc; c < cEnd; ++c) {
+                double* dstCol = dst + c * dstStride;
+                for (size_t r = rr; r < rEnd; ++r) {
+                    dstCol[r] = src[r * srcStride + c];
+                }
+            }
+        }
+    }
+}
+
 ///
 /// template argument for the extractToOp<> function
 /// 
 /// This operator is used as the template arg to extractToOp<Op_tt>(Array)
-/// extractToOp passes over every cell of every chunk in the Array
-/// at that node and calls Op_tt::operator()(val, row, col).  This operator
-/// subtracts ctor arguments {minrow, mincol} from {row,col} and
+/// extractToOp passes over every chunk in the Array at that node
+/// and calls Op_tt::copyBlock() with the values of the chunk.
+/// This operator subtracts ctor arguments {minrow, mincol} from {row,col} and
 /// stores the result in "data" which is the local instance's share
 /// of a ScaLAPACK-format ScaLAPACK matrix.
+/// operator()(val, row, col) does the same one cell at a time.
 ///
 /// SciDB chunks in psScaLAPACK distribution are written as ScaLAPACK blocks.
 /// It is an error to use ReformatToScalapack on SciDB arrays that are not
@@ -91,6 +121,8 @@ public:
     void    blockBegin();
     void    blockEnd();
     void    operator()(double val, size_t scidbRow, size_t scidbCol);
+    void    copyBlock(const double* src, size_t srcStride,
+                      int64_t scidbRow, int64_t scidbCol, size_t nRows, size_t nCols);
 private:
     enum BlockState { BlockEnded, BlockEmpty, BlockInProgress };
     double*             _data ;
@@ -253,6 +285,34 @@ inline void ReformatToScalapack::operator()(double val, size_t scidbRow, size_t
 }
 
 
+///
+/// bulk version of operator()(): stores the nRows x nCols values src, row-major with leading
+/// dimension srcStride, at SciDB position [scidbRow, scidbCol] onward.
+/// Zeros are stored as well, as a whole chunk is cheaper to copy than to test cell by cell.
+/// The values must lie in a single ScaLAPACK block, which the cells of one chunk
+/// of an array in psScaLAPACK distribution do; so a single infoG2L maps all of them.
+///
+inline void ReformatToScalapack::copyBlock(const double* src, size_t srcStride,
+                                           int64_t scidbRow, int64_t scidbCol, size_t nRows, size_t nCols)
+{
+    assert(ReformatToScalapack::BlockEnded != _blockState) ; // blockBegin() must precede copyBlock()
+    if (nRows == 0 || nCols == 0) {
+        return;
+    }
+
+    slpp::int_t globalRow = scidbRow-_minrow ;
+    slpp::int_t globalCol = scidbCol-_mincol ;
+    assert(globalRow % _desc.MB + slpp::int_t(nRows) <= _desc.MB);
+    assert(globalCol % _desc.NB + slpp::int_t(nCols) <= _desc.NB);
+
+    slpp::int_t localRow, localCol; // infoG2L_zero_based() outputs
+    infoG2L_zero_based(globalRow, globalCol, _desc, _NPROW, _NPCOL, _MYPROW, _MYPCOL, localRow, localCol);
+
+    // write _data in column-major layout required by ScaLAPACK
+    copyTransposed(src, srcStride, _data + localRow + localCol * _desc.LLD, _desc.LLD, nRows, nCols);
+}
+
+
 ///
 /// template argument for the OpArray<> class
 /// 
@@ -325,6 +385,31 @@ public:
         return val;
     }
 
+    /// bulk version of operator()(row, col): fills 'out' with the nRows x nCols values at
+    /// SciDB position [row, col] onward, row-major with leading dimension nCols.
+    /// The values must lie in a single ScaLAPACK block held by this instance, as the
+    /// cells of one chunk of an OpArray over local ScaLAPACK memory do.
+    inline void getBlock(int64_t row, int64_t col, size_t nRows, size_t nCols, double* out) const
+    {
+        if (nRows == 0 || nCols == 0) {
+            return;
+        }
+        slpp::int_t ICTXT = _desc.CTXT;
+        slpp::int_t NPROW=-1, NPCOL=-1, MYPROW=-1, MYPCOL=-1;
+        scidb_blacs_gridinfo_(ICTXT, NPROW, NPCOL, MYPROW, MYPCOL);
+
+        slpp::int_t globalRow = row-_minrow;
+        slpp::int_t globalCol = col-_mincol;
+        assert(globalRow % _desc.MB + slpp::int_t(nRows) <= _desc.MB);
+        assert(globalCol % _desc.NB + slpp::int_t(nCols) <= _desc.NB);
+
+        slpp::int_t localRow, localCol; // infoG2L_zero_based() outputs
+        infoG2L_zero_based(globalRow, globalCol, _desc, NPROW, NPCOL, MYPROW, MYPCOL, localRow, localCol);
+
+        // the ScaLAPACK block is column-major: its columns are the rows of the transpose copy
+        copyTransposed(_data.get() + localRow + localCol * _desc.LLD, _desc.LLD, out, nCols, nCols, nRows);
+    }
+
     // single-dimension version such as the 'values' of an SVD
     inline double operator()(int64_t row) const {
         using namespace scidb;
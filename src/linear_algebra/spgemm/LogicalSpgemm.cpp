@@ -28,6 +28,8 @@
 
 #include <query/Operator.h>
 
+#include "SpgemmOptions.h"
+
 namespace scidb
 {
 
@@ -40,7 +42,7 @@ inline bool hasSingleAttribute(ArrayDesc const& desc)
  * @brief The operator: spgemm().
  *
  * @par Synopsis:
- *   spgemm( leftArray, rightArray [,semiring] )
+ *   spgemm( leftArray, rightArray [,options] )
  *
  * @par Summary:
  *   Produces a result array via matrix multiplication.
@@ -50,7 +52,8 @@ inline bool hasSingleAttribute(ArrayDesc const& desc)
  * @par Input:
  *   - leftArray: the left matrix with two dimensions: leftDim1, leftDim2
  *   - rightArray: the right matrix with two dimensions: rightDim1, rightDim2
- *   - [semiring]: optional name of a semiring to be used instead of ordinary arithmetic (+,*)
+ *   - [options]: optional comma-separated list of the following.
+ *                 The name of a semiring to be used instead of ordinary arithmetic (+,*)
  *                 when performing the matrix multiplication. Supported values are:
  *                 "min.+" -- the Tropical Semiring, i.e. a+b -> min(a,b) ; a*b -> a+b ;
  *                            the implicit sparse value is +inf.
@@ -61,6 +64,11 @@ inline bool hasSingleAttribute(ArrayDesc const& desc)
  *                 for a computer scientist is: Stephan Dolan, "Fun with Semirings,
  *                 A functional perl on the abuse of linear algebra"
  *                 [http://www.cl.cam.ac.uk/~sd601/papers/semirings.pdf]
+ *                 "2d"   -- distribute the work over a sqrt(P) x sqrt(P) grid of instances instead of
+ *                           rotating the whole right matrix through all P instances; each instance then
+ *                           receives O(1/sqrt(P)) of both matrices rather than all of the right one.
+ *                 "hash" -- accumulate result rows in hash tables rather than dense arrays of the
+ *                           result width; for very wide, very sparse results.
  *
  * @par Output array:
  *        <
@@ -144,7 +152,7 @@ public:
         }
 
         //
-        // get the optional 3rd argument: the semiring string: "min.+" or "max.+". They only apply to float and double
+        // get the optional 3rd argument: the options string, e.g. "min.+" or "max.+,2d". Semirings only apply to float and double
         //
         string namedOptionStr;
         switch (_parameters.size()) {
@@ -153,13 +161,8 @@ public:
         case 1:
             typedef boost::shared_ptr<OperatorParamLogicalExpression> ParamType_t ;
             namedOptionStr = evaluate(reinterpret_cast<ParamType_t&>(_parameters[0])->getExpression(), query, TID_STRING).getString();
-            if (namedOptionStr != "min.+" &&
-                namedOptionStr != "max.+" &&
-                namedOptionStr != "count-mults") {
-                throw(SYSTEM_EXCEPTION(SCIDB_SE_INTERNAL, SCIDB_LE_OPERATION_FAILED)
-                      << "LogicalSpgemm::inferSchema(): unrecognized option '" << namedOptionStr << "'");
-            }
-            if (type != TID_FLOAT && type != TID_DOUBLE) {
+            if (SpgemmOptions(namedOptionStr).semiring != SpgemmOptions::SRING_PLUS_STAR && // throws if not recognized
+                type != TID_FLOAT && type != TID_DOUBLE) {
                 throw(SYSTEM_EXCEPTION(SCIDB_SE_INTERNAL, SCIDB_LE_OPERATION_FAILED)
                       << "LogicalSpgemm::inferSchema(): the 'min.+' and 'max.+' options support only float and double attribute types");
             }
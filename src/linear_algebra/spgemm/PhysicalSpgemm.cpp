@@ -27,11 +27,14 @@
  */
 
 // C++
-#include <limits>
+#include <cmath>
 #include <limits>
 #include <sstream>
 
 // boost
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/ref.hpp>
 #include <boost/unordered_map.hpp>
 
 // scidb
@@ -39,7 +42,10 @@
 #include <util/Platform.h>
 #include <array/Tile.h>
 #include <array/TileIteratorAdaptors.h>
+#include <system/BlockCyclic.h>
 #include <system/Sysinfo.h>
+#include <util/Job.h>
+#include <util/JobQueue.h>
 
 // local
 #include "../LAErrors.h"
@@ -49,6 +55,7 @@
 #include "SpAccumulatorUtils.h"
 #include "SpgemmBlock.h"
 #include "SpgemmBlock_impl.h"
+#include "SpgemmOptions.h"
 #include "spgemmSemiringTraits.h"
 
 
@@ -61,7 +68,7 @@ using namespace scidb;
 struct SpgemmTimes {
     SpgemmTimes() : totalSecs(0.0) {;}
     std::vector<double>     redistributeLeftSecs;  //
-    std::vector<double>     redistributeRightSecs;  // per psByCol rotation
+    std::vector<double>     redistributeRightSecs;  // per psByCol rotation, overlapped with the previous one's multiplication
     std::vector<double>     loadLeftSecs;           // per psByCol rotation
     std::vector<double>     loadLeftCopySecs;       // per psByCol rotation
     std::vector<double>     loadRightSecs;          // per psByCol rotation
@@ -82,7 +89,9 @@ std::ostream& operator<<(ostream& os, const SpgemmTimes& times)
     os << "spgemm(): " << std::endl;
     for(size_t ii=0; ii<times.redistributeRightSecs.size(); ++ii) {
         os << "round: " << ii << "--------------" << std::endl ;
-        os << "redistributeLeftSecs: " << times.redistributeLeftSecs[ii] << std::endl ;
+        if (ii < times.redistributeLeftSecs.size()) {
+            os << "redistributeLeftSecs: " << times.redistributeLeftSecs[ii] << std::endl ;
+        }
         os << "redistributeRightSecs: " << times.redistributeRightSecs[ii] << std::endl ;
         os << "loadLeftSecs:          " << times.loadLeftSecs[ii] << std::endl ;
         os << "  loadLeftCopySecs:    " << times.loadLeftCopySecs[ii] << std::endl ;
@@ -98,12 +107,98 @@ std::ostream& operator<<(ostream& os, const SpgemmTimes& times)
 }
 
 
+/**
+ * A chunk of one of several arrays that together hold the local part of a matrix.
+ */
+struct SpgemmChunkRef
+{
+    Coordinates pos;
+    size_t      array;
+};
+
+/**
+ * Orders SpgemmChunkRefs by the position of their chunks.
+ */
+template<class CoordinatesComparator_tt>
+struct SpgemmChunkRefLess
+{
+    bool operator()(SpgemmChunkRef const& a, SpgemmChunkRef const& b) const
+    {
+        return CoordinatesComparator_tt()(a.pos, b.pos);
+    }
+};
+
+/**
+ * Assigns the chunks of one factor to a gridSize x gridSize grid of instances, for the "2d" option.
+ * The result chunk (I,J) is computed on grid position (I%gridSize, J%gridSize).
+ * At step s, left chunk (I,K) goes to grid position (I, K+s) and right chunk (K,J) to (K+s, J), modulo gridSize,
+ * so that after the gridSize steps each instance holds every chunk of the left rows and right columns it needs.
+ */
+class SpgemmGridSchemaData : public PartitioningSchemaDataForScaLAPACK
+{
+public:
+    /**
+     * @param isLeft    true for the left factor, false for the right one
+     * @param step      which of the gridSize steps
+     * @param gridSize  number of rows (and columns) of the instance grid
+     * @param dims      dimensions of the factor
+     */
+    SpgemmGridSchemaData(bool isLeft, size_t step, size_t gridSize, Dimensions const& dims)
+    :
+        PartitioningSchemaDataForScaLAPACK(gridRowCol(gridSize), blockRowCol(dims)),
+        _isLeft(isLeft),
+        _step(step),
+        _gridSize(gridSize),
+        _dims(dims)
+    {
+    }
+
+    virtual InstanceID getInstanceID(const Coordinates& chunkPos, const Query& query) const
+    {
+        size_t chunkRow = (chunkPos[0] - _dims[0].getStartMin()) / _dims[0].getChunkInterval();
+        size_t chunkCol = (chunkPos[1] - _dims[1].getStartMin()) / _dims[1].getChunkInterval();
+        if (_isLeft) {
+            chunkCol += _step;
+        } else {
+            chunkRow += _step;
+        }
+        return (chunkRow % _gridSize) * _gridSize + (chunkCol % _gridSize);
+    }
+
+private:
+    static procRowCol_t gridRowCol(size_t gridSize)
+    {
+        procRowCol_t result;
+        result.row = result.col = gridSize;
+        return result;
+    }
+
+    static RowCol<procNum_t> blockRowCol(Dimensions const& dims)
+    {
+        RowCol<procNum_t> result;
+        result.row = dims[0].getChunkInterval();
+        result.col = dims[1].getChunkInterval();
+        return result;
+    }
+
+    bool        _isLeft;
+    size_t      _step;
+    size_t      _gridSize;
+    Dimensions  _dims;
+};
+
+
 class PhysicalSpgemm : public  PhysicalOperator
 {
     TypeEnum _typeEnum; // the value type as an enum
     Type _type; // the value type as a type
 
 public:
+    static bool isMemoryHungry()
+    {
+        return true;
+    }
+
     PhysicalSpgemm(std::string const& logicalName,
                      std::string const& physicalName,
                      Parameters const& parameters,
@@ -123,42 +218,153 @@ public:
             std::vector<ArrayDistribution> const& inputDistributions,
             std::vector<ArrayDesc> const& inputSchemas) const
     {
-        return ArrayDistribution(psByRow);
+        // the 2-D grid places result chunks by both row and column of chunks, which no named distribution describes
+        return ArrayDistribution(getOptions().twoD ? psUndefined : psByRow);
     }
 
     boost::shared_ptr< Array> execute(std::vector< boost::shared_ptr< Array> >& inputArrays, boost::shared_ptr<Query> query);
 
 private:
+    /**
+     * the result is wider than this, in values, the SPAs are hashed rather than dense,
+     * as there is one SPA per thread and each dense one needs about sizeof(Value_t)+1/8 bytes per value.
+     */
+    static const Coordinate MAX_DENSE_SPA_WIDTH = 4*1024*1024;
+
+    typedef std::vector<SpgemmChunkRef> ChunkRefs_t;
+
+    /**
+     * the right blocks of one column of chunks, by the row of their chunk
+     */
+    template<class Value_tt>
+    struct RightColumn {
+        typedef SpgemmBlock<Value_tt> RightBlock_t;
+        typedef boost::unordered_map<Coordinate, shared_ptr<RightBlock_t> > RightBlockMap_t;
+
+        Coordinate      chunkCol;
+        RightBlockMap_t blocks;
+    };
+
+    /**
+     * Multiplies some of the left rows of chunks by all of the right columns of chunks, on a thread of the operator pool.
+     * Rows of chunks are dealt out round-robin to the jobs, so each result chunk is written by a single job.
+     */
+    template<class SemiringTraits_tt>
+    class MultiplyJob : public Job
+    {
+    public:
+        typedef RightColumn<typename SemiringTraits_tt::Value_t> RightColumn_t;
+
+        MultiplyJob(PhysicalSpgemm& op,
+                    std::vector<shared_ptr<Array> > const& leftArrays,
+                    std::vector<ChunkRefs_t> const& leftRows,
+                    std::vector<RightColumn_t> const& rightColumns,
+                    shared_ptr<MemArray> const& resultArray,
+                    size_t jobNum, size_t nJobs, bool hashed,
+                    shared_ptr<Query> const& query)
+        :
+            Job(query),
+            _op(op), _leftArrays(leftArrays), _leftRows(leftRows), _rightColumns(rightColumns),
+            _resultArray(resultArray), _jobNum(jobNum), _nJobs(nJobs), _hashed(hashed)
+        {
+        }
+
+        SpgemmTimes const& getTimes() const { return _times; }
+
+    protected:
+        virtual void run()
+        {
+            _op.multiplyRows<SemiringTraits_tt>(_leftArrays, _leftRows, _rightColumns, _resultArray,
+                                                _jobNum, _nJobs, _hashed, _query, _times);
+        }
+
+    private:
+        PhysicalSpgemm&                         _op;
+        std::vector<shared_ptr<Array> > const&  _leftArrays;
+        std::vector<ChunkRefs_t> const&         _leftRows;
+        std::vector<RightColumn_t> const&       _rightColumns;
+        shared_ptr<MemArray>                    _resultArray;
+        size_t                                  _jobNum;
+        size_t                                  _nJobs;
+        bool                                    _hashed;
+        SpgemmTimes                             _times;
+    };
+
+    /**
+     * @return the options given by the optional string parameter
+     */
+    SpgemmOptions getOptions() const;
+
     /**
      * same args as execute(), but templated on the a class corresponding to the semiring (arithmetic rules for + and *)
      * that will be used during the sparse multiplication.
      */
-    typedef enum dummy { SRING_PLUS_STAR, SRING_MIN_PLUS, SRING_MAX_PLUS, SRING_COUNT_MULTS } sringEnum_t ;
     template<class SemiringTraits_tt>
     boost::shared_ptr<Array> executeTraited(std::vector< boost::shared_ptr< Array> >& inputArrays,
-                                            boost::shared_ptr<Query>& query);
+                                            boost::shared_ptr<Query>& query, SpgemmOptions const& options);
 
     /**
-     * Multiply two arrays, with an SPMD algorithm.
+     * Multiply the local parts of two arrays, with an SPMD algorithm.
      *
-     * @param[in]  resultArray  the iterator for the result array
-     * @param[in]  leftArray -- a BY_ROWS subset of the rows of the total leftArray
-     * @param[in]  rightArray -- a BY_COLS subset of the columns of the total rightArray
+     * @param[in]  leftArrays -- arrays holding, together, whole rows of chunks of the total leftArray
+     * @param[in]  rightArrays -- arrays holding, together, whole columns of chunks of the total rightArray
+     * @param[in]  resultArray  the result array
+     * @param[in]  hashed  whether the SPAs are hashed
      * @param[in]  query  the query context
+     * @param[in]  overlapped  work for the calling thread while the multiplication runs on the operator threads,
+     *                         typically the redistribution of the next subset of the right array; may be empty
      *
-     * @note -- It is the caller's responsibility to call this method once per unique subset of columns that are
-     *          present on each instance in successive BY_ROWS re-distributions (Rotated Cannon-style in the rows).
-     *          It is also the callers responsibilyt to call the re-distrubte of the columns between calls to this method.
-     *          The leftArray subset is assumed to never change, and the overall algorithm will then produce output
-     *          in a BY_ROWS distribution.
+     * @note -- In the 1-D algorithm it is the caller's responsibility to call this method once per unique subset of
+     *          columns that are present on each instance in successive BY_COLS re-distributions
+     *          (Rotated Cannon-style in the columns).  The leftArray subset is assumed to never change, and the overall
+     *          algorithm will then produce output in a BY_ROWS distribution.
+     *          In the 2-D algorithm it is called once, with the arrays of all the steps.
+     */
+    template<class SemiringTraits_tt>
+    void spGemmSubset(std::vector<shared_ptr<Array> >& leftArrays, std::vector<shared_ptr<Array> >& rightArrays,
+                      shared_ptr<MemArray>& resultArray, bool hashed, shared_ptr<Query>& query, SpgemmTimes& times,
+                      boost::function<void()> const& overlapped);
+
+    /**
+     * load the right chunks into memory blocks, by column of chunks.
+     * small detail factored from spGemmSubset
      */
     template<class SemiringTraits_tt>
-    void spGemmColumnSubset(shared_ptr<Array>& leftArray, shared_ptr<Array>& rightArray,
-                            shared_ptr<ArrayIterator>& resultArray, shared_ptr<Query>& query, SpgemmTimes& times);
+    void loadRightColumns(std::vector<shared_ptr<Array> >& rightArrays,
+                          std::vector<RightColumn<typename SemiringTraits_tt::Value_t> >& rightColumns,
+                          const shared_ptr<Query>& query);
+
+    /**
+     * The body of MultiplyJob: multiply left rows of chunks jobNum, jobNum+nJobs, ... by every right column of chunks,
+     * accumulating the result rows in a SPA of its own.
+     * @param times receives one entry of each per-pass timing, summed over the rows of chunks handled
+     */
+    template<class SemiringTraits_tt>
+    void multiplyRows(std::vector<shared_ptr<Array> > const& leftArrays,
+                      std::vector<ChunkRefs_t> const& leftRows,
+                      std::vector<RightColumn<typename SemiringTraits_tt::Value_t> > const& rightColumns,
+                      shared_ptr<MemArray> const& resultArray,
+                      size_t jobNum, size_t nJobs, bool hashed,
+                      shared_ptr<Query>& query, SpgemmTimes& times);
+
+    /**
+     * redistribute the right array for the next rotation of the 1-D algorithm
+     */
+    void redistributeRight(shared_ptr<Array> const& rightArray, shared_ptr<Array>& nextRightArray,
+                           shared_ptr<Query> const& query, size_t shift, SpgemmTimes& times);
+
+    /**
+     * get the chunks of several arrays, sorted in a particular order, and grouped by one of their coordinates.
+     * small detail factored from spGemmSubset
+     * @param arrays
+     * @param groupDim  the dimension whose coordinate is common to the chunks of a group
+     * @param result    a container for the algorithm to fill
+     */
+    template<class CoordinatesComparator_tt>
+    void getChunkGroups(std::vector<shared_ptr<Array> >& arrays, size_t groupDim, std::vector<ChunkRefs_t>& result);
 
     /**
      * get the chunk positions of an array, sorted in a particular order.
-     * small detail factored from spGemmColumnSubset
      * @param array
      * @param result a container for the algorithm to fill [TODO: change to accept an output random-access iterator (random to support sort())
      */
@@ -189,70 +395,57 @@ private:
 };
 
 
-boost::shared_ptr< Array> PhysicalSpgemm::execute(std::vector< boost::shared_ptr< Array> >& inputArrays, boost::shared_ptr<Query> query)
+SpgemmOptions PhysicalSpgemm::getOptions() const
 {
-    assert(inputArrays.size()==2); // should not happen to developer, else inferSchema() did not raise an exception as it should have
-
-    sringEnum_t sringE= SRING_PLUS_STAR ; // the standard ring (TYPE, +,*) over all supported types is the default.
     // get string from the optional 3rd argument, if present.
-    // it holds the name of alternative ring arithmetic to use
+    // it holds the name of alternative ring arithmetic to use, and other options
     std::string namedOptionStr;
     if (_parameters.size() >= 1) {
         assert(_parameters[0]->getParamType() == PARAM_PHYSICAL_EXPRESSION);
         typedef boost::shared_ptr<OperatorParamPhysicalExpression> ParamType_t ;
-        ParamType_t& paramExpr = reinterpret_cast<ParamType_t&>(_parameters[0]);
+        ParamType_t const& paramExpr = reinterpret_cast<ParamType_t const&>(_parameters[0]);
         assert(paramExpr->isConstant());
         namedOptionStr = paramExpr->getExpression()->evaluate().getString();
-
-        if (namedOptionStr == "min.+") {
-            if (_typeEnum == TE_FLOAT || _typeEnum == TE_DOUBLE)
-                sringE= SRING_MIN_PLUS ;
-            else
-                throw (SYSTEM_EXCEPTION(SCIDB_SE_INTERNAL, SCIDB_LE_OPERATION_FAILED)
-                       << "PhysicalSpgemm::execute(): the 'min.+' option supports only float or double attributes");
-        } else if (namedOptionStr == "max.+") {
-            if (_typeEnum == TE_FLOAT || _typeEnum == TE_DOUBLE)
-                sringE= SRING_MAX_PLUS ;
-            else
-                throw (SYSTEM_EXCEPTION(SCIDB_SE_INTERNAL, SCIDB_LE_OPERATION_FAILED)
-                       << "PhysicalSpgemm::execute(): the 'max.+' option supports only float or double attributes");
-        } else if (namedOptionStr == "count-mults") {
-            if (_typeEnum == TE_FLOAT || _typeEnum == TE_DOUBLE)
-                sringE= SRING_COUNT_MULTS ;
-            else
-                throw (SYSTEM_EXCEPTION(SCIDB_SE_INTERNAL, SCIDB_LE_OPERATION_FAILED)
-                       << "PhysicalSpgemm::execute(): the 'count-mults' option supports only float or double attributes");
-        } else {
-            throw (SYSTEM_EXCEPTION(SCIDB_SE_INTERNAL, SCIDB_LE_OPERATION_FAILED)
-                   << "PhysicalSpgemm::execute(): no such option '" << namedOptionStr << "'");
-        }
     }
+    return SpgemmOptions(namedOptionStr);
+}
+
 
+boost::shared_ptr< Array> PhysicalSpgemm::execute(std::vector< boost::shared_ptr< Array> >& inputArrays, boost::shared_ptr<Query> query)
+{
+    assert(inputArrays.size()==2); // should not happen to developer, else inferSchema() did not raise an exception as it should have
+
+    // the standard ring (TYPE, +,*) over all supported types is the default.
+    SpgemmOptions const options = getOptions();
+    if (options.semiring != SpgemmOptions::SRING_PLUS_STAR && _typeEnum != TE_FLOAT && _typeEnum != TE_DOUBLE) {
+        throw (SYSTEM_EXCEPTION(SCIDB_SE_INTERNAL, SCIDB_LE_OPERATION_FAILED)
+               << "PhysicalSpgemm::execute(): the semiring options support only float or double attributes");
+    }
 
     switch(_typeEnum) {
     case TE_FLOAT:
-        switch (sringE) {
-        case SRING_PLUS_STAR:
-            return executeTraited<SemiringTraitsPlusStarZeroOne<float> >(inputArrays, query);
-        case SRING_MIN_PLUS:
-            return executeTraited<SemiringTraitsMinPlusInfZero <float> >(inputArrays, query);
-        case SRING_MAX_PLUS:
-            return executeTraited<SemiringTraitsMaxPlusMInfZero <float> >(inputArrays, query);
-        case SRING_COUNT_MULTS:
-            return executeTraited<SemiringTraitsCountMultiplies <float> >(inputArrays, query);
+        switch (options.semiring) {
+        case SpgemmOptions::SRING_PLUS_STAR:
+            return executeTraited<SemiringTraitsPlusStarZeroOne<float> >(inputArrays, query, options);
+        case SpgemmOptions::SRING_MIN_PLUS:
+            return executeTraited<SemiringTraitsMinPlusInfZero <float> >(inputArrays, query, options);
+        case SpgemmOptions::SRING_MAX_PLUS:
+            return executeTraited<SemiringTraitsMaxPlusMInfZero <float> >(inputArrays, query, options);
+        case SpgemmOptions::SRING_COUNT_MULTS:
+            return executeTraited<SemiringTraitsCountMultiplies <float> >(inputArrays, query, options);
         default:
             assert(false);
         }
     case TE_DOUBLE:
-        switch (sringE) {
-        case SRING_PLUS_STAR:
-            return executeTraited<SemiringTraitsPlusStarZeroOne<double> >(inputArrays, query);
-        case SRING_MIN_PLUS:
-            return executeTraited<SemiringTraitsMinPlusInfZero <double> >(inputArrays, query);
-        case SRING_MAX_PLUS:
-            return executeTraited<SemiringTraitsMaxPlusMInfZero <double> >(inputArrays, query);
-        case SRING_COUNT_MULTS:
-            return executeTraited<SemiringTraitsCountMultiplies <double> >(inputArrays, query);
+        switch (options.semiring) {
+        case SpgemmOptions::SRING_PLUS_STAR:
+            return executeTraited<SemiringTraitsPlusStarZeroOne<double> >(inputArrays, query, options);
+        case SpgemmOptions::SRING_MIN_PLUS:
+            return executeTraited<SemiringTraitsMinPlusInfZero <double> >(inputArrays, query, options);
+        case SpgemmOptions::SRING_MAX_PLUS:
+            return executeTraited<SemiringTraitsMaxPlusMInfZero <double> >(inputArrays, query, options);
+        case SpgemmOptions::SRING_COUNT_MULTS:
+            return executeTraited<SemiringTraitsCountMultiplies <double> >(inputArrays, query, options);
         default:
             assert(false);
         }
@@ -266,36 +459,73 @@ boost::shared_ptr< Array> PhysicalSpgemm::execute(std::vector< boost::shared_ptr
 
 
 template<class SemiringTraits_tt>
-boost::shared_ptr<Array> PhysicalSpgemm::executeTraited(std::vector< boost::shared_ptr< Array> >& inputArrays, boost::shared_ptr<Query>& query)
+boost::shared_ptr<Array> PhysicalSpgemm::executeTraited(std::vector< boost::shared_ptr< Array> >& inputArrays,
+                                                        boost::shared_ptr<Query>& query, SpgemmOptions const& options)
 {
     SpgemmTimes times;
 
     // Create a result array.
     shared_ptr<MemArray> resultArray = make_shared<MemArray>(_schema, query);
-    shared_ptr<ArrayIterator> resultArrayIter = resultArray->getIterator(0);
 
-    // We need to duplicate the right array to all instances, and multiply with the local chunks.
-    // One option is to duplicate.
-    // Another option is to rotate, which is what is used. In more detail:
-    // In each rotation, the chunks in the same col are distributed to the same instance, with a 'shift'.
-    // E.g. if in the first rotation, a whole column goes to instance 5, in the next rotation the columns will go to instance 6.
-    // warning: distribution of columns is NOT optimal for large instanceCounts (where communication limits even weak scaling),
-    //          or for small matrices with a chunk size that is smaller than necessary.
-    // redistribute the left array, so that chunks in the same row are distributed to the same instance.
-    double timeOrigin = getMonotonicrawSecs(); // TODO: refactor as getSecs(MONOTONIC_RAW) etc
-    shared_ptr<Array> leftArray = redistribute(inputArrays[0], query, psByRow);
-    times.redistributeLeftSecs.push_back(getMonotonicrawSecs()-timeOrigin) ;
-
-    shared_ptr<Array> rightArray = inputArrays[1];
+    const bool hashed = options.hashedAccumulator || _schema.getDimensions()[1].getLength() > MAX_DENSE_SPA_WIDTH;
     const size_t instanceCount = query->getInstancesCount();
-    for (size_t i=0; i<instanceCount; ++i) {
-        // next subset of the columns of rightArray
-        double timeLocal= getMonotonicrawSecs();
-        rightArray = redistribute(rightArray, query, psByCol, "", ALL_INSTANCES_MASK, shared_ptr<DistributionMapper>(), i);
-        times.redistributeRightSecs.push_back(getMonotonicrawSecs()-timeLocal) ;
+    double timeOrigin = getMonotonicrawSecs(); // TODO: refactor as getSecs(MONOTONIC_RAW) etc
 
-        // do the sub-calculation for that column subset
-        spGemmColumnSubset<SemiringTraits_tt>(leftArray, rightArray, resultArrayIter, query, times);
+    if (options.twoD) {
+        // 2-D algorithm: the instances form a gridSize x gridSize grid (any others sit idle), and each one
+        // gathers the left rows of chunks and right columns of chunks of the result chunks it owns,
+        // in gridSize redistributions of each factor.  Each instance thus receives O(1/sqrt(instanceCount))
+        // of both factors, rather than all of the right one as in the 1-D rotation.
+        const size_t gridSize = std::max(size_t(1), size_t(floor(sqrt(double(instanceCount)))));
+        std::vector<shared_ptr<Array> > leftArrays;
+        std::vector<shared_ptr<Array> > rightArrays;
+        double leftSecs = 0;
+        double rightSecs = 0;
+        for (size_t step = 0; step < gridSize; ++step) {
+            double timeLocal = getMonotonicrawSecs();
+            SpgemmGridSchemaData leftGrid(true, step, gridSize, inputArrays[0]->getArrayDesc().getDimensions());
+            leftArrays.push_back(redistribute(inputArrays[0], query, psScaLAPACK, "", ALL_INSTANCES_MASK,
+                                              shared_ptr<DistributionMapper>(), 0, &leftGrid));
+            leftSecs += getMonotonicrawSecs() - timeLocal;
+
+            timeLocal = getMonotonicrawSecs();
+            SpgemmGridSchemaData rightGrid(false, step, gridSize, inputArrays[1]->getArrayDesc().getDimensions());
+            rightArrays.push_back(redistribute(inputArrays[1], query, psScaLAPACK, "", ALL_INSTANCES_MASK,
+                                               shared_ptr<DistributionMapper>(), 0, &rightGrid));
+            rightSecs += getMonotonicrawSecs() - timeLocal;
+        }
+        times.redistributeLeftSecs.push_back(leftSecs);
+        times.redistributeRightSecs.push_back(rightSecs);
+
+        spGemmSubset<SemiringTraits_tt>(leftArrays, rightArrays, resultArray, hashed, query, times,
+                                        boost::function<void()>());
+    } else {
+        // We need to duplicate the right array to all instances, and multiply with the local chunks.
+        // One option is to duplicate.
+        // Another option is to rotate, which is what is used. In more detail:
+        // In each rotation, the chunks in the same col are distributed to the same instance, with a 'shift'.
+        // E.g. if in the first rotation, a whole column goes to instance 5, in the next rotation the columns will go to instance 6.
+        // The redistribution for the next rotation runs while the current one is multiplied.
+        // warning: distribution of columns is NOT optimal for large instanceCounts (where communication limits even weak scaling),
+        //          or for small matrices with a chunk size that is smaller than necessary.  The "2d" option addresses the former.
+        // redistribute the left array, so that chunks in the same row are distributed to the same instance.
+        std::vector<shared_ptr<Array> > leftArrays(1, redistribute(inputArrays[0], query, psByRow));
+        times.redistributeLeftSecs.push_back(getMonotonicrawSecs()-timeOrigin) ;
+
+        shared_ptr<Array> rightArray;
+        redistributeRight(inputArrays[1], rightArray, query, 0, times);
+        for (size_t i=0; i<instanceCount; ++i) {
+            // the next subset of the columns of rightArray is prefetched during the sub-calculation for this one
+            shared_ptr<Array> nextRightArray;
+            boost::function<void()> prefetch;
+            if (i+1 < instanceCount) {
+                prefetch = boost::bind(&PhysicalSpgemm::redistributeRight, this, boost::cref(rightArray),
+                                       boost::ref(nextRightArray), boost::cref(query), i+1, boost::ref(times));
+            }
+            std::vector<shared_ptr<Array> > rightArrays(1, rightArray);
+            spGemmSubset<SemiringTraits_tt>(leftArrays, rightArrays, resultArray, hashed, query, times, prefetch);
+            rightArray = nextRightArray;
+        }
     }
 
     times.totalSecs = getMonotonicrawSecs() - timeOrigin;
@@ -310,146 +540,224 @@ boost::shared_ptr<Array> PhysicalSpgemm::executeTraited(std::vector< boost::shar
 }
 
 
+void PhysicalSpgemm::redistributeRight(shared_ptr<Array> const& rightArray, shared_ptr<Array>& nextRightArray,
+                                       shared_ptr<Query> const& query, size_t shift, SpgemmTimes& times)
+{
+    double timeLocal= getMonotonicrawSecs();
+    nextRightArray = redistribute(rightArray, query, psByCol, "", ALL_INSTANCES_MASK, shared_ptr<DistributionMapper>(), shift);
+    times.redistributeRightSecs.push_back(getMonotonicrawSecs()-timeLocal) ;
+}
+
+
 template<class SemiringTraits_tt>
-void PhysicalSpgemm::spGemmColumnSubset(shared_ptr<Array>& leftArray, shared_ptr<Array>& rightArray,
-                                        shared_ptr<ArrayIterator>& resultArray, shared_ptr<Query>& query, SpgemmTimes& times)
+void PhysicalSpgemm::spGemmSubset(std::vector<shared_ptr<Array> >& leftArrays, std::vector<shared_ptr<Array> >& rightArrays,
+                                  shared_ptr<MemArray>& resultArray, bool hashed, shared_ptr<Query>& query, SpgemmTimes& times,
+                                  boost::function<void()> const& overlapped)
 {
     typedef typename SemiringTraits_tt::Value_t Value_t;
-    typedef typename SemiringTraits_tt::OpAdd_t OpAdd_t ;
-    typedef typename SemiringTraits_tt::IdAdd_t IdAdd_t ;
-    typedef CSRBlock<Value_t> LeftBlock_t; // chunks will be converted to matrix blocks which are efficient for sparse operations
+    typedef RightColumn<Value_t> RightColumn_t;
+    typedef MultiplyJob<SemiringTraits_tt> MultiplyJob_t;
+
+    assert(!leftArrays.empty() && !rightArrays.empty());
+    assert(leftArrays[0] ->getArrayDesc().getDimensions()[1].getLength() ==
+           rightArrays[0]->getArrayDesc().getDimensions()[0].getLength()); // a fundamental requirement of matrix arithmetic
+
+    // PART 1: load every column of right chunks into memory blocks, shared read-only by the jobs
+    double timeRightStart=getMonotonicrawSecs() ;
+    std::vector<RightColumn_t> rightColumns;
+    loadRightColumns<SemiringTraits_tt>(rightArrays, rightColumns, query);
+    times.loadRightSecs.push_back(getMonotonicrawSecs() - timeRightStart) ;
+
+    // PART 2: deal the rows of left chunks out to jobs on the operator threads,
+    //         each multiplying its rows of chunks by every column of right chunks
+    std::vector<ChunkRefs_t> leftRows;
+    getChunkGroups<CoordinatesComparatorRMO>(leftArrays, 0, leftRows);
+
+    size_t nJobs = 0;
+    if (!rightColumns.empty()) {
+        nJobs = std::min(leftRows.size(), size_t(Sysinfo::getNumberOfCPUs()));
+    }
+    std::vector<shared_ptr<MultiplyJob_t> > jobs(nJobs);
+    shared_ptr<JobQueue> queue = PhysicalOperator::getGlobalQueueForOperators();
+    for (size_t j = 0; j < nJobs; j++) {
+        jobs[j] = make_shared<MultiplyJob_t>(boost::ref(*this), leftArrays, leftRows, rightColumns, resultArray,
+                                             j, nJobs, hashed, query);
+        queue->pushJob(jobs[j]);
+    }
 
-    typedef SpgemmBlock<Value_t> RightBlock_t;
-    typedef boost::unordered_map<Coordinate, shared_ptr<RightBlock_t> > RightBlockMap_t; // a map of a column of right blocks
+    // the jobs refer to the locals above, so they must be waited for even if the overlapped work fails
+    try {
+        if (overlapped) {
+            overlapped();
+        }
+    } catch (...) {
+        for (size_t j = 0; j < nJobs; j++) {
+            jobs[j]->wait();
+        }
+        throw;
+    }
 
-    times.loadRightSecs.push_back(0) ;
+    int errorJob = -1;
+    for (size_t j = 0; j < nJobs; j++) {
+        if (!jobs[j]->wait()) {
+            errorJob = j;
+        }
+    }
+    if (errorJob >= 0) {
+        jobs[errorJob]->rethrow();
+    }
+
+    // the per-job times are thread times, summed: with several jobs they exceed the elapsed time
     times.loadLeftSecs.push_back(0) ;
     times.loadLeftCopySecs.push_back(0) ;
     times.blockFindSecs.push_back(0) ;
     times.blockMultSecs.push_back(0) ;
     times.flushSecs.push_back(0) ;
+    for (size_t j = 0; j < nJobs; j++) {
+        SpgemmTimes const& jobTimes = jobs[j]->getTimes();
+        times.loadLeftSecs.back() += jobTimes.loadLeftSecs.back();
+        times.loadLeftCopySecs.back() += jobTimes.loadLeftCopySecs.back();
+        times.blockFindSecs.back() += jobTimes.blockFindSecs.back();
+        times.blockMultSecs.back() += jobTimes.blockMultSecs.back();
+        times.flushSecs.back() += jobTimes.flushSecs.back();
+    }
+}
 
-    // method invariants:
-    size_t leftChunkRowSize = leftArray->getArrayDesc().getDimensions()[0].getChunkInterval();
-    size_t leftChunkColSize = leftArray->getArrayDesc().getDimensions()[1].getChunkInterval();
-
-    assert(leftArray ->getArrayDesc().getDimensions()[1].getLength() ==
-           rightArray->getArrayDesc().getDimensions()[0].getLength()); // a fundamental requirement of matrix arithmetic
-
-    // GRR. if it were not for SpAccumulator needing OpAdd_t, we could have passed the traits to this routine
-    //      as an enum, and it would not need to be templated on the semiring until just before the block spgemm<SemiringTraits_t>(...) call
-    //      and the only reason this needs to be as high as it is, is to keep reusing the SPA_t's storage repeatedly
-    Coordinate resultMinCol =     _schema.getDimensions()[1].getStartMin();
-    Coordinate resultArrayWidth = _schema.getDimensions()[1].getLength();
-    typedef SpAccumulator<Value_t, OpAdd_t> SPA_t; // an SPA efficiently accumulates (sparse row * sparse matrix).
-    SPA_t sparseRowAccumulator(resultMinCol, resultArrayWidth);     // TODO ...we can go block-relative on this and reduce the size
-                                                                    //         and adjust offset now that we flush each row to a single chunk
-
-    // get positions of all left and right chunks
-    vector<Coordinates> leftChunkPositions;
-    getChunkPositions<CoordinatesComparatorRMO>(leftArray, leftChunkPositions);
-    vector<Coordinates> rightChunkPositions;
-    getChunkPositions<CoordinatesComparatorCMO>(rightArray, rightChunkPositions);
 
-    // for every column of chunks in the right array.
-    vector<Coordinates>::iterator itChunkPositionsRight = rightChunkPositions.begin();
-    shared_ptr<ConstArrayIterator> arrayIterRight = rightArray->getConstIterator(0);
+template<class SemiringTraits_tt>
+void PhysicalSpgemm::loadRightColumns(std::vector<shared_ptr<Array> >& rightArrays,
+                                      std::vector<RightColumn<typename SemiringTraits_tt::Value_t> >& rightColumns,
+                                      const shared_ptr<Query>& query)
+{
+    typedef RightColumn<typename SemiringTraits_tt::Value_t> RightColumn_t;
+    typedef typename RightColumn_t::RightBlock_t RightBlock_t;
 
-    Coordinate lastColMonotonic = std::numeric_limits<Coordinate>::min();
-    while (itChunkPositionsRight != rightChunkPositions.end()) {
-        double timeRightStart=getMonotonicrawSecs() ;
+    std::vector<ChunkRefs_t> chunkCols;
+    getChunkGroups<CoordinatesComparatorCMO>(rightArrays, 1, chunkCols);
 
-        // PART 1: load a column of right chunks into memory blocks (owned by rightBlockMap)
-        RightBlockMap_t rightBlockMap;
+    std::vector<shared_ptr<ConstArrayIterator> > arrayItersRight(rightArrays.size());
+    for (size_t a = 0; a < rightArrays.size(); ++a) {
+        arrayItersRight[a] = rightArrays[a]->getConstIterator(0);
+    }
 
+    rightColumns.resize(chunkCols.size());
+    // for every column of chunks in the right arrays
+    for (size_t c = 0; c < chunkCols.size(); ++c) {
+        rightColumns[c].chunkCol = chunkCols[c].front().pos[1];
         // for chunks in a single column
-        Coordinate chunkCol = (*itChunkPositionsRight)[1]; // stay in this column
-        assert(lastColMonotonic <= chunkCol);
-        lastColMonotonic = chunkCol;                        // to support the above assertion
-
-        while (true) {
-            bool success = arrayIterRight->setPosition(*itChunkPositionsRight);
+        for (typename ChunkRefs_t::const_iterator it = chunkCols[c].begin(); it != chunkCols[c].end(); ++it) {
+            bool success = arrayItersRight[it->array]->setPosition(it->pos);
             SCIDB_ASSERT(success);
 
             // allocate the right kind and size of data structure for doing Spgemm (SpgemmBlock)
             // for a right-hand-side chunk, based on the pattern of non-zeros of the chunk
             // (e.g. nnz count, number of rows/cols occupied, etc).
-            ConstChunk const& curChunk = arrayIterRight->getChunk();
+            ConstChunk const& curChunk = arrayItersRight[it->array]->getChunk();
             size_t nnzEstimate = curChunk.count();
 
             ssize_t chunkRows = curChunk.getLastPosition(false)[0] - curChunk.getFirstPosition(false)[0] + 1;
             ssize_t chunkCols = curChunk.getLastPosition(false)[1] - curChunk.getFirstPosition(false)[1] + 1;
 
             shared_ptr<RightBlock_t> rightBlock =
-                SpgemmBlockFactory<SemiringTraits_tt>((*itChunkPositionsRight)[0], (*itChunkPositionsRight)[1],
-                                                      chunkRows, chunkCols, nnzEstimate);
+                SpgemmBlockFactory<SemiringTraits_tt>(it->pos[0], it->pos[1], chunkRows, chunkCols, nnzEstimate);
 
             // copy chunk to the SpgemmBlock
             copyChunkToBlock<SemiringTraits_tt, RightBlock_t>(curChunk, rightBlock, NULL, query);
 
             if (!rightBlock->empty()) {
-                rightBlockMap.insert(std::pair<Coordinate, shared_ptr<RightBlock_t> >((*itChunkPositionsRight)[0], rightBlock));
-            }
-            // next chunk in list of sorted chunks, until the chunk column changes
-            ++itChunkPositionsRight;
-            if (itChunkPositionsRight == rightChunkPositions.end() || (*itChunkPositionsRight)[1] != chunkCol) {
-                break;
+                rightColumns[c].blocks.insert(std::pair<Coordinate, shared_ptr<RightBlock_t> >(it->pos[0], rightBlock));
             }
         }
-        double copyRightSecs = getMonotonicrawSecs() - timeRightStart;
-        times.loadRightSecs.back() += copyRightSecs;
-
-        // PART 2: for each column of right chunks, above, go through every row of left chunks
-        //         to multiply the left row of chunks by the colunn of right chunks
-
-        // for every row of chunks in the left array.
-        shared_ptr<ConstArrayIterator> leftArrayIt = leftArray->getConstIterator(0);
-        vector<Coordinates>::iterator leftPosIt = leftChunkPositions.begin();
-        while(leftPosIt != leftChunkPositions.end()) {
-            double timeLeftStart=getMonotonicrawSecs() ;
-            // part 2A: load a row of right chunks into memory blocks (owned by leftBlockList)
-            //          while also finding the set of rows occupied by these blocks (leftRowsInUse)
-            typedef pair<Coordinate, shared_ptr<LeftBlock_t> > ColBlockPair_t ;
-            typedef std::vector<ColBlockPair_t> LeftBlockList_t;  // TODO: should this be made a list?
-            typedef typename std::vector< ColBlockPair_t >::iterator LeftBlockListIt_t;
-            LeftBlockList_t leftBlockList;
-                                                                // TODO: the tree here is too expensive when it becomes ultra-sparse
-            typedef std::set<Coordinate> LeftRowOrderedSet_t ;  // TODO: try making this std::map<pair<Coord, std::set<pair<Coord, shared_ptr<Block_t>> >
-            LeftRowOrderedSet_t leftRowsInUse;                  //       and iteration will skip blocks not involved in the row, rather
-                                                                //       than looking them up in the map and then checking.
-
-            // for every chunk in the left row of chunks
-            Coordinate chunkRow = (*leftPosIt)[0]; // stay in this row-of-chunks
-            while (true) {
-                // copy chunk to block
-                shared_ptr<LeftBlock_t> leftBlock = make_shared<LeftBlock_t>((*leftPosIt)[0], (*leftPosIt)[1],
-                                                                             leftChunkRowSize, leftChunkColSize, 0);
-                bool success = leftArrayIt->setPosition(*leftPosIt);
-                SCIDB_ASSERT(success);
-                double timeLeftCopyStart=getMonotonicrawSecs() ;
-                copyChunkToBlock<SemiringTraits_tt, LeftBlock_t>(leftArrayIt->getChunk(), leftBlock, &leftRowsInUse, query);
-                double chunkCopySecs = getMonotonicrawSecs() - timeLeftCopyStart;
-                times.loadLeftCopySecs.back() += chunkCopySecs;
-
-                if (!leftBlock->empty()) {
-                    leftBlockList.push_back(std::pair<Coordinate, shared_ptr<LeftBlock_t> >((*leftPosIt)[1], leftBlock));
-                }
-                // next chunk in list of sorted chunks, until the chunk column changes
-                ++leftPosIt;
-                if (leftPosIt == leftChunkPositions.end() || (*leftPosIt)[0] != chunkRow) {
-                    break;
-                }
+    }
+}
+
+
+template<class SemiringTraits_tt>
+void PhysicalSpgemm::multiplyRows(std::vector<shared_ptr<Array> > const& leftArrays,
+                                  std::vector<ChunkRefs_t> const& leftRows,
+                                  std::vector<RightColumn<typename SemiringTraits_tt::Value_t> > const& rightColumns,
+                                  shared_ptr<MemArray> const& resultArray,
+                                  size_t jobNum, size_t nJobs, bool hashed,
+                                  shared_ptr<Query>& query, SpgemmTimes& times)
+{
+    typedef typename SemiringTraits_tt::Value_t Value_t;
+    typedef typename SemiringTraits_tt::OpAdd_t OpAdd_t ;
+    typedef typename SemiringTraits_tt::IdAdd_t IdAdd_t ;
+    typedef CSRBlock<Value_t> LeftBlock_t; // chunks will be converted to matrix blocks which are efficient for sparse operations
+    typedef RightColumn<Value_t> RightColumn_t;
+    typedef typename RightColumn_t::RightBlock_t RightBlock_t;
+    typedef typename RightColumn_t::RightBlockMap_t RightBlockMap_t;
+
+    times.loadLeftSecs.push_back(0) ;
+    times.loadLeftCopySecs.push_back(0) ;
+    times.blockFindSecs.push_back(0) ;
+    times.blockMultSecs.push_back(0) ;
+    times.flushSecs.push_back(0) ;
+
+    // method invariants:
+    size_t leftChunkRowSize = leftArrays[0]->getArrayDesc().getDimensions()[0].getChunkInterval();
+    size_t leftChunkColSize = leftArrays[0]->getArrayDesc().getDimensions()[1].getChunkInterval();
+
+    // GRR. if it were not for SpAccumulator needing OpAdd_t, we could have passed the traits to this routine
+    //      as an enum, and it would not need to be templated on the semiring until just before the block spgemm<SemiringTraits_t>(...) call
+    //      and the only reason this needs to be as high as it is, is to keep reusing the SPA_t's storage repeatedly
+    Coordinate resultMinCol =     _schema.getDimensions()[1].getStartMin();
+    Coordinate resultArrayWidth = _schema.getDimensions()[1].getLength();
+    typedef SpAccumulator<Value_t, OpAdd_t> SPA_t; // an SPA efficiently accumulates (sparse row * sparse matrix).
+    SPA_t sparseRowAccumulator(resultMinCol, resultArrayWidth, hashed); // TODO ...we can go block-relative on this and reduce the size
+                                                                        //         and adjust offset now that we flush each row to a single chunk
+
+    // iterators of this job's own, as neither array iterators nor chunk iterators are shared between threads
+    std::vector<shared_ptr<ConstArrayIterator> > leftArrayIters(leftArrays.size());
+    for (size_t a = 0; a < leftArrays.size(); ++a) {
+        leftArrayIters[a] = leftArrays[a]->getConstIterator(0);
+    }
+    shared_ptr<ArrayIterator> resultArrayIter = resultArray->getIterator(0);
+
+    // for this job's rows of chunks in the left arrays.
+    for (size_t r = jobNum; r < leftRows.size(); r += nJobs) {
+        double timeLeftStart=getMonotonicrawSecs() ;
+        // part 2A: load a row of left chunks into memory blocks (owned by leftBlockList)
+        //          while also finding the set of rows occupied by these blocks (leftRowsInUse)
+        typedef pair<Coordinate, shared_ptr<LeftBlock_t> > ColBlockPair_t ;
+        typedef std::vector<ColBlockPair_t> LeftBlockList_t;  // TODO: should this be made a list?
+        typedef typename std::vector< ColBlockPair_t >::iterator LeftBlockListIt_t;
+        LeftBlockList_t leftBlockList;
+                                                            // TODO: the tree here is too expensive when it becomes ultra-sparse
+        typedef std::set<Coordinate> LeftRowOrderedSet_t ;  // TODO: try making this std::map<pair<Coord, std::set<pair<Coord, shared_ptr<Block_t>> >
+        LeftRowOrderedSet_t leftRowsInUse;                  //       and iteration will skip blocks not involved in the row, rather
+                                                            //       than looking them up in the map and then checking.
+
+        // for every chunk in the left row of chunks
+        Coordinate chunkRow = leftRows[r].front().pos[0];
+        for (typename ChunkRefs_t::const_iterator it = leftRows[r].begin(); it != leftRows[r].end(); ++it) {
+            // copy chunk to block
+            shared_ptr<LeftBlock_t> leftBlock = make_shared<LeftBlock_t>(it->pos[0], it->pos[1],
+                                                                         leftChunkRowSize, leftChunkColSize, 0);
+            bool success = leftArrayIters[it->array]->setPosition(it->pos);
+            SCIDB_ASSERT(success);
+            double timeLeftCopyStart=getMonotonicrawSecs() ;
+            copyChunkToBlock<SemiringTraits_tt, LeftBlock_t>(leftArrayIters[it->array]->getChunk(), leftBlock, &leftRowsInUse, query);
+            double chunkCopySecs = getMonotonicrawSecs() - timeLeftCopyStart;
+            times.loadLeftCopySecs.back() += chunkCopySecs;
+
+            if (!leftBlock->empty()) {
+                leftBlockList.push_back(std::pair<Coordinate, shared_ptr<LeftBlock_t> >(it->pos[1], leftBlock));
             }
+        }
+
+        double leftCopySecs = getMonotonicrawSecs() - timeLeftStart;
+        times.loadLeftSecs.back() += leftCopySecs ;
 
-            double leftCopySecs = getMonotonicrawSecs() - timeLeftStart;
-            times.loadLeftSecs.back() += leftCopySecs ;
+        // part 2B: for each column of right chunks, and every row in the blocks in leftBlockList,
+        //          multiply by the corresponding block in the column while accumulating the resulting row in the SPA
+        for (size_t c = 0; c < rightColumns.size(); ++c) {
             double timeBlockFindStart=getMonotonicrawSecs() ;
+            double blockMultSecs = 0;
+            RightBlockMap_t const& rightBlockMap = rightColumns[c].blocks;
 
-            // part 2B: for every row in the blocks in leftBlockList, multiply by the corresponding block in rightBlockMap
-            //          while accumulating the resulting row in the SPA
-            //
             Coordinates resultChunkPos(2);
-            resultChunkPos[0] = chunkRow; resultChunkPos[1] = chunkCol ;
+            resultChunkPos[0] = chunkRow; resultChunkPos[1] = rightColumns[c].chunkCol ;
 
             // for every row used in the left row-of-chunks
             shared_ptr<ChunkIterator> currentResultChunk; // lazy creation by sparseRowAccumulator
@@ -459,23 +767,24 @@ void PhysicalSpgemm::spGemmColumnSubset(shared_ptr<Array>& leftArray, shared_ptr
                 for(LeftBlockListIt_t leftBlocksIt=leftBlockList.begin(); leftBlocksIt != leftBlockList.end(); ++leftBlocksIt) {
                     Coordinate leftBlockCol = (*leftBlocksIt).first ;
                     // find the corresponding right chunk
-                    typename RightBlockMap_t::iterator rightBlocksIt = rightBlockMap.find(leftBlockCol); // same rightBlockRow as leftBlockCol
+                    typename RightBlockMap_t::const_iterator rightBlocksIt = rightBlockMap.find(leftBlockCol); // same rightBlockRow as leftBlockCol
                     if (rightBlocksIt != rightBlockMap.end()) { // if a matching rightBlock was found
                         LeftBlock_t&  leftBlock  = *(leftBlocksIt->second);
                         RightBlock_t& rightBlock = *(rightBlocksIt->second);
                         // leftBlock[leftRow,:] * rightBlock[:,:]
                         double timeBlockMultStart=getMonotonicrawSecs() ;
                         spGemm<SemiringTraits_tt>(leftRow, leftBlock, rightBlock, sparseRowAccumulator);
-                        times.blockMultSecs.back() += (getMonotonicrawSecs() - timeBlockMultStart);
+                        blockMultSecs += (getMonotonicrawSecs() - timeBlockMultStart);
                     }
                 } // end for each block along that row in the left row-of-chunks
                 // the result row is totally accumulated in the SPA
                 currentResultChunk = spAccumulatorFlushToChunk<IdAdd_t>(sparseRowAccumulator, leftRow,
-                                                               resultArray, currentResultChunk, resultChunkPos,
+                                                               resultArrayIter, currentResultChunk, resultChunkPos,
                                                                _typeEnum, _type, query);
             } // end- for every row used in the left row of chunks
             double multSecs = getMonotonicrawSecs() - timeBlockFindStart;
-            times.blockFindSecs.back() += (multSecs - times.blockMultSecs.back());
+            times.blockMultSecs.back() += blockMultSecs;
+            times.blockFindSecs.back() += (multSecs - blockMultSecs);
 
             if (currentResultChunk) {          // at least one of the rows in the output chunk had a non-zero
                 double timeFlushStart = getMonotonicrawSecs();
@@ -483,15 +792,37 @@ void PhysicalSpgemm::spGemmColumnSubset(shared_ptr<Array>& leftArray, shared_ptr
                 double flushSecs = getMonotonicrawSecs() - timeFlushStart;
                 times.flushSecs.back() += flushSecs;
             }
-        } // end every row of chunks in left array
-    } // end every column of chunks in right array
-
-    // the time inside the block multiply was counted twice.
-    // we correct it now by subtracting the blockMult time from the blockFind time
-    times.blockFindSecs.back() -= times.blockMultSecs.back();
+        } // end every column of chunks in right arrays
+    } // end this job's rows of chunks in left arrays
 } // end method
 
 
+template<class CoordinatesComparator_tt>
+void PhysicalSpgemm::getChunkGroups(std::vector<shared_ptr<Array> >& arrays, size_t groupDim, std::vector<ChunkRefs_t>& result)
+{
+    ChunkRefs_t chunks;
+    for (size_t a = 0; a < arrays.size(); ++a) {
+        vector<Coordinates> positions;
+        getChunkPositions<CoordinatesComparator_tt>(arrays[a], positions);
+        for (size_t i = 0; i < positions.size(); ++i) {
+            SpgemmChunkRef ref;
+            ref.pos = positions[i];
+            ref.array = a;
+            chunks.push_back(ref);
+        }
+    }
+    if (arrays.size() > 1) {
+        sort(chunks.begin(), chunks.end(), SpgemmChunkRefLess<CoordinatesComparator_tt>());
+    }
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        if (i == 0 || chunks[i].pos[groupDim] != chunks[i-1].pos[groupDim]) {
+            result.push_back(ChunkRefs_t());
+        }
+        result.back().push_back(chunks[i]);
+    }
+}
+
+
 template<class CoordinatesComparator_tt>
 void PhysicalSpgemm::getChunkPositions(shared_ptr<Array>& array, vector<Coordinates>& result)
 {
@@ -31,6 +31,8 @@
 
 // std::
 #include <vector>
+// boost::
+#include <boost/unordered_map.hpp>
 // scidb::
 #include "array/Array.h"
 
@@ -49,6 +51,11 @@ namespace scidb
  *
  * This is done by maintaining an array of values, an array of flags indicating whether the corresponding value is in use,
  * and a list of indices of values in use.  For details see [Gilbert1991].
+ *
+ * The dense arrays cost O(indexSize) memory per SPA, which is too much when the index range is very wide
+ * and the rows are very sparse, or when there is one SPA per thread.  A "hashed" SPA keeps the values in
+ * a hash table instead, trading a constant factor in addScatter() for memory proportional to the number
+ * of values actually accumulated.
  * @note
  *     [Gilbert1991] Gilbert, Moler, and Schreiber, SIAM Journal on Matrix Analysis and Applications, 13.1 (1992) pp 333-356<br>
  * *   [Gustavson1978] Gustavson, Fred G, ACM Transactions on Mathematical Software, Vol 4, No 3, September 1978, pp 250-269<br>
@@ -66,8 +73,9 @@ public:
      * constructor -- initializes the SPA to contain no values.
      * @param indexBegin -- minumum index that will be used
      * @param indexSize  -- the number of consecutive indices that can be used.
+     * @param hashed     -- keep the values in a hash table rather than dense arrays of indexSize
      */
-    SpAccumulator(ssize_t indexBegin, size_t indexSize);
+    SpAccumulator(ssize_t indexBegin, size_t indexSize, bool hashed=false);
     /**
      * reset the SPA to contain no non-zeros.
      */
@@ -117,7 +125,7 @@ public:
         bool operator!=(const_iterator rhs) const { return !(*this==rhs); }
         const IdxValPair operator*() const {
             size_t indexZeroBased = *(_indicesUsedIt) ;
-            assert(_accumulator._valsUsed[indexZeroBased]);
+            assert(_accumulator.isUsed(indexZeroBased));
             return _accumulator.getExternalIdxVal(indexZeroBased);
         }
         const_iterator& operator++() { ++_indicesUsedIt; return *this;}
@@ -144,7 +152,12 @@ public:
          */
         IdxValPair consume() { // like operator*(), but this one resets _valsUsed while its still in the cache
             size_t indexZeroBased = *(Base_t::_indicesUsedIt) ;
-            assert(Base_t::_accumulator._valsUsed[indexZeroBased]);
+            assert(Base_t::_accumulator.isUsed(indexZeroBased));
+            if (Base_t::_accumulator._hashed) {
+                IdxValPair result = Base_t::_accumulator.getExternalIdxVal(indexZeroBased);
+                Base_t::_accumulator._hashValues.erase(indexZeroBased);
+                return result;
+            }
             Base_t::_accumulator._valsUsed[indexZeroBased] = false; // the one difference from operator*() !!
             return Base_t::_accumulator.getExternalIdxVal(indexZeroBased);
         }
@@ -171,8 +184,12 @@ public:
      */
     typedef Val_tt Val_t ;
 private:
+    bool isUsed(size_t indexZeroBased) const {
+        return _hashed ? _hashValues.find(indexZeroBased) != _hashValues.end() : bool(_valsUsed[indexZeroBased]);
+    }
+
     IdxValPair getExternalIdxVal(size_t indexZeroBased) {
-        Val_tt value = _values[indexZeroBased];
+        Val_tt value = _hashed ? _hashValues.find(indexZeroBased)->second : _values[indexZeroBased];
         ssize_t indexExternal = _minExternalIndex + indexZeroBased;
         return IdxValPair(indexExternal, value) ;
     }
@@ -184,17 +201,24 @@ private:
     typedef typename std::vector<ssize_t> IndicesUsed_t;
     IndicesUsed_t           _indicesUsed;  // indices in _values[] that are in use
     ssize_t                 _minExternalIndex;
+    size_t                  _indexSize;
+
+    typedef boost::unordered_map<size_t, Val_tt> HashValues_t;
+    bool                    _hashed;
+    HashValues_t            _hashValues;   // replaces _values and _valsUsed when _hashed
 };
 
 
 // construction is O(size)
 template<class Val_tt, class OpAdd_tt>
-SpAccumulator<Val_tt, OpAdd_tt>::SpAccumulator(ssize_t indexBegin, size_t indexSize)
+SpAccumulator<Val_tt, OpAdd_tt>::SpAccumulator(ssize_t indexBegin, size_t indexSize, bool hashed)
 :
-    _values(indexSize),             // pre-allocated, doesn't actually need initialization. will hold values at indices written in random order
-    _valsUsed(indexSize,false),     // pre-allocated, initialized false.     _valsUsed[i] will be true <-> values[i] was addScattered()
-    _indicesUsed(),                 // maintained by doing .push_back(i) when _valsUsed[i] is first set true.
-    _minExternalIndex(indexBegin)
+    _values(hashed ? 0 : indexSize),            // pre-allocated, doesn't actually need initialization. will hold values at indices written in random order
+    _valsUsed(hashed ? 0 : indexSize,false),    // pre-allocated, initialized false.     _valsUsed[i] will be true <-> values[i] was addScattered()
+    _indicesUsed(),                             // maintained by doing .push_back(i) when _valsUsed[i] is first set true.
+    _minExternalIndex(indexBegin),
+    _indexSize(indexSize),
+    _hashed(hashed)
 {
     assert(indexSize >= 1);
 }
@@ -203,8 +227,12 @@ SpAccumulator<Val_tt, OpAdd_tt>::SpAccumulator(ssize_t indexBegin, size_t indexS
 template<class Val_tt, class OpAdd_tt>
 void SpAccumulator<Val_tt, OpAdd_tt>::reset()
 {
-    for(typename IndicesUsed_t::iterator it = _indicesUsed.begin(); it != _indicesUsed.end(); ++it) {
-        _valsUsed[ *it ] = false;
+    if (_hashed) {
+        _hashValues.clear();
+    } else {
+        for(typename IndicesUsed_t::iterator it = _indicesUsed.begin(); it != _indicesUsed.end(); ++it) {
+            _valsUsed[ *it ] = false;
+        }
     }
     _indicesUsed.clear();   // retention of capacity (no reallocation) is helpful here.
 }
@@ -217,8 +245,17 @@ void SpAccumulator<Val_tt, OpAdd_tt>::addScatter(Val_tt value, ssize_t index)
     ssize_t tmp = index - _minExternalIndex ;
     assert(tmp >= 0);   // works until size is so big, it wouldn't be addressable as an index in this process
     size_t indexZeroBased = tmp ;
-    assert(indexZeroBased <  _values.size());
+    assert(indexZeroBased <  _indexSize);
 
+    if (_hashed) {
+        std::pair<typename HashValues_t::iterator, bool> found = _hashValues.insert(std::make_pair(indexZeroBased, value));
+        if (found.second) {
+            _indicesUsed.push_back(indexZeroBased);
+        } else {
+            found.first->second = OpAdd_tt::operate(found.first->second, value);
+        }
+        return;
+    }
 
     if( !_valsUsed[indexZeroBased]) {
         _valsUsed[indexZeroBased] = true ;
@@ -0,0 +1,98 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+#ifndef SPGEMM_OPTIONS_H_
+#define SPGEMM_OPTIONS_H_
+
+/*
+ * SpgemmOptions.h
+ *
+ *  Parsing of the optional string argument of spgemm(), shared by the logical and physical operators.
+ */
+
+// std::
+#include <sstream>
+#include <string>
+// scidb::
+#include "system/Exceptions.h"
+
+namespace scidb
+{
+
+/**
+ * The options of spgemm(), given as a comma-separated list in its optional string argument, e.g. "min.+,2d".
+ *   - "min.+", "max.+", "count-mults": the semiring (default: ordinary arithmetic); at most one
+ *   - "2d":   distribute the multiplication over a 2-D grid of instances rather than rotating the right matrix
+ *   - "hash": use hashed sparse accumulators regardless of the width of the result
+ */
+struct SpgemmOptions
+{
+    enum Semiring { SRING_PLUS_STAR, SRING_MIN_PLUS, SRING_MAX_PLUS, SRING_COUNT_MULTS };
+
+    Semiring    semiring;
+    bool        twoD;
+    bool        hashedAccumulator;
+
+    /**
+     * @param options the option string; may be empty
+     * @throw SystemException if an option is not recognized or more than one semiring is named
+     */
+    explicit SpgemmOptions(std::string const& options = std::string())
+    :
+        semiring(SRING_PLUS_STAR),
+        twoD(false),
+        hashedAccumulator(false)
+    {
+        bool semiringGiven = false;
+        std::istringstream in(options);
+        std::string option;
+        while (std::getline(in, option, ',')) {
+            if (option.empty()) {
+                continue;
+            }
+            if (option == "2d") {
+                twoD = true;
+            } else if (option == "hash") {
+                hashedAccumulator = true;
+            } else {
+                if (option == "min.+") {
+                    semiring = SRING_MIN_PLUS;
+                } else if (option == "max.+") {
+                    semiring = SRING_MAX_PLUS;
+                } else if (option == "count-mults") {
+                    semiring = SRING_COUNT_MULTS;
+                } else {
+                    throw (SYSTEM_EXCEPTION(SCIDB_SE_INTERNAL, SCIDB_LE_OPERATION_FAILED)
+                           << "spgemm(): unrecognized option '" << option << "'");
+                }
+                if (semiringGiven) {
+                    throw (SYSTEM_EXCEPTION(SCIDB_SE_INTERNAL, SCIDB_LE_OPERATION_FAILED)
+                           << "spgemm(): more than one semiring in options '" << options << "'");
+                }
+                semiringGiven = true;
+            }
+        }
+    }
+};
+
+} // end namespace scidb
+
+#endif // SPGEMM_OPTIONS_H_
@@ -80,6 +80,19 @@ string ClientMessageHandleJob::getProgramOptions(std::string const& programOptio
     return ip.str();
 }
 
+namespace
+{
+    /// @return the values of the $placeholders the client sent with the query
+    QueryParameters getQueryParameters(scidb_msg::Query const& record)
+    {
+        QueryParameters parameters;
+        for (int i = 0; i < record.parameters_size(); i++) {
+            parameters[record.parameters(i).name()] = record.parameters(i).value();
+        }
+        return parameters;
+    }
+}
+
 void
 ClientMessageHandleJob::executeSerially(shared_ptr<WorkQueue>& serialQueue,
                                         weak_ptr<WorkQueue>& initialQueue,
@@ -398,7 +411,8 @@ void ClientMessageHandleJob::prepareClientQuery()
         assert(queryResult.queryID > 0);
         try
         {
-            scidb.prepareQuery(queryString, afl, getProgramOptions(programOptions), queryResult);
+            scidb.prepareQuery(queryString, afl, getProgramOptions(programOptions),
+                               getQueryParameters(*record), queryResult);
         }
         catch (const scidb::SystemCatalog::LockBusyException& e)
         {
@@ -538,7 +552,8 @@ void ClientMessageHandleJob::executeClientQuery()
             _connection->attachQuery(queryResult.queryID);
             try
             {
-                scidb.prepareQuery(queryString, afl, getProgramOptions(programOptions), queryResult);
+                scidb.prepareQuery(queryString, afl, getProgramOptions(programOptions),
+                                   getQueryParameters(*record), queryResult);
             }
             catch (const scidb::SystemCatalog::LockBusyException& e)
             {
@@ -611,6 +626,7 @@ void ClientMessageHandleJob::postExecuteQueryInternal(scidb::QueryResult& queryR
     queryResultRecord->set_execution_time(queryResult.executionTime);
     queryResultRecord->set_explain_logical(queryResult.explainLogical);
     queryResultRecord->set_explain_physical(queryResult.explainPhysical);
+    queryResultRecord->set_explain_analyze(queryResult.explainAnalyze);
     queryResultRecord->set_selective(queryResult.selective);
 
     if (queryResult.selective)
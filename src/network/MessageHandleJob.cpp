@@ -40,9 +40,13 @@
 #include <smgr/io/Storage.h>
 #include <system/Cluster.h>
 #include <system/Exceptions.h>
+#include <system/Config.h>
 #include <system/Resources.h>
+#include <system/SciDBConfigOptions.h>
+#include <system/SystemCatalog.h>
 #include <util/RWLock.h>
 #include <util/Thread.h>
+#include <util/Tracer.h>
 #include <query/PullSGContext.h>
 
 using namespace std;
@@ -541,6 +545,9 @@ void ServerMessageHandleJob::handlePreparePhysicalPlan()
     ASSERT_EXCEPTION((clusterUuid==Cluster::getInstance()->getUuid()),
                      (string(funcName)+string("unknown cluster UUID=")+clusterUuid));
 
+    // The metadata cached here may predate updates the coordinator has seen
+    SystemCatalog::getInstance()->validateCache(ppMsg->catalog_version());
+
     const string physicalPlan = ppMsg->physical_plan();
 
     LOG4CXX_DEBUG(logger,  funcName << "Preparing physical plan: queryID="
@@ -594,6 +601,16 @@ void ServerMessageHandleJob::handleExecutePhysicalPlan()
       boost::shared_ptr<MessageDesc> resultMessage = boost::make_shared<MessageDesc>(mtQueryResult);
       resultMessage->setQueryID(_query->getQueryID());
 
+      if (Config::getInstance()->getOption<bool>(CONFIG_PROFILE_QUERIES)) {
+          // The profiles of the plan nodes, merged by the coordinator into explain analyze
+          vector<uint64_t> profiles;
+          _query->getCurrentPhysicalPlan()->getProfiles(profiles);
+          boost::shared_ptr<scidb_msg::QueryResult> resultRecord = resultMessage->getRecord<scidb_msg::QueryResult>();
+          for (size_t i = 0; i < profiles.size(); i++) {
+              resultRecord->add_operator_profiles(profiles[i]);
+          }
+      }
+
       networkManager.sendMessage(_messageDesc->getSourceInstanceID(), resultMessage);
       LOG4CXX_DEBUG(logger, "Result was sent to instance #" << _messageDesc->getSourceInstanceID());
    }
@@ -613,13 +630,23 @@ void ServerMessageHandleJob::handleQueryResult()
         handleInvalidMessage();
     }
 
-    const string arrayName = _messageDesc->getRecord<scidb_msg::QueryResult>()->array_name();
+    boost::shared_ptr<scidb_msg::QueryResult> resultRecord = _messageDesc->getRecord<scidb_msg::QueryResult>();
+    const string arrayName = resultRecord->array_name();
 
     LOG4CXX_DEBUG(logger,  funcName << "Received query result from instance#"
                   << _messageDesc->getSourceInstanceID()
                   << ", queryID=" << _messageDesc->getQueryID()
                   << ", arrayName=" << arrayName)
 
+    if (resultRecord->operator_profiles_size() > 0) {
+        const vector<uint64_t> profiles(resultRecord->operator_profiles().begin(),
+                                        resultRecord->operator_profiles().end());
+        if (!_query->getCurrentPhysicalPlan()->mergeProfiles(&profiles[0], profiles.size())) {
+            LOG4CXX_WARN(logger, funcName << "Ignoring the operator profiles of instance#"
+                         << _messageDesc->getSourceInstanceID() << ": they do not match the plan");
+        }
+    }
+
     // Signaling to query context to defreeze
     _query->results.release();
 }
@@ -657,6 +684,7 @@ void ServerMessageHandleJob::_handleChunkOrAggregateChunk(bool isAggregateChunk)
 
         ScopedMutexLock cs(_query->resultCS);
         shared_ptr<CompressedBuffer> compressedBuffer = dynamic_pointer_cast<CompressedBuffer>(_messageDesc->getBinary());
+        TraceScope trace(Tracer::SG_RECEIVE, compressedBuffer ? compressedBuffer->getSize() : 0);
         shared_ptr<SGChunkReceiver> chunkReceiver = sgCtx->_chunkReceiver;
         assert(chunkReceiver);
         Coordinates coordinates;
@@ -774,7 +802,9 @@ void ServerMessageHandleJob::handleReplicaChunk()
         boost::shared_ptr<ArrayIterator> outputIter = dbArr->getIterator(attributeID);
         boost::shared_ptr<CompressedBuffer> compressedBuffer =
             dynamic_pointer_cast<CompressedBuffer>(_messageDesc->getBinary());
-        compressedBuffer->setCompressionMethod(compMethod);
+        compressedBuffer->setCompressionMethod(chunkRecord->has_wire_compression_method()
+                                               ? chunkRecord->wire_compression_method()
+                                               : compMethod);
         compressedBuffer->setDecompressedSize(decompressedSize);
         Chunk& outChunk = outputIter->newChunk(coordinates, compMethod);
         try
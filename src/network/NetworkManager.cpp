@@ -46,6 +46,7 @@
 #include "smgr/io/Storage.h"
 #include "util/PluginManager.h"
 #include "util/Notification.h"
+#include "util/Tracer.h"
 #include "system/Constants.h"
 #include <system/Utils.h>
 
@@ -623,6 +624,20 @@ size_t NetworkManager::getPhysicalInstances(std::vector<InstanceID>& instances)
    return instances.size();
 }
 
+void NetworkManager::countSent(const shared_ptr<MessageDesc>& msg)
+{
+    // The record is only serialized by the connection, count the header and the binary
+    shared_ptr<SharedBuffer> binary = msg->getBinary();
+    const size_t size = sizeof(MessageHeader) + (binary ? binary->getSize() : 0);
+    currentStatistics->sentSize += size;
+    currentStatistics->sentMessages++;
+    addToCurrentProfile(OperatorProfile::BYTES_SENT, size);
+    if (Tracer::isEnabled()) {
+        const uint64_t now = Tracer::now();
+        Tracer::record(Tracer::SG_SEND, now, now, size, NULL);
+    }
+}
+
 void
 NetworkManager::send(InstanceID targetInstanceID,
                      shared_ptr<MessageDesc>& msg)
@@ -633,6 +648,7 @@ NetworkManager::send(InstanceID targetInstanceID,
    }
    shared_ptr<Query> query = Query::getQueryByID(msg->getQueryID());
    InstanceID target = query->mapLogicalToPhysical(targetInstanceID);
+   countSent(msg);
    sendMessage(target, msg);
 }
 
@@ -641,6 +657,7 @@ void NetworkManager::send(InstanceID targetInstanceID, shared_ptr<SharedBuffer>
     shared_ptr<MessageDesc> msg = make_shared<MessageDesc>(mtBufferSend, data);
     msg->setQueryID(query->getQueryID());
     InstanceID target = query->mapLogicalToPhysical(targetInstanceID);
+    countSent(msg);
     sendMessage(target, msg);
 }
 
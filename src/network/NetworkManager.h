@@ -233,6 +233,11 @@ class NetworkManager: public Singleton<NetworkManager>
                       boost::shared_ptr<MessageDesc>& messageDesc,
                       MessageQueueType flowControlType = mqtNone);
 
+    /**
+     * Count a message sent on behalf of the current operator
+     */
+    static void countSent(const boost::shared_ptr<MessageDesc>& msg);
+
     static void handleLivenessNotification(boost::shared_ptr<const InstanceLiveness> liveInfo) {
        getInstance()->_handleLivenessNotification(liveInfo);
     }
@@ -200,6 +200,7 @@ void runSciDB()
    }
 #endif
    boost::shared_ptr<JobQueue> messagesJobQueue = boost::make_shared<JobQueue>();
+   messagesJobQueue->setName("messages");
 
    // Here we can play with thread number
    // TODO: For SG operations probably we should have separate thread pool
@@ -262,6 +263,7 @@ void runSciDB()
       if (messagesThreadPool) {
          messagesThreadPool->stop();
       }
+      SharedMemCache::getInstance().stopBackgroundWriter();
       StorageManager::getInstance().close();
       ReplicationManager::getInstance()->stop();
    }
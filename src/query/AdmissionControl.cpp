@@ -0,0 +1,235 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file AdmissionControl.cpp
+ *
+ * @brief Memory-governed admission of client queries on the coordinator.
+ */
+
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <log4cxx/logger.h>
+
+#include <array/MemArray.h>
+#include <query/OperatorLibrary.h>
+#include <query/Query.h>
+#include <system/Config.h>
+#include <system/SciDBConfigOptions.h>
+
+#include "query/AdmissionControl.h"
+#include "query/QueryPlan.h"
+
+using namespace std;
+using namespace boost;
+
+namespace scidb
+{
+
+static log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("scidb.qproc.admission"));
+
+AdmissionQueue::AdmissionQueue(uint64_t limit)
+: _limit(limit),
+  _reserved(0),
+  _nextTicket(0)
+{
+}
+
+bool AdmissionQueue::tryAdmit(QueryID queryID, Priority priority, uint64_t estimate, uint64_t footprint)
+{
+    if (_running.find(queryID) != _running.end()) {
+        return true;
+    }
+    if (estimate == 0) {
+        // nothing to wait for
+        release(queryID);
+        _running[queryID] = 0;
+        return true;
+    }
+    map<QueryID, Ticket>::iterator t = _tickets.find(queryID);
+    if (t == _tickets.end()) {
+        Ticket ticket(priority, _nextTicket++);
+        t = _tickets.insert(make_pair(queryID, ticket)).first;
+        _waiting[ticket] = queryID;
+    }
+
+    // Strictly in line, so that large queries are not starved by a stream of small ones
+    if (_waiting.begin()->second != queryID) {
+        return false;
+    }
+    uint64_t const inUse = std::max(_reserved, footprint);
+    if (!_running.empty() && inUse + estimate > _limit) {
+        return false;
+    }
+    _waiting.erase(t->second);
+    _tickets.erase(t);
+    _running[queryID] = estimate;
+    _reserved += estimate;
+    return true;
+}
+
+void AdmissionQueue::release(QueryID queryID)
+{
+    map<QueryID, uint64_t>::iterator r = _running.find(queryID);
+    if (r != _running.end()) {
+        assert(_reserved >= r->second);
+        _reserved -= r->second;
+        _running.erase(r);
+        return;
+    }
+    map<QueryID, Ticket>::iterator t = _tickets.find(queryID);
+    if (t != _tickets.end()) {
+        _waiting.erase(t->second);
+        _tickets.erase(t);
+    }
+}
+
+namespace
+{
+    uint64_t getAdmissionLimit()
+    {
+        int limit = Config::getInstance()->getOption<int>(CONFIG_ADMISSION_MEMORY_LIMIT);
+        if (limit < 0) {
+            limit = Config::getInstance()->getOption<int>(CONFIG_MAX_MEMORY_LIMIT);
+        }
+        return limit > 0 ? static_cast<uint64_t>(limit) * MiB : 0;
+    }
+
+    bool hasMemoryHungryNode(shared_ptr<LogicalQueryPlanNode> const& node)
+    {
+        if (!node) {
+            return false;
+        }
+        if (OperatorLibrary::getInstance()->isMemoryHungry(node->getLogicalOperator()->getLogicalName())) {
+            return true;
+        }
+        vector<shared_ptr<LogicalQueryPlanNode> >& children = node->getChildren();
+        for (size_t i = 0; i < children.size(); i++) {
+            if (hasMemoryHungryNode(children[i])) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    class ArenaUsage
+    {
+    public:
+        ArenaUsage() : _total(0) {}
+
+        bool operator!() const
+        {
+            return false;
+        }
+
+        void operator()(const shared_ptr<Query>& query)
+        {
+            if (arena::ArenaPtr arena = query->getArena()) {
+                _total += arena->allocated();
+            }
+        }
+
+        uint64_t getTotal() const
+        {
+            return _total;
+        }
+
+    private:
+        uint64_t _total;
+    };
+}
+
+AdmissionControl::AdmissionControl()
+: _queue(getAdmissionLimit())
+{
+}
+
+AdmissionQueue::Priority AdmissionControl::classify(const shared_ptr<Query>& query, uint64_t& estimate)
+{
+    estimate = 0;
+    if (!query->logicalPlan || !hasMemoryHungryNode(query->logicalPlan->getRoot())) {
+        return AdmissionQueue::INTERACTIVE;
+    }
+    estimate = Query::getMemoryBudget();
+    if (estimate == 0) {
+        estimate = static_cast<uint64_t>(Config::getInstance()->getOption<int>(CONFIG_MERGE_SORT_BUFFER)) * MiB;
+    }
+    return AdmissionQueue::BATCH;
+}
+
+uint64_t AdmissionControl::getFootprint()
+{
+    ArenaUsage usage;
+    Query::listQueries(usage);
+    return usage.getTotal() + SharedMemCache::getInstance().getUsedMemSize();
+}
+
+bool AdmissionControl::admit(const shared_ptr<Query>& query)
+{
+    if (!isEnabled()) {
+        return true;
+    }
+    QueryID const queryID = query->getQueryID();
+    uint64_t estimate = 0;
+    AdmissionQueue::Priority const priority = classify(query, estimate);
+    uint64_t const footprint = getFootprint();
+
+    bool first = false;
+    bool admitted = false;
+    {
+        ScopedMutexLock cs(_mutex);
+        first = _registered.insert(make_pair(queryID, priority)).second;
+        admitted = _queue.tryAdmit(queryID, priority, estimate, footprint);
+        LOG4CXX_DEBUG(logger, "Query (" << queryID << ") "
+                      << (priority == AdmissionQueue::BATCH ? "batch" : "interactive")
+                      << " estimate=" << estimate << " footprint=" << footprint
+                      << " reserved=" << _queue.getReserved()
+                      << " running=" << _queue.getNumRunning()
+                      << " waiting=" << _queue.getNumWaiting()
+                      << (admitted ? " admitted" : " queued"));
+    }
+    if (first) {
+        Query::Finalizer f = bind(&AdmissionControl::releaseFinalizer, _1);
+        query->pushFinalizer(f);
+    }
+    return admitted;
+}
+
+bool AdmissionControl::isAdmitted(QueryID queryID)
+{
+    if (!isEnabled()) {
+        return true;
+    }
+    ScopedMutexLock cs(_mutex);
+    return _queue.isRunning(queryID);
+}
+
+void AdmissionControl::releaseFinalizer(const shared_ptr<Query>& query)
+{
+    AdmissionControl* self = AdmissionControl::getInstance();
+    ScopedMutexLock cs(self->_mutex);
+    self->_registered.erase(query->getQueryID());
+    self->_queue.release(query->getQueryID());
+}
+
+} //namespace scidb
@@ -0,0 +1,181 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file AdmissionControl.h
+ *
+ * @brief Memory-governed admission of client queries on the coordinator.
+ *
+ * CONFIG_MAX_REQUESTS bounds the number of queries, not their weight. Admission control
+ * lets a query start executing only when its estimated footprint fits into the memory left
+ * over by the queries already running, so that a few large queries do not exhaust an instance
+ * while small ones are not held back needlessly. Queries that do not fit wait in priority order:
+ * interactive queries (no memory-hungry operators) ahead of batch queries, first come first
+ * served within a class. Queries are admitted before they take their array locks, so that
+ * the waiting ones hold none.
+ */
+
+#ifndef ADMISSION_CONTROL_H_
+#define ADMISSION_CONTROL_H_
+
+#include <map>
+#include <stdint.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <array/Metadata.h>
+#include <util/Mutex.h>
+#include <util/Singleton.h>
+
+namespace scidb
+{
+
+class Query;
+
+/**
+ * The bookkeeping behind admission control: reservations of the running queries and the
+ * ordered list of waiting ones. Not synchronized.
+ */
+class AdmissionQueue
+{
+public:
+    enum Priority
+    {
+        INTERACTIVE = 0,
+        BATCH = 1
+    };
+
+    /**
+     * @param limit the memory (bytes) the admitted queries may reserve together
+     */
+    AdmissionQueue(uint64_t limit);
+
+    /**
+     * Admit a query if it is first in line and its estimate fits into the memory left.
+     * A query that is not admitted stays in line until it is admitted or released.
+     * A query is always admitted when nothing else is running, so that queries larger
+     * than the limit still make progress, and a query with a zero estimate is always
+     * admitted, ahead of the line, since it reserves nothing.
+     * @param queryID the query
+     * @param priority the class of the query
+     * @param estimate the memory (bytes) to reserve for the query
+     * @param footprint the memory (bytes) actually in use on the instance, if known;
+     *        admission uses the larger of it and the sum of the reservations
+     * @return true if the query is (or already was) admitted
+     */
+    bool tryAdmit(QueryID queryID, Priority priority, uint64_t estimate, uint64_t footprint);
+
+    /**
+     * Drop a running or waiting query, and give back its reservation.
+     */
+    void release(QueryID queryID);
+
+    bool isRunning(QueryID queryID) const
+    {
+        return _running.find(queryID) != _running.end();
+    }
+
+    uint64_t getLimit() const
+    {
+        return _limit;
+    }
+
+    uint64_t getReserved() const
+    {
+        return _reserved;
+    }
+
+    size_t getNumRunning() const
+    {
+        return _running.size();
+    }
+
+    size_t getNumWaiting() const
+    {
+        return _waiting.size();
+    }
+
+private:
+    /** Position in line: priority class first, then arrival order */
+    typedef std::pair<int, uint64_t> Ticket;
+
+    uint64_t const _limit;
+    uint64_t _reserved;
+    uint64_t _nextTicket;
+    std::map<QueryID, uint64_t> _running;
+    std::map<Ticket, QueryID> _waiting;
+    std::map<QueryID, Ticket> _tickets;
+};
+
+/**
+ * Admission control of the instance, configured by CONFIG_ADMISSION_MEMORY_LIMIT.
+ */
+class AdmissionControl : public Singleton<AdmissionControl>
+{
+public:
+    AdmissionControl();
+
+    /**
+     * @return false if admission control is disabled
+     */
+    bool isEnabled() const
+    {
+        return _queue.getLimit() != 0;
+    }
+
+    /**
+     * Try to admit a prepared query for execution. On the first call for a query a finalizer
+     * is pushed that drops the query from admission control when it completes or is aborted.
+     * @return true if the query may execute now; false if it has to retry later
+     */
+    bool admit(const boost::shared_ptr<Query>& query);
+
+    /**
+     * @return true if admission control is disabled or has admitted the query
+     */
+    bool isAdmitted(QueryID queryID);
+
+    /**
+     * Queries with an operator whose physical implementation is memory-hungry
+     * (see PhysicalOperator::isMemoryHungry()) are queued as batch work and reserve
+     * the per-query budget; the others are interactive and reserve nothing up front.
+     * @param query a query with a logical plan
+     * @param estimate [out] the memory (bytes) to reserve for the query
+     */
+    static AdmissionQueue::Priority classify(const boost::shared_ptr<Query>& query, uint64_t& estimate);
+
+    /**
+     * @return the memory (bytes) in use by the query arenas and the SharedMemCache
+     */
+    static uint64_t getFootprint();
+
+private:
+    static void releaseFinalizer(const boost::shared_ptr<Query>& query);
+
+    Mutex _mutex;
+    AdmissionQueue _queue;
+    std::map<QueryID, AdmissionQueue::Priority> _registered;
+};
+
+} //namespace scidb
+
+#endif /* ADMISSION_CONTROL_H_ */
@@ -34,6 +34,7 @@
 
 #include <cmath>
 #include <limits>
+#include <vector>
 
 #include <boost/shared_ptr.hpp>
 
@@ -48,9 +49,123 @@ CPPUNIT_TEST(testIntegerSum);
 CPPUNIT_TEST(testFloatSum);
 CPPUNIT_TEST(testIntegerAvg);
 CPPUNIT_TEST(testDoubleAvg);
+CPPUNIT_TEST(testApproxDC);
+CPPUNIT_TEST(testApproxMedian);
+CPPUNIT_TEST(testApproxQuantile);
+CPPUNIT_TEST(testFlatStates);
 CPPUNIT_TEST_SUITE_END();
 
 private:
+    static void setNumber(Value& value, TypeId const& type, int64_t number)
+    {
+        if (type == TID_DOUBLE) {
+            value.setDouble(number + 0.25);
+        } else {
+            value.setInt64(number);
+        }
+    }
+
+    /**
+     * The value of a finalized int64, uint64 or double result, for comparisons that do not
+     * depend on the bytes a Value leaves unused.
+     */
+    static double resultOf(Value const& result, TypeId const& type)
+    {
+        if (type == TID_INT64) {
+            return static_cast<double>(result.getInt64());
+        }
+        if (type == TID_UINT64) {
+            return static_cast<double>(result.getUint64());
+        }
+        CPPUNIT_ASSERT(type == TID_DOUBLE);
+        return result.getDouble();
+    }
+
+    /**
+     * Accumulate a tile into flat per-group states, the way grouped aggregate() and regrid() do,
+     * and check that every group finalizes to the result of its cells accumulated one at a time.
+     * The tile mixes runs of one value crossing group boundaries, distinct values, nulls and
+     * skipped cells, and leaves one group without values.
+     */
+    void checkFlatStates(std::string const& name, TypeId const& inputType)
+    {
+        AggregatePtr agg = AggregateLibrary::getInstance()->createAggregate(name, TypeLibrary::getType(inputType));
+        CPPUNIT_ASSERT(agg.get() != 0);
+        size_t const stateSize = agg->getFlatStateSize();
+        CPPUNIT_ASSERT(stateSize != 0);
+
+        size_t const nGroups = 5;
+        std::vector<Value> cells;
+        std::vector<size_t> groups;
+        Value v(TypeLibrary::getType(inputType));
+        for (size_t i = 0; i < 40; i++)
+        {
+            if (i < 12) {
+                setNumber(v, inputType, -2);                    // a run of one value
+            } else if (i < 20) {
+                setNumber(v, inputType, int64_t(i) * 3 - 40);   // distinct values
+            } else if (i < 24) {
+                v.setNull();
+            } else if (i < 34) {
+                setNumber(v, inputType, 7);
+            } else {
+                setNumber(v, inputType, 100 - int64_t(i));
+            }
+            cells.push_back(v);
+            // Group 3 gets only nulls and group 4 nothing; every seventh cell is skipped
+            size_t g = (i < 20 || i >= 24) ? (i / 5) % 3 : 3;
+            groups.push_back(i % 7 == 6 ? size_t(Aggregate::NO_FLAT_GROUP) : g);
+        }
+
+        RLEPayload tile(TypeLibrary::getType(inputType));
+        {
+            RLEPayload::append_iterator appender(&tile);
+            for (size_t i = 0; i < cells.size(); i++)
+            {
+                appender.add(cells[i]);
+            }
+            appender.flush();
+        }
+        bool hasRun = false;
+        for (size_t i = 0; i < tile.nSegments(); i++)
+        {
+            hasRun |= tile.getSegment(i)._same && !tile.getSegment(i)._null && tile.getSegment(i).length() > 1;
+        }
+        CPPUNIT_ASSERT(hasRun);
+
+        std::vector<char> flat(nGroups * stateSize);
+        std::vector<uint8_t> seen(nGroups, 0);
+        for (size_t g = 0; g < nGroups; g++)
+        {
+            agg->initializeFlatState(&flat[g * stateSize]);
+        }
+        agg->accumulatePayloadFlat(&flat[0], &seen[0], &tile, &groups[0]);
+
+        TypeId const resultType = agg->getResultType().typeId();
+        for (size_t g = 0; g < nGroups; g++)
+        {
+            Value state(agg->getStateType());
+            agg->initializeState(state);
+            for (size_t i = 0; i < cells.size(); i++)
+            {
+                if (groups[i] == g) {
+                    agg->tryAccumulate(state, cells[i]);
+                }
+            }
+            Value expected(agg->getResultType());
+            agg->finalResult(expected, state);
+
+            Value flatState(agg->getStateType());
+            agg->getFlatState(flatState, &flat[g * stateSize], seen[g] != 0);
+            Value result(agg->getResultType());
+            agg->finalResult(result, flatState);
+
+            CPPUNIT_ASSERT(result.isNull() == expected.isNull());
+            if (!expected.isNull()) {
+                CPPUNIT_ASSERT(resultOf(result, resultType) == resultOf(expected, resultType));
+            }
+        }
+    }
 
 public:
     void setUp()
@@ -223,6 +338,138 @@ public:
         ///
     }
 
+    void testApproxDC()
+    {
+        AggregateLibrary* al = AggregateLibrary::getInstance();
+        Type tInt64 = TypeLibrary::getType(TID_INT64);
+
+        AggregatePtr dc = al->createAggregate("approxdc", tInt64);
+        CPPUNIT_ASSERT(dc.get() != 0);
+        CPPUNIT_ASSERT(dc->getResultType() == TypeLibrary::getType(TID_UINT64));
+
+        Value input(tInt64);
+        Value state(dc->getStateType());
+        Value state2(dc->getStateType());
+        Value final(dc->getResultType());
+
+        // Few distinct values stay in the sparse format and are counted exactly
+        dc->initializeState(state);
+        for (int64_t i = 0; i < 1000; i++)
+        {
+            input.setInt64(i % 100);
+            dc->accumulate(state, input);
+        }
+        dc->finalResult(final, state);
+        CPPUNIT_ASSERT(final.getUint64() == 100);
+
+        // Two overlapping halves merge into the estimate of their union
+        dc->initializeState(state);
+        dc->initializeState(state2);
+        for (int64_t i = 0; i < 60000; i++)
+        {
+            input.setInt64(i);
+            dc->accumulate(state, input);
+            input.setInt64(i + 40000);
+            dc->accumulate(state2, input);
+        }
+        dc->merge(state, state2);
+        dc->finalResult(final, state);
+        CPPUNIT_ASSERT( std::fabs(final.getUint64() - 100000.0) < 0.05 * 100000 );
+
+        // A sparse source merges into a dense destination and vice versa
+        dc->initializeState(state2);
+        for (int64_t i = 0; i < 10; i++)
+        {
+            input.setInt64(-1 - i);
+            dc->accumulate(state2, input);
+        }
+        Value sparse = state2;
+        dc->merge(state2, state);
+        dc->merge(state, sparse);
+        Value final2(dc->getResultType());
+        dc->finalResult(final, state);
+        dc->finalResult(final2, state2);
+        CPPUNIT_ASSERT(final.getUint64() == final2.getUint64());
+    }
+
+    void testApproxMedian()
+    {
+        AggregateLibrary* al = AggregateLibrary::getInstance();
+        Type tDouble = TypeLibrary::getType(TID_DOUBLE);
+
+        AggregatePtr median = al->createAggregate("approxmedian", tDouble);
+        CPPUNIT_ASSERT(median.get() != 0);
+        CPPUNIT_ASSERT(median->getResultType() == TypeLibrary::getType(TID_DOUBLE));
+
+        Value input(tDouble);
+        Value state(median->getStateType());
+        Value state2(median->getStateType());
+        Value final(median->getResultType());
+
+        median->initializeState(state);
+        median->finalResult(final, state);
+        CPPUNIT_ASSERT(final.isNull());
+
+        // Two interleaved halves of 0 .. 99999; the merged median must be within 2% in rank
+        median->initializeState(state2);
+        for (int i = 0; i < 100000; i++)
+        {
+            input.setDouble((i * 7919) % 100000);
+            median->accumulate(i % 2 ? state : state2, input);
+        }
+        median->merge(state, state2);
+        median->finalResult(final, state);
+        CPPUNIT_ASSERT( std::fabs(final.getDouble() - 50000) < 0.02 * 100000 );
+    }
+
+    void testApproxQuantile()
+    {
+        AggregateLibrary* al = AggregateLibrary::getInstance();
+        Type tInt32 = TypeLibrary::getType(TID_INT32);
+
+        // The fraction is a required argument in [0, 1]
+        AggregatePtr quantile = al->createAggregate("approxquantile", tInt32);
+        CPPUNIT_ASSERT(quantile.get() != 0);
+        CPPUNIT_ASSERT_THROW(quantile->setArguments(std::vector<double>()), UserException);
+        CPPUNIT_ASSERT_THROW(quantile->setArguments(std::vector<double>(1, 1.5)), UserException);
+        CPPUNIT_ASSERT_THROW(quantile->setArguments(std::vector<double>(2, 0.5)), UserException);
+        CPPUNIT_ASSERT_THROW(al->createAggregate("approxmedian", tInt32)->setArguments(std::vector<double>(1, 0.5)),
+                             UserException);
+        quantile->setArguments(std::vector<double>(1, 0.9));
+
+        Value input(tInt32);
+        Value state(quantile->getStateType());
+        Value state2(quantile->getStateType());
+        Value final(quantile->getResultType());
+
+        // Two interleaved halves of 0 .. 99999, one of them on a clone; the merged 0.9 quantile must be within 2% in rank
+        AggregatePtr clone = quantile->clone();
+        quantile->initializeState(state);
+        clone->initializeState(state2);
+        for (int32_t i = 0; i < 100000; i++)
+        {
+            input.setInt32((i * 7919) % 100000);
+            if (i % 2) {
+                quantile->accumulate(state, input);
+            } else {
+                clone->accumulate(state2, input);
+            }
+        }
+        quantile->merge(state, state2);
+        quantile->finalResult(final, state);
+        CPPUNIT_ASSERT( std::fabs(final.getDouble() - 90000) < 0.02 * 100000 );
+    }
+
+    void testFlatStates()
+    {
+        checkFlatStates("sum", TID_INT64);
+        checkFlatStates("sum", TID_DOUBLE);
+        checkFlatStates("avg", TID_INT64);
+        checkFlatStates("avg", TID_DOUBLE);
+        checkFlatStates("min", TID_INT64);
+        checkFlatStates("max", TID_DOUBLE);
+        checkFlatStates("count", TID_DOUBLE);
+    }
 
 };
 
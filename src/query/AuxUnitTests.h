@@ -35,6 +35,8 @@
 #include <boost/shared_ptr.hpp>
 
 #include "query/Operator.h"
+#include "query/AdmissionControl.h"
+#include "system/catalog/CatalogCache.h"
 
 using namespace scidb;
 
@@ -42,6 +44,8 @@ class AuxTests: public CppUnit::TestFixture
 {
 CPPUNIT_TEST_SUITE(AuxTests);
 CPPUNIT_TEST(testChunkInstanceMap);
+CPPUNIT_TEST(testAdmissionQueue);
+CPPUNIT_TEST(testCatalogCache);
 CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -198,6 +202,68 @@ public:
 
         testCoordinateStreaming();
     }
+
+    void testAdmissionQueue()
+    {
+        AdmissionQueue q(100);
+
+        // a query larger than the limit still runs on an idle instance
+        CPPUNIT_ASSERT(q.tryAdmit(1, AdmissionQueue::BATCH, 150, 0));
+        CPPUNIT_ASSERT(q.tryAdmit(1, AdmissionQueue::BATCH, 150, 0));
+        CPPUNIT_ASSERT(!q.tryAdmit(2, AdmissionQueue::BATCH, 10, 0));
+        q.release(1);
+        CPPUNIT_ASSERT(q.getReserved() == 0);
+
+        CPPUNIT_ASSERT(q.tryAdmit(2, AdmissionQueue::BATCH, 60, 0));
+        CPPUNIT_ASSERT(!q.tryAdmit(3, AdmissionQueue::BATCH, 60, 0));
+        // interactive queries reserving nothing go ahead of waiting batch queries, even
+        // when the instance is over the limit; the ones with an estimate wait while they do not fit
+        CPPUNIT_ASSERT(q.tryAdmit(4, AdmissionQueue::INTERACTIVE, 0, 50));
+        CPPUNIT_ASSERT(q.tryAdmit(5, AdmissionQueue::INTERACTIVE, 0, 120));
+        CPPUNIT_ASSERT(!q.tryAdmit(6, AdmissionQueue::INTERACTIVE, 50, 0));
+        CPPUNIT_ASSERT(!q.tryAdmit(3, AdmissionQueue::BATCH, 60, 0));
+        CPPUNIT_ASSERT(q.getNumWaiting() == 2);
+        CPPUNIT_ASSERT(q.getNumRunning() == 3);
+        q.release(6);
+        q.release(2);
+        CPPUNIT_ASSERT(q.tryAdmit(3, AdmissionQueue::BATCH, 60, 0));
+        CPPUNIT_ASSERT(q.getNumRunning() == 3);
+        CPPUNIT_ASSERT(q.getNumWaiting() == 0);
+        CPPUNIT_ASSERT(q.getReserved() == 60);
+    }
+
+    void testCatalogCache()
+    {
+        CatalogCache cache(2);
+        VersionID version = 0;
+
+        // nothing is cached until the catalog version is known
+        cache.putLastVersion(1, 5);
+        CPPUNIT_ASSERT(!cache.getLastVersion(1, version));
+
+        cache.validate(7);
+        cache.putLastVersion(1, 5);
+        CPPUNIT_ASSERT(cache.getLastVersion(1, version) && version == 5);
+        cache.validate(7);
+        CPPUNIT_ASSERT(cache.getLastVersion(1, version));
+
+        // an update anywhere in the cluster drops the cache
+        cache.validate(8);
+        CPPUNIT_ASSERT(!cache.getLastVersion(1, version));
+
+        cache.putLastVersion(1, 6);
+        cache.putLastVersion(2, 1);
+        cache.putLastVersion(3, 1);
+        CPPUNIT_ASSERT(!cache.getLastVersion(1, version));
+        CPPUNIT_ASSERT(cache.getLastVersion(3, version));
+        cache.clear();
+        CPPUNIT_ASSERT(!cache.getLastVersion(3, version));
+
+        CatalogCache disabled(0);
+        disabled.validate(8);
+        disabled.putLastVersion(1, 6);
+        CPPUNIT_ASSERT(!disabled.getLastVersion(1, version));
+    }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(AuxTests);
@@ -30,10 +30,11 @@
 #include "query/FunctionLibrary.h"
 #include "query/Expression.h"
 #include "query/TileFunctions.h"
-
-#include "query/ops/analyze/AnalyzeAggregate.h"
+#include "util/HyperLogLog.h"
+#include "util/KllSketch.h"
 
 #include <math.h>
+#include <algorithm>
 #include <log4cxx/logger.h>
 
 using boost::shared_ptr;
@@ -268,6 +269,40 @@ public:
         (*((uint64_t*) state.data())) = newCount;
     }
 
+    size_t getFlatStateSize() const
+    {
+        return sizeof(uint64_t);
+    }
+
+    void initializeFlatState(char* state)
+    {
+        *reinterpret_cast<uint64_t*>(state) = 0;
+    }
+
+    void accumulatePayloadFlat(char* states, uint8_t* seen, ConstRLEPayload const* tile, size_t const* groups)
+    {
+        uint64_t* counts = reinterpret_cast<uint64_t*>(states);
+        for (size_t i = 0, n = tile->nSegments(); i < n; i++)
+        {
+            const RLEPayload::Segment& v = tile->getSegment(i);
+            if (v._null && ignoreNulls())
+                continue;
+            for (position_t p = v._pPosition, end = v._pPosition + v.length(); p < end; p++)
+            {
+                if (groups[p] != NO_FLAT_GROUP)
+                {
+                    counts[groups[p]]++;
+                }
+            }
+        }
+    }
+
+    void getFlatState(Value& state, char const* flat, bool seen)
+    {
+        initializeState(state);
+        overrideCount(state, *reinterpret_cast<uint64_t const*>(flat));
+    }
+
     void finalResult(Value& result, Value const& state)
     {
         if (state.isNull())
@@ -280,6 +315,409 @@ public:
     }
 };
 
+/**
+ * Approximate distinct count. The state is a HyperLogLog++ sketch image (see util/HyperLogLog.h):
+ * a short sorted list of sparse entries while few distinct values have been seen, switching to
+ * 2^14 one-byte registers once that list would be larger. Most groups of a grouped aggregate,
+ * regrid or window therefore carry a few dozen bytes of state rather than the full register array.
+ */
+class ApproxDCAggregate : public Aggregate
+{
+private:
+    typedef HyperLogLog::Header Header;
+
+    static Header* sketch(Value& state)
+    {
+        return static_cast<Header*>(state.data());
+    }
+
+    static Header const* sketch(Value const& state)
+    {
+        return static_cast<Header const*>(state.data());
+    }
+
+    static bool hasSketch(Value const& state)
+    {
+        return state.size() >= sizeof(Header);
+    }
+
+    /**
+     * Replace the state with the given sorted, normalized sparse entries,
+     * or with the equivalent dense registers if there are too many of them.
+     */
+    static void storeSparse(Value& state, uint32_t const* entries, size_t nEntries)
+    {
+        if (nEntries > HyperLogLog::MAX_SPARSE_ENTRIES) {
+            state.setVector(HyperLogLog::denseSize());
+            Header* header = sketch(state);
+            HyperLogLog::initialize(header);
+            header->format = HyperLogLog::DENSE;
+            memset(HyperLogLog::registers(header), 0, HyperLogLog::NUM_REGISTERS);
+            HyperLogLog::addSparseToDense(HyperLogLog::registers(header), entries, nEntries);
+        } else {
+            state.setVector(HyperLogLog::sparseSize(nEntries));
+            Header* header = sketch(state);
+            HyperLogLog::initialize(header);
+            header->nEntries = static_cast<uint32_t>(nEntries);
+            memcpy(HyperLogLog::entries(header), entries, nEntries * sizeof(uint32_t));
+        }
+    }
+
+    static void convertToDense(Value& state)
+    {
+        Header const* header = sketch(state);
+        if (header->format == HyperLogLog::DENSE) {
+            return;
+        }
+        vector<uint32_t> entries(HyperLogLog::entries(header), HyperLogLog::entries(header) + header->nEntries);
+        state.setVector(HyperLogLog::denseSize());
+        Header* dense = sketch(state);
+        HyperLogLog::initialize(dense);
+        dense->format = HyperLogLog::DENSE;
+        memset(HyperLogLog::registers(dense), 0, HyperLogLog::NUM_REGISTERS);
+        HyperLogLog::addSparseToDense(HyperLogLog::registers(dense), entries.empty() ? NULL : &entries[0], entries.size());
+    }
+
+    static void addHash(Value& state, uint64_t hash)
+    {
+        Header* header = sketch(state);
+        if (header->format == HyperLogLog::DENSE) {
+            HyperLogLog::addDense(HyperLogLog::registers(header), hash);
+            return;
+        }
+        uint32_t const entry = HyperLogLog::encode(hash);
+        size_t const n = header->nEntries;
+        uint32_t* begin = HyperLogLog::entries(header);
+        uint32_t* pos = std::lower_bound(begin, begin + n, entry & ~0x3Fu);
+        if (pos != begin + n && (*pos >> 6) == (entry >> 6)) {
+            *pos = std::max(*pos, entry);
+            return;
+        }
+        if (n == HyperLogLog::MAX_SPARSE_ENTRIES) {
+            convertToDense(state);
+            HyperLogLog::addDense(HyperLogLog::registers(sketch(state)), hash);
+            return;
+        }
+        size_t const offset = pos - begin;
+        state.setVector(HyperLogLog::sparseSize(n + 1));
+        header = sketch(state);
+        begin = HyperLogLog::entries(header);
+        memmove(begin + offset + 1, begin + offset, (n - offset) * sizeof(uint32_t));
+        begin[offset] = entry;
+        header->nEntries = static_cast<uint32_t>(n + 1);
+    }
+
+    static uint64_t hashPayloadValue(ConstRLEPayload const* tile, size_t index)
+    {
+        if (tile->isBool()) {
+            uint8_t const b = (*tile->getRawValue(index >> 3) >> (index & 7)) & 1;
+            return HyperLogLog::hash(&b, 1);
+        }
+        if (tile->elementSize() != 0) {
+            return HyperLogLog::hash(tile->getRawValue(index), tile->elementSize());
+        }
+        size_t size;
+        char const* data = tile->getRawVarValue(index, size);
+        return HyperLogLog::hash(data, size);
+    }
+
+public:
+    ApproxDCAggregate()
+        : Aggregate("ApproxDC", TypeLibrary::getType(TID_VOID), TypeLibrary::getType(TID_UINT64))
+    {}
+
+    AggregatePtr clone() const
+    {
+        return AggregatePtr(new ApproxDCAggregate());
+    }
+
+    AggregatePtr clone(Type const& aggregateType) const
+    {
+        return clone();
+    }
+
+    bool ignoreNulls() const
+    {
+        return true;
+    }
+
+    Type getStateType() const
+    {
+        return TypeLibrary::getType(TID_BINARY);
+    }
+
+    void initializeState(Value& state)
+    {
+        state.setVector(HyperLogLog::sparseSize(0));
+        HyperLogLog::initialize(sketch(state));
+        state.setNull(-1);
+    }
+
+    void accumulate(Value& state, Value const& input)
+    {
+        addHash(state, HyperLogLog::hash(input.data(), input.size()));
+    }
+
+    void accumulatePayload(Value& state, ConstRLEPayload const* tile)
+    {
+        Header* header = sketch(state);
+        if (header->format == HyperLogLog::SPARSE &&
+            header->nEntries + tile->count() > HyperLogLog::MAX_SPARSE_ENTRIES) {
+            convertToDense(state);
+            header = sketch(state);
+        }
+
+        if (header->format == HyperLogLog::DENSE) {
+            uint8_t* regs = HyperLogLog::registers(header);
+            for (size_t i = 0, n = tile->nSegments(); i < n; i++)
+            {
+                const RLEPayload::Segment& v = tile->getSegment(i);
+                if (v._null)
+                    continue;
+                if (v._same) {
+                    HyperLogLog::addDense(regs, hashPayloadValue(tile, v._valueIndex));
+                } else {
+                    for (size_t j = v._valueIndex, end = v._valueIndex + v.length(); j < end; j++) {
+                        HyperLogLog::addDense(regs, hashPayloadValue(tile, j));
+                    }
+                }
+            }
+            return;
+        }
+
+        // Encode the whole tile, then fold it into the sorted entry list in a single pass.
+        vector<uint32_t> batch;
+        batch.reserve(tile->count());
+        for (size_t i = 0, n = tile->nSegments(); i < n; i++)
+        {
+            const RLEPayload::Segment& v = tile->getSegment(i);
+            if (v._null)
+                continue;
+            if (v._same) {
+                batch.push_back(HyperLogLog::encode(hashPayloadValue(tile, v._valueIndex)));
+            } else {
+                for (size_t j = v._valueIndex, end = v._valueIndex + v.length(); j < end; j++) {
+                    batch.push_back(HyperLogLog::encode(hashPayloadValue(tile, j)));
+                }
+            }
+        }
+        if (batch.empty()) {
+            return;
+        }
+        std::sort(batch.begin(), batch.end());
+        size_t const nBatch = HyperLogLog::normalize(&batch[0], batch.size());
+        vector<uint32_t> merged(header->nEntries + nBatch);
+        size_t const nMerged = HyperLogLog::mergeSparse(HyperLogLog::entries(header), header->nEntries,
+                                                        &batch[0], nBatch, &merged[0]);
+        storeSparse(state, &merged[0], nMerged);
+    }
+
+    void merge(Value& dstState, Value const& srcState)
+    {
+        if (!hasSketch(srcState)) {
+            return;
+        }
+        if (!hasSketch(dstState)) {
+            dstState = srcState;
+            return;
+        }
+        Header const* src = sketch(srcState);
+        Header* dst = sketch(dstState);
+        if (src->format == HyperLogLog::DENSE) {
+            convertToDense(dstState);
+            HyperLogLog::mergeDense(HyperLogLog::registers(sketch(dstState)), HyperLogLog::registers(src));
+        } else if (dst->format == HyperLogLog::DENSE) {
+            HyperLogLog::addSparseToDense(HyperLogLog::registers(dst), HyperLogLog::entries(src), src->nEntries);
+        } else if (src->nEntries != 0) {
+            vector<uint32_t> merged(dst->nEntries + src->nEntries);
+            size_t const nMerged = HyperLogLog::mergeSparse(HyperLogLog::entries(dst), dst->nEntries,
+                                                            HyperLogLog::entries(src), src->nEntries, &merged[0]);
+            storeSparse(dstState, &merged[0], nMerged);
+        }
+    }
+
+    void finalResult(Value& result, Value const& state)
+    {
+        if (state.getMissingReason() == 0 || !hasSketch(state))
+        {
+            result.setUint64(0);
+            return;
+        }
+        result.setUint64(static_cast<uint64_t>(HyperLogLog::estimate(sketch(state)) + 0.5));
+    }
+};
+
+/**
+ * Approximate quantile of a numeric attribute. The state is a KLL sketch image (see util/KllSketch.h)
+ * of at most a few hundred doubles, so it merges across chunks and instances like any other state
+ * while the rank of the result stays within about 2% of the requested fraction.
+ */
+template<typename T>
+class ApproxQuantileAggregate : public Aggregate
+{
+private:
+    typedef KllSketch::Header Header;
+
+    double _fraction;
+
+    static Header* sketch(Value& state)
+    {
+        return static_cast<Header*>(state.data());
+    }
+
+    static Header const* sketch(Value const& state)
+    {
+        return static_cast<Header const*>(state.data());
+    }
+
+    static bool hasSketch(Value const& state)
+    {
+        return state.size() >= sizeof(Header);
+    }
+
+    /**
+     * Make room for count more items in the state image. The image grows to the capacity of the
+     * sketch at once and never shrinks, so that it is only reallocated when the sketch adds a level.
+     */
+    static void reserve(Value& state, size_t count)
+    {
+        Header const* header = sketch(state);
+        size_t const room = (state.size() - sizeof(Header)) / sizeof(double) - header->nItems;
+        if (room < count)
+        {
+            state.setVector(KllSketch::imageSize(header->nItems + std::max(count, KllSketch::freeSpace(header) + 1)));
+        }
+    }
+
+    static void append(Value& state, double const* values, size_t count)
+    {
+        while (count != 0)
+        {
+            size_t const n = std::min(count, std::max<size_t>(KllSketch::freeSpace(sketch(state)), 1));
+            reserve(state, n);
+            KllSketch::append(sketch(state), values, n);
+            values += n;
+            count -= n;
+        }
+    }
+
+public:
+    /**
+     * @param fraction the quantile to compute, or a negative value if every call passes it as
+     *        an argument, as in approxquantile(a, 0.9)
+     */
+    ApproxQuantileAggregate(const std::string& name, Type const& aggregateType, double fraction)
+        : Aggregate(name, aggregateType, TypeLibrary::getType(TID_DOUBLE)), _fraction(fraction)
+    {}
+
+    void setArguments(std::vector<double> const& arguments)
+    {
+        if (_fraction >= 0)
+        {
+            Aggregate::setArguments(arguments);
+            return;
+        }
+        if (arguments.size() != 1)
+        {
+            throw USER_EXCEPTION(SCIDB_SE_SYNTAX, SCIDB_LE_WRONG_AGGREGATE_ARGUMENTS_COUNT);
+        }
+        if (!(arguments[0] >= 0 && arguments[0] <= 1))
+        {
+            throw USER_EXCEPTION(SCIDB_SE_SYNTAX, SCIDB_LE_ILLEGAL_OPERATION)
+                << "the fraction of " + getName() + "() must be between 0 and 1";
+        }
+        _fraction = arguments[0];
+    }
+
+    AggregatePtr clone() const
+    {
+        return AggregatePtr(new ApproxQuantileAggregate(getName(), getAggregateType(), _fraction));
+    }
+
+    AggregatePtr clone(Type const& aggregateType) const
+    {
+        return AggregatePtr(new ApproxQuantileAggregate(getName(), aggregateType, _fraction));
+    }
+
+    bool ignoreNulls() const
+    {
+        return true;
+    }
+
+    Type getStateType() const
+    {
+        return TypeLibrary::getType(TID_BINARY);
+    }
+
+    void initializeState(Value& state)
+    {
+        state.setVector(KllSketch::imageSize(0));
+        KllSketch::initialize(sketch(state));
+        state.setNull(-1);
+    }
+
+    void accumulate(Value& state, Value const& input)
+    {
+        double const value = *reinterpret_cast<T*>(input.data());
+        if (value == value) { // NaN has no rank
+            append(state, &value, 1);
+        }
+    }
+
+    void accumulatePayload(Value& state, ConstRLEPayload const* tile)
+    {
+        vector<double> values;
+        values.reserve(tile->count());
+        for (size_t i = 0, n = tile->nSegments(); i < n; i++)
+        {
+            const RLEPayload::Segment& v = tile->getSegment(i);
+            if (v._null)
+                continue;
+            if (v._same) {
+                double const value = getPayloadValue<T>(tile, v._valueIndex);
+                values.insert(values.end(), v.length(), value);
+            } else {
+                for (size_t j = v._valueIndex, end = v._valueIndex + v.length(); j < end; j++) {
+                    values.push_back(getPayloadValue<T>(tile, j));
+                }
+            }
+        }
+        values.erase(std::remove_if(values.begin(), values.end(), isNaN), values.end());
+        if (!values.empty()) {
+            append(state, &values[0], values.size());
+        }
+    }
+
+    void merge(Value& dstState, Value const& srcState)
+    {
+        if (!hasSketch(srcState)) {
+            return;
+        }
+        if (!hasSketch(dstState)) {
+            dstState = srcState;
+            return;
+        }
+        reserve(dstState, sketch(srcState)->nItems);
+        KllSketch::merge(sketch(dstState), sketch(srcState));
+    }
+
+    void finalResult(Value& result, Value const& state)
+    {
+        if (state.getMissingReason() == 0 || !hasSketch(state) || sketch(state)->nItems == 0)
+        {
+            result.setNull();
+            return;
+        }
+        result.setDouble(KllSketch::quantile(sketch(state), _fraction));
+    }
+
+private:
+    static bool isNaN(double value)
+    {
+        return value != value;
+    }
+};
+
 AggregateLibrary::AggregateLibrary()
 {
     /** SUM **/
@@ -377,8 +815,32 @@ AggregateLibrary::AggregateLibrary()
     addAggregate(make_shared<BaseAggregate<AggStDev, float, double> >("stdev", TypeLibrary::getType(TID_FLOAT), TypeLibrary::getType(TID_DOUBLE)));
     addAggregate(make_shared<BaseAggregate<AggStDev, double, double> >("stdev", TypeLibrary::getType(TID_DOUBLE), TypeLibrary::getType(TID_DOUBLE)));
 
-    /** ApproxDC (ANALYZE) **/
-    addAggregate(make_shared<AnalyzeAggregate>());
+    /** APPROXMEDIAN **/
+    addAggregate(make_shared<ApproxQuantileAggregate<int8_t> >("approxmedian", TypeLibrary::getType(TID_INT8), 0.5));
+    addAggregate(make_shared<ApproxQuantileAggregate<int16_t> >("approxmedian", TypeLibrary::getType(TID_INT16), 0.5));
+    addAggregate(make_shared<ApproxQuantileAggregate<int32_t> >("approxmedian", TypeLibrary::getType(TID_INT32), 0.5));
+    addAggregate(make_shared<ApproxQuantileAggregate<int64_t> >("approxmedian", TypeLibrary::getType(TID_INT64), 0.5));
+    addAggregate(make_shared<ApproxQuantileAggregate<uint8_t> >("approxmedian", TypeLibrary::getType(TID_UINT8), 0.5));
+    addAggregate(make_shared<ApproxQuantileAggregate<uint16_t> >("approxmedian", TypeLibrary::getType(TID_UINT16), 0.5));
+    addAggregate(make_shared<ApproxQuantileAggregate<uint32_t> >("approxmedian", TypeLibrary::getType(TID_UINT32), 0.5));
+    addAggregate(make_shared<ApproxQuantileAggregate<uint64_t> >("approxmedian", TypeLibrary::getType(TID_UINT64), 0.5));
+    addAggregate(make_shared<ApproxQuantileAggregate<float> >("approxmedian", TypeLibrary::getType(TID_FLOAT), 0.5));
+    addAggregate(make_shared<ApproxQuantileAggregate<double> >("approxmedian", TypeLibrary::getType(TID_DOUBLE), 0.5));
+
+    /** APPROXQUANTILE **/
+    addAggregate(make_shared<ApproxQuantileAggregate<int8_t> >("approxquantile", TypeLibrary::getType(TID_INT8), -1.0));
+    addAggregate(make_shared<ApproxQuantileAggregate<int16_t> >("approxquantile", TypeLibrary::getType(TID_INT16), -1.0));
+    addAggregate(make_shared<ApproxQuantileAggregate<int32_t> >("approxquantile", TypeLibrary::getType(TID_INT32), -1.0));
+    addAggregate(make_shared<ApproxQuantileAggregate<int64_t> >("approxquantile", TypeLibrary::getType(TID_INT64), -1.0));
+    addAggregate(make_shared<ApproxQuantileAggregate<uint8_t> >("approxquantile", TypeLibrary::getType(TID_UINT8), -1.0));
+    addAggregate(make_shared<ApproxQuantileAggregate<uint16_t> >("approxquantile", TypeLibrary::getType(TID_UINT16), -1.0));
+    addAggregate(make_shared<ApproxQuantileAggregate<uint32_t> >("approxquantile", TypeLibrary::getType(TID_UINT32), -1.0));
+    addAggregate(make_shared<ApproxQuantileAggregate<uint64_t> >("approxquantile", TypeLibrary::getType(TID_UINT64), -1.0));
+    addAggregate(make_shared<ApproxQuantileAggregate<float> >("approxquantile", TypeLibrary::getType(TID_FLOAT), -1.0));
+    addAggregate(make_shared<ApproxQuantileAggregate<double> >("approxquantile", TypeLibrary::getType(TID_DOUBLE), -1.0));
+
+    /** ApproxDC **/
+    addAggregate(make_shared<ApproxDCAggregate>());
 }
 
 
@@ -114,6 +114,7 @@ void Expression::compile(boost::shared_ptr<LogicalExpression> expr,
     try
     {
         _tileMode = tile;
+        _parameters.clear();
         for (size_t i = 0; i < _variables.size(); i++)
         {
             BindInfo b;
@@ -445,6 +446,14 @@ void Expression::swapArguments(size_t firstIndex)
     Value tmpValue = _eargs[firstIndex];
     _eargs[firstIndex] = _eargs[firstIndex + 1];
     _eargs[firstIndex + 1] = tmpValue;
+
+    for (size_t i = 0; i < _parameters.size(); i++) {
+        if (_parameters[i].index == firstIndex) {
+            _parameters[i].index = firstIndex + 1;
+        } else if (_parameters[i].index == firstIndex + 1) {
+            _parameters[i].index = firstIndex;
+        }
+    }
 }
 
 const Expression::ArgProp&
@@ -473,9 +482,12 @@ Expression::internalCompile(boost::shared_ptr<LogicalExpression> expr,
             _supportsVectorMode = false;
         }
     }
-    else if (typeid(*expr) == typeid(Constant))
+    else if (typeid(*expr) == typeid(Constant) || typeid(*expr) == typeid(Parameter))
     {
         boost::shared_ptr<Constant> e = dynamic_pointer_cast<Constant>(expr);
+        if (typeid(*expr) == typeid(Parameter)) {
+            _parameters.push_back(ParameterSlot(dynamic_pointer_cast<Parameter>(expr)->getName(), resultIndex));
+        }
         _props[resultIndex].type = e->getType();
         _eargs.resize(_props.size());
         const Value& v = e->getValue();
@@ -751,9 +763,34 @@ void Expression::resolveFunctions()
     }
 }
 
+void Expression::bindParameter(const string& name, const TypeId& type, const Value& value)
+{
+    for (size_t i = 0; i < _parameters.size(); i++)
+    {
+        if (_parameters[i].name != name) {
+            continue;
+        }
+        const size_t index = _parameters[i].index;
+        const TypeId& slotType = _props[index].type;
+        Value v(value);
+        if (type != slotType && !value.isNull()) {
+            // The constant was converted in place at compilation, see insertConverter()
+            FunctionPointer converter = FunctionLibrary::getInstance()->findConverter(type, slotType);
+            const Value* arg = &value;
+            v = Value(TypeLibrary::getType(slotType));
+            converter(&arg, &v, NULL);
+        }
+        if (_tileMode) {
+            v.makeTileConstant(slotType);
+        }
+        _eargs[index] = v;
+    }
+}
+
 void Expression::clear()
 {
     _bindings.clear();
+    _parameters.clear();
     _compiled = false;
     _constant = false;
     _contextNo.clear();
@@ -770,6 +807,10 @@ Value evaluate(boost::shared_ptr<LogicalExpression> expr,
 {
     Expression e;
     e.compile(expr, query, false, expectedType);
+    if (query && e.hasParameters()) {
+        // The value ends up in the plan, which then holds only for these parameter values
+        query->markParameterValuesUsed();
+    }
     return e.evaluate();
 }
 
@@ -65,6 +65,14 @@ void Constant::toString(std::ostream &out, int indent) const
     out <<" value "<< ValueToString(_type,_value) << "\n";
 }
 
+void Parameter::toString(std::ostream &out, int indent) const
+{
+    Indent prefix(indent);
+    out << prefix(' ', false);
+    out << "[parameter] $" << _name << " type " << getType();
+    out <<" value "<< ValueToString(getType(),getValue()) << "\n";
+}
+
 void Function::toString(std::ostream &out, int indent) const
 {
     Indent prefix(indent);
@@ -47,6 +47,7 @@
 #include <system/BlockCyclic.h>
 #include <system/Config.h>
 #include <system/SciDBConfigOptions.h>
+#include <system/Sysinfo.h>
 #include <smgr/io/Storage.h>
 #include <boost/functional/hash.hpp>
 #include <util/Hashing.h>
@@ -179,6 +180,17 @@ void OperatorParamAggregateCall::toString(std::ostream &out, int indent) const
     out <<"input: ";
     _inputAttribute->toString(out);
 
+    if (_arguments.size())
+    {
+        out << prefix(' ');
+        out << "arguments";
+        for (size_t i = 0; i < _arguments.size(); i++)
+        {
+            out << " " << _arguments[i];
+        }
+        out << "\n";
+    }
+
     if (_alias.size() )
     {
         out << prefix(' ');
@@ -1357,6 +1369,7 @@ AggregatePtr resolveAggregate(boost::shared_ptr <OperatorParamAggregateCall>cons
         if (PARAM_ASTERISK == acParam->getParamType())
         {
             AggregatePtr agg = AggregateLibrary::getInstance()->createAggregate( aggregateCall->getAggregateName(), TypeLibrary::getType(TID_VOID));
+            agg->setArguments(aggregateCall->getArguments());
 
             if (inputAttributeID)
             {
@@ -1375,6 +1388,7 @@ AggregatePtr resolveAggregate(boost::shared_ptr <OperatorParamAggregateCall>cons
             AttributeDesc const& inputAttr = inputAttributes[ref->getObjectNo()];
             Type const& inputType = TypeLibrary::getType(inputAttr.getType());
             AggregatePtr agg = AggregateLibrary::getInstance()->createAggregate( aggregateCall->getAggregateName(), inputType);
+            agg->setArguments(aggregateCall->getArguments());
 
             if (inputAttributeID)
             {
@@ -1398,6 +1412,10 @@ AggregatePtr resolveAggregate(boost::shared_ptr <OperatorParamAggregateCall>cons
         {
             throw CONV_TO_USER_QUERY_EXCEPTION(e, acParam->getParsingContext());
         }
+        if (SCIDB_SE_SYNTAX == e.getShortErrorCode())
+        {
+            throw CONV_TO_USER_QUERY_EXCEPTION(e, aggregateCall->getParsingContext());
+        }
 
         throw;
     }
@@ -1910,9 +1928,14 @@ boost::shared_ptr<JobQueue> PhysicalOperator::getGlobalQueueForOperators()
 {
     ScopedMutexLock cs(_mutexGlobalQueueForOperators);
     if (!_globalThreadPoolForOperators) {
-        _globalQueueForOperators = boost::shared_ptr<JobQueue>(new JobQueue());
+        // with NUMA affinity, idle threads steal from the threads of their own node first
+        bool const numaAffinity = Config::getInstance()->getOption<bool>(CONFIG_NUMA_AFFINITY);
+        size_t const nNodes = numaAffinity ? Sysinfo::getNumberOfNUMANodes() : 1;
+        _globalQueueForOperators = boost::shared_ptr<JobQueue>(new JobQueue(nNodes));
+        _globalQueueForOperators->setName("operators");
         _globalThreadPoolForOperators = boost::shared_ptr<ThreadPool>(
-                new ThreadPool(Config::getInstance()->getOption<int>(CONFIG_EXEC_THREADS), _globalQueueForOperators));
+                new ThreadPool(Config::getInstance()->getOption<int>(CONFIG_EXEC_THREADS), _globalQueueForOperators,
+                               numaAffinity));
         _globalThreadPoolForOperators->start();
     }
     return _globalQueueForOperators;
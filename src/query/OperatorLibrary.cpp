@@ -179,6 +179,25 @@ void OperatorLibrary::getPhysicalNames(const string& logicalName,
 }
 
 
+bool OperatorLibrary::isMemoryHungry(const string& logicalName)
+{
+    PhysicalOperatorFactoriesMap::const_iterator pOpIt = _physicalOperatorFactories.find(logicalName);
+
+    if (pOpIt == _physicalOperatorFactories.end())
+    {
+        return false;
+    }
+
+    BOOST_FOREACH(const PhysicalOperatorFactoriesPair &pOpFactory, (*pOpIt).second)
+    {
+        if (pOpFactory.second->isMemoryHungry()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
 void OperatorLibrary::getLogicalNames(vector<string> &logicalOperatorsNames)
 {
     for(LogicalOperatorFactories::iterator it = _logicalOperatorFactories.begin(); it != _logicalOperatorFactories.end(); ++it)
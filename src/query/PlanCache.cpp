@@ -0,0 +1,151 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file PlanCache.cpp
+ *
+ * @brief Cache of optimized physical plans on the coordinator.
+ */
+
+#include <algorithm>
+#include <sstream>
+
+#include <log4cxx/logger.h>
+
+#include <query/Query.h>
+#include <system/Cluster.h>
+#include <system/Config.h>
+#include <system/SciDBConfigOptions.h>
+#include <system/SystemCatalog.h>
+
+#include "query/PlanCache.h"
+#include "query/QueryProcessor.h"
+
+using namespace std;
+using namespace boost;
+
+namespace scidb
+{
+
+static log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("scidb.qproc.plancache"));
+
+PlanCache::PlanCache()
+: _capacity(std::max(Config::getInstance()->getOption<int>(CONFIG_PLAN_CACHE_SIZE), 0))
+{
+}
+
+string PlanCache::getKey(const shared_ptr<Query>& query, bool afl)
+{
+    if (query->doesExclusiveArrayAccess()) {
+        return string();
+    }
+    ostringstream key;
+    key << (afl ? "afl " : "aql ") << query->queryString.size() << ':' << query->queryString;
+
+    if (query->queryParams) {
+        const QueryParamMap::Params& params = query->queryParams->params;
+        for (QueryParamMap::Params::const_iterator p = params.begin(); p != params.end(); ++p) {
+            key << " $" << p->first << ':' << p->second.type;
+        }
+    }
+
+    // The plan is built for the instances of the query
+    key << " view " << query->getCoordinatorLiveness()->getViewId()
+        << ':' << query->getInstancesCount();
+
+    // ... under the options which change the plan and can be set at run time
+    Config* config = Config::getInstance();
+    key << " gemm " << config->getOption<int>(CONFIG_GEMM_IN_PROCESS_LIMIT)
+        << " profile " << config->getOption<bool>(CONFIG_PROFILE_QUERIES);
+
+    // ... and for the latest versions of the arrays it reads
+    SystemCatalog* catalog = SystemCatalog::getInstance();
+    const Query::QueryLocks locks = query->getRequestedLocks();
+    for (Query::QueryLocks::const_iterator l = locks.begin(); l != locks.end(); ++l) {
+        if ((*l)->getLockMode() != SystemCatalog::LockDesc::RD) {
+            return string();
+        }
+        const string& arrayName = (*l)->getArrayName();
+        const ArrayID arrayId = catalog->findArrayByName(arrayName);
+        if (arrayId == INVALID_ARRAY_ID) {
+            return string();
+        }
+        // A temporary array is overwritten in place, without a new version to tell the plans apart
+        if (catalog->getArrayDesc(arrayId)->isTransient()) {
+            return string();
+        }
+        key << ' ' << arrayName << '@' << arrayId << ':' << catalog->getLastVersion(arrayId);
+    }
+    return key.str();
+}
+
+bool PlanCache::sameValues(const QueryParamMap* left, const QueryParamMap* right)
+{
+    if (!left || !right) {
+        return (!left || left->empty()) && (!right || right->empty());
+    }
+    if (left->params.size() != right->params.size()) {
+        return false;
+    }
+    QueryParamMap::Params::const_iterator l = left->params.begin();
+    QueryParamMap::Params::const_iterator r = right->params.begin();
+    for (; l != left->params.end(); ++l, ++r) {
+        if (l->first != r->first || l->second.type != r->second.type || l->second.value != r->second.value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+shared_ptr<const CachedPlan> PlanCache::find(const string& key, const QueryParamMap* params)
+{
+    ScopedMutexLock cs(_mutex);
+    map<string, shared_ptr<const CachedPlan> >::const_iterator i = _plans.find(key);
+    if (i == _plans.end()) {
+        return shared_ptr<const CachedPlan>();
+    }
+    const shared_ptr<const CachedPlan>& plan = i->second;
+    if (plan->parameterValuesUsed && !sameValues(plan->params.get(), params)) {
+        LOG4CXX_TRACE(logger, "Cached plan is bound to other parameter values: " << key);
+        return shared_ptr<const CachedPlan>();
+    }
+    _lru.touch(key);
+    return plan;
+}
+
+void PlanCache::insert(const shared_ptr<const CachedPlan>& plan)
+{
+    assert(plan && !plan->key.empty() && !plan->physicalPlan.empty());
+    if (!isEnabled()) {
+        return;
+    }
+    ScopedMutexLock cs(_mutex);
+    _plans[plan->key] = plan;
+    _lru.touch(plan->key);
+    string victim;
+    while (_plans.size() > _capacity && _lru.pop(victim)) {
+        _plans.erase(victim);
+    }
+    LOG4CXX_DEBUG(logger, "Cached plan (" << _plans.size() << " plans): " << plan->key);
+}
+
+} //namespace scidb
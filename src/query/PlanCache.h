@@ -0,0 +1,135 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file PlanCache.h
+ *
+ * @brief Cache of optimized physical plans on the coordinator.
+ *
+ * Parsing, type inference and optimization cost a client query tens of milliseconds and several
+ * catalog round trips, which dominates short queries fired over and over, typically the same AFL
+ * text with different values bound to its $placeholders. The coordinator keeps the serialized
+ * physical plan of such queries, keyed by the query text, the types of its parameters, the cluster
+ * membership, the run-time options which change the plan (gemm-in-process-limit, profile-queries)
+ * and the latest versions of the arrays it reads. A query found in the cache skips
+ * the second parsing pass, type inference and optimization; its parameters are bound into the
+ * physical expressions of the cached plan.
+ *
+ * Only read-only queries executed with a single physical plan are cached, and not the queries of
+ * temporary arrays, which change without a new version. A plan whose shape
+ * depends on the value of a parameter (e.g. a parameter used as a schema bound) is reused only
+ * for the same values.
+ */
+
+#ifndef PLAN_CACHE_H_
+#define PLAN_CACHE_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <util/Lru.h>
+#include <util/Mutex.h>
+#include <util/Singleton.h>
+
+namespace scidb
+{
+
+class Query;
+struct QueryParamMap;
+
+/**
+ * A physical plan cached by the coordinator, with the results of preparation the client expects.
+ */
+struct CachedPlan
+{
+    CachedPlan() : selective(false), parameterValuesUsed(false)
+    {
+    }
+
+    std::string key;
+    std::string physicalPlan;   /**< serialized, empty until the query has executed */
+    std::string explainLogical;
+    std::vector<std::string> plugins;
+    bool selective;
+
+    /** The parameters the plan was built with */
+    boost::shared_ptr<const QueryParamMap> params;
+
+    /** true if the plan holds only for the values of params */
+    bool parameterValuesUsed;
+};
+
+/**
+ * The plan cache of the coordinator, configured by CONFIG_PLAN_CACHE_SIZE.
+ */
+class PlanCache : public Singleton<PlanCache>
+{
+public:
+    PlanCache();
+
+    /**
+     * @return false if the plan cache is disabled
+     */
+    bool isEnabled() const
+    {
+        return _capacity != 0;
+    }
+
+    /**
+     * Compute the key of a query prepared under its array locks.
+     * @return the key, or an empty string if the plan of the query must not be cached
+     */
+    static std::string getKey(const boost::shared_ptr<Query>& query, bool afl);
+
+    /**
+     * @param key the key of the query
+     * @param params the parameters of the query, NULL if it has none
+     * @return the plan cached for the key and the parameters, or NULL
+     */
+    boost::shared_ptr<const CachedPlan> find(const std::string& key, const QueryParamMap* params);
+
+    /**
+     * Cache a plan under its key, evicting the least recently used plan if the cache is full.
+     */
+    void insert(const boost::shared_ptr<const CachedPlan>& plan);
+
+    size_t size()
+    {
+        ScopedMutexLock cs(_mutex);
+        return _plans.size();
+    }
+
+private:
+    static bool sameValues(const QueryParamMap* left, const QueryParamMap* right);
+
+    Mutex _mutex;
+    size_t const _capacity;
+    LRU<std::string> _lru;
+    std::map<std::string, boost::shared_ptr<const CachedPlan> > _plans;
+};
+
+} //namespace scidb
+
+#endif /* PLAN_CACHE_H_ */
@@ -0,0 +1,263 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/*
+ * @file ProfileUnitTests.h
+ *
+ * @brief Tests of the counters of explain analyze: OperatorProfile and ProfiledArray.
+ */
+
+#ifndef PROFILE_UNIT_TESTS_H_
+#define PROFILE_UNIT_TESTS_H_
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <pthread.h>
+#include <algorithm>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "array/MemArray.h"
+#include "array/Metadata.h"
+#include "query/ProfiledArray.h"
+#include "query/Query.h"
+#include "query/Statistics.h"
+#include "system/Cluster.h"
+
+using namespace scidb;
+
+class ProfileTests: public CppUnit::TestFixture
+{
+CPPUNIT_TEST_SUITE(ProfileTests);
+CPPUNIT_TEST(testConcurrentCounters);
+CPPUNIT_TEST(testMerge);
+CPPUNIT_TEST(testProfiledArray);
+CPPUNIT_TEST(testProfiledEmptyableArray);
+CPPUNIT_TEST_SUITE_END();
+
+private:
+    enum
+    {
+        N_THREADS = 8,
+        N_ADDS = 100000,    // additions per thread
+        SIDE = 25,          // cells of the arrays, the last chunk is partial
+        CHUNK = 10          // chunk interval
+    };
+
+    boost::shared_ptr<Query> _query;
+
+    struct Adder
+    {
+        OperatorProfile* profile;
+        uint64_t threadNo;
+    };
+
+    static void* addAll(void* arg)
+    {
+        Adder& adder = *static_cast<Adder*>(arg);
+        for (uint64_t i = 0; i < N_ADDS; i++) {
+            adder.profile->add(OperatorProfile::CHUNKS_OUT, 1);
+            adder.profile->add(OperatorProfile::BYTES_SENT, adder.threadNo);
+            adder.profile->add(OperatorProfile::PEAK_MEMORY, adder.threadNo * N_ADDS + i);
+        }
+        return NULL;
+    }
+
+    static Dimensions getDimensions()
+    {
+        Dimensions dims(1);
+        dims[0] = DimensionDesc("x", 0, SIDE - 1, CHUNK, 0);
+        return dims;
+    }
+
+    /**
+     * Fill every cell of the array, except those with x % skip == 1 when skip is not 0
+     */
+    boost::shared_ptr<Array> makeArray(ArrayDesc const& desc, Coordinate skip)
+    {
+        boost::shared_ptr<MemArray> array(new MemArray(desc, _query));
+        Attributes const& attrs = desc.getAttributes();
+        Coordinates chunkPos(1);
+        Coordinates pos(1);
+        for (chunkPos[0] = 0; chunkPos[0] < SIDE; chunkPos[0] += CHUNK) {
+            for (AttributeID i = 0; i < attrs.size(); i++) {
+                Value value(TypeLibrary::getType(attrs[i].getType()));
+                boost::shared_ptr<ArrayIterator> arrayIterator = array->getIterator(i);
+                boost::shared_ptr<ChunkIterator> chunkIterator =
+                    arrayIterator->newChunk(chunkPos).getIterator(_query, i == 0
+                        ? ChunkIterator::SEQUENTIAL_WRITE
+                        : ChunkIterator::SEQUENTIAL_WRITE | ChunkIterator::NO_EMPTY_CHECK);
+                for (pos[0] = chunkPos[0]; pos[0] < std::min<Coordinate>(chunkPos[0] + CHUNK, SIDE); pos[0]++) {
+                    if (skip != 0 && pos[0] % skip == 1) {
+                        continue;
+                    }
+                    if (attrs[i].isEmptyIndicator()) {
+                        value.setBool(true);
+                    } else {
+                        value.setInt64(pos[0] * 3);
+                    }
+                    CPPUNIT_ASSERT(chunkIterator->setPosition(pos));
+                    chunkIterator->writeItem(value);
+                }
+                chunkIterator->flush();
+            }
+        }
+        return array;
+    }
+
+    /**
+     * Pull every chunk of the first attribute through a ProfiledArray, getting each one twice,
+     * then the first one again after a setPosition().
+     * @return the cells of the chunks pulled whose count is known
+     */
+    uint64_t pullChunks(boost::shared_ptr<Array> const& input, Statistics& producer, OperatorProfile* consumer)
+    {
+        ProfiledArray profiled(input, producer, consumer, _query);
+        CPPUNIT_ASSERT(&profiled.getArrayDesc() == &input->getArrayDesc());
+
+        uint64_t cells = 0;
+        boost::shared_ptr<ConstArrayIterator> arrayIterator = profiled.getConstIterator(0);
+        for (; !arrayIterator->end(); ++(*arrayIterator)) {
+            ConstChunk const& chunk = arrayIterator->getChunk();
+            CPPUNIT_ASSERT(&arrayIterator->getChunk() == &chunk);
+            cells += chunk.isCountKnown() ? chunk.count() : 0;
+        }
+        Coordinates first(1, 0);
+        CPPUNIT_ASSERT(arrayIterator->setPosition(first));
+        ConstChunk const& chunk = arrayIterator->getChunk();
+        cells += chunk.isCountKnown() ? chunk.count() : 0;
+        return cells;
+    }
+
+public:
+    void setUp()
+    {
+        boost::shared_ptr<const InstanceLiveness> liveness(Cluster::getInstance()->getInstanceLiveness());
+        int32_t longErrorCode = SCIDB_E_NO_ERROR;
+        _query = Query::createFakeQuery(0, 0, liveness, &longErrorCode);
+        if (longErrorCode != SCIDB_E_NO_ERROR &&
+            longErrorCode != SCIDB_LE_INVALID_FUNCTION_ARGUMENT) {
+            // NetworkManager::createWorkQueue() may complain about a null queue,
+            // which does not matter since the network is not used
+            throw SYSTEM_EXCEPTION(SCIDB_LE_UNKNOWN_ERROR, longErrorCode);
+        }
+    }
+
+    void tearDown()
+    {
+        Query::destroyFakeQuery(_query.get());
+        _query.reset();
+    }
+
+    /// The threads add to their own slots: no addition is lost, and the peak is the largest value
+    void testConcurrentCounters()
+    {
+        OperatorProfile profile;
+        std::vector<Adder> adders(N_THREADS);
+        std::vector<pthread_t> threads(N_THREADS);
+        for (size_t t = 0; t < N_THREADS; t++) {
+            adders[t].profile = &profile;
+            adders[t].threadNo = t;
+            CPPUNIT_ASSERT(pthread_create(&threads[t], NULL, &addAll, &adders[t]) == 0);
+        }
+        for (size_t t = 0; t < N_THREADS; t++) {
+            pthread_join(threads[t], NULL);
+        }
+        CPPUNIT_ASSERT(profile.get(OperatorProfile::CHUNKS_OUT) == uint64_t(N_THREADS) * N_ADDS);
+        CPPUNIT_ASSERT(profile.get(OperatorProfile::BYTES_SENT) == uint64_t(N_THREADS) * (N_THREADS - 1) / 2 * N_ADDS);
+        CPPUNIT_ASSERT(profile.get(OperatorProfile::PEAK_MEMORY) == uint64_t(N_THREADS) * N_ADDS - 1);
+        CPPUNIT_ASSERT(profile.get(OperatorProfile::CELLS_OUT) == 0);
+    }
+
+    /// The totals of the other instances add up, except the peak which is the largest one
+    void testMerge()
+    {
+        OperatorProfile local;
+        local.add(OperatorProfile::WALL_TIME, 100);
+        local.add(OperatorProfile::CELLS_IN, 7);
+        local.add(OperatorProfile::PEAK_MEMORY, 5000);
+
+        uint64_t remote[OperatorProfile::NUM_COUNTERS];
+        for (size_t c = 0; c < OperatorProfile::NUM_COUNTERS; c++) {
+            remote[c] = c + 1;
+        }
+        local.merge(remote);
+        remote[OperatorProfile::PEAK_MEMORY] = 9000;
+        local.merge(remote);
+
+        uint64_t totals[OperatorProfile::NUM_COUNTERS];
+        local.getTotals(totals);
+        CPPUNIT_ASSERT(totals[OperatorProfile::WALL_TIME] == 100 + 2 * (OperatorProfile::WALL_TIME + 1));
+        CPPUNIT_ASSERT(totals[OperatorProfile::CELLS_IN] == 7 + 2 * (OperatorProfile::CELLS_IN + 1));
+        CPPUNIT_ASSERT(totals[OperatorProfile::BYTES_READ] == 2 * (OperatorProfile::BYTES_READ + 1));
+        CPPUNIT_ASSERT(totals[OperatorProfile::PEAK_MEMORY] == 9000);
+        for (size_t c = 0; c < OperatorProfile::NUM_COUNTERS; c++) {
+            CPPUNIT_ASSERT(totals[c] == local.get(OperatorProfile::Counter(c)));
+        }
+    }
+
+    /// Every chunk pulled counts once as output of the producer and once as input of the consumer,
+    /// however often the consumer gets it; the cells of a dense chunk are always known
+    void testProfiledArray()
+    {
+        Attributes attrs(1);
+        attrs[0] = AttributeDesc(0, "a", TID_INT64, 0, 0);
+        boost::shared_ptr<Array> input = makeArray(ArrayDesc("dense", attrs, getDimensions()), 0);
+
+        OperatorProfile producerProfile;
+        OperatorProfile consumerProfile;
+        Statistics producer;
+        producer.profile = &producerProfile;
+        CPPUNIT_ASSERT(pullChunks(input, producer, &consumerProfile) == SIDE + CHUNK);
+
+        CPPUNIT_ASSERT(producerProfile.get(OperatorProfile::CHUNKS_OUT) == 4);
+        CPPUNIT_ASSERT(producerProfile.get(OperatorProfile::CELLS_OUT) == SIDE + CHUNK);
+        CPPUNIT_ASSERT(consumerProfile.get(OperatorProfile::CHUNKS_IN) == 4);
+        CPPUNIT_ASSERT(consumerProfile.get(OperatorProfile::CELLS_IN) == SIDE + CHUNK);
+        CPPUNIT_ASSERT(producerProfile.get(OperatorProfile::CHUNKS_IN) == 0);
+        CPPUNIT_ASSERT(consumerProfile.get(OperatorProfile::CHUNKS_OUT) == 0);
+    }
+
+    /// The cells of a sparse chunk count only when they are known; the result of the plan has no consumer
+    void testProfiledEmptyableArray()
+    {
+        Attributes attrs(2);
+        attrs[0] = AttributeDesc(0, "a", TID_INT64, 0, 0);
+        attrs[1] = AttributeDesc(1, DEFAULT_EMPTY_TAG_ATTRIBUTE_NAME, TID_INDICATOR, AttributeDesc::IS_EMPTY_INDICATOR, 0);
+        boost::shared_ptr<Array> input = makeArray(ArrayDesc("sparse", attrs, getDimensions()), 4);
+
+        OperatorProfile producerProfile;
+        Statistics producer;
+        producer.profile = &producerProfile;
+        uint64_t const cells = pullChunks(input, producer, NULL);
+
+        CPPUNIT_ASSERT(producerProfile.get(OperatorProfile::CHUNKS_OUT) == 4);
+        CPPUNIT_ASSERT(producerProfile.get(OperatorProfile::CELLS_OUT) == cells);
+        CPPUNIT_ASSERT(cells < SIDE + CHUNK);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ProfileTests);
+
+#endif /* PROFILE_UNIT_TESTS_H_ */
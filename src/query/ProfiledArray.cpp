@@ -0,0 +1,130 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file ProfiledArray.cpp
+ *
+ * @brief Array counting the chunks pulled from the result of an operator.
+ */
+
+#include <query/Query.h>
+
+#include "query/ProfiledArray.h"
+
+using namespace std;
+using namespace boost;
+
+namespace scidb
+{
+
+ProfiledArray::ProfiledArray(shared_ptr<Array> const& input,
+                             Statistics& producer,
+                             OperatorProfile* consumer,
+                             shared_ptr<Query> const& query)
+: _input(input),
+  _producer(producer),
+  _profile(*producer.profile),
+  _consumer(consumer),
+  _query(query)
+{
+}
+
+shared_ptr<ConstArrayIterator> ProfiledArray::getConstIterator(AttributeID attr) const
+{
+    shared_ptr<ConstArrayIterator> input;
+    {
+        StatisticsScope sScope(&_producer);
+        ProfileTimer timer(_profile, NULL);
+        input = _input->getConstIterator(attr);
+    }
+    return shared_ptr<ConstArrayIterator>(new ProfiledArrayIterator(*this, input));
+}
+
+ProfiledArrayIterator::ProfiledArrayIterator(ProfiledArray const& array, shared_ptr<ConstArrayIterator> const& input)
+: _array(array),
+  _input(input),
+  _counted(false)
+{
+}
+
+bool ProfiledArrayIterator::end()
+{
+    StatisticsScope sScope(&_array._producer);
+    ProfileTimer timer(_array._profile, NULL);
+    return _input->end();
+}
+
+void ProfiledArrayIterator::operator ++()
+{
+    StatisticsScope sScope(&_array._producer);
+    ProfileTimer timer(_array._profile, NULL);
+    ++(*_input);
+    _counted = false;
+}
+
+Coordinates const& ProfiledArrayIterator::getPosition()
+{
+    return _input->getPosition();
+}
+
+bool ProfiledArrayIterator::setPosition(Coordinates const& pos)
+{
+    StatisticsScope sScope(&_array._producer);
+    ProfileTimer timer(_array._profile, NULL);
+    _counted = false;
+    return _input->setPosition(pos);
+}
+
+void ProfiledArrayIterator::reset()
+{
+    StatisticsScope sScope(&_array._producer);
+    ProfileTimer timer(_array._profile, NULL);
+    _input->reset();
+    _counted = false;
+}
+
+ConstChunk const& ProfiledArrayIterator::getChunk()
+{
+    if (_counted) {
+        return _input->getChunk();
+    }
+    shared_ptr<Query> query = _array._query.lock();
+    ConstChunk const* chunk;
+    {
+        StatisticsScope sScope(&_array._producer);
+        ProfileTimer timer(_array._profile, query.get());
+        chunk = &_input->getChunk();
+    }
+    _counted = true;
+
+    // Counting the cells of a chunk could cost as much as producing it
+    const uint64_t cells = chunk->isCountKnown() ? chunk->count() : 0;
+    _array._profile.add(OperatorProfile::CHUNKS_OUT, 1);
+    _array._profile.add(OperatorProfile::CELLS_OUT, cells);
+    if (_array._consumer) {
+        _array._consumer->add(OperatorProfile::CHUNKS_IN, 1);
+        _array._consumer->add(OperatorProfile::CELLS_IN, cells);
+    }
+    return *chunk;
+}
+
+} //namespace scidb
@@ -0,0 +1,139 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file ProfiledArray.h
+ *
+ * @brief Array counting the chunks pulled from the result of an operator.
+ */
+
+#ifndef PROFILED_ARRAY_H_
+#define PROFILED_ARRAY_H_
+
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <array/Array.h>
+#include <query/Statistics.h>
+
+namespace scidb
+{
+
+/**
+ * Wraps the result of a plan node when queries are profiled (CONFIG_PROFILE_QUERIES).
+ * The chunks pulled through it count as output of the producer node and as input of the
+ * consumer node. The time spent in the array iterators of the result, and the I/O done there,
+ * are accounted to the producer. The chunks themselves are those of the input array: the work
+ * done by their chunk iterators is accounted to the operator iterating them.
+ */
+class ProfiledArray : public Array
+{
+public:
+    /**
+     * @param input the result of the producer
+     * @param producer the statistics of the operator producing input, with the profile of its node
+     * @param consumer the profile of the node reading input, NULL for the result of the plan
+     * @param query the query, whose memory usage is sampled as chunks are pulled
+     */
+    ProfiledArray(boost::shared_ptr<Array> const& input,
+                  Statistics& producer,
+                  OperatorProfile* consumer,
+                  boost::shared_ptr<Query> const& query);
+
+    virtual std::string const& getName() const
+    {
+        return _input->getName();
+    }
+
+    virtual ArrayID getHandle() const
+    {
+        return _input->getHandle();
+    }
+
+    virtual bool isRLE() const
+    {
+        return _input->isRLE();
+    }
+
+    virtual bool hasChunkPositions() const
+    {
+        return _input->hasChunkPositions();
+    }
+
+    virtual boost::shared_ptr<CoordinateSet> getChunkPositions() const
+    {
+        return _input->getChunkPositions();
+    }
+
+    virtual bool isMaterialized() const
+    {
+        return _input->isMaterialized();
+    }
+
+    virtual Access getSupportedAccess() const
+    {
+        return _input->getSupportedAccess();
+    }
+
+    virtual ArrayDesc const& getArrayDesc() const
+    {
+        return _input->getArrayDesc();
+    }
+
+    virtual boost::shared_ptr<ConstArrayIterator> getConstIterator(AttributeID attr) const;
+
+    boost::shared_ptr<Array> const& getInputArray() const
+    {
+        return _input;
+    }
+
+private:
+    friend class ProfiledArrayIterator;
+
+    boost::shared_ptr<Array> const _input;
+    Statistics& _producer;
+    OperatorProfile& _profile;
+    OperatorProfile* const _consumer;
+    boost::weak_ptr<Query> const _query;
+};
+
+class ProfiledArrayIterator : public ConstArrayIterator
+{
+public:
+    ProfiledArrayIterator(ProfiledArray const& array, boost::shared_ptr<ConstArrayIterator> const& input);
+
+    virtual bool end();
+    virtual void operator ++();
+    virtual Coordinates const& getPosition();
+    virtual bool setPosition(Coordinates const& pos);
+    virtual void reset();
+    virtual ConstChunk const& getChunk();
+
+private:
+    ProfiledArray const& _array;
+    boost::shared_ptr<ConstArrayIterator> const _input;
+    bool _counted;  // the current chunk has been counted
+};
+
+} //namespace scidb
+
+#endif /* PROFILED_ARRAY_H_ */
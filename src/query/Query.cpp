@@ -34,6 +34,7 @@
 #endif
 
 #include <time.h>
+#include <fstream>
 #include <boost/make_shared.hpp>
 #include <boost/foreach.hpp>
 #include <boost/serialization/string.hpp>
@@ -49,6 +50,7 @@
 #include "system/Cluster.h"
 #include "util/iqsort.h"
 #include "util/LockManager.h"
+#include "util/Tracer.h"
 #include <system/BlockCyclic.h>
 #include <system/Exceptions.h>
 #include <system/System.h>
@@ -190,6 +192,7 @@ Query::Query(QueryID queryID):
     _creationTime(time(NULL)),
     _useCounter(0),
     _doesExclusiveArrayAccess(false),
+    _parameterValuesUsed(false),
     _procGrid(NULL), isDDL(false)
 {
 }
@@ -283,6 +286,34 @@ void Query::init(InstanceID coordID,
    LOG4CXX_DEBUG(_logger, "Initialized query (" << _queryID << ")");
 }
 
+const size_t Query::MIN_SPILL_THRESHOLD;
+
+size_t Query::getMemoryUsage() const
+{
+    return _arena ? _arena->allocated() : 0;
+}
+
+size_t Query::getMemoryBudget()
+{
+    int const budget = Config::getInstance()->getOption<int>(CONFIG_QUERY_MEMORY_BUDGET);
+    return budget > 0 ? static_cast<size_t>(budget) * MiB : 0;
+}
+
+size_t Query::getSpillThreshold(size_t preferred) const
+{
+    size_t const budget = getMemoryBudget();
+    if (budget == 0) {
+        return preferred;
+    }
+    size_t const used = getMemoryUsage();
+    size_t const left = used < budget ? budget - used : 0;
+    if (left < preferred) {
+        LOG4CXX_DEBUG(_logger, "Query (" << _queryID << ") uses " << used << " of its "
+                      << budget << " bytes budget, spill threshold lowered to " << left);
+    }
+    return std::max(std::min(preferred, left), MIN_SPILL_THRESHOLD);
+}
+
 shared_ptr<Query> Query::insert(const shared_ptr<Query>& query)
 {
     assert(query);
@@ -776,6 +807,7 @@ QueryID Query::getCurrentQueryID()
 void Query::setCurrentQueryID(QueryID queryID)
 {
     currentQueryID = queryID;
+    Tracer::setCurrentQueryID(queryID);
 }
 #else
 static ThreadContext<QueryID> currentQueryID;
@@ -794,6 +826,7 @@ void Query::setCurrentQueryID(QueryID queryID)
         currentQueryID = ptr;
     }
     *ptr = queryID;
+    Tracer::setCurrentQueryID(queryID);
 }
 #endif
 
@@ -856,6 +889,30 @@ void dumpMemoryUsage(const QueryID queryId)
 #endif
 }
 
+void Query::dumpTrace()
+{
+    if (!Tracer::isEnabled()) {
+        return;
+    }
+    string dir = Config::getInstance()->getOption<string>(CONFIG_TRACE_PATH);
+    if (dir.empty()) {
+        dir = Config::getInstance()->getOption<string>(CONFIG_TMP_PATH);
+    }
+    const QueryID queryId = getQueryID();
+    const InstanceID instanceId = Cluster::getInstance()->getLocalInstanceId();
+    stringstream path;
+    path << dir << "/trace-" << queryId << "-" << instanceId << ".json";
+
+    ofstream out(path.str().c_str());
+    Tracer::dump(out, queryId, uint64_t(_creationTime) * 1000000, instanceId);
+    out.close();
+    if (!out) {
+        LOG4CXX_WARN(_logger, "Cannot write the trace of query " << queryId << " to " << path.str());
+    } else {
+        LOG4CXX_DEBUG(_logger, "Trace of query " << queryId << " written to " << path.str());
+    }
+}
+
 void Query::destroy()
 {
     shared_ptr<Array> resultArray;
@@ -895,6 +952,7 @@ void Query::destroy()
     if (errQueue)    { errQueue->stop(); }
     if (opQueue)     { opQueue->stop(); }
     dumpMemoryUsage(getQueryID());
+    dumpTrace();
 }
 
 void
@@ -1364,7 +1422,8 @@ void Query::listLiveInstances(InstanceVisitor& func)
 }
 
 ReplicationContext::ReplicationContext(const boost::shared_ptr<Query>& query, size_t nInstances)
-: _query(query)
+: _query(query),
+  _queryId(query->getQueryID())
 #ifndef NDEBUG // for debugging
 ,_chunkReplicasReqs(nInstances)
 #endif
@@ -1375,6 +1434,14 @@ ReplicationContext::ReplicationContext(const boost::shared_ptr<Query>& query, si
     }
 }
 
+ReplicationContext::~ReplicationContext()
+{
+    // the replicas left by an aborted query are failed by the ReplicationManager on their own
+    if (_replicationMngr != NULL) {
+        _replicationMngr->discardDeferred(_queryId);
+    }
+}
+
 ReplicationContext::QueueInfoPtr ReplicationContext::getQueueInfo(QueueID id)
 {   // mutex must be locked
     QueueInfoPtr& qInfo = _inboundQueues[id];
@@ -1475,6 +1542,9 @@ void ReplicationContext::replicationSync(ArrayID arrId)
     boost::shared_ptr<Query> query(Query::getValidQueryPtr(_query));
     msg->setQueryID(query->getQueryID());
 
+    // the replicas sent ahead of the eof have to be out before it
+    _replicationMngr->waitForDeferred(query->getQueryID(), arrId);
+
     vector<boost::shared_ptr<ReplicationManager::Item> > replicasVec;
     Query::InstanceVisitor f =
         boost::bind(&generateReplicationItems, msg, &replicasVec, _1, _2);
@@ -222,4 +222,73 @@ void PhysicalPlan::toString(std::ostream &out, int const indent, bool children)
     }
 }
 
+static void getNodesInPreorder(const PhysNodePtr& node, vector<PhysNodePtr>& nodes)
+{
+    nodes.push_back(node);
+    const vector<PhysNodePtr>& children = node->getChildren();
+    for (size_t i = 0; i < children.size(); i++) {
+        getNodesInPreorder(children[i], nodes);
+    }
+}
+
+void PhysicalPlan::getNodes(vector<PhysNodePtr>& nodes) const
+{
+    nodes.clear();
+    if (_root) {
+        getNodesInPreorder(_root, nodes);
+    }
+}
+
+void PhysicalPlan::getProfiles(vector<uint64_t>& counters) const
+{
+    vector<PhysNodePtr> nodes;
+    getNodes(nodes);
+    counters.resize(nodes.size() * OperatorProfile::NUM_COUNTERS);
+    for (size_t i = 0; i < nodes.size(); i++) {
+        nodes[i]->getProfile().getTotals(&counters[i * OperatorProfile::NUM_COUNTERS]);
+    }
+}
+
+bool PhysicalPlan::mergeProfiles(const uint64_t* counters, size_t size)
+{
+    vector<PhysNodePtr> nodes;
+    getNodes(nodes);
+    if (size != nodes.size() * OperatorProfile::NUM_COUNTERS) {
+        return false;
+    }
+    for (size_t i = 0; i < nodes.size(); i++) {
+        nodes[i]->getRemoteProfile().merge(counters + i * OperatorProfile::NUM_COUNTERS);
+    }
+    return true;
+}
+
+static void writeNodeProfile(std::ostream &out, const PhysNodePtr& node, int indent)
+{
+    uint64_t totals[OperatorProfile::NUM_COUNTERS];
+    uint64_t remote[OperatorProfile::NUM_COUNTERS];
+    node->getProfile().getTotals(totals);
+    node->getRemoteProfile().getTotals(remote);
+    for (size_t c = 0; c < OperatorProfile::NUM_COUNTERS; c++) {
+        totals[c] = (c == OperatorProfile::PEAK_MEMORY) ? std::max(totals[c], remote[c]) : totals[c] + remote[c];
+    }
+
+    Indent prefix(indent);
+    out << prefix('>', false);
+    out << "[pNode] " << node->getPhysicalOperator()->getPhysicalName() << ": ";
+    writeProfile(out, totals);
+    out << "\n";
+
+    const vector<PhysNodePtr>& children = node->getChildren();
+    for (size_t i = 0; i < children.size(); i++) {
+        writeNodeProfile(out, children[i], indent + 1);
+    }
+}
+
+void PhysicalPlan::writeProfile(std::ostream &out) const
+{
+    if (_root) {
+        writeNodeProfile(out, _root, 1);
+    }
+}
+
 } // namespace
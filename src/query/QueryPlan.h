@@ -224,6 +224,23 @@ class PhysicalQueryPlanNode : boost::noncopyable
         return _tile;
     }
 
+    /**
+     * @return the execution counters of the node on this instance
+     */
+    OperatorProfile& getProfile()
+    {
+        return _profile;
+    }
+
+    /**
+     * @return the execution counters of the node on the other instances,
+     * merged by the coordinator as the instances finish executing the plan
+     */
+    OperatorProfile& getRemoteProfile()
+    {
+        return _remoteProfile;
+    }
+
     //TODO: there should be a list of arbitrary markers for optimizer to scratch with.
     //Something like a std::map<std::string, boost::any>.
 
@@ -478,6 +495,9 @@ private:
 
     ArrayDistribution _distribution;
     PhysicalBoundaries _boundaries;
+
+    OperatorProfile _profile;
+    OperatorProfile _remoteProfile;
 };
 
 /**
@@ -571,6 +591,30 @@ public:
      */
     void toString(std::ostream &out, int indent = 0, bool children = true) const;
 
+    /**
+     * @param[out] nodes the nodes of the plan, in preorder
+     */
+    void getNodes(std::vector<PhysNodePtr>& nodes) const;
+
+    /**
+     * @param[out] counters the OperatorProfile counters of the nodes on this instance, in preorder
+     */
+    void getProfiles(std::vector<uint64_t>& counters) const;
+
+    /**
+     * Merge the counters sent by another instance into the remote profiles of the nodes.
+     * @param counters the counters returned by getProfiles() on the other instance
+     * @param size the number of counters
+     * @return false if the counters do not match the plan
+     */
+    bool mergeProfiles(const uint64_t* counters, size_t size);
+
+    /**
+     * Write the profile of every node (explain analyze), on this instance and on the instances merged.
+     * @param[out] stream to write to
+     */
+    void writeProfile(std::ostream &out) const;
+
 private:
     boost::shared_ptr<PhysicalQueryPlanNode> _root;
 };
@@ -41,6 +41,7 @@
 #include <log4cxx/logger.h>
 
 #include <query/QueryProcessor.h>
+#include <query/ProfiledArray.h>
 #include <query/Parser.h>
 #include <smgr/io/Storage.h>
 #include <network/MessageUtils.h>
@@ -67,6 +68,15 @@ class QueryProcessorImpl: public QueryProcessor
 private:
     // Recursive method for executing physical plan
     boost::shared_ptr<Array> execute(boost::shared_ptr<PhysicalQueryPlanNode> node, boost::shared_ptr<Query> query, int depth);
+    // Execute the operator of a node, counting its time in the profile of the node
+    boost::shared_ptr<Array> executeOperator(boost::shared_ptr<PhysicalQueryPlanNode> node,
+                                             vector<boost::shared_ptr<Array> >& operatorArguments,
+                                             boost::shared_ptr<Query> query);
+    // Count the chunks pulled from the result of a node when queries are profiled
+    boost::shared_ptr<Array> profileResult(boost::shared_ptr<PhysicalQueryPlanNode> node,
+                                           boost::shared_ptr<Array> const& result,
+                                           OperatorProfile* consumer,
+                                           boost::shared_ptr<Query> const& query);
     void preSingleExecute(boost::shared_ptr<PhysicalQueryPlanNode> node, boost::shared_ptr<Query> query);
     void postSingleExecute(boost::shared_ptr<PhysicalQueryPlanNode> node, boost::shared_ptr<Query> query);
     // Synchronization methods
@@ -82,6 +92,9 @@ private:
      */
     void wait(boost::shared_ptr<Query>& query);
 
+    // Recursive method for binding query parameters into physical plan
+    void bindParameters(boost::shared_ptr<PhysicalQueryPlanNode> node, const QueryParamMap& queryParams);
+
 public:
     boost::shared_ptr<Query> createQuery(string queryString, QueryID queryId);
     void parseLogical(boost::shared_ptr<Query> query, bool afl);
@@ -158,6 +171,48 @@ bool QueryProcessorImpl::optimize(boost::shared_ptr<Optimizer> optimizer, boost:
 
 void QueryProcessorImpl::setParameters(boost::shared_ptr<Query> query, QueryParamMap queryParams)
 {
+    query->queryParams = boost::make_shared<QueryParamMap>(queryParams);
+    if (query->hasPhysicalPlan() && !queryParams.empty()) {
+        bindParameters(query->getCurrentPhysicalPlan()->getRoot(), queryParams);
+    }
+}
+
+void QueryProcessorImpl::bindParameters(boost::shared_ptr<PhysicalQueryPlanNode> node, const QueryParamMap& queryParams)
+{
+    const PhysicalOperator::Parameters& parameters = node->getPhysicalOperator()->getParameters();
+    for (size_t i = 0; i < parameters.size(); i++)
+    {
+        if (parameters[i]->getParamType() != PARAM_PHYSICAL_EXPRESSION) {
+            continue;
+        }
+        boost::shared_ptr<Expression> expression =
+            ((boost::shared_ptr<OperatorParamPhysicalExpression> const&)parameters[i])->getExpression();
+        if (!expression->hasParameters()) {
+            continue;
+        }
+        for (QueryParamMap::Params::const_iterator p = queryParams.params.begin(); p != queryParams.params.end(); ++p) {
+            expression->bindParameter(p->first, p->second.type, p->second.value);
+        }
+    }
+
+    vector<boost::shared_ptr<PhysicalQueryPlanNode> >& childs = node->getChildren();
+    for (size_t i = 0; i < childs.size(); i++) {
+        bindParameters(childs[i], queryParams);
+    }
+}
+
+
+void QueryParamMap::bind(const std::string& name, const std::string& literal)
+{
+    boost::shared_ptr<LogicalExpression> logicalExpression = parseExpression(literal);
+    Expression expression;
+    expression.compile(logicalExpression, boost::shared_ptr<Query>(), false);
+    if (!expression.isConstant()) {
+        throw USER_EXCEPTION(SCIDB_SE_QPROC, SCIDB_LE_CONSTANT_EXPRESSION_EXPECTED);
+    }
+    Param& param = params[name];
+    param.type = expression.getType();
+    param.value = expression.evaluate();
 }
 
 
@@ -208,6 +263,26 @@ void QueryProcessorImpl::postSingleExecute(boost::shared_ptr<Query> query)
     postSingleExecute(query->getCurrentPhysicalPlan()->getRoot(), query);
 }
 
+boost::shared_ptr<Array> QueryProcessorImpl::executeOperator(boost::shared_ptr<PhysicalQueryPlanNode> node,
+                                                      vector<boost::shared_ptr<Array> >& operatorArguments,
+                                                      boost::shared_ptr<Query> query)
+{
+    ProfileTimer timer(node->getProfile(), query.get());
+    return node->getPhysicalOperator()->execute(operatorArguments, query);
+}
+
+boost::shared_ptr<Array> QueryProcessorImpl::profileResult(boost::shared_ptr<PhysicalQueryPlanNode> node,
+                                                    boost::shared_ptr<Array> const& result,
+                                                    OperatorProfile* consumer,
+                                                    boost::shared_ptr<Query> const& query)
+{
+    if (!result || !Config::getInstance()->getOption<bool>(CONFIG_PROFILE_QUERIES)) {
+        return result;
+    }
+    return boost::shared_ptr<Array>(
+        new ProfiledArray(result, node->getPhysicalOperator()->getStatistics(), consumer, query));
+}
+
 // Recursive method for executing physical plan
 boost::shared_ptr<Array> QueryProcessorImpl::execute(boost::shared_ptr<PhysicalQueryPlanNode> node, boost::shared_ptr<Query> query, int depth)
 {
@@ -219,13 +294,15 @@ boost::shared_ptr<Array> QueryProcessorImpl::execute(boost::shared_ptr<PhysicalQ
     vector<boost::shared_ptr<Array> > operatorArguments;
     vector<boost::shared_ptr<PhysicalQueryPlanNode> >& childs = node->getChildren();
 
+    physicalOperator->getStatistics().profile = &node->getProfile();
     StatisticsScope sScope(&physicalOperator->getStatistics());
     if (node->isAgg())
     {
         // This assert should be provided by optimizer
         assert(childs.size() == 1);
 
-        boost::shared_ptr<Array> currentResultArray = execute(childs[0], query, depth+1);
+        boost::shared_ptr<Array> currentResultArray =
+            profileResult(childs[0], execute(childs[0], query, depth+1), &node->getProfile(), query);
         assert(currentResultArray);
 
         if (query->getCoordinatorID() != COORDINATOR_INSTANCE)
@@ -261,7 +338,7 @@ boost::shared_ptr<Array> QueryProcessorImpl::execute(boost::shared_ptr<PhysicalQ
              * TODO: we need to get whole result on this instance before we call wait(query)
              * because we hope on currentResultArray of remote instances but it lives until we send wait notification
              */
-            boost::shared_ptr<Array> res = physicalOperator->execute(operatorArguments, query);
+            boost::shared_ptr<Array> res = executeOperator(node, operatorArguments, query);
             wait(query);
 
             return res;
@@ -283,7 +360,7 @@ boost::shared_ptr<Array> QueryProcessorImpl::execute(boost::shared_ptr<PhysicalQ
     }
     else if (node->isDdl())
     {
-        physicalOperator->execute(operatorArguments, query);
+        executeOperator(node, operatorArguments, query);
         return boost::shared_ptr<Array>();
     }
     else
@@ -293,9 +370,9 @@ boost::shared_ptr<Array> QueryProcessorImpl::execute(boost::shared_ptr<PhysicalQ
             boost::shared_ptr<Array> arg = execute(childs[i], query, depth+1);
             if (!arg)
                 throw SYSTEM_EXCEPTION(SCIDB_SE_EXECUTION, SCIDB_LE_NO_OPERATOR_RESULT);
-            operatorArguments.push_back(arg);
+            operatorArguments.push_back(profileResult(childs[i], arg, &node->getProfile(), query));
         }
-        return physicalOperator->execute(operatorArguments, query);
+        return executeOperator(node, operatorArguments, query);
     }
 }
 
@@ -323,6 +400,12 @@ void QueryProcessorImpl::execute(boost::shared_ptr<Query> query)
 
     Query::validateQueryPtr(query);
 
+    if (!rootNode->isAgg())
+    {
+        // The result of an aggregating root is already the current result array
+        currentResultArray = profileResult(rootNode, currentResultArray, NULL, query);
+    }
+
     if (currentResultArray)
     {
         if (Config::getInstance()->getOption<int>(CONFIG_PREFETCHED_CHUNKS) > 1 && currentResultArray->getSupportedAccess() == Array::RANDOM) {
@@ -37,6 +37,7 @@
 #define QUERY_PROCESSOR_H_
 
 #include <boost/shared_ptr.hpp>
+#include <map>
 #include <string>
 #include <queue>
 #include <stdio.h>
@@ -57,11 +58,40 @@ namespace scidb
 {
 
 /**
- * The stub for data type
+ * The values bound to the $placeholders of a prepared query, by placeholder name (without the '$').
+ * A placeholder can stand wherever a constant can, in expressions and as a constant operator parameter.
  */
 struct QueryParamMap
 {
+    struct Param
+    {
+        TypeId type;
+        Value value;
+    };
+    typedef std::map<std::string, Param> Params;
 
+    Params params;
+
+    /**
+     * Bind a placeholder to the value of a constant AFL expression such as
+     * "5", "-2.5", "'text'" or "datetime('2014-01-01 00:00:00')".
+     * @throw USER_EXCEPTION if the text is not a constant expression
+     */
+    void bind(const std::string& name, const std::string& literal);
+
+    /**
+     * @return the value bound to a placeholder, NULL if there is none
+     */
+    const Param* find(const std::string& name) const
+    {
+        Params::const_iterator i = params.find(name);
+        return i == params.end() ? NULL : &i->second;
+    }
+
+    bool empty() const
+    {
+        return params.empty();
+    }
 };
 
 /**
@@ -109,7 +139,8 @@ public:
     virtual bool optimize(boost::shared_ptr< Optimizer> optimizer, boost::shared_ptr<Query> query) = 0;
 
     /**
-     * Set parameters of query before execution
+     * Set parameters of query before execution: keep them in the query for the parser,
+     * and bind them into the current physical plan, if there is one.
      */
     virtual void setParameters(boost::shared_ptr<Query> query, QueryParamMap queryParams) = 0;
 
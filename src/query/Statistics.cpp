@@ -28,6 +28,8 @@
  * @brief Implementation of statistic gatharing class
  */
 
+#include <assert.h>
+#include <time.h>
 #include <boost/make_shared.hpp>
 #include <log4cxx/logger.h>
 
@@ -79,7 +81,71 @@ inline const char* printSizeUnit(size_t size)
     return "MiB";
 }
 
+const char* OperatorProfile::getCounterName(Counter counter)
+{
+    static const char* names[NUM_COUNTERS] = {
+        "wall_time", "cpu_time", "chunks_in", "cells_in", "chunks_out", "cells_out",
+        "bytes_read", "bytes_written", "bytes_sent", "peak_memory"
+    };
+    assert(counter < NUM_COUNTERS);
+    return names[counter];
+}
+
+size_t OperatorProfile::getSlot()
+{
+    static size_t nextSlot = 0;
+    static __thread size_t slot = 0;
+    if (slot == 0) {
+        slot = __sync_add_and_fetch(&nextSlot, 1);
+    }
+    return slot % NUM_SLOTS;
+}
+
 #ifndef SCIDB_CLIENT
+static uint64_t getMicroseconds(clockid_t clock)
+{
+    struct timespec ts;
+    if (clock_gettime(clock, &ts) != 0) {
+        return 0;
+    }
+    return uint64_t(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+ProfileTimer::ProfileTimer(OperatorProfile& profile, const Query* query)
+: _profile(profile),
+  _query(query),
+  _wallStart(getMicroseconds(CLOCK_MONOTONIC)),
+  _cpuStart(getMicroseconds(CLOCK_THREAD_CPUTIME_ID))
+{
+}
+
+ProfileTimer::~ProfileTimer()
+{
+    _profile.add(OperatorProfile::WALL_TIME, getMicroseconds(CLOCK_MONOTONIC) - _wallStart);
+    _profile.add(OperatorProfile::CPU_TIME, getMicroseconds(CLOCK_THREAD_CPUTIME_ID) - _cpuStart);
+    if (_query) {
+        _profile.setMax(OperatorProfile::PEAK_MEMORY, _query->getMemoryUsage());
+    }
+}
+
+std::ostream& writeProfile(std::ostream& os, const uint64_t* totals)
+{
+    const uint64_t wall = totals[OperatorProfile::WALL_TIME];
+    const uint64_t cpu = totals[OperatorProfile::CPU_TIME];
+    const uint64_t read = totals[OperatorProfile::BYTES_READ];
+    const uint64_t written = totals[OperatorProfile::BYTES_WRITTEN];
+    const uint64_t sent = totals[OperatorProfile::BYTES_SENT];
+    const uint64_t memory = totals[OperatorProfile::PEAK_MEMORY];
+    os << "wall " << wall / 1000 << "ms, cpu " << cpu / 1000 << "ms"
+       << ", in " << totals[OperatorProfile::CHUNKS_IN] << " chunks (" << totals[OperatorProfile::CELLS_IN] << " cells)"
+       << ", out " << totals[OperatorProfile::CHUNKS_OUT] << " chunks (" << totals[OperatorProfile::CELLS_OUT] << " cells)"
+       << ", read " << printSize(read) << printSizeUnit(read)
+       << ", written " << printSize(written) << printSizeUnit(written)
+       << ", sent " << printSize(sent) << printSizeUnit(sent)
+       << ", peak memory " << printSize(memory) << printSizeUnit(memory);
+    return os;
+}
+
 std::ostream& writeStatistics(std::ostream& os, const Statistics& s, size_t tab)
 {
     string tabStr(tab*4, ' ');
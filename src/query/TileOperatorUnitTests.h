@@ -0,0 +1,307 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/*
+ * @file TileOperatorUnitTests.h
+ *
+ * @brief Tests of the getData() tiles of filter, apply, between and join.
+ *
+ * Every chunk of the result is read both cell by cell and with getData(),
+ * and the tiles must hold the same cells, in the same order, as the cells.
+ */
+
+#ifndef TILE_OPERATOR_UNIT_TESTS_H_
+#define TILE_OPERATOR_UNIT_TESTS_H_
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "array/MemArray.h"
+#include "array/Metadata.h"
+#include "array/Tile.h"
+#include "query/Expression.h"
+#include "query/Parser.h"
+#include "query/Query.h"
+#include "query/ops/apply/ApplyArray.h"
+#include "query/ops/between/BetweenArray.h"
+#include "query/ops/filter/FilterArray.h"
+#include "query/ops/join/JoinArray.h"
+#include "system/Cluster.h"
+#include "util/SpatialType.h"
+
+using namespace scidb;
+
+class TileOperatorTests: public CppUnit::TestFixture
+{
+CPPUNIT_TEST_SUITE(TileOperatorTests);
+CPPUNIT_TEST(testFilter);
+CPPUNIT_TEST(testApply);
+CPPUNIT_TEST(testBetween);
+CPPUNIT_TEST(testJoin);
+CPPUNIT_TEST_SUITE_END();
+
+private:
+    enum
+    {
+        SIDE = 24,      // cells per dimension, the chunks at the edges are partial
+        CHUNK = 10,     // chunk interval
+        TILE = 7        // values per getData() call, tiles cross the runs of cells
+    };
+
+    boost::shared_ptr<Query> _query;
+
+    static Dimensions getDimensions()
+    {
+        Dimensions dims(2);
+        dims[0] = DimensionDesc("x", 0, SIDE - 1, CHUNK, 0);
+        dims[1] = DimensionDesc("y", 0, SIDE - 1, CHUNK, 0);
+        return dims;
+    }
+
+    static AttributeDesc getEmptyTag(AttributeID id)
+    {
+        return AttributeDesc(id, DEFAULT_EMPTY_TAG_ATTRIBUTE_NAME, TID_INDICATOR, AttributeDesc::IS_EMPTY_INDICATOR, 0);
+    }
+
+    /// <a:int64, b:double null> [x, y]
+    static ArrayDesc getInputSchema(std::string const& name)
+    {
+        Attributes attrs(3);
+        attrs[0] = AttributeDesc(0, "a", TID_INT64, 0, 0);
+        attrs[1] = AttributeDesc(1, "b", TID_DOUBLE, AttributeDesc::IS_NULLABLE, 0);
+        attrs[2] = getEmptyTag(2);
+        return ArrayDesc(name, attrs, getDimensions());
+    }
+
+    /**
+     * Fill a sparse array: every attribute is an int64 or a nullable double,
+     * the cells are skipped in runs that depend on the seed.
+     */
+    boost::shared_ptr<Array> makeArray(ArrayDesc const& desc, int64_t seed)
+    {
+        boost::shared_ptr<MemArray> array(new MemArray(desc, _query));
+        Attributes const& attrs = desc.getAttributes(true);
+        Coordinates chunkPos(2);
+        Coordinates pos(2);
+        for (chunkPos[0] = 0; chunkPos[0] < SIDE; chunkPos[0] += CHUNK) {
+            for (chunkPos[1] = 0; chunkPos[1] < SIDE; chunkPos[1] += CHUNK) {
+                for (AttributeID i = 0; i < attrs.size(); i++) {
+                    Value value(TypeLibrary::getType(attrs[i].getType()));
+                    boost::shared_ptr<ArrayIterator> arrayIterator = array->getIterator(i);
+                    boost::shared_ptr<ChunkIterator> chunkIterator =
+                        arrayIterator->newChunk(chunkPos).getIterator(_query, i == 0
+                            ? ChunkIterator::SEQUENTIAL_WRITE
+                            : ChunkIterator::SEQUENTIAL_WRITE | ChunkIterator::NO_EMPTY_CHECK);
+                    for (pos[0] = chunkPos[0]; pos[0] < std::min<Coordinate>(chunkPos[0] + CHUNK, SIDE); pos[0]++) {
+                        for (pos[1] = chunkPos[1]; pos[1] < std::min<Coordinate>(chunkPos[1] + CHUNK, SIDE); pos[1]++) {
+                            if ((pos[0] * 7 + pos[1] * 3 + seed) % 4 == 0) {
+                                continue;
+                            }
+                            if (attrs[i].getType() == TID_INT64) {
+                                value.setInt64(pos[0] * SIDE + pos[1] + seed);
+                            } else if ((pos[0] + pos[1] + seed) % 5 == 0) {
+                                value.setNull();
+                            } else {
+                                value.setDouble(pos[0] * 0.5 - pos[1]);
+                            }
+                            CPPUNIT_ASSERT(chunkIterator->setPosition(pos));
+                            chunkIterator->writeItem(value);
+                        }
+                    }
+                    chunkIterator->flush();
+                }
+            }
+        }
+        return array;
+    }
+
+    boost::shared_ptr<Expression> compile(std::string const& text, TypeId const& type,
+                                          ArrayDesc const& input, ArrayDesc const& output)
+    {
+        boost::shared_ptr<Expression> expression = boost::make_shared<Expression>();
+        std::vector<ArrayDesc> inputSchemas(1, input);
+        expression->compile(parseExpression(text), _query, false, type, inputSchemas, output);
+        return expression;
+    }
+
+    /**
+     * Read every chunk of every attribute with getData(), and check that the tiles hold
+     * the cells of the cell iteration and that the cell position follows the tiles.
+     * @return the number of cells read
+     */
+    size_t checkTiles(Array const& array)
+    {
+        size_t nCells = 0;
+        Attributes const& attrs = array.getArrayDesc().getAttributes(true);
+        for (AttributeID i = 0; i < attrs.size(); i++) {
+            boost::shared_ptr<ConstArrayIterator> arrayIterator = array.getConstIterator(i);
+            for (; !arrayIterator->end(); ++(*arrayIterator)) {
+                ConstChunk const& chunk = arrayIterator->getChunk();
+                CoordinatesMapper mapper(chunk);
+
+                std::vector<position_t> positions;
+                std::vector<Value> values;
+                boost::shared_ptr<ConstChunkIterator> cells =
+                    chunk.getConstIterator(ConstChunkIterator::IGNORE_EMPTY_CELLS);
+                for (; !cells->end(); ++(*cells)) {
+                    positions.push_back(mapper.coord2pos(cells->getPosition()));
+                    values.push_back(cells->getItem());
+                }
+
+                boost::shared_ptr<ConstChunkIterator> tiles =
+                    chunk.getConstIterator(ConstChunkIterator::IGNORE_EMPTY_CELLS);
+                if (tiles->end()) {
+                    CPPUNIT_ASSERT(positions.empty());
+                    continue;
+                }
+                size_t n = 0;
+                Value value;
+                position_t next = tiles->getLogicalPosition();
+                while (next >= 0) {
+                    boost::shared_ptr<BaseTile> tileData;
+                    boost::shared_ptr<BaseTile> tileCoords;
+                    next = tiles->getData(next, TILE, tileData, tileCoords);
+                    CPPUNIT_ASSERT(tileData && tileCoords);
+                    CPPUNIT_ASSERT(tileData->size() <= size_t(TILE));
+                    CPPUNIT_ASSERT(tileData->size() == tileCoords->size());
+                    ArrayEncoding<position_t> const& tilePositions =
+                        *safe_dynamic_cast<ArrayEncoding<position_t>*>(tileCoords->getEncoding());
+                    for (size_t j = 0; j < tileData->size(); j++, n++) {
+                        CPPUNIT_ASSERT(n < positions.size());
+                        CPPUNIT_ASSERT(tilePositions.at(j) == positions[n]);
+                        tileData->at(j, value);
+                        CPPUNIT_ASSERT(value == values[n]);
+                    }
+                    // the cell position is advanced past the tile
+                    if (next >= 0) {
+                        CPPUNIT_ASSERT(!tiles->end());
+                        CPPUNIT_ASSERT(tiles->getLogicalPosition() == next);
+                        CPPUNIT_ASSERT(tiles->getItem() == values[n]);
+                    } else {
+                        CPPUNIT_ASSERT(tiles->end());
+                    }
+                }
+                CPPUNIT_ASSERT(n == positions.size());
+                nCells += n;
+            }
+        }
+        return nCells;
+    }
+
+public:
+    void setUp()
+    {
+        boost::shared_ptr<const InstanceLiveness> liveness(Cluster::getInstance()->getInstanceLiveness());
+        int32_t longErrorCode = SCIDB_E_NO_ERROR;
+        _query = Query::createFakeQuery(0, 0, liveness, &longErrorCode);
+        if (longErrorCode != SCIDB_E_NO_ERROR &&
+            longErrorCode != SCIDB_LE_INVALID_FUNCTION_ARGUMENT) {
+            // NetworkManager::createWorkQueue() may complain about a null queue,
+            // which does not matter since the network is not used
+            throw SYSTEM_EXCEPTION(SCIDB_LE_UNKNOWN_ERROR, longErrorCode);
+        }
+    }
+
+    void tearDown()
+    {
+        Query::destroyFakeQuery(_query.get());
+        _query.reset();
+    }
+
+    void testFilter()
+    {
+        ArrayDesc desc = getInputSchema("left");
+        boost::shared_ptr<Array> input = makeArray(desc, 0);
+        boost::shared_ptr<Expression> expression =
+            compile("a % 3 <> 0 and y < 20 and b > -5.0", TID_BOOL, desc, desc);
+        FilterArray filter(desc, input, expression, _query, false);
+        CPPUNIT_ASSERT(checkTiles(filter) > 0);
+    }
+
+    void testApply()
+    {
+        ArrayDesc inputDesc = getInputSchema("left");
+        boost::shared_ptr<Array> input = makeArray(inputDesc, 0);
+
+        Attributes attrs(5);
+        attrs[0] = inputDesc.getAttributes()[0];
+        attrs[1] = inputDesc.getAttributes()[1];
+        attrs[2] = AttributeDesc(2, "c", TID_INT64, 0, 0);
+        attrs[3] = AttributeDesc(3, "d", TID_DOUBLE, AttributeDesc::IS_NULLABLE, 0);
+        attrs[4] = getEmptyTag(4);
+        ArrayDesc desc("applied", attrs, getDimensions());
+
+        std::vector<boost::shared_ptr<Expression> > expressions(attrs.size());
+        expressions[2] = compile("a * 2 + x", TID_INT64, inputDesc, desc);
+        expressions[3] = compile("b * y", TID_DOUBLE, inputDesc, desc);
+        ApplyArray apply(desc, input, expressions, _query, false);
+        CPPUNIT_ASSERT(checkTiles(apply) > 0);
+    }
+
+    void testBetween()
+    {
+        ArrayDesc desc = getInputSchema("left");
+        boost::shared_ptr<Array> input = makeArray(desc, 0);
+
+        // one range across four chunks, one inside a chunk at the edge
+        SpatialRangesPtr ranges = boost::make_shared<SpatialRanges>(2);
+        Coordinates low(2);
+        Coordinates high(2);
+        low[0] = 3;  low[1] = 2;
+        high[0] = 15; high[1] = 13;
+        ranges->_ranges.push_back(SpatialRange(low, high));
+        low[0] = 20; low[1] = 21;
+        high[0] = 23; high[1] = 22;
+        ranges->_ranges.push_back(SpatialRange(low, high));
+        BetweenArray between(desc, ranges, input);
+        CPPUNIT_ASSERT(checkTiles(between) > 0);
+    }
+
+    void testJoin()
+    {
+        ArrayDesc leftDesc = getInputSchema("left");
+        boost::shared_ptr<Array> left = makeArray(leftDesc, 0);
+
+        Attributes rightAttrs(2);
+        rightAttrs[0] = AttributeDesc(0, "c", TID_INT64, 0, 0);
+        rightAttrs[1] = getEmptyTag(1);
+        boost::shared_ptr<Array> right = makeArray(ArrayDesc("right", rightAttrs, getDimensions()), 1);
+
+        Attributes attrs(4);
+        attrs[0] = leftDesc.getAttributes()[0];
+        attrs[1] = leftDesc.getAttributes()[1];
+        attrs[2] = AttributeDesc(2, "c", TID_INT64, 0, 0);
+        attrs[3] = getEmptyTag(3);
+        JoinEmptyableArray join(ArrayDesc("joined", attrs, getDimensions()), left, right);
+        CPPUNIT_ASSERT(checkTiles(join) > 0);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TileOperatorTests);
+
+#endif /* TILE_OPERATOR_UNIT_TESTS_H_ */
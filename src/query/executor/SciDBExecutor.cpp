@@ -43,11 +43,14 @@
 #include "network/Connection.h"
 #include "array/StreamArray.h"
 #include "system/Exceptions.h"
+#include "query/AdmissionControl.h"
+#include "query/PlanCache.h"
 #include "query/QueryProcessor.h"
 #include "query/Serialize.h"
 #include "network/NetworkManager.h"
 #include "network/MessageUtils.h"
 #include "system/Cluster.h"
+#include "system/SystemCatalog.h"
 #include "util/RWLock.h"
 
 
@@ -93,6 +96,16 @@ class SciDBExecutor: public scidb::SciDB
                       const std::string& programOptions,
                       QueryResult& queryResult,
                       void* connection) const
+    {
+        prepareQuery(queryString, afl, programOptions, QueryParameters(), queryResult, connection);
+    }
+
+    void prepareQuery(const std::string& queryString,
+                      bool afl,
+                      const std::string& programOptions,
+                      const QueryParameters& parameters,
+                      QueryResult& queryResult,
+                      void* connection) const
     {
         // Parsing query string
         if (Query::getQueryByID(queryResult.queryID, false)) {
@@ -113,8 +126,18 @@ class SciDBExecutor: public scidb::SciDB
         LOG4CXX_DEBUG(logger, "Parsing query(" << query->getQueryID() << "): " << queryString << "");
 
         try {
+            if (!parameters.empty()) {
+                QueryParamMap queryParams;
+                for (QueryParameters::const_iterator i = parameters.begin(); i != parameters.end(); ++i) {
+                    queryParams.bind(i->first, i->second);
+                }
+                queryProcessor->setParameters(query, queryParams);
+            }
+
             prepareQueryBeforeLocking(query, queryProcessor, afl, programOptions);
 
+            admitQuery(query); //can throw "try-again", i.e. SystemCatalog::LockBusyException
+
             query->acquireLocks(); //can throw "try-again", i.e. SystemCatalog::LockBusyException
 
             prepareQueryAfterLocking(query, queryProcessor, afl, queryResult);
@@ -140,7 +163,13 @@ class SciDBExecutor: public scidb::SciDB
         StatisticsScope sScope(&query->statistics);
         try {
 
-            query->retryAcquireLocks();  //can throw "try-again", i.e. SystemCatalog::LockBusyException
+            if (AdmissionControl::getInstance()->isAdmitted(query->getQueryID())) {
+                query->retryAcquireLocks();  //can throw "try-again", i.e. SystemCatalog::LockBusyException
+            } else {
+                // the query has been waiting for admission, it has not asked for its locks yet
+                admitQuery(query);
+                query->acquireLocks();
+            }
 
             shared_ptr<QueryProcessor> queryProcessor = QueryProcessor::create();
 
@@ -156,6 +185,19 @@ class SciDBExecutor: public scidb::SciDB
         LOG4CXX_DEBUG(logger, "Prepared query(" << query->getQueryID() << "): " << queryString << "");
    }
 
+    /**
+     * Admission control runs before the array locks are taken, so that a query waiting
+     * for memory does not hold the arrays it is going to use.
+     * @throw SystemCatalog::LockBusyException if the query is not admitted yet:
+     *        it is retried the same way as a query waiting for a lock
+     */
+    void admitQuery(boost::shared_ptr<Query> const& query) const
+    {
+        if (!AdmissionControl::getInstance()->admit(query)) {
+            throw SystemCatalog::LockBusyException(REL_FILE, __FUNCTION__, __LINE__);
+        }
+    }
+
     void prepareQueryBeforeLocking(boost::shared_ptr<Query>& query,
                                    boost::shared_ptr<QueryProcessor>& queryProcessor,
                                    bool afl,
@@ -178,6 +220,23 @@ class SciDBExecutor: public scidb::SciDB
     {
         query->validate();
 
+        PlanCache* planCache = PlanCache::getInstance();
+        const string planKey = planCache->isEnabled() ? PlanCache::getKey(query, afl) : string();
+        if (!planKey.empty()) {
+            query->cachedPlan = planCache->find(planKey, query->queryParams.get());
+            if (query->cachedPlan) {
+                // the plan of an earlier execution still holds, skip the second pass and optimization
+                queryResult.plugins = query->cachedPlan->plugins;
+                queryResult.explainLogical = query->cachedPlan->explainLogical;
+                queryResult.selective = query->cachedPlan->selective;
+                queryResult.requiresExclusiveArrayAccess = false;
+
+                query->stop();
+                LOG4CXX_DEBUG(logger, "The query is prepared from the plan cache");
+                return;
+            }
+        }
+
         // second pass under the array locks
         queryProcessor->parseLogical(query, afl);
         LOG4CXX_TRACE(logger, "Query is parsed");
@@ -193,10 +252,102 @@ class SciDBExecutor: public scidb::SciDB
         queryResult.selective = !query->logicalPlan->getRoot()->isDdl();
         queryResult.requiresExclusiveArrayAccess = query->doesExclusiveArrayAccess();
 
+        if (!planKey.empty()) {
+            boost::shared_ptr<CachedPlan> entry = boost::make_shared<CachedPlan>();
+            entry->key = planKey;
+            entry->explainLogical = queryResult.explainLogical;
+            entry->plugins = queryResult.plugins;
+            entry->selective = queryResult.selective;
+            entry->params = query->queryParams;
+            query->cachedPlan = entry;
+        }
+
         query->stop();
         LOG4CXX_DEBUG(logger, "The query is prepared");
    }
 
+    /**
+     * Execute the current physical plan of the query on all instances.
+     * @return the plan as serialized for the workers
+     */
+    string executePhysicalPlan(boost::shared_ptr<Query>& query,
+                               boost::shared_ptr<QueryProcessor>& queryProcessor) const
+    {
+        const bool isDdl = query->getCurrentPhysicalPlan()->isDdl();
+        query->isDDL = isDdl;
+        LOG4CXX_DEBUG(logger, "The physical plan is detected as " << (isDdl ? "DDL" : "DML") );
+        if (logger->isDebugEnabled())
+        {
+            std::ostringstream planString;
+            query->getCurrentPhysicalPlan()->toString(planString);
+            LOG4CXX_DEBUG(logger, "\n" + planString.str());
+        }
+
+        // Execution of single part of physical plan
+        queryProcessor->preSingleExecute(query);
+        NetworkManager* networkManager = NetworkManager::getInstance();
+        size_t instancesCount = query->getInstancesCount();
+
+        std::ostringstream planString;
+        query->getCurrentPhysicalPlan()->toString(planString);
+        query->statistics.explainPhysical += planString.str() + ";";
+
+        // Serialize physical plan and sending it out
+        const string physicalPlan = serializePhysicalPlan(query->getCurrentPhysicalPlan());
+        {
+            LOG4CXX_DEBUG(logger, "Query is serialized: " << planString.str());
+            boost::shared_ptr<MessageDesc> preparePhysicalPlanMsg = boost::make_shared<MessageDesc>(mtPreparePhysicalPlan);
+            boost::shared_ptr<scidb_msg::PhysicalPlan> preparePhysicalPlanRecord =
+                preparePhysicalPlanMsg->getRecord<scidb_msg::PhysicalPlan>();
+            preparePhysicalPlanMsg->setQueryID(query->getQueryID());
+            preparePhysicalPlanRecord->set_physical_plan(physicalPlan);
+            boost::shared_ptr<const InstanceLiveness> queryLiveness(query->getCoordinatorLiveness());
+            serializeQueryLiveness(queryLiveness, preparePhysicalPlanRecord);
+
+            uint32_t redundancy = Config::getInstance()->getOption<int>(CONFIG_REDUNDANCY);
+            Cluster* cluster = Cluster::getInstance();
+            assert(cluster);
+            shared_ptr<const InstanceMembership> membership(cluster->getInstanceMembership());
+            assert(membership);
+            if ((membership->getViewId() != queryLiveness->getViewId()) ||
+                ((instancesCount + redundancy) < membership->getInstances().size())) {
+                throw SYSTEM_EXCEPTION(SCIDB_SE_EXECUTION, SCIDB_LE_NO_QUORUM2);
+            }
+            preparePhysicalPlanRecord->set_cluster_uuid(cluster->getUuid());
+            preparePhysicalPlanRecord->set_catalog_version(SystemCatalog::getInstance()->getCatalogVersion());
+            networkManager->sendOutMessage(preparePhysicalPlanMsg);
+            LOG4CXX_DEBUG(logger, "Prepare physical plan was sent out");
+            LOG4CXX_DEBUG(logger, "Waiting confirmation about preparing physical plan in queryID from "
+                          << instancesCount - 1 << " instances")
+        }
+        try {
+            // Execution of local part of physical plan
+            queryProcessor->execute(query);
+        }
+        catch (const std::bad_alloc& e) {
+                throw SYSTEM_EXCEPTION(SCIDB_SE_NO_MEMORY, SCIDB_LE_MEMORY_ALLOCATION_ERROR) << e.what();
+        }
+        LOG4CXX_DEBUG(logger, "Query is executed locally");
+
+        // Wait for results from every instance except itself
+        Semaphore::ErrorChecker ec = bind(&Query::validate, query);
+        query->results.enter(instancesCount-1, ec);
+        LOG4CXX_DEBUG(logger, "The responses are received");
+        /**
+         * Check error state
+         */
+        query->validate();
+
+        queryProcessor->postSingleExecute(query);
+
+        if (Config::getInstance()->getOption<bool>(CONFIG_PROFILE_QUERIES)) {
+            std::ostringstream profileString;
+            query->getCurrentPhysicalPlan()->writeProfile(profileString);
+            query->statistics.explainAnalyze += profileString.str() + ";";
+        }
+        return physicalPlan;
+    }
+
     void executeQuery(const std::string& queryString, bool afl, QueryResult& queryResult, void* connection) const
     {
         const clock_t startClock = clock();
@@ -217,79 +368,41 @@ class SciDBExecutor: public scidb::SciDB
         queryResult.explainLogical = planString.str();
         // Note: Optimization will be performed while execution
         boost::shared_ptr<Optimizer> optimizer =  Optimizer::create();
-        bool isDdl = true;
+        boost::shared_ptr<const CachedPlan> cachedPlan = query->cachedPlan;
         try {
             query->start();
 
-            while (queryProcessor->optimize(optimizer, query))
+            if (cachedPlan && !cachedPlan->physicalPlan.empty())
             {
-                LOG4CXX_DEBUG(logger, "Query is optimized");
-
-                isDdl = query->getCurrentPhysicalPlan()->isDdl();
-                query->isDDL = isDdl;
-                LOG4CXX_DEBUG(logger, "The physical plan is detected as " << (isDdl ? "DDL" : "DML") );
-                if (logger->isDebugEnabled())
-                {
-                    std::ostringstream planString;
-                    query->getCurrentPhysicalPlan()->toString(planString);
-                    LOG4CXX_DEBUG(logger, "\n" + planString.str());
+                queryProcessor->parsePhysical(cachedPlan->physicalPlan, query);
+                if (query->queryParams && !query->queryParams->empty()) {
+                    // Some operators evaluate their constant parameters when they are constructed,
+                    // so construct them again from the bound plan
+                    queryProcessor->setParameters(query, *query->queryParams);
+                    queryProcessor->parsePhysical(serializePhysicalPlan(query->getCurrentPhysicalPlan()), query);
                 }
+                query->logicalPlan->setRoot(boost::shared_ptr<LogicalQueryPlanNode>());
+                LOG4CXX_DEBUG(logger, "Query plan is taken from the plan cache");
 
-                // Execution of single part of physical plan
-                queryProcessor->preSingleExecute(query);
-                NetworkManager* networkManager = NetworkManager::getInstance();
-                size_t instancesCount = query->getInstancesCount();
-
+                executePhysicalPlan(query, queryProcessor);
+            }
+            else
+            {
+                size_t nPlans = 0;
+                string physicalPlan;
+                while (queryProcessor->optimize(optimizer, query))
                 {
-                    std::ostringstream planString;
-                    query->getCurrentPhysicalPlan()->toString(planString);
-                    query->statistics.explainPhysical += planString.str() + ";";
-
-                    // Serialize physical plan and sending it out
-                    const string physicalPlan = serializePhysicalPlan(query->getCurrentPhysicalPlan());
-                    LOG4CXX_DEBUG(logger, "Query is serialized: " << planString.str());
-                    boost::shared_ptr<MessageDesc> preparePhysicalPlanMsg = boost::make_shared<MessageDesc>(mtPreparePhysicalPlan);
-                    boost::shared_ptr<scidb_msg::PhysicalPlan> preparePhysicalPlanRecord =
-                        preparePhysicalPlanMsg->getRecord<scidb_msg::PhysicalPlan>();
-                    preparePhysicalPlanMsg->setQueryID(query->getQueryID());
-                    preparePhysicalPlanRecord->set_physical_plan(physicalPlan);
-                    boost::shared_ptr<const InstanceLiveness> queryLiveness(query->getCoordinatorLiveness());
-                    serializeQueryLiveness(queryLiveness, preparePhysicalPlanRecord);
-
-                    uint32_t redundancy = Config::getInstance()->getOption<int>(CONFIG_REDUNDANCY);
-                    Cluster* cluster = Cluster::getInstance();
-                    assert(cluster);
-                    shared_ptr<const InstanceMembership> membership(cluster->getInstanceMembership());
-                    assert(membership);
-                    if ((membership->getViewId() != queryLiveness->getViewId()) ||
-                        ((instancesCount + redundancy) < membership->getInstances().size())) {
-                        throw SYSTEM_EXCEPTION(SCIDB_SE_EXECUTION, SCIDB_LE_NO_QUORUM2);
-                    }
-                    preparePhysicalPlanRecord->set_cluster_uuid(cluster->getUuid());
-                    networkManager->sendOutMessage(preparePhysicalPlanMsg);
-                    LOG4CXX_DEBUG(logger, "Prepare physical plan was sent out");
-                    LOG4CXX_DEBUG(logger, "Waiting confirmation about preparing physical plan in queryID from "
-                                  << instancesCount - 1 << " instances")
-                }
-                try {
-                    // Execution of local part of physical plan
-                    queryProcessor->execute(query);
+                    LOG4CXX_DEBUG(logger, "Query is optimized");
+
+                    physicalPlan = executePhysicalPlan(query, queryProcessor);
+                    ++nPlans;
                 }
-                catch (const std::bad_alloc& e) {
-                        throw SYSTEM_EXCEPTION(SCIDB_SE_NO_MEMORY, SCIDB_LE_MEMORY_ALLOCATION_ERROR) << e.what();
+                if (cachedPlan && nPlans == 1) {
+                    boost::shared_ptr<CachedPlan> entry = boost::make_shared<CachedPlan>(*cachedPlan);
+                    entry->physicalPlan = physicalPlan;
+                    entry->parameterValuesUsed = query->areParameterValuesUsed();
+                    PlanCache::getInstance()->insert(entry);
                 }
-                LOG4CXX_DEBUG(logger, "Query is executed locally");
-
-                // Wait for results from every instance except itself
-                Semaphore::ErrorChecker ec = bind(&Query::validate, query);
-                query->results.enter(instancesCount-1, ec);
-                LOG4CXX_DEBUG(logger, "The responses are received");
-                /**
-                 * Check error state
-                 */
-                query->validate();
-
-                queryProcessor->postSingleExecute(query);
             }
             query->done();
         } catch (const Exception& e) {
@@ -303,6 +416,7 @@ class SciDBExecutor: public scidb::SciDB
         queryResult.queryID = query->getQueryID();
         queryResult.executionTime = query->statistics.executionTime;
         queryResult.explainPhysical = query->statistics.explainPhysical;
+        queryResult.explainAnalyze = query->statistics.explainAnalyze;
         queryResult.selective = query->getCurrentResultArray();
         if (queryResult.selective) {
             queryResult.array = query->getCurrentResultArray();
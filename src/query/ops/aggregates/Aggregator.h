@@ -40,6 +40,8 @@
 #include "query/Aggregate.h"
 #include "array/DelegateArray.h"
 #include "system/Sysinfo.h"
+#include "system/Config.h"
+#include "system/SciDBConfigOptions.h"
 
 #include <boost/unordered_map.hpp>
 #include <boost/foreach.hpp>
@@ -280,6 +282,138 @@ struct AggregationFlags
     std::vector<bool> nullBarrier;
 };
 
+/**
+ * Per-group states of the aggregates of one AggIOMapping, kept in flat typed arrays.
+ * The groups are the cells of a box of the output space: a CoordinatesMapper over the box
+ * maps an output position to a dense group index. Each aggregate owns one contiguous array
+ * of flat states (struct-of-arrays), so that a whole RLE payload is folded into the states
+ * by the templated kernel of the aggregate, see Aggregate::accumulatePayloadFlat().
+ */
+class FlatAggregateStates
+{
+private:
+    CoordinatesMapper _mapper;
+    Coordinates _low;
+    Coordinates _high;
+    size_t _nGroups;
+    std::vector<AggregatePtr> _aggs;
+    std::vector< std::vector<char> > _states;
+    std::vector< std::vector<uint8_t> > _seen;
+    std::vector<uint8_t> _touched;
+
+public:
+    /**
+     * @param mapping the aggregates; all of them must support flat states
+     * @param low     the first output position of the group box
+     * @param high    the last output position of the group box
+     */
+    FlatAggregateStates(AggIOMapping const& mapping, Coordinates const& low, Coordinates const& high)
+      : _mapper(low, high)
+      , _low(low)
+      , _high(high)
+      , _nGroups(1)
+      , _aggs(mapping.getAggregates())
+      , _states(mapping.size())
+      , _seen(mapping.size())
+    {
+        for (size_t i = 0, n = low.size(); i < n; i++)
+        {
+            _nGroups *= high[i] - low[i] + 1;
+        }
+        _touched.resize(_nGroups, 0);
+        for (size_t i = 0, n = _aggs.size(); i < n; i++)
+        {
+            size_t const stateSize = _aggs[i]->getFlatStateSize();
+            _states[i].resize(_nGroups * stateSize);
+            _seen[i].resize(_nGroups, 0);
+            for (size_t g = 0; g < _nGroups; g++)
+            {
+                _aggs[i]->initializeFlatState(&_states[i][g * stateSize]);
+            }
+        }
+    }
+
+    /**
+     * @return the number of bytes needed per group by the aggregates of mapping,
+     *         or 0 if one of them does not support flat states
+     */
+    static size_t getGroupSize(AggIOMapping const& mapping)
+    {
+        size_t size = sizeof(uint8_t);
+        for (size_t i = 0, n = mapping.size(); i < n; i++)
+        {
+            size_t const stateSize = mapping.getAggregate(i)->getFlatStateSize();
+            if (stateSize == 0)
+            {
+                return 0;
+            }
+            size += stateSize + sizeof(uint8_t);
+        }
+        return size;
+    }
+
+    Coordinates const& getLow() const
+    {
+        return _low;
+    }
+
+    Coordinates const& getHigh() const
+    {
+        return _high;
+    }
+
+    /**
+     * @return the group index of an output position inside the box
+     */
+    position_t getGroup(Coordinates const& outPos) const
+    {
+        return _mapper.coord2pos(outPos);
+    }
+
+    /**
+     * Accumulate a payload.
+     * @param tile    the input values
+     * @param groups  the group of every position of tile, or Aggregate::NO_FLAT_GROUP
+     * @param noNulls true if null cells do not create groups
+     */
+    void accumulate(ConstRLEPayload const* tile, size_t const* groups, bool noNulls)
+    {
+        for (size_t i = 0, n = tile->nSegments(); i < n; i++)
+        {
+            const RLEPayload::Segment& v = tile->getSegment(i);
+            if (v._null && noNulls)
+                continue;
+            for (position_t p = v._pPosition, end = v._pPosition + v.length(); p < end; p++)
+            {
+                if (groups[p] != Aggregate::NO_FLAT_GROUP)
+                {
+                    _touched[groups[p]] = 1;
+                }
+            }
+        }
+        for (size_t i = 0, n = _aggs.size(); i < n; i++)
+        {
+            _aggs[i]->accumulatePayloadFlat(&_states[i][0], &_seen[i][0], tile, groups);
+        }
+    }
+
+    /**
+     * @return true if some cell of the input fell into group g
+     */
+    bool isTouched(position_t g) const
+    {
+        return _touched[g];
+    }
+
+    /**
+     * Get the Value state of aggregate i for group g.
+     */
+    void getState(size_t i, position_t g, Value& state) const
+    {
+        _aggs[i]->getFlatState(state, &_states[i][g * _aggs[i]->getFlatStateSize()], _seen[i][g]);
+    }
+};
+
 /**
  * The aggregator computes a distributed aggregation to the input array, based on several parameters.
  * The pieces of the puzzle are:
@@ -411,6 +545,16 @@ class AggregatePartitioningOperator : public PhysicalOperator
 
     virtual void transformCoordinates(Coordinates const & inPos, Coordinates & outPos) = 0;
 
+    /**
+     * Whether transformCoordinates() is separable: every output coordinate is a non-decreasing
+     * function of a single input coordinate. Such transforms can be tabulated one dimension at
+     * a time, which is what the flat-state engine (groupedFlatAggregate) relies on.
+     */
+    virtual bool isSeparableTransform() const
+    {
+        return false;
+    }
+
     ArrayDesc createStateDesc()
     {
         Attributes outAttrs;
@@ -962,6 +1106,314 @@ class AggregatePartitioningOperator : public PhysicalOperator
     }
 
 
+    /**
+     * Advance pos to the next position of the box [first, last] in row-major order,
+     * moving by step[i] along dimension i.
+     * @return false once the box is exhausted
+     */
+    static bool nextPosition(Coordinates& pos, Coordinates const& first, Coordinates const& last, Coordinates const& step)
+    {
+        for (size_t i = pos.size(); i-- > 0; )
+        {
+            pos[i] += step[i];
+            if (pos[i] <= last[i])
+            {
+                return true;
+            }
+            pos[i] = first[i];
+        }
+        return false;
+    }
+
+    /**
+     * Compute the box of output positions that the local input chunks map to.
+     * Only chunk positions are looked at; no chunk data is read.
+     * @return false if there are no local chunks
+     */
+    bool computeLocalOutputBox(boost::shared_ptr<Array> const& inputArray, Coordinates& low, Coordinates& high)
+    {
+        Dimensions const& inDims = inputArray->getArrayDesc().getDimensions();
+        boost::shared_ptr<CoordinateSet> chunkPositions = inputArray->findChunkPositions();
+        if (chunkPositions->empty())
+        {
+            return false;
+        }
+        size_t const nDims = _schema.getDimensions().size();
+        Coordinates outFirst(nDims);
+        Coordinates outLast(nDims);
+        low.clear();
+        for (CoordinateSet::const_iterator i = chunkPositions->begin(); i != chunkPositions->end(); ++i)
+        {
+            transformCoordinates(computeFirstChunkPosition(*i, inDims, false), outFirst);
+            transformCoordinates(computeLastChunkPosition(*i, inDims, false), outLast);
+            if (low.empty())
+            {
+                low = outFirst;
+                high = outLast;
+                continue;
+            }
+            for (size_t d = 0; d < nDims; d++)
+            {
+                low[d] = std::min(low[d], outFirst[d]);
+                high[d] = std::max(high[d], outLast[d]);
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Compute the group of every payload position of an input chunk.
+     * The transform is tabulated per input dimension as an offset from the group of the
+     * first position of the chunk; the group of a cell is then a sum of table lookups.
+     * Overlap cells get Aggregate::NO_FLAT_GROUP.
+     * @param chunk       the input chunk
+     * @param bitmap      the empty bitmap of the chunk, NULL if the array is not emptyable
+     * @param nPositions  the number of payload positions of the chunk
+     * @param flat        the states that define the group space
+     * @param groups      [out] the group of each payload position
+     */
+    void computeFlatGroups(ConstChunk const& chunk,
+                           ConstRLEEmptyBitmap const* bitmap,
+                           size_t nPositions,
+                           FlatAggregateStates const& flat,
+                           std::vector<size_t>& groups)
+    {
+        Coordinates const& firstO = chunk.getFirstPosition(true);
+        Coordinates const& lastO = chunk.getLastPosition(true);
+        Coordinates const& firstC = chunk.getFirstPosition(false);
+        Coordinates const& lastC = chunk.getLastPosition(false);
+        size_t const nDims = firstO.size();
+        size_t const lastDim = nDims - 1;
+
+        Coordinates outPos(_schema.getDimensions().size());
+        transformCoordinates(firstC, outPos);
+        position_t const base = flat.getGroup(outPos);
+
+        // offsets[d][c - firstO[d]] is the group offset contributed by coordinate c of
+        // dimension d, or -1 if c lies in the overlap.
+        std::vector< std::vector<position_t> > offsets(nDims);
+        Coordinates probe(firstC);
+        for (size_t d = 0; d < nDims; d++)
+        {
+            offsets[d].resize(lastO[d] - firstO[d] + 1, -1);
+            for (Coordinate c = firstC[d]; c <= lastC[d]; c++)
+            {
+                probe[d] = c;
+                transformCoordinates(probe, outPos);
+                offsets[d][c - firstO[d]] = flat.getGroup(outPos) - base;
+            }
+            probe[d] = firstC[d];
+        }
+
+        groups.assign(nPositions, Aggregate::NO_FLAT_GROUP);
+        CoordinatesMapper chunkMapper(chunk);
+        Coordinates coords(nDims);
+        size_t const nSegments = bitmap ? bitmap->nSegments() : 1;
+        for (size_t s = 0; s < nSegments; s++)
+        {
+            position_t lPos = 0;
+            position_t pPos = 0;
+            position_t length = nPositions;
+            if (bitmap)
+            {
+                ConstRLEEmptyBitmap::Segment const& seg = bitmap->getSegment(s);
+                lPos = seg._lPosition;
+                pPos = seg._pPosition;
+                length = seg._length;
+            }
+            assert(static_cast<size_t>(pPos + length) <= nPositions);
+            if (length == 0)
+            {
+                continue;
+            }
+            chunkMapper.pos2coord(lPos, coords);
+
+            // Offset of the current row, i.e. of all dimensions but the last one.
+            position_t rowOffset = 0;
+            for (size_t d = 0; d < lastDim && rowOffset >= 0; d++)
+            {
+                position_t const o = offsets[d][coords[d] - firstO[d]];
+                rowOffset = o < 0 ? -1 : rowOffset + o;
+            }
+            for (position_t k = 0; k < length; k++)
+            {
+                if (k > 0 && ++coords[lastDim] > lastO[lastDim])
+                {
+                    coords[lastDim] = firstO[lastDim];
+                    for (size_t d = lastDim; d-- > 0; )
+                    {
+                        if (++coords[d] <= lastO[d])
+                        {
+                            break;
+                        }
+                        coords[d] = firstO[d];
+                    }
+                    rowOffset = 0;
+                    for (size_t d = 0; d < lastDim && rowOffset >= 0; d++)
+                    {
+                        position_t const o = offsets[d][coords[d] - firstO[d]];
+                        rowOffset = o < 0 ? -1 : rowOffset + o;
+                    }
+                }
+                position_t const o = offsets[lastDim][coords[lastDim] - firstO[lastDim]];
+                if (rowOffset >= 0 && o >= 0)
+                {
+                    groups[pPos + k] = base + rowOffset + o;
+                }
+            }
+        }
+    }
+
+    /**
+     * Write the touched groups of flat into the state array, one output chunk at a time.
+     */
+    void writeFlatStates(Array* stateArray, AggIOMapping const& mapping, FlatAggregateStates const& flat)
+    {
+        Dimensions const& outDims = _schema.getDimensions();
+        size_t const nDims = outDims.size();
+        size_t const nAggs = mapping.size();
+        Coordinates const& low = flat.getLow();
+        Coordinates const& high = flat.getHigh();
+
+        Coordinates chunkIntervals(nDims);
+        Coordinates ones(nDims, 1);
+        for (size_t d = 0; d < nDims; d++)
+        {
+            chunkIntervals[d] = outDims[d].getChunkInterval();
+        }
+        Coordinates firstChunkPos(low);
+        _schema.getChunkPositionFor(firstChunkPos);
+
+        std::vector <boost::shared_ptr<ArrayIterator> > stateArrayIterators(nAggs);
+        for (size_t i = 0; i < nAggs; i++)
+        {
+            stateArrayIterators[i] = stateArray->getIterator(mapping.getOutputAttributeId(i));
+        }
+
+        Value state;
+        Coordinates chunkPos(firstChunkPos);
+        Coordinates first(nDims);
+        Coordinates last(nDims);
+        do
+        {
+            for (size_t d = 0; d < nDims; d++)
+            {
+                first[d] = std::max(chunkPos[d], low[d]);
+                last[d] = std::min(chunkPos[d] + chunkIntervals[d] - 1, high[d]);
+            }
+            std::vector <boost::shared_ptr<ChunkIterator> > stateChunkIterators(nAggs);
+            Coordinates pos(first);
+            do
+            {
+                position_t const g = flat.getGroup(pos);
+                if (!flat.isTouched(g))
+                {
+                    continue;
+                }
+                for (size_t i = 0; i < nAggs; i++)
+                {
+                    if (!stateChunkIterators[i])
+                    {
+                        initializeOutput(stateArrayIterators[i], stateChunkIterators[i], pos);
+                    }
+                    if (!stateChunkIterators[i]->setPosition(pos))
+                    {
+                        throw SYSTEM_EXCEPTION(SCIDB_SE_QPROC, SCIDB_LE_OPERATION_FAILED) << "setPosition";
+                    }
+                    flat.getState(i, g, state);
+                    stateChunkIterators[i]->writeItem(state);
+                }
+            }
+            while (nextPosition(pos, first, last, ones));
+
+            for (size_t i = 0; i < nAggs; i++)
+            {
+                if (stateChunkIterators[i])
+                {
+                    stateChunkIterators[i]->flush();
+                }
+            }
+        }
+        while (nextPosition(chunkPos, firstChunkPos, high, chunkIntervals));
+    }
+
+    /**
+     * Grouped aggregation with flat, typed per-group states.
+     * Applies when the transform is separable, every aggregate of the mapping supports flat
+     * states and the local group space fits in CONFIG_FLAT_AGGREGATE_LIMIT. Whole chunk
+     * payloads are then accumulated without per-cell setPosition() or Value traffic.
+     * @return false if the flat engine does not apply; nothing has been accumulated then
+     */
+    bool groupedFlatAggregate(Array* stateArray,
+                              boost::shared_ptr<Array> & inputArray,
+                              AggIOMapping const& mapping,
+                              AggregationFlags const& aggFlags)
+    {
+        if (!isSeparableTransform() || (aggFlags.iterationMode & ConstChunkIterator::IGNORE_DEFAULT_VALUES))
+        {
+            return false;
+        }
+        if (inputArray->getArrayDesc().getAttributes()[mapping.getInputAttributeId()].isEmptyIndicator())
+        {
+            return false;
+        }
+        size_t const groupSize = FlatAggregateStates::getGroupSize(mapping);
+        if (groupSize == 0)
+        {
+            return false;
+        }
+        int const limitMiB = Config::getInstance()->getOption<int>(CONFIG_FLAT_AGGREGATE_LIMIT);
+        if (limitMiB <= 0)
+        {
+            return false;
+        }
+        uint64_t const maxGroups = static_cast<uint64_t>(limitMiB) * MiB / groupSize;
+
+        Coordinates low;
+        Coordinates high;
+        if (!computeLocalOutputBox(inputArray, low, high))
+        {
+            return true;
+        }
+        uint64_t nGroups = 1;
+        for (size_t d = 0, n = low.size(); d < n; d++)
+        {
+            uint64_t const length = high[d] - low[d] + 1;
+            if (length > maxGroups || nGroups > maxGroups / length)
+            {
+                LOG4CXX_DEBUG(aggLogger, "Group space too large for flat states, using the state array");
+                return false;
+            }
+            nGroups *= length;
+        }
+
+        FlatAggregateStates flat(mapping, low, high);
+        bool const noNulls = aggFlags.iterationMode & ChunkIterator::IGNORE_NULL_VALUES;
+        std::vector<size_t> groups;
+
+        boost::shared_ptr<ConstArrayIterator> inArrayIterator =
+            inputArray->getConstIterator(mapping.getInputAttributeId());
+        while (!inArrayIterator->end())
+        {
+            {
+                ConstChunk const& chunk = inArrayIterator->getChunk();
+                assert(chunk.isRLE());
+                PinBuffer scope(chunk);
+                ConstRLEPayload payload((char*)chunk.getData());
+                if (payload.count())
+                {
+                    boost::shared_ptr<ConstRLEEmptyBitmap> bitmap = chunk.getEmptyBitmap();
+                    computeFlatGroups(chunk, bitmap.get(), payload.count(), flat, groups);
+                    flat.accumulate(&payload, &groups[0], noNulls);
+                }
+            }
+            ++(*inArrayIterator);
+        }
+
+        writeFlatStates(stateArray, mapping, flat);
+        return true;
+    }
+
     void grandAggregate(Array* stateArray,
                         boost::shared_ptr<Array> & inputArray,
                         AggIOMapping const& mapping,
@@ -1154,6 +1606,11 @@ class AggregatePartitioningOperator : public PhysicalOperator
                 AggregationFlags aggFlags = composeGroupedFlags( inputArray, _ioMappings[i]);
                 logMapping(_ioMappings[i], aggFlags);
 
+                if (groupedFlatAggregate(stateArray.get(), inputArray, _ioMappings[i], aggFlags))
+                {
+                    continue;
+                }
+
                 size_t attributeSize = inArrayDesc.getAttributes()[_ioMappings[i].getInputAttributeId()].getSize();
                 if (inArrayDesc.getAttributes()[_ioMappings[i].getInputAttributeId()].getType() != TID_BOOL
                     && attributeSize > 0)
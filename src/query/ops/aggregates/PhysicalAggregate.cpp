@@ -38,6 +38,11 @@ class PhysicalAggregate: public AggregatePartitioningOperator
      DimensionGrouping     _grouping;
 
   public:
+    static bool isMemoryHungry()
+    {
+        return true;
+    }
+
     PhysicalAggregate(const string& logicalName,
                       const string& physicalName,
                       const Parameters& parameters,
@@ -78,6 +83,11 @@ class PhysicalAggregate: public AggregatePartitioningOperator
 
         _grouping.reduceToGroup(inPos, outPos);
     }
+
+    virtual bool isSeparableTransform() const
+    {
+        return true;
+    }
 };
     
 DECLARE_PHYSICAL_OPERATOR_FACTORY(PhysicalAggregate, "aggregate", "physical_aggregate")
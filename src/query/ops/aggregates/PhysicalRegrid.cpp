@@ -38,6 +38,11 @@ class PhysicalRegrid: public AggregatePartitioningOperator
      vector<uint64_t> _grid;
 
   public:
+    static bool isMemoryHungry()
+    {
+        return true;
+    }
+
      PhysicalRegrid(const string& logicalName, const string& physicalName, const Parameters& parameters, const ArrayDesc& schema):
          AggregatePartitioningOperator(logicalName, physicalName, parameters, schema)
     {
@@ -60,6 +65,11 @@ class PhysicalRegrid: public AggregatePartitioningOperator
             outPos[i] = _schema.getDimensions()[i].getStart() + (inPos[i] - _schema.getDimensions()[i].getStart())/_grid[i];
         }
     }
+
+    virtual bool isSeparableTransform() const
+    {
+        return true;
+    }
 };
 
 DECLARE_PHYSICAL_OPERATOR_FACTORY(PhysicalRegrid, "regrid", "physical_regrid")
@@ -44,6 +44,11 @@ private:
 
 public:
 
+    static bool isMemoryHungry()
+    {
+        return true;
+    }
+
     PhysicalWindow(const string& logicalName, const string& physicalName, const Parameters& parameters, const ArrayDesc& schema):
 	     PhysicalOperator(logicalName, physicalName, parameters, schema)
 	{
@@ -165,8 +165,87 @@ void ApplyChunkIterator::setVectorMode(bool enabled)
     }
 }
 
+position_t ApplyChunkIterator::getTiles(position_t logicalOffset,
+                                        size_t maxValues,
+                                        boost::shared_ptr<BaseTile>& tileData,
+                                        boost::shared_ptr<BaseTile>& tileCoords)
+{
+    if ((_mode & TILE_MODE) || !(_mode & IGNORE_EMPTY_CELLS) ||
+        (_nullable && (_mode & IGNORE_NULL_VALUES) && !chunk->isRLE()))
+    {
+        throw SYSTEM_EXCEPTION(SCIDB_SE_INTERNAL, SCIDB_LE_UNREACHABLE_CODE) << "ApplyChunkIterator::getTiles";
+    }
+    if (!_tileIterators[0])
+    {
+        // the input goes first, its tiles give the positions;
+        // the cell interface keeps inputIterator and _iterators where they are
+        _tileIterators[0] = makeTileConstChunkIterator(
+            chunk->getInputChunk().getConstIterator(_mode & ~(INTENDED_TILE_MODE | IGNORE_NULL_VALUES | IGNORE_DEFAULT_VALUES)));
+        for (size_t i = 0, n = _bindings.size(); i < n; i++)
+        {
+            if (_bindings[i].kind == BindInfo::BI_ATTRIBUTE && _iterators[i] != inputIterator)
+            {
+                _tileIterators[i + 1] = makeTileConstChunkIterator(
+                    _iterators[i]->getChunk().getConstIterator(_iterators[i]->getMode()));
+            }
+        }
+    }
+    boost::shared_ptr<BaseTile> inData;
+    boost::shared_ptr<BaseTile> inCoords;
+    position_t next = _tileIterators[0]->getData(logicalOffset, maxValues, inData, inCoords);
+    if (!inData || inData->empty())
+    {
+        tileData.reset();
+        tileCoords.reset();
+        return next;
+    }
+    const ArrayEncoding<position_t>& positions = getPositions(*inCoords);
+    size_t const nValues = positions.size();
+    for (size_t i = 0, n = _bindings.size(); i < n; i++)
+    {
+        if (_tileIterators[i + 1])
+        {
+            getAlignedTile(_tileIterators[i + 1], positions.at(0), nValues, _tiles[i]);
+        }
+    }
+
+    const CoordinatesMapper* mapper = (*this);
+    Expression& expression = *_array._expressions[_outAttrId];
+    boost::shared_ptr<BaseTile> outData = newDataTile(chunk->getAttributeDesc().getType(), nValues);
+    for (size_t j = 0; j < nValues; j++)
+    {
+        for (size_t i = 0, n = _bindings.size(); i < n; i++)
+        {
+            switch (_bindings[i].kind)
+            {
+                case BindInfo::BI_ATTRIBUTE:
+                    if (_iterators[i] == inputIterator)
+                    {
+                        inData->at(j, _params[i]);
+                    }
+                    else
+                    {
+                        _tiles[i]->at(j, _params[i]);
+                    }
+                    break;
+                case BindInfo::BI_COORDINATE:
+                    mapper->pos2coord(positions.at(j), _tilePos);
+                    _params[i].setInt64(_tilePos[_bindings[i].resolvedId]);
+                    break;
+                default:
+                    break;
+            }
+        }
+        outData->push_back(expression.evaluate(_params));
+    }
+    outData->finalize();
+    tileData.swap(outData);
+    tileCoords.swap(inCoords);
+    return next;
+}
+
 ApplyChunkIterator::ApplyChunkIterator(ApplyArrayIterator const& arrayIterator, DelegateChunk const* chunk, int iterationMode) :
-    DelegateChunkIterator(chunk, iterationMode & ~(INTENDED_TILE_MODE | IGNORE_NULL_VALUES | IGNORE_DEFAULT_VALUES)),
+    TileOutputChunkIterator<DelegateChunkIterator>(chunk, iterationMode & ~(INTENDED_TILE_MODE | IGNORE_NULL_VALUES | IGNORE_DEFAULT_VALUES)),
     _array((ApplyArray&) arrayIterator.array),
     _outAttrId(arrayIterator.attr),
     _bindings(_array._bindingSets[_outAttrId]),
@@ -175,7 +254,9 @@ ApplyChunkIterator::ApplyChunkIterator(ApplyArrayIterator const& arrayIterator,
     _mode(iterationMode),
     _applied(false),
     _nullable(_array._attributeNullable[_outAttrId]),
-    _query(Query::getValidQueryPtr(_array._query))
+    _query(Query::getValidQueryPtr(_array._query)),
+    _tileIterators(_bindings.size() + 1),
+    _tiles(_bindings.size())
 {
     _supportsVectorMode = ! _nullable && _array._expressions[_outAttrId]->supportsVectorMode() && inputIterator->supportsVectorMode();
     for (size_t i = 0, n = _bindings.size(); i < n; i++)
@@ -326,7 +407,7 @@ DelegateChunkIterator* ApplyArray::createChunkIterator(DelegateChunk const* chun
         iterationMode &= ~ChunkIterator::TILE_MODE;
     }
     DelegateChunkIterator* res = (_expressions[attId].get()) ? (DelegateChunkIterator*) new ApplyChunkIterator(arrayIterator, chunk, iterationMode)
-                                                             : DelegateArray::createChunkIterator(chunk, iterationMode);
+                                                             : (DelegateChunkIterator*) new TileDelegateChunkIterator(chunk, iterationMode);
     return res;
 }
 
@@ -34,6 +34,7 @@
 #include <vector>
 #include "array/DelegateArray.h"
 #include "array/Metadata.h"
+#include "array/TileIteratorAdaptors.h"
 #include "query/LogicalExpression.h"
 #include "query/Expression.h"
 
@@ -48,7 +49,7 @@ class ApplyArrayIterator;
 class ApplyChunkIterator;
 
 
-class ApplyChunkIterator : public DelegateChunkIterator
+class ApplyChunkIterator : public TileOutputChunkIterator<DelegateChunkIterator>
 {
 public:
     virtual  Value& getItem();
@@ -61,6 +62,16 @@ public:
     bool isNull();
     virtual boost::shared_ptr<Query> getQuery() { return _query; }
 
+protected:
+    /**
+     * Evaluate the expression over the tiles of the input attributes.
+     * The output tile has the positions of the input tile.
+     */
+    virtual position_t getTiles(position_t logicalOffset,
+                                size_t maxValues,
+                                boost::shared_ptr<BaseTile>& tileData,
+                                boost::shared_ptr<BaseTile>& tileCoords);
+
 private:
     ApplyArray const& _array;
     AttributeID _outAttrId;
@@ -73,7 +84,10 @@ private:
     bool _applied;
     bool _nullable;
     shared_ptr<Query> _query;
-
+    /// getData() iterators of the attributes in the expression, and their tiles
+    vector< boost::shared_ptr<ConstChunkIterator> > _tileIterators;
+    vector< boost::shared_ptr<BaseTile> > _tiles;
+    Coordinates _tilePos;
 };
 
 class ApplyArrayIterator : public DelegateArrayIterator
@@ -31,6 +31,7 @@
 #include "array/Metadata.h"
 #include "array/DelegateArray.h"
 #include "system/SciDBConfigOptions.h"
+#include "util/CoordinatesMapper.h"
 #include "NumericOps.h"
 
 using namespace std;
@@ -51,6 +52,8 @@ class BernoulliArrayIterator : public DelegateArrayIterator
         }
         nextElem -= nChunkElems;
         ++(*inputIterator);
+        // the count of a stored chunk comes from its header (ChunkHeader::nElems),
+        // so chunks that receive no sample are skipped without being read
         while (!inputIterator->end()) { 
             nChunkElems = inputIterator->getChunk().count();
             if (nextElem < nChunkElems) {
@@ -151,8 +154,15 @@ class BernoulliArrayIterator : public DelegateArrayIterator
           arrayIterator((BernoulliArrayIterator&)chunk->getArrayIterator()),                
           nops(arrayIterator.nops),
           nextElem(arrayIterator.nextElem),
-          lastElem(0)
+          lastElem(0),
+          mapper(*chunk)
         {
+            // In an emptyable array the n-th sample is the n-th non-empty cell, which the empty bitmap locates
+            // directly, so the chunk iterator can jump to it rather than step over every cell in between.
+            // The bitmap counts the cells of the overlap, which the samples do not; so only without overlap.
+            if (!arrayIterator.isPlainArray && !chunk->getArrayDesc().hasOverlap()) {
+                emptyBitmap = chunk->getInputChunk().getEmptyBitmap();
+            }
             setSamplePosition();        
             trueValue.setBool(true);
         }
@@ -160,7 +170,16 @@ class BernoulliArrayIterator : public DelegateArrayIterator
         void setSamplePosition() 
         {
             size_t offset = nextElem;
-            if (!arrayIterator.isPlainArray) { 
+            if (emptyBitmap) {
+                position_t lPos = findNonEmptyCell(nextElem);
+                if (lPos < 0) {
+                    hasCurrent = false;
+                } else {
+                    Coordinates pos;
+                    mapper.pos2coord(lPos, pos);
+                    hasCurrent = inputIterator->setPosition(pos);
+                }
+            } else if (!arrayIterator.isPlainArray) { 
                 offset -= lastElem;
                 while (offset-- != 0 && !inputIterator->end()) { 
                     ++(*inputIterator);
@@ -180,7 +199,30 @@ class BernoulliArrayIterator : public DelegateArrayIterator
                 hasCurrent = inputIterator->setPosition(pos);
             }
         }
-        
+
+        /**
+         * @return the logical position in the chunk of its n-th non-empty cell, or -1 if there are not that many
+         */
+        position_t findNonEmptyCell(size_t n) const
+        {
+            // the segments are ordered by the index of their first cell among the non-empty ones
+            size_t l = 0, r = emptyBitmap->nSegments();
+            while (l < r) {
+                size_t m = (l + r) >> 1;
+                if (size_t(emptyBitmap->getSegment(m)._pPosition) <= n) {
+                    l = m + 1;
+                } else {
+                    r = m;
+                }
+            }
+            if (l == 0) {
+                return -1;
+            }
+            ConstRLEEmptyBitmap::Segment const& seg = emptyBitmap->getSegment(l - 1);
+            size_t const skip = n - seg._pPosition;
+            return skip < size_t(seg._length) ? seg._lPosition + skip : -1;
+        }
+
       private:
         BernoulliArrayIterator& arrayIterator;
         NumericOperations nops;
@@ -188,6 +230,8 @@ class BernoulliArrayIterator : public DelegateArrayIterator
         size_t lastElem;
         bool hasCurrent;
         Value trueValue;
+        CoordinatesMapper mapper;
+        shared_ptr<ConstRLEEmptyBitmap> emptyBitmap;
     };
 
 class BernoulliArray : public DelegateArray
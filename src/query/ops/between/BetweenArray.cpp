@@ -54,7 +54,7 @@ namespace scidb
                   ? (ConstChunkIterator*)new DelegateChunkIterator(this, iterationMode & ~ConstChunkIterator::IGNORE_DEFAULT_VALUES)                                
                   : (ConstChunkIterator*)new ExistedBitmapBetweenChunkIterator(*this, iterationMode & ~ConstChunkIterator::IGNORE_DEFAULT_VALUES)        
             : fullyInside 
-                ? (ConstChunkIterator*)new DelegateChunkIterator(this, iterationMode)          
+                ? (ConstChunkIterator*)new TileDelegateChunkIterator(this, iterationMode)
                 : (ConstChunkIterator*)new BetweenChunkIterator(*this, iterationMode));            
     }
 
@@ -180,6 +180,25 @@ namespace scidb
         return chunk;
     }
 
+    boost::shared_ptr<ConstChunkIterator> BetweenChunkIterator::getTileInput()
+    {
+        if (!_ignoreEmptyCells || chunk.getAttributeDesc().isEmptyIndicator()) {
+            return boost::shared_ptr<ConstChunkIterator>();
+        }
+        // the cell interface keeps inputIterator where it is
+        return chunk.getInputChunk().getConstIterator(_mode);
+    }
+
+    void BetweenChunkIterator::selectTile(BaseTile& tileData,
+                                          const ArrayEncoding<position_t>& positions,
+                                          std::vector<char>& selected)
+    {
+        for (size_t i = 0, n = positions.size(); i < n; i++) {
+            pos2coord(positions.at(i), tilePos);
+            selected[i] = array._spatialRangesPtr->findOneThatContains(tilePos, _hintForSpatialRanges);
+        }
+    }
+
     BetweenChunkIterator::BetweenChunkIterator(BetweenChunk const& aChunk, int iterationMode)
     : CoordinatesMapper(aChunk),
       array(aChunk.array),
@@ -189,6 +208,7 @@ namespace scidb
       _mode(iterationMode & ~INTENDED_TILE_MODE & ~TILE_MODE),
       _ignoreEmptyCells((iterationMode & IGNORE_EMPTY_CELLS) == IGNORE_EMPTY_CELLS),
       type(chunk.getAttributeDesc().getType()),
+      tilePos(array.getArrayDesc().getDimensions().size()),
       _hintForSpatialRanges(0)
     {
         reset();
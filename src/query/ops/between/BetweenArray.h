@@ -43,6 +43,7 @@
 #include <array/DelegateArray.h>
 #include <array/Metadata.h>
 #include <array/SpatialRangesChunkPosIterator.h>
+#include <array/TileIteratorAdaptors.h>
 
 namespace scidb
 {
@@ -75,7 +76,7 @@ private:
     boost::shared_ptr<ConstArrayIterator> emptyBitmapIterator;
 };
     
-class BetweenChunkIterator : public ConstChunkIterator, CoordinatesMapper
+class BetweenChunkIterator : public TileSelectingChunkIterator<ConstChunkIterator>, CoordinatesMapper
 {
 public:
     int getMode() {
@@ -94,6 +95,11 @@ public:
     BetweenChunkIterator(BetweenChunk const& chunk, int iterationMode);
 
   protected:
+    virtual boost::shared_ptr<ConstChunkIterator> getTileInput();
+    virtual void selectTile(BaseTile& tileData,
+                            const ArrayEncoding<position_t>& positions,
+                            std::vector<char>& selected);
+
     BetweenArray const& array;
     BetweenChunk const& chunk;
     boost::shared_ptr<ConstChunkIterator> inputIterator;
@@ -104,6 +110,7 @@ public:
     MemChunk shapeChunk;
     boost::shared_ptr<ConstChunkIterator> emptyBitmapIterator;
     TypeId type;
+    Coordinates tilePos;
 
     /**
      * Several member functions of class SpatialRanges takes a hint, on where the last successful search.
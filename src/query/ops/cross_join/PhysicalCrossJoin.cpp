@@ -40,6 +40,11 @@ namespace scidb {
 class PhysicalCrossJoin: public PhysicalOperator
 {
 public:
+    static bool isMemoryHungry()
+    {
+        return true;
+    }
+
     PhysicalCrossJoin(std::string const& logicalName,
                       std::string const& physicalName,
                       Parameters const& parameters,
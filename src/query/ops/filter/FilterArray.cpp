@@ -174,14 +174,66 @@ namespace scidb {
         nextVisible();
     }
 
+    boost::shared_ptr<ConstChunkIterator> FilterChunkIterator::getTileInput()
+    {
+        if ((_mode & TILE_MODE) || !(_mode & IGNORE_EMPTY_CELLS) || chunk->getAttributeDesc().isEmptyIndicator()) {
+            return boost::shared_ptr<ConstChunkIterator>();
+        }
+        // the cell interface keeps inputIterator and _iterators where they are
+        return chunk->getInputChunk().getConstIterator(_mode & ~INTENDED_TILE_MODE);
+    }
+
+    void FilterChunkIterator::selectTile(BaseTile& tileData,
+                                         const ArrayEncoding<position_t>& positions,
+                                         std::vector<char>& selected)
+    {
+        size_t const nValues = positions.size();
+        size_t const nBindings = _array.bindings.size();
+        for (size_t i = 0; i < nBindings; i++) {
+            if (_array.bindings[i].kind == BindInfo::BI_ATTRIBUTE && _iterators[i] != inputIterator) {
+                if (!_tileIterators[i]) {
+                    _tileIterators[i] = makeTileConstChunkIterator(
+                        _iterators[i]->getChunk().getConstIterator(_iterators[i]->getMode()));
+                }
+                getAlignedTile(_tileIterators[i], positions.at(0), nValues, _tiles[i]);
+            }
+        }
+        const CoordinatesMapper* mapper = (*this);
+        for (size_t j = 0; j < nValues; j++) {
+            for (size_t i = 0; i < nBindings; i++) {
+                switch (_array.bindings[i].kind) {
+                    case BindInfo::BI_ATTRIBUTE:
+                        if (_iterators[i] == inputIterator) {
+                            tileData.at(j, _params[i]);
+                        } else {
+                            _tiles[i]->at(j, _params[i]);
+                        }
+                        break;
+
+                    case BindInfo::BI_COORDINATE:
+                        mapper->pos2coord(positions.at(j), _tilePos);
+                        _params[i].setInt64(_tilePos[_array.bindings[i].resolvedId]);
+                        break;
+
+                    default:
+                        break;
+                }
+            }
+            Value const& result = _array.expression->evaluate(_params);
+            selected[j] = !result.isNull() && result.getBool();
+        }
+    }
+
     FilterChunkIterator::FilterChunkIterator(FilterArrayIterator const& arrayIterator, DelegateChunk const* chunk, int iterationMode)
-    : DelegateChunkIterator(chunk, iterationMode),
+    : TileSelectingChunkIterator<DelegateChunkIterator>(chunk, iterationMode),
       _array((FilterArray&)arrayIterator.array),
       _iterators(_array.bindings.size()),
       _params(*_array.expression),
       _mode(iterationMode),
       _type(chunk->getAttributeDesc().getType()),
-      _query(Query::getValidQueryPtr(_array._query))
+      _query(Query::getValidQueryPtr(_array._query)),
+      _tileIterators(_array.bindings.size()),
+      _tiles(_array.bindings.size())
     {
         for (size_t i = 0, n = _array.bindings.size(); i < n; i++) {
             switch (_array.bindings[i].kind) {
@@ -35,6 +35,7 @@
 
 #include "array/DelegateArray.h"
 #include "array/Metadata.h"
+#include "array/TileIteratorAdaptors.h"
 #include "query/LogicalExpression.h"
 #include "query/Expression.h"
 
@@ -49,7 +50,7 @@ class FilterArrayIterator;
 class FilterChunkIterator;
 
 
-class FilterChunkIterator : public DelegateChunkIterator
+class FilterChunkIterator : public TileSelectingChunkIterator<DelegateChunkIterator>
 {
   protected:
     Value& evaluate();
@@ -57,6 +58,10 @@ class FilterChunkIterator : public DelegateChunkIterator
     bool filter();
     void moveNext();
     void nextVisible();
+    virtual boost::shared_ptr<ConstChunkIterator> getTileInput();
+    virtual void selectTile(BaseTile& tileData,
+                            const ArrayEncoding<position_t>& positions,
+                            std::vector<char>& selected);
 
   public:
     virtual Value& getItem();
@@ -79,6 +84,10 @@ class FilterChunkIterator : public DelegateChunkIterator
     TypeId _type;
  private:
     boost::shared_ptr<Query> _query;
+    /// getData() iterators of the attributes in the expression, and their tiles
+    vector< boost::shared_ptr<ConstChunkIterator> > _tileIterators;
+    vector< boost::shared_ptr<BaseTile> > _tiles;
+    Coordinates _tilePos;
 };
 
 
@@ -50,6 +50,11 @@ static log4cxx::LoggerPtr oplogger(log4cxx::Logger::getLogger("scidb.ops.impl_in
 class PhysicalInput : public PhysicalOperator
 {
 public:
+    static bool isMemoryHungry()
+    {
+        return true;
+    }
+
     PhysicalInput(std::string const& logicalName,
                   std::string const& physicalName,
                   Parameters const& parameters,
@@ -68,6 +68,11 @@ private:
     ArrayDesc _previousVersionDesc;
 
 public:
+    static bool isMemoryHungry()
+    {
+        return true;
+    }
+
     /**
     * Vanilla. Same as most operators.
     */
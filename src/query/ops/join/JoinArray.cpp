@@ -30,6 +30,8 @@
 #include "query/Operator.h"
 #include "array/Metadata.h"
 #include "array/Array.h"
+#include "system/Config.h"
+#include "system/SciDBConfigOptions.h"
 #include "JoinArray.h"
 
 using namespace std;
@@ -88,10 +90,81 @@ namespace scidb
         alignIterators();
     }
 
+    boost::shared_ptr<ConstChunkIterator> JoinChunkIterator::getTileInput()
+    {
+        if (!(mode & IGNORE_EMPTY_CELLS) || chunk->getAttributeDesc().isEmptyIndicator()) {
+            return boost::shared_ptr<ConstChunkIterator>();
+        }
+        // the cell interface keeps inputIterator and joinIterator where they are
+        return chunk->getInputChunk().getConstIterator(mode & ~INTENDED_TILE_MODE);
+    }
+
+    void JoinChunkIterator::joinReset()
+    {
+        _joinData.reset();
+        _joinCoords.reset();
+        _joinIndex = 0;
+        _joinNext = -1;
+        _joinTileIterator->reset();
+        if (!_joinTileIterator->end()) {
+            const CoordinatesMapper* mapper = (*this);
+            _joinNext = mapper->coord2pos(_joinTileIterator->getPosition());
+        }
+        _joinLast = -1;
+    }
+
+    bool JoinChunkIterator::joinTile(position_t pos)
+    {
+        if (pos <= _joinLast) {
+            joinReset();
+        }
+        _joinLast = pos;
+        while (true) {
+            if (_joinData) {
+                const ArrayEncoding<position_t>& positions = getPositions(*_joinCoords);
+                for (size_t n = positions.size(); _joinIndex < n; _joinIndex++) {
+                    position_t const joinPos = positions.at(_joinIndex);
+                    if (joinPos >= pos) {
+                        return joinPos == pos;
+                    }
+                }
+                _joinData.reset();
+                _joinCoords.reset();
+            }
+            if (_joinNext < 0) {
+                return false;
+            }
+            _joinNext = _joinTileIterator->getData(_joinNext, _joinTileSize, _joinData, _joinCoords);
+            _joinIndex = 0;
+            if (!_joinData || _joinData->empty()) {
+                _joinData.reset();
+                _joinCoords.reset();
+                return false;
+            }
+        }
+    }
+
+    void JoinChunkIterator::selectTile(BaseTile& tileData,
+                                       const ArrayEncoding<position_t>& positions,
+                                       std::vector<char>& selected)
+    {
+        if (!_joinTileIterator) {
+            _joinTileIterator = makeTileConstChunkIterator(joinIterator->getChunk().getConstIterator(mode));
+            joinReset();
+        }
+        for (size_t i = 0, n = positions.size(); i < n; i++) {
+            selected[i] = joinTile(positions.at(i));
+        }
+    }
+
     JoinChunkIterator::JoinChunkIterator(JoinEmptyableArrayIterator const& arrayIterator, DelegateChunk const* chunk, int iterationMode)
-    : DelegateChunkIterator(chunk, iterationMode),
+    : TileSelectingChunkIterator<DelegateChunkIterator>(chunk, iterationMode),
       joinIterator(arrayIterator._joinIterator->getChunk().getConstIterator(iterationMode)),
-      mode(iterationMode)
+      mode(iterationMode),
+      _joinIndex(0),
+      _joinNext(-1),
+      _joinLast(-1),
+      _joinTileSize(std::max(Config::getInstance()->getOption<int>(CONFIG_TILE_SIZE), 1))
     {
         alignIterators();
     }
@@ -178,7 +251,7 @@ namespace scidb
 
         if (!arrayIterator._chunkLevelJoin)
         {
-            return new DelegateChunkIterator(chunk, iterationMode);
+            return new TileDelegateChunkIterator(chunk, iterationMode);
         }
         else if (attr.isEmptyIndicator())
         {
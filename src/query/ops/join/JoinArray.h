@@ -32,6 +32,7 @@
 #include "query/Operator.h"
 #include "array/Metadata.h"
 #include "array/DelegateArray.h"
+#include "array/TileIteratorAdaptors.h"
 
 namespace scidb {
 
@@ -41,7 +42,7 @@ using namespace std;
 class JoinEmptyableArray;
 class JoinEmptyableArrayIterator;
 
-class JoinChunkIterator : public DelegateChunkIterator
+class JoinChunkIterator : public TileSelectingChunkIterator<DelegateChunkIterator>
 {    
   public:
     virtual void operator ++();
@@ -54,10 +55,31 @@ class JoinChunkIterator : public DelegateChunkIterator
   protected:
     bool join();
     void alignIterators();
+    virtual boost::shared_ptr<ConstChunkIterator> getTileInput();
+    virtual void selectTile(BaseTile& tileData,
+                            const ArrayEncoding<position_t>& positions,
+                            std::vector<char>& selected);
 
     boost::shared_ptr<ConstChunkIterator> joinIterator;
     int mode;
     bool hasCurrent;
+
+  private:
+    /**
+     * @return true if the other array has a cell at the position,
+     *         the positions are expected in ascending order since the last call to joinReset()
+     */
+    bool joinTile(position_t pos);
+    void joinReset();
+
+    /// getData() iterator of the other array and its current tile
+    boost::shared_ptr<ConstChunkIterator> _joinTileIterator;
+    boost::shared_ptr<BaseTile> _joinData;
+    boost::shared_ptr<BaseTile> _joinCoords;
+    size_t _joinIndex;
+    position_t _joinNext;
+    position_t _joinLast;
+    size_t _joinTileSize;
 };
    
 
@@ -27,6 +27,7 @@
  *      Author: poliocough@gmail.com
  */
 
+#include "query/QueryPlan.h"
 #include "ListArrayBuilder.h"
 
 using namespace boost;
@@ -102,6 +103,53 @@ void ListArrayBuilder<T>::listElement(T const& element)
     ++_currPos[1];
 }
 
+template <typename T>
+Attributes ListArrayBuilder<T>::makeAttributes(ListAttributeSpec const* specs, size_t nSpecs)
+{
+    Attributes attrs(nSpecs + 1);
+    for (AttributeID i = 0; i < nSpecs; ++i)
+    {
+        attrs[i] = AttributeDesc(i, specs[i].name, specs[i].type, 0, 0);
+    }
+    attrs[nSpecs] = AttributeDesc(nSpecs,
+                                  DEFAULT_EMPTY_TAG_ATTRIBUTE_NAME,
+                                  TID_INDICATOR,
+                                  AttributeDesc::IS_EMPTY_INDICATOR, 0);
+    return attrs;
+}
+
+template <typename T>
+void ListArrayBuilder<T>::writeUint32(AttributeID attr, uint32_t value)
+{
+    Value v;
+    v.setUint32(value);
+    _outCIters[attr]->writeItem(v);
+}
+
+template <typename T>
+void ListArrayBuilder<T>::writeUint64(AttributeID attr, uint64_t value)
+{
+    Value v;
+    v.setUint64(value);
+    _outCIters[attr]->writeItem(v);
+}
+
+template <typename T>
+void ListArrayBuilder<T>::writeDouble(AttributeID attr, double value)
+{
+    Value v;
+    v.setDouble(value);
+    _outCIters[attr]->writeItem(v);
+}
+
+template <typename T>
+void ListArrayBuilder<T>::writeString(AttributeID attr, std::string const& value)
+{
+    Value v;
+    v.setString(value);
+    _outCIters[attr]->writeItem(v);
+}
+
 template <typename T>
 shared_ptr<MemArray> ListArrayBuilder<T>::getArray()
 {
@@ -372,4 +420,131 @@ void ListQueriesArrayBuilder::addToArray(shared_ptr<Query> const& query)
     _outCIters[IDLE]->writeItem(v);
 }
 
+
+Attributes ListChunkMapStatisticsArrayBuilder::getAttributes() const
+{
+    static const ListAttributeSpec specs[] = {
+        { "uaid",               TID_UINT64 },
+        { "entries",            TID_UINT64 },
+        { "positions",          TID_UINT64 },
+        { "tombstones",         TID_UINT64 },
+        { "lookups",            TID_UINT64 },
+        { "visits",             TID_UINT64 },
+        { "read_amplification", TID_DOUBLE }
+    };
+    assert(sizeof(specs) / sizeof(specs[0]) == EMPTY_INDICATOR);
+    return makeAttributes(specs, EMPTY_INDICATOR);
+}
+
+void ListChunkMapStatisticsArrayBuilder::addToArray(ChunkMapStatistics const& stats)
+{
+    writeUint64(U_ARRAY_ID, stats.uaId);
+    writeUint64(ENTRIES, stats.entries);
+    writeUint64(POSITIONS, stats.positions);
+    writeUint64(TOMBSTONES, stats.tombstones);
+    writeUint64(LOOKUPS, stats.lookups);
+    writeUint64(VISITS, stats.visits);
+    writeDouble(READ_AMPLIFICATION, stats.lookups == 0 ? 0 : double(stats.visits) / stats.lookups);
+}
+
+Attributes ListJobQueuesArrayBuilder::getAttributes() const
+{
+    static const ListAttributeSpec specs[] = {
+        { "name",        TID_STRING },
+        { "workers",     TID_UINT64 },
+        { "depth",       TID_UINT64 },
+        { "injected",    TID_UINT64 },
+        { "spawned",     TID_UINT64 },
+        { "local_pops",  TID_UINT64 },
+        { "steals",      TID_UINT64 },
+        { "node_steals", TID_UINT64 },
+        { "sleeps",      TID_UINT64 }
+    };
+    assert(sizeof(specs) / sizeof(specs[0]) == EMPTY_INDICATOR);
+    return makeAttributes(specs, EMPTY_INDICATOR);
+}
+
+void ListJobQueuesArrayBuilder::addToArray(JobQueue const& queue)
+{
+    JobQueue::Statistics const stats = queue.getStatistics();
+    writeString(NAME, queue.getName());
+    writeUint64(WORKERS, stats.workers);
+    writeUint64(DEPTH, stats.depth);
+    writeUint64(INJECTED, stats.injected);
+    writeUint64(SPAWNED, stats.spawned);
+    writeUint64(LOCAL_POPS, stats.localPops);
+    writeUint64(STEALS, stats.steals);
+    writeUint64(NODE_STEALS, stats.nodeSteals);
+    writeUint64(SLEEPS, stats.sleeps);
+}
+
+Attributes ListMemCacheArrayBuilder::getAttributes() const
+{
+    static const ListAttributeSpec specs[] = {
+        { "shard",            TID_UINT32 },
+        { "lru_chunks",       TID_UINT64 },
+        { "pins",             TID_UINT64 },
+        { "slow_pins",        TID_UINT64 },
+        { "lock_waits",       TID_UINT64 },
+        { "cache_lock_waits", TID_UINT64 }
+    };
+    assert(sizeof(specs) / sizeof(specs[0]) == EMPTY_INDICATOR);
+    return makeAttributes(specs, EMPTY_INDICATOR);
+}
+
+void ListMemCacheArrayBuilder::addToArray(SharedMemCache::ShardStatistics const& stats)
+{
+    writeUint32(SHARD, stats.shard);
+    writeUint64(LRU_CHUNKS, stats.lruChunks);
+    writeUint64(PINS, stats.pins);
+    writeUint64(SLOW_PINS, stats.slowPins);
+    writeUint64(LOCK_WAITS, stats.lockWaits);
+    writeUint64(CACHE_LOCK_WAITS, stats.cacheLockWaits);
+}
+
+Attributes ListOperatorProfilesArrayBuilder::getAttributes() const
+{
+    vector<ListAttributeSpec> specs(EMPTY_INDICATOR);
+    specs[QUERY_ID].name = "query_id";
+    specs[QUERY_ID].type = TID_UINT64;
+    specs[NODE].name     = "node";
+    specs[NODE].type     = TID_UINT32;
+    specs[OPERATOR].name = "operator";
+    specs[OPERATOR].type = TID_STRING;
+    for (size_t c = 0; c < OperatorProfile::NUM_COUNTERS; c++) {
+        specs[FIRST_COUNTER + c].name = OperatorProfile::getCounterName(OperatorProfile::Counter(c));
+        specs[FIRST_COUNTER + c].type = TID_UINT64;
+    }
+    return makeAttributes(&specs[0], specs.size());
+}
+
+void ListOperatorProfilesArrayBuilder::listQuery(shared_ptr<Query> const& query)
+{
+    shared_ptr<PhysicalPlan> plan = query->getCurrentPhysicalPlan();
+    if (!plan) {
+        return;
+    }
+    vector<PhysNodePtr> nodes;
+    plan->getNodes(nodes);
+
+    OperatorProfileEntry entry;
+    entry.queryId = query->getQueryID();
+    for (size_t i = 0; i < nodes.size(); i++) {
+        entry.node = i;
+        entry.name = nodes[i]->getPhysicalOperator()->getPhysicalName();
+        nodes[i]->getProfile().getTotals(entry.counters);
+        listElement(entry);
+    }
+}
+
+void ListOperatorProfilesArrayBuilder::addToArray(OperatorProfileEntry const& entry)
+{
+    writeUint64(QUERY_ID, entry.queryId);
+    writeUint32(NODE, entry.node);
+    writeString(OPERATOR, entry.name);
+    for (size_t c = 0; c < OperatorProfile::NUM_COUNTERS; c++) {
+        writeUint64(FIRST_COUNTER + c, entry.counters[c]);
+    }
+}
+
 }
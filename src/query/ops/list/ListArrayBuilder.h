@@ -31,12 +31,23 @@
 #define LISTARRAYBUILDER_H_
 
 #include <array/MemArray.h>
+#include <query/Statistics.h>
 #include <smgr/io/InternalStorage.h>
+#include <util/JobQueue.h>
 
 
 namespace scidb
 {
 
+/**
+ * The name and type of an attribute of a list, see ListArrayBuilder::makeAttributes().
+ */
+struct ListAttributeSpec
+{
+    const char* name;
+    const char* type;
+};
+
 /**
  * Abstract class to build a per-instance MemArray that contains a list of arbitrary elements.
  * Every MemArray built with this class contains two dimensions:
@@ -49,6 +60,8 @@ namespace scidb
  * - a getAttributes() function which returns the list of the K attributes for the resulting array.
  *   K must include the emtpy tag.
  * - an addToArray() function which takes an object and splits it into the K-1 attribute values.
+ * Lists of statistics can build their attributes with makeAttributes() and write their values
+ * with the write functions.
  */
 template <typename T>
 class ListArrayBuilder
@@ -72,6 +85,42 @@ protected:
      */
     virtual void addToArray(T const& value) =0;
 
+    /**
+     * Construct attributes with the given names and types, in the order of their ids, followed by the empty tag.
+     * @param specs the names and types of the attributes, without the empty tag
+     * @param nSpecs the number of specs
+     * @return the attributes, for getAttributes()
+     */
+    static Attributes makeAttributes(ListAttributeSpec const* specs, size_t nSpecs);
+
+    /**
+     * Write an attribute of the element being added, for addToArray().
+     * @param attr the attribute
+     * @param value its value
+     */
+    void writeUint32(AttributeID attr, uint32_t value);
+
+    /**
+     * Write an attribute of the element being added, for addToArray().
+     * @param attr the attribute
+     * @param value its value
+     */
+    void writeUint64(AttributeID attr, uint64_t value);
+
+    /**
+     * Write an attribute of the element being added, for addToArray().
+     * @param attr the attribute
+     * @param value its value
+     */
+    void writeDouble(AttributeID attr, double value);
+
+    /**
+     * Write an attribute of the element being added, for addToArray().
+     * @param attr the attribute
+     * @param value its value
+     */
+    void writeString(AttributeID attr, std::string const& value);
+
     ListArrayBuilder(): _initialized(false) {}
 
     /**
@@ -359,6 +408,167 @@ public:
     virtual Attributes getAttributes() const;
 };
 
+
+/**
+ * A ListArrayBuilder for listing the chunk map statistics of the arrays stored on the instance.
+ */
+class ListChunkMapStatisticsArrayBuilder : public ListArrayBuilder <ChunkMapStatistics>
+{
+private:
+    /**
+     * Verbose names of all the attributes output by list('chunk map statistics') for internal consistency and dev readability.
+     */
+    enum Attrs
+    {
+    U_ARRAY_ID=0,
+    ENTRIES,
+    POSITIONS,
+    TOMBSTONES,
+    LOOKUPS,
+    VISITS,
+    READ_AMPLIFICATION,
+    EMPTY_INDICATOR,
+    NUM_ATTRIBUTES // must be last
+    };
+
+    /**
+     * Add the statistics of an array to the array.
+     * @param item statistics to add
+     */
+    virtual void addToArray(ChunkMapStatistics const& item);
+
+public:
+    /**
+     * Get the attributes of the array
+     * @return the attribute descriptors
+     */
+    virtual Attributes getAttributes() const;
+};
+
+/**
+ * A ListArrayBuilder for listing the JobQueue statistics of the instance.
+ */
+class ListJobQueuesArrayBuilder : public ListArrayBuilder <JobQueue>
+{
+private:
+    /**
+     * Verbose names of all the attributes output by list('job queues') for internal consistency and dev readability.
+     */
+    enum Attrs
+    {
+    NAME=0,
+    WORKERS,
+    DEPTH,
+    INJECTED,
+    SPAWNED,
+    LOCAL_POPS,
+    STEALS,
+    NODE_STEALS,
+    SLEEPS,
+    EMPTY_INDICATOR,
+    NUM_ATTRIBUTES // must be last
+    };
+
+    /**
+     * Add the statistics of a JobQueue to the array.
+     * @param item queue to add
+     */
+    virtual void addToArray(JobQueue const& item);
+
+public:
+    /**
+     * Get the attributes of the array
+     * @return the attribute descriptors
+     */
+    virtual Attributes getAttributes() const;
+};
+
+/**
+ * A ListArrayBuilder for listing the pin statistics of the SharedMemCache shards of the instance.
+ */
+class ListMemCacheArrayBuilder : public ListArrayBuilder <SharedMemCache::ShardStatistics>
+{
+private:
+    /**
+     * Verbose names of all the attributes output by list('mem cache') for internal consistency and dev readability.
+     */
+    enum Attrs
+    {
+    SHARD=0,
+    LRU_CHUNKS,
+    PINS,
+    SLOW_PINS,
+    LOCK_WAITS,
+    CACHE_LOCK_WAITS,
+    EMPTY_INDICATOR,
+    NUM_ATTRIBUTES // must be last
+    };
+
+    /**
+     * Add the statistics of a shard to the array.
+     * @param item statistics to add
+     */
+    virtual void addToArray(SharedMemCache::ShardStatistics const& item);
+
+public:
+    /**
+     * Get the attributes of the array
+     * @return the attribute descriptors
+     */
+    virtual Attributes getAttributes() const;
+};
+
+/**
+ * The counters of one node of the current physical plan of a query on this instance.
+ */
+struct OperatorProfileEntry
+{
+    QueryID queryId;
+    uint32_t node;          /**< the number of the node in a preorder walk of the plan */
+    std::string name;       /**< the name of the physical operator */
+    uint64_t counters[OperatorProfile::NUM_COUNTERS];
+};
+
+/**
+ * A ListArrayBuilder for listing the operator profiles of the running queries.
+ */
+class ListOperatorProfilesArrayBuilder : public ListArrayBuilder <OperatorProfileEntry>
+{
+private:
+    /**
+     * Verbose names of all the attributes output by list('operator profiles') for internal consistency and dev readability.
+     * The counters follow OPERATOR, in the order of OperatorProfile::Counter.
+     */
+    enum Attrs
+    {
+    QUERY_ID=0,
+    NODE,
+    OPERATOR,
+    FIRST_COUNTER,
+    EMPTY_INDICATOR = FIRST_COUNTER + OperatorProfile::NUM_COUNTERS,
+    NUM_ATTRIBUTES // must be last
+    };
+
+    /**
+     * Add the counters of a plan node to the array.
+     * @param item counters to add
+     */
+    virtual void addToArray(OperatorProfileEntry const& item);
+
+public:
+    /**
+     * Add every node of the current physical plan of a query.
+     * @param query the query to list
+     */
+    void listQuery(boost::shared_ptr<Query> const& query);
+
+    /**
+     * Get the attributes of the array
+     * @return the attribute descriptors
+     */
+    virtual Attributes getAttributes() const;
+};
+
 }
 
 #endif /* LISTARRAYBUILDER_H_ */
@@ -57,9 +57,14 @@ using namespace boost;
  *   - arrays: show all the arrays.
  *   - chunk descriptors: show all the chunk descriptors.
  *   - chunk map: show the chunk map.
+ *   - chunk map statistics: show the number of chunk versions and the read amplification of the arrays on every instance.
  *   - functions: show all the functions.
  *   - instances: show all SciDB instances.
+ *   - job queues: show the depth and work-stealing statistics of the job queues on every instance.
  *   - libraries: show all the libraries that are loaded in the current SciDB session.
+ *   - mem cache: show the pin and lock contention statistics of the shards of the MemArray cache on every instance.
+ *   - operator profiles: show the counters of every node of the current physical plan of the active queries
+ *     on every instance; chunks and cells are counted when the profile-queries option is on.
  *   - operators: show all the operators and the libraries in which they reside.
  *   - types: show all the datatypes that SciDB supports.
  *   - queries: show all the active queries.
@@ -202,9 +207,21 @@ public:
         } else if (what == "chunk map") {
             ListChunkMapArrayBuilder builder;
             return builder.getSchema(query);
+        } else if (what == "chunk map statistics") {
+            ListChunkMapStatisticsArrayBuilder builder;
+            return builder.getSchema(query);
         } else if (what == "libraries") {
             ListLibrariesArrayBuilder builder;
             return builder.getSchema(query);
+        } else if (what == "job queues") {
+            ListJobQueuesArrayBuilder builder;
+            return builder.getSchema(query);
+        } else if (what == "mem cache") {
+            ListMemCacheArrayBuilder builder;
+            return builder.getSchema(query);
+        } else if (what == "operator profiles") {
+            ListOperatorProfilesArrayBuilder builder;
+            return builder.getSchema(query);
         }
         else {
                 throw USER_QUERY_EXCEPTION(SCIDB_SE_INFER_SCHEMA, SCIDB_LE_LIST_ERROR1,
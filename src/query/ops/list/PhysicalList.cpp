@@ -74,7 +74,10 @@ public:
     bool coordinatorOnly() const
     {
         if(getMainParameter() == "chunk descriptors" || getMainParameter() == "chunk map" ||
-           getMainParameter() == "libraries" || getMainParameter() == "queries")
+           getMainParameter() == "chunk map statistics" ||
+           getMainParameter() == "libraries" || getMainParameter() == "queries" ||
+           getMainParameter() == "job queues" || getMainParameter() == "mem cache" ||
+           getMainParameter() == "operator profiles")
         {
             return false;
         }
@@ -255,11 +258,37 @@ public:
              builder.initialize(query);
              StorageManager::getInstance().listChunkMap(builder);
              return builder.getArray();
+         } else if (what == "chunk map statistics") {
+             ListChunkMapStatisticsArrayBuilder builder;
+             builder.initialize(query);
+             StorageManager::getInstance().listChunkMapStatistics(builder);
+             return builder.getArray();
          } else if (what == "libraries") {
              ListLibrariesArrayBuilder builder;
              builder.initialize(query);
              PluginManager::getInstance()->listPlugins(builder);
              return builder.getArray();
+         } else if (what == "job queues") {
+             ListJobQueuesArrayBuilder builder;
+             builder.initialize(query);
+             boost::function<void (JobQueue const&)> f
+             = boost::bind(&ListJobQueuesArrayBuilder::listElement, &builder, _1);
+             JobQueue::listQueues(f);
+             return builder.getArray();
+         } else if (what == "mem cache") {
+             ListMemCacheArrayBuilder builder;
+             builder.initialize(query);
+             boost::function<void (SharedMemCache::ShardStatistics const&)> f
+             = boost::bind(&ListMemCacheArrayBuilder::listElement, &builder, _1);
+             SharedMemCache::getInstance().listShards(f);
+             return builder.getArray();
+         } else if (what == "operator profiles") {
+             ListOperatorProfilesArrayBuilder builder;
+             builder.initialize(query);
+             boost::function<void (const boost::shared_ptr<scidb::Query>&)> f
+             = boost::bind(&ListOperatorProfilesArrayBuilder::listQuery, &builder, _1);
+             scidb::Query::listQueries(f);
+             return builder.getArray();
          }
          else {
            assert(0);
@@ -43,6 +43,11 @@ namespace scidb
 class PhysicalAverageRank: public PhysicalOperator
 {
   public:
+    static bool isMemoryHungry()
+    {
+        return true;
+    }
+
     PhysicalAverageRank(const std::string& logicalName, const std::string& physicalName, const Parameters& parameters, const ArrayDesc& schema):
         PhysicalOperator(logicalName, physicalName, parameters, schema)
     {
@@ -34,6 +34,7 @@
 #include <array/MemArray.h>
 #include "RankCommon.h"
 #include <cmath>
+#include <sstream>
 #include <array/Compressor.h>
 #include <util/RegionCoordinatesIterator.h>
 #include <util/Timing.h>
@@ -155,8 +156,6 @@ double getPercentage(Coordinate quantileIndex, DimensionDesc const& quantileDime
 
 struct QuantileBucket
 {
-    vector<double> indeces;
-    vector<double> maxIndeces;
     vector<Value> values;
 };
 
@@ -1077,92 +1076,539 @@ void GroupbyQuantileChunk::setPosition(Coordinates const& pos)
 }
 
 /**
- * PhysicalQuantile.
+ * Exact quantiles of one attribute over the whole array, found by distributed selection.
+ *
+ * Rather than ranking every cell and passing the rank array around all instances, the
+ * coordinator (the instance that owns the output chunk) narrows down, for every requested
+ * rank, a value range that is known to contain it. Each round:
+ *   - every instance scans its local cells once, counts the values below and inside each
+ *     requested range, and returns either a uniform sample of the values inside the range or,
+ *     once the range is small enough, all of them;
+ *   - the coordinator checks that the target rank falls inside the range, and either picks
+ *     the answer from the collected values or chooses a narrower range around the target
+ *     from the merged samples.
+ * Only counts, samples and the final candidate ranges cross the network, and memory use is
+ * bounded by SAMPLE_SIZE and CANDIDATE_LIMIT rather than by the size of the attribute.
+ * Null values and NaNs are not ranked.
  */
-class PhysicalQuantile: public PhysicalOperator
+class QuantileSelector
 {
-  public:
-    PhysicalQuantile(const std::string& logicalName, const std::string& physicalName, const Parameters& parameters, const ArrayDesc& schema):
-        PhysicalOperator(logicalName, physicalName, parameters, schema)
+public:
+    /** Values sampled per range by each instance. */
+    static const size_t SAMPLE_SIZE = 16384;
+
+    /** A range holding at most this many values is collected on the coordinator. */
+    static const uint64_t CANDIDATE_LIMIT = 1 << 20;
+
+    /**
+     * Rounds in a row a range may stay larger than CANDIDATE_LIMIT without getting narrower,
+     * before quantile() gives up rather than collecting it.
+     */
+    static const size_t MAX_SAMPLE_ROUNDS = 16;
+
+    QuantileSelector(shared_ptr<Array> const& input, AttributeID attrID, shared_ptr<Query> const& query, InstanceID coordinator):
+        _input(input),
+        _attrID(attrID),
+        _query(query),
+        _coordinator(coordinator),
+        _typeId(input->getArrayDesc().getAttributes()[attrID].getType()),
+        _doubleFloatOther(getDoubleFloatOther(_typeId)),
+        _less(_typeId),
+        _round(0)
+    {}
+
+    /**
+     * Compute the quantiles at ranks ceil(i * N / (numQuantiles - 1)), i = 0 .. numQuantiles-1,
+     * of the N non-null values, the same ranks the ranking-based algorithm used.
+     * @return the quantile values on the coordinator, or an empty vector if there is no value
+     *         to rank or this is not the coordinator
+     */
+    vector<Value> select(size_t numQuantiles)
     {
+        if (_query->getInstanceID() != _coordinator) {
+            serve();
+            return vector<Value>();
+        }
+
+        // Round 0: a single unbounded range gives the total count and a first sample.
+        vector<Target> targets(numQuantiles);
+        vector<Range> ranges(1);
+        vector<RangeStats> stats = exchange(ranges);
+        uint64_t const count = stats[0].inside;
+        if (count == 0) {
+            finish();
+            return vector<Value>();
+        }
+        for (size_t i = 0; i < numQuantiles; i++) {
+            Target& t = targets[i];
+            t.rank = numQuantiles > 1 ? (i * count + numQuantiles - 2) / (numQuantiles - 1) : 1;
+            t.rank = std::max<uint64_t>(t.rank, 1);
+            t.knownInside = count;
+            t.proposal = t.known;
+            t.rangeNo = 0;
+        }
+
+        while (true) {
+            bool pending = false;
+            for (size_t i = 0; i < numQuantiles; i++) {
+                if (!targets[i].done) {
+                    refine(targets[i], stats[targets[i].rangeNo]);
+                    pending |= !targets[i].done;
+                }
+            }
+            if (!pending) {
+                break;
+            }
+            ranges.clear();
+            for (size_t i = 0; i < numQuantiles; i++) {
+                Target& t = targets[i];
+                if (!t.done) {
+                    t.rangeNo = findOrAddRange(ranges, t.proposal);
+                }
+            }
+            stats = exchange(ranges);
+        }
+        finish();
+
+        vector<Value> result(numQuantiles);
+        for (size_t i = 0; i < numQuantiles; i++) {
+            result[i] = targets[i].result;
+        }
+        return result;
     }
 
-    virtual bool changesDistribution(std::vector<ArrayDesc> const&) const
+private:
+    /**
+     * A range of values between two inclusive bounds; a missing bound is unbounded.
+     */
+    struct Range
     {
-        return true;
+        bool hasLo;
+        bool hasHi;
+        bool collect;
+        Value lo;
+        Value hi;
+
+        Range(): hasLo(false), hasHi(false), collect(false)
+        {}
+    };
+
+    /**
+     * What the instances found about a range: how many values are below and inside it,
+     * and a sample of (or, if Range::collect, all) the values inside it.
+     */
+    struct RangeStats
+    {
+        uint64_t below;
+        uint64_t inside;
+        vector<Value> items;
+        vector<double> weights;
+
+        RangeStats(): below(0), inside(0)
+        {}
+    };
+
+    struct Target
+    {
+        uint64_t rank;
+        Range known;            // contains the value at rank
+        uint64_t knownInside;   // number of values inside known
+        Range proposal;         // range being checked this round
+        size_t rangeNo;
+        size_t sampleRounds;
+        bool done;
+        Value result;
+
+        Target(): rank(0), knownInside(0), rangeNo(0), sampleRounds(0), done(false)
+        {}
+    };
+
+    shared_ptr<Array> _input;
+    AttributeID _attrID;
+    shared_ptr<Query> _query;
+    InstanceID _coordinator;
+    TypeId _typeId;
+    DoubleFloatOther _doubleFloatOther;
+    AttributeComparator _less;
+    uint64_t _round;
+
+    bool sameValue(Value const& a, Value const& b) const
+    {
+        return a.size() == b.size() && memcmp(a.data(), b.data(), a.size()) == 0;
     }
 
-    virtual ArrayDistribution getOutputDistribution(const std::vector<ArrayDistribution> & inputDistributions,
-                                                 const std::vector< ArrayDesc> & inputSchemas) const
+    bool sameRange(Range const& a, Range const& b) const
     {
-        return ArrayDistribution(psUndefined);
+        return a.hasLo == b.hasLo && a.hasHi == b.hasHi && a.collect == b.collect &&
+            (!a.hasLo || sameValue(a.lo, b.lo)) && (!a.hasHi || sameValue(a.hi, b.hi));
+    }
+
+    size_t findOrAddRange(vector<Range>& ranges, Range const& range) const
+    {
+        for (size_t i = 0; i < ranges.size(); i++) {
+            if (sameRange(ranges[i], range)) {
+                return i;
+            }
+        }
+        ranges.push_back(range);
+        return ranges.size() - 1;
     }
 
     /**
-     * We require that input is distributed round-robin so that our parallel trick works.
+     * Digest the outcome of one round for one target and set up its next proposal.
      */
-    virtual DistributionRequirement getDistributionRequirement(const std::vector<ArrayDesc> & inputSchemas) const
-    {
-        vector<ArrayDistribution> requiredDistribution;
-        requiredDistribution.push_back(ArrayDistribution(psHashPartitioned));
-        return DistributionRequirement(DistributionRequirement::SpecificAnyOrder, requiredDistribution);
+    void refine(Target& t, RangeStats& stats)
+    {
+        if (t.rank <= stats.below || t.rank > stats.below + stats.inside) {
+            // The sample misled us; go back to the range known to contain the target.
+            t.proposal = t.known;
+            t.proposal.collect = t.knownInside <= CANDIDATE_LIMIT;
+            if (!t.proposal.collect) {
+                stall(t);
+            }
+            return;
+        }
+        if (stats.inside < t.knownInside) {
+            t.sampleRounds = 0;
+        }
+        t.known = t.proposal;
+        t.known.collect = false;
+        t.knownInside = stats.inside;
+        uint64_t const local = t.rank - stats.below;
+
+        if (t.proposal.collect) {
+            assert(stats.items.size() == stats.inside);
+            std::nth_element(stats.items.begin(), stats.items.begin() + (local - 1), stats.items.end(), _less);
+            t.result = stats.items[local - 1];
+            t.done = true;
+            return;
+        }
+        if (t.known.hasLo && t.known.hasHi && !_less(t.known.lo, t.known.hi)) {
+            // Every value inside the range is equal to its bounds.
+            t.result = t.known.lo;
+            t.done = true;
+            return;
+        }
+        if (stats.inside <= CANDIDATE_LIMIT) {
+            t.proposal.collect = true;
+            return;
+        }
+
+        // Bracket the target with a margin of three standard deviations of the sample rank error.
+        vector<size_t> order(stats.items.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), IndirectLess(stats.items, _less));
+        double const margin = 1.5 * stats.inside / sqrt(static_cast<double>(stats.items.size())) + 1;
+        double const loRank = local - margin;
+        double const hiRank = local + margin;
+        double cumulative = 0;
+        Value const* atRank = NULL;
+        for (size_t i = 0; i < order.size(); i++) {
+            Value const& v = stats.items[order[i]];
+            cumulative += stats.weights[order[i]];
+            if (!atRank && cumulative >= local) {
+                atRank = &v;
+            }
+            if (cumulative <= loRank) {
+                t.proposal.lo = v;
+                t.proposal.hasLo = true;
+            }
+            if (cumulative >= hiRank) {
+                t.proposal.hi = v;
+                t.proposal.hasHi = true;
+                break;
+            }
+        }
+        if (sameRange(t.proposal, t.known)) {
+            if (atRank) {
+                // The margin spans the whole range, as when a value repeats more than CANDIDATE_LIMIT
+                // times; try the single value the sample puts at the target rank.
+                t.proposal.lo = *atRank;
+                t.proposal.hi = *atRank;
+                t.proposal.hasLo = t.proposal.hasHi = true;
+            } else {
+                // This sample cannot narrow the range down, the next round draws another one.
+                stall(t);
+            }
+        }
+    }
+
+    /**
+     * Count a round in which the range of a target stayed too large to be collected.
+     * @throw USER_EXCEPTION if it has not got any narrower for MAX_SAMPLE_ROUNDS rounds
+     */
+    void stall(Target& t) const
+    {
+        if (++t.sampleRounds >= MAX_SAMPLE_ROUNDS) {
+            std::ostringstream msg;
+            msg << "quantile() could not narrow the " << t.knownInside
+                << " values around rank " << t.rank << " down to " << CANDIDATE_LIMIT
+                << " in " << MAX_SAMPLE_ROUNDS << " rounds";
+            throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION) << msg.str();
+        }
     }
 
-    void fillQuantiles (shared_ptr<Array> rankings, shared_ptr < QuantileBucketsMap > buckets, DimensionGrouping const& grouping)
+    struct IndirectLess
     {
-        size_t qDim = _schema.getDimensions().size() -1;
-        DimensionDesc quantileDimension = _schema.getDimensions()[qDim];
+        vector<Value> const& _items;
+        AttributeComparator const& _less;
 
-        shared_ptr<ConstArrayIterator> rankArrayIterator = rankings->getConstIterator(1);
-        shared_ptr<ConstItemIterator> valueItemIterator = rankings->getItemIterator(0);
-        size_t numQuantiles = quantileDimension.getEndMax() - quantileDimension.getStartMin() + 1;
+        IndirectLess(vector<Value> const& items, AttributeComparator const& less): _items(items), _less(less)
+        {}
 
-        while(! rankArrayIterator->end() )
+        bool operator()(size_t a, size_t b) const
         {
-            boost::shared_ptr<ConstChunkIterator> rankChunkIterator = rankArrayIterator->getChunk().getConstIterator();
-            while (! rankChunkIterator->end())
-            {
-                Coordinates const& pos = rankChunkIterator->getPosition();
-                Coordinates reduced = grouping.reduceToGroup(pos);
+            return _less(_items[a], _items[b]);
+        }
+    };
 
-                if (buckets->count(reduced) != 0)    // have a bucket
-                {
-                    QuantileBucket &bucket = (*buckets)[reduced];
-                    if (bucket.values.size() == 0)  // have a brand new bucket
-                    {
-                        size_t count = bucket.indeces[0];
-                        bucket.indeces=vector<double>(numQuantiles);
-                        bucket.maxIndeces=vector<double>(numQuantiles);
-                        bucket.values=vector<Value>(numQuantiles);
-
-                        for (size_t i =0; i<numQuantiles; i++)
-                        {
-                            double index = ceil( i * 1.0 * count / (numQuantiles - 1) );
-                            index = index < 1 ? 1 : index;
-                            bucket.indeces[i] = index;
-                            bucket.maxIndeces[i] = 0;
-                        }
-                    }
+    /**
+     * Scan the local part of the attribute once for all ranges.
+     */
+    void scan(vector<Range> const& ranges, vector<RangeStats>& stats, uint64_t seed) const
+    {
+        stats.assign(ranges.size(), RangeStats());
+        uint64_t random = seed * 6364136223846793005ULL + 1442695040888963407ULL;
 
-                    Value rv = rankChunkIterator->getItem();
-                    if (!rv.isNull())
+        shared_ptr<ConstArrayIterator> arrayIterator = _input->getConstIterator(_attrID);
+        while (!arrayIterator->end())
+        {
+            shared_ptr<ConstChunkIterator> chunkIterator = arrayIterator->getChunk().getConstIterator(
+                ConstChunkIterator::IGNORE_EMPTY_CELLS | ConstChunkIterator::IGNORE_NULL_VALUES);
+            while (!chunkIterator->end())
+            {
+                Value const& v = chunkIterator->getItem();
+                if (!isNullOrNan(v, _doubleFloatOther))
+                {
+                    for (size_t i = 0; i < ranges.size(); i++)
                     {
-                        double ranking = rv.getDouble();
-                        for (size_t i =0; i<bucket.indeces.size(); i++)
-                        {
-                            if (ranking <= bucket.indeces[i] && ranking > bucket.maxIndeces[i])
-                            {
-                                valueItemIterator->setPosition(pos);
-                                bucket.values[i] = valueItemIterator->getItem();
-                                bucket.maxIndeces[i] = ranking;
+                        Range const& r = ranges[i];
+                        RangeStats& st = stats[i];
+                        if (r.hasLo && _less(v, r.lo)) {
+                            st.below++;
+                        } else if (!r.hasHi || !_less(r.hi, v)) {
+                            st.inside++;
+                            if (r.collect || st.items.size() < SAMPLE_SIZE) {
+                                st.items.push_back(v);
+                            } else {
+                                random = random * 6364136223846793005ULL + 1442695040888963407ULL;
+                                uint64_t const j = (random >> 11) % st.inside;
+                                if (j < SAMPLE_SIZE) {
+                                    st.items[j] = v;
+                                }
                             }
                         }
                     }
                 }
-                ++(*rankChunkIterator);
+                ++(*chunkIterator);
+            }
+            ++(*arrayIterator);
+        }
+        for (size_t i = 0; i < stats.size(); i++) {
+            RangeStats& st = stats[i];
+            double const weight = st.items.empty() ? 0 : static_cast<double>(st.inside) / st.items.size();
+            st.weights.assign(st.items.size(), weight);
+        }
+    }
+
+    /**
+     * Coordinator side of a round: send the ranges, scan locally, and add up the replies.
+     */
+    vector<RangeStats> exchange(vector<Range> const& ranges)
+    {
+        size_t const nInstances = _query->getInstancesCount();
+        shared_ptr<SharedBuffer> request = encodeRanges(ranges, false);
+        for (InstanceID i = 0; i < nInstances; i++) {
+            if (i != _coordinator) {
+                BufSend(i, request, _query);
+            }
+        }
+        vector<RangeStats> total;
+        scan(ranges, total, (_round++ << 16) + _coordinator);
+        for (InstanceID i = 0; i < nInstances; i++) {
+            if (i != _coordinator) {
+                vector<RangeStats> stats;
+                decodeStats(BufReceive(i, _query), stats);
+                for (size_t r = 0; r < total.size(); r++) {
+                    total[r].below += stats[r].below;
+                    total[r].inside += stats[r].inside;
+                    total[r].items.insert(total[r].items.end(), stats[r].items.begin(), stats[r].items.end());
+                    total[r].weights.insert(total[r].weights.end(), stats[r].weights.begin(), stats[r].weights.end());
+                }
             }
-           ++(*rankArrayIterator);
         }
+        return total;
+    }
+
+    void finish()
+    {
+        shared_ptr<SharedBuffer> request = encodeRanges(vector<Range>(), true);
+        for (InstanceID i = 0, n = _query->getInstancesCount(); i < n; i++) {
+            if (i != _coordinator) {
+                BufSend(i, request, _query);
+            }
+        }
+    }
+
+    /**
+     * Worker side: answer the coordinator's rounds until it is done.
+     */
+    void serve()
+    {
+        for (uint64_t round = 0; ; round++) {
+            vector<Range> ranges;
+            if (!decodeRanges(BufReceive(_coordinator, _query), ranges)) {
+                return;
+            }
+            vector<RangeStats> stats;
+            scan(ranges, stats, (round << 16) + _query->getInstanceID());
+            BufSend(_coordinator, encodeStats(stats), _query);
+        }
+    }
+
+    // Message encoding: fixed-size fields in native byte order, values as a size and the bytes.
+
+    static void put(vector<char>& buf, void const* data, size_t size)
+    {
+        buf.insert(buf.end(), static_cast<char const*>(data), static_cast<char const*>(data) + size);
+    }
+
+    static void putUint64(vector<char>& buf, uint64_t v)
+    {
+        put(buf, &v, sizeof(v));
+    }
+
+    static void putValue(vector<char>& buf, Value const& v)
+    {
+        putUint64(buf, v.size());
+        put(buf, v.data(), v.size());
+    }
+
+    static uint64_t getUint64(char const*& src)
+    {
+        uint64_t v;
+        memcpy(&v, src, sizeof(v));
+        src += sizeof(v);
+        return v;
+    }
+
+    static void getValue(char const*& src, Value& v)
+    {
+        size_t const size = getUint64(src);
+        v.setData(src, size);
+        src += size;
+    }
+
+    static shared_ptr<SharedBuffer> toBuffer(vector<char> const& buf)
+    {
+        return shared_ptr<SharedBuffer>(new MemoryBuffer(buf.empty() ? NULL : &buf[0], buf.size()));
+    }
+
+    static shared_ptr<SharedBuffer> encodeRanges(vector<Range> const& ranges, bool stop)
+    {
+        vector<char> buf;
+        putUint64(buf, stop);
+        putUint64(buf, ranges.size());
+        for (size_t i = 0; i < ranges.size(); i++) {
+            Range const& r = ranges[i];
+            putUint64(buf, r.hasLo | (r.hasHi << 1) | (r.collect << 2));
+            if (r.hasLo) {
+                putValue(buf, r.lo);
+            }
+            if (r.hasHi) {
+                putValue(buf, r.hi);
+            }
+        }
+        return toBuffer(buf);
+    }
+
+    /**
+     * @return false if the coordinator asks to stop
+     */
+    static bool decodeRanges(shared_ptr<SharedBuffer> const& msg, vector<Range>& ranges)
+    {
+        char const* src = static_cast<char const*>(msg->getData());
+        if (getUint64(src)) {
+            return false;
+        }
+        ranges.resize(getUint64(src));
+        for (size_t i = 0; i < ranges.size(); i++) {
+            Range& r = ranges[i];
+            uint64_t const flags = getUint64(src);
+            r.hasLo = flags & 1;
+            r.hasHi = flags & 2;
+            r.collect = flags & 4;
+            if (r.hasLo) {
+                getValue(src, r.lo);
+            }
+            if (r.hasHi) {
+                getValue(src, r.hi);
+            }
+        }
+        return true;
+    }
+
+    static shared_ptr<SharedBuffer> encodeStats(vector<RangeStats> const& stats)
+    {
+        vector<char> buf;
+        putUint64(buf, stats.size());
+        for (size_t i = 0; i < stats.size(); i++) {
+            RangeStats const& st = stats[i];
+            putUint64(buf, st.below);
+            putUint64(buf, st.inside);
+            putUint64(buf, st.items.size());
+            for (size_t j = 0; j < st.items.size(); j++) {
+                putValue(buf, st.items[j]);
+            }
+        }
+        return toBuffer(buf);
+    }
+
+    static void decodeStats(shared_ptr<SharedBuffer> const& msg, vector<RangeStats>& stats)
+    {
+        char const* src = static_cast<char const*>(msg->getData());
+        stats.resize(getUint64(src));
+        for (size_t i = 0; i < stats.size(); i++) {
+            RangeStats& st = stats[i];
+            st.below = getUint64(src);
+            st.inside = getUint64(src);
+            st.items.resize(getUint64(src));
+            for (size_t j = 0; j < st.items.size(); j++) {
+                getValue(src, st.items[j]);
+            }
+            double const weight = st.items.empty() ? 0 : static_cast<double>(st.inside) / st.items.size();
+            st.weights.assign(st.items.size(), weight);
+        }
+    }
+};
+
+/**
+ * PhysicalQuantile.
+ */
+class PhysicalQuantile: public PhysicalOperator
+{
+  public:
+    static bool isMemoryHungry()
+    {
+        return true;
+    }
+
+    PhysicalQuantile(const std::string& logicalName, const std::string& physicalName, const Parameters& parameters, const ArrayDesc& schema):
+        PhysicalOperator(logicalName, physicalName, parameters, schema)
+    {
+    }
+
+    virtual bool changesDistribution(std::vector<ArrayDesc> const&) const
+    {
+        return true;
+    }
+
+    virtual ArrayDistribution getOutputDistribution(const std::vector<ArrayDistribution> & inputDistributions,
+                                                 const std::vector< ArrayDesc> & inputSchemas) const
+    {
+        return ArrayDistribution(psUndefined);
     }
 
   public:
@@ -1240,88 +1686,33 @@ class PhysicalQuantile: public PhysicalOperator
             psdGroupby._arrIsGroupbyDim.push_back(isGroupbyDim);
         }
 
-        // If this is not a groupby quantile, use the original code.
+        // If this is not a groupby quantile, select the quantiles across the instances.
         if (groupBy.size()==0) {
-            // timing
-            LOG4CXX_DEBUG(logger, "[Quantile] Using the original algorithm, because this is not a group-by quantile.");
+            LOG4CXX_DEBUG(logger, "[Quantile] Using distributed selection, because this is not a group-by quantile.");
 
-            shared_ptr<DimensionGrouping> grouping ( new DimensionGrouping(inputArray->getArrayDesc().getDimensions(), groupBy));
-            shared_ptr<RankingStats> rStats (new RankingStats());
-            shared_ptr<Array> rankArray(buildRankArray(inputArray, rankedAttributeID, groupBy, query, rStats));
+            size_t qDim = _schema.getDimensions().size() -1;
+            DimensionDesc quantileDimension = _schema.getDimensions()[qDim];
+            size_t numQuantiles = quantileDimension.getEndMax() - quantileDimension.getStartMin() + 1;
 
-            size_t nInstances = query->getInstancesCount();
-            InstanceID myInstance = query->getInstanceID();
+            shared_ptr<DimensionGrouping> grouping ( new DimensionGrouping(inputArray->getArrayDesc().getDimensions(), groupBy));
+            Coordinates chunkCoords = grouping->reduceToGroup(Coordinates());
+            InstanceID coordinator = getInstanceForChunk(query, chunkCoords, _schema, psHashPartitioned, shared_ptr<DistributionMapper> (), 0, 0);
 
-            if (nInstances > 1)
-            {
-                rankArray = redistribute(rankArray,query,psHashPartitioned,"", -1, boost::shared_ptr<DistributionMapper>(), 0);
-            }
-            else
-            {
-                //we don't need to redistribute the rank array but we still need to pass over it to collect max rankings
-                shared_ptr<ConstArrayIterator> aiter = rankArray->getConstIterator(1);
-                while (!aiter->end())
-                {
-                    shared_ptr<ConstChunkIterator> citer = aiter->getChunk().getConstIterator();
-                    while(!citer->end())
-                    {
-                        citer->getItem();
-                        ++(*citer);
-                    }
-                    ++(*aiter);
-                }
-            }
-            LOG4CXX_DEBUG(logger, "Created prerank array");
+            QuantileSelector selector(inputArray, rankedAttributeID, query, coordinator);
+            vector<Value> quantiles = selector.select(numQuantiles);
 
             shared_ptr <QuantileBucketsMap> buckets(new QuantileBucketsMap);
             shared_ptr <set<size_t> > liveChunks(new set<size_t>);
-
-            BOOST_FOREACH (CountsMap::value_type bucket, rStats->counts)
-            {
-                Coordinates const& pos = bucket.first;
-                double count = bucket.second;
-
-                if (pos.size())
-                {
-                    LOG4CXX_DEBUG(logger, "Bucket " << pos[0] << " count " << count);
-                }
-                else
-                {
-                    LOG4CXX_DEBUG(logger, "Bucket 0 maxRanking " << count);
-                }
-
-                Coordinates chunkCoords = pos;
-                if (pos.size() > 1)
-                {
-                    chunkCoords.push_back(0);
-                }
-
-                InstanceID instanceForChunk = getInstanceForChunk(query, chunkCoords, _schema, psHashPartitioned, shared_ptr<DistributionMapper> (), 0, 0);
-                if(instanceForChunk == myInstance)
-                {
-                    LOG4CXX_DEBUG(logger, "Initializing bucket with "<<chunkCoords.size()<<" coords; count "<<count);
-                    (*buckets)[chunkCoords].indeces.push_back(count);
-                    (*buckets)[chunkCoords].maxIndeces = vector<double> ();
-                    (*buckets)[chunkCoords].values = vector<Value> ();
-
-                    size_t chunkNo = _schema.getHashedChunkNumber(chunkCoords);
-                    liveChunks->insert(chunkNo);
-                }
-            }
-            rStats.reset();
-
-            fillQuantiles(rankArray, buckets, *grouping);
-            for(size_t i =1 ; i < nInstances ; i++)
+            if (!quantiles.empty())
             {
-                rankArray = redistribute(rankArray,query,psHashPartitioned,"", -1, boost::shared_ptr<DistributionMapper>(), i);
-                fillQuantiles(rankArray, buckets, *grouping);
+                (*buckets)[chunkCoords].values = quantiles;
+                liveChunks->insert(_schema.getHashedChunkNumber(chunkCoords));
             }
-            rankArray.reset();
 
             shared_ptr<Array> result = shared_ptr<Array>(new QuantileArray( _schema, buckets, grouping, liveChunks));
 
             // timing
-            timing.logTiming(logger, "[Quantile] original algorithm", false); // false = no restart
+            timing.logTiming(logger, "[Quantile] distributed selection", false); // false = no restart
             LOG4CXX_DEBUG(logger, "[Quantile] finished!")
 
             return result;
@@ -66,6 +66,11 @@ class PhysicalRank: public PhysicalOperator
     typedef RowIterator<size_t> RIChunk;
 
 public:
+    static bool isMemoryHungry()
+    {
+        return true;
+    }
+
     PhysicalRank(const std::string& logicalName, const std::string& physicalName, const Parameters& parameters, const ArrayDesc& schema):
         PhysicalOperator(logicalName, physicalName, parameters, schema)
     {
@@ -44,6 +44,11 @@ using namespace boost;
 class PhysicalRedimension: public RedimensionCommon
 {
 public:
+    static bool isMemoryHungry()
+    {
+        return true;
+    }
+
     /**
      * Vanilla.
      * @param logicalName the name of operator "redimension"
@@ -19,8 +19,10 @@
 *
 * END_COPYRIGHT
 */
+#include <functional>
+#include <queue>
+
 #include "RedimensionCommon.h"
-#include <array/SortArray.h>
 #include <system/Config.h>
 
 namespace scidb
@@ -154,6 +156,7 @@ shared_ptr<MemArray> RedimensionCommon::initializeRedimensionedArray(
     Attributes const& destAttrs,
     vector<size_t> const& attrMapping,
     vector<AggregatePtr> const& aggregates,
+    bool collapse,
     vector< shared_ptr<ArrayIterator> >& redimArrayIters,
     vector< shared_ptr<ChunkIterator> >& redimChunkIters,
     size_t& redimCount,
@@ -169,14 +172,15 @@ shared_ptr<MemArray> RedimensionCommon::initializeRedimensionedArray(
     //    (a) An aggregate field's type is replaced with the source field type, but still uses the name of the dest attribute.
     //        The motivation is that multiple dest aggregate attribute may come from the same source attribute,
     //        in which case storing under the source attribute name would cause a conflict.
+    //        When the records of a cell are collapsed, the field holds the aggregate state instead, and has its type.
     //    (b) Two additional attributes are appended to the end:
     //        (1) 'tmpDestChunkPosition', that stores the location of the item in the dest chunk
     //        (2) 'tmpDestChunkId', that stores the id of the destination chunk
     //
     // The data is derived from the inputarray as follows.
     //    (a) They are "redimensioned".
-    //    (b) Each record is stored as a distinct record in the MemArray. For an aggregate field, no aggregation is performed;
-    //        For a synthetic dimension, just use dimStartSynthetic.
+    //    (b) Each record is stored as a distinct record in the MemArray. For an aggregate field, no aggregation is performed,
+    //        unless the records of a cell are collapsed; For a synthetic dimension, just use dimStartSynthetic.
     //
     // Local aggregation will be performed at a later step, when generating the MemArray called 'beforeRedistribute'.
     // Global aggregation will be performed at the redistributeAggregate() step.
@@ -192,7 +196,13 @@ shared_ptr<MemArray> RedimensionCommon::initializeRedimensionedArray(
         // An optimization is possible in this special case, to only store the source attribute once.
         // But some unintuitive bookkeeping would be needed.
         // We decide to skip the optimization at least for now.
-        if (aggregates[i]) {
+        if (aggregates[i] && collapse) {
+            attrsRedimensioned.push_back(AttributeDesc(i,
+                                                       destAttrs[i].getName(),
+                                                       aggregates[i]->getStateType().typeId(),
+                                                       destAttrs[i].getFlags(),
+                                                       destAttrs[i].getDefaultCompressionMethod()));
+        } else if (aggregates[i]) {
             AttributeDesc const& srcAttrForAggr = srcAttrs[ attrMapping[i] ];
             attrsRedimensioned.push_back(AttributeDesc(i,
                                                        destAttrs[i].getName(),
@@ -278,128 +288,277 @@ void RedimensionCommon::appendItemToRedimArray(vector<Value> const& item,
 }
 
 
-bool RedimensionCommon::updateSyntheticDimForRedimArray(shared_ptr<Query> const& query,
-                                                        ArrayCoordinatesMapper const& coordMapper,
-                                                        ChunkIdMaps& chunkIdMaps,
-                                                        size_t dimSynthetic,
-                                                        shared_ptr<MemArray>& redimensioned)
+void RedimensionCommon::flushRedimArray(vector< shared_ptr<ChunkIterator> >& redimChunkIters,
+                                        size_t& redimCount,
+                                        size_t const& redimChunkSize)
 {
-    // If there is a synthetic dimension, and if there are duplicates, modify the values
-    // (so that the duplicates get distinct coordinates in the synthetic dimension).
-    //
-
-    queue< pair<position_t, position_t> > updates;
-    bool needsResort = false;
-    size_t currChunkId;
-    size_t nextChunkId;
-    position_t prevPosition;
-    position_t currPosition;
-    Coordinates currPosCoord(coordMapper.getDims().size());
-    size_t chunkIdAttr = redimensioned->getArrayDesc().getAttributes(true).size() - 1;
-    size_t posAttr = chunkIdAttr - 1;
-    shared_ptr<ConstArrayIterator> arrayChunkIdIter = redimensioned->getConstIterator(chunkIdAttr);
-    shared_ptr<ArrayIterator> arrayPosIter = redimensioned->getIterator(posAttr);
-    SCIDB_ASSERT(!arrayChunkIdIter->end());
-    SCIDB_ASSERT(!arrayPosIter->end());
-    shared_ptr<ConstChunkIterator> chunkChunkIdIter = arrayChunkIdIter->getChunk().getConstIterator();
-    shared_ptr<ConstChunkIterator> chunkPosReadIter = arrayPosIter->getChunk().getConstIterator();
-    shared_ptr<ChunkIterator> chunkPosWriteIter;
-    Coordinates lows(coordMapper.getDims().size()), intervals(coordMapper.getDims().size());
-
-    // initialize the previous position value, current chunk id, and lows and intervals
-    prevPosition = chunkPosReadIter->getItem().getInt64();
-    currChunkId = chunkChunkIdIter->getItem().getInt64();
-    coordMapper.chunkPos2LowsAndIntervals(mapIdToChunkPos(currChunkId, chunkIdMaps),
-                                          lows,
-                                          intervals);
-    coordMapper.pos2coordWithLowsAndIntervals(lows, intervals, prevPosition, currPosCoord);
-    ++(*chunkPosReadIter);
-    ++(*chunkChunkIdIter);
-
-    // scan array from beginning to end
-    while (!arrayChunkIdIter->end())
+    // Flush the partially filled chunks and skip the rest of their rows,
+    // so that the next append starts a new chunk.
+    if (redimCount % redimChunkSize != 0)
     {
-        while (!chunkChunkIdIter->end())
+        for (size_t i = 0; i < redimChunkIters.size(); ++i)
         {
-            // Are we processing a new output chunk id?
-            nextChunkId = chunkChunkIdIter->getItem().getInt64();
-            if (nextChunkId != currChunkId)
-            {
-                prevPosition = chunkPosReadIter->getItem().getInt64();
-                currChunkId = nextChunkId;
-                coordMapper.chunkPos2LowsAndIntervals(mapIdToChunkPos(currChunkId, chunkIdMaps),
-                                                      lows,
-                                                      intervals);
-                coordMapper.pos2coordWithLowsAndIntervals(lows, intervals, prevPosition, currPosCoord);
-                goto nextitem;
-            }
+            redimChunkIters[i]->flush();
+            redimChunkIters[i].reset();
+        }
+        redimCount += redimChunkSize - redimCount % redimChunkSize;
+    }
+}
 
-            // Are we processing a run of identical positions?
-            currPosition = chunkPosReadIter->getItem().getInt64();
-            if (currPosition == prevPosition)
+
+void RedimensionCommon::appendItemToPartition(ChunkPartition& partition,
+                                              position_t pos,
+                                              vector<Value> const& item,
+                                              vector<AggregatePtr> const& aggregates,
+                                              bool collapse,
+                                              size_t& memUsage)
+{
+    size_t const nAttrs = item.size();
+    if (collapse)
+    {
+        // Accumulate into the record of the cell, if it has one already
+        pair<ChunkPartition::CellIndex::iterator, bool> cell =
+            partition.cells.insert(make_pair(pos, partition.positions.size()));
+        if (!cell.second)
+        {
+            Value* state = &partition.values[cell.first->second * nAttrs];
+            for (size_t i = 0; i < nAttrs; ++i)
             {
-                // found a duplicate --- add an update to the list
-                pair<position_t, position_t> pu;
-
-                currPosCoord[dimSynthetic]++;
-                pu.first = chunkPosReadIter->getPosition()[0];
-                pu.second = coordMapper.coord2posWithLowsAndIntervals(lows,
-                                                                      intervals,
-                                                                      currPosCoord);
-                updates.push(pu);
-
-                // make sure the number of duplicates is less than chunk interval (for the synthetic dim)
-                if ((currPosCoord[dimSynthetic] - lows[dimSynthetic]) >=
-                    intervals[dimSynthetic])
+                if (aggregates[i])
                 {
-                    throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_OP_REDIMENSION_STORE_ERROR7);
+                    aggregates[i]->tryAccumulate(state[i], item[i]);
                 }
             }
-            else
+            return;
+        }
+        memUsage += sizeof(position_t) + sizeof(size_t) + 2*sizeof(void*);
+    }
+
+    partition.positions.push_back(pos);
+    memUsage += sizeof(position_t);
+    for (size_t i = 0; i < nAttrs; ++i)
+    {
+        if (collapse && aggregates[i])
+        {
+            partition.values.push_back(Value());
+            Value& state = partition.values.back();
+            aggregates[i]->initializeState(state);
+            aggregates[i]->tryAccumulate(state, item[i]);
+            memUsage += sizeof(Value) + (state.size() > sizeof(int64_t) ? state.size() : 0);
+        }
+        else
+        {
+            partition.values.push_back(item[i]);
+            memUsage += sizeof(Value) + (item[i].size() > sizeof(int64_t) ? item[i].size() : 0);
+        }
+    }
+}
+
+
+void RedimensionCommon::spillPartitions(ChunkPartitions& partitions,
+                                        ChunkIdMaps& chunkIdMaps,
+                                        size_t nAttrs,
+                                        shared_ptr<Query> const& query,
+                                        vector< shared_ptr<ArrayIterator> >& redimArrayIters,
+                                        vector< shared_ptr<ChunkIterator> >& redimChunkIters,
+                                        size_t& redimCount,
+                                        size_t const& redimChunkSize)
+{
+    // Move the in-memory records of every partition to the 'redimensioned' array.
+    // The records of a partition are appended as one run of rows sorted by position, after the runs of
+    // earlier spills. Ties keep the input order, so PartitionReader can merge the runs without
+    // changing the order of the records of a cell.
+    vector<Value> item(nAttrs+2);
+    vector< pair<position_t, size_t> > order;
+    for (ChunkPartitions::iterator it = partitions.begin(); it != partitions.end(); ++it)
+    {
+        ChunkPartition& partition = it->second;
+        size_t const nRecords = partition.positions.size();
+        if (nRecords == 0)
+        {
+            continue;
+        }
+        order.resize(nRecords);
+        for (size_t r = 0; r < nRecords; ++r)
+        {
+            order[r] = make_pair(partition.positions[r], r);
+        }
+        sort(order.begin(), order.end());
+
+        partition.spilledRuns.push_back(make_pair(redimCount, nRecords));
+        item[nAttrs+1].setInt64(mapChunkPosToId(it->first, chunkIdMaps));
+        for (size_t k = 0; k < nRecords; ++k)
+        {
+            size_t const r = order[k].second;
+            for (size_t i = 0; i < nAttrs; ++i)
             {
-                prevPosition = currPosition;
-                coordMapper.pos2coordWithLowsAndIntervals(lows, intervals, currPosition, currPosCoord);
+                item[i] = partition.values[r*nAttrs + i];
             }
+            item[nAttrs].setInt64(order[k].first);
+            appendItemToRedimArray(item, query, redimArrayIters, redimChunkIters, redimCount, redimChunkSize);
+        }
+        vector<position_t>().swap(partition.positions);
+        vector<Value>().swap(partition.values);
+        ChunkPartition::CellIndex().swap(partition.cells);
+    }
+    flushRedimArray(redimChunkIters, redimCount, redimChunkSize);
+}
 
-        nextitem:
-            ++(*chunkPosReadIter);
-            ++(*chunkChunkIdIter);
+
+class RedimensionCommon::PartitionReader
+{
+public:
+    PartitionReader(ChunkPartition const& partition,
+                    shared_ptr<MemArray> const& redimensioned,
+                    size_t nAttrs)
+    : _partition(partition),
+      _nAttrs(nAttrs),
+      _redimChunkSize(0),
+      _runs(partition.spilledRuns.size()),
+      _next(0)
+    {
+        // The in-memory records came after all the spilled runs
+        size_t const nRecords = partition.positions.size();
+        _order.resize(nRecords);
+        for (size_t r = 0; r < nRecords; ++r)
+        {
+            _order[r] = make_pair(partition.positions[r], r);
+        }
+        sort(_order.begin(), _order.end());
+        if (nRecords != 0)
+        {
+            _heads.push(Head(_order[0].first, _runs.size()));
         }
 
-        // At the end of a chunk, process any updates we have accumulated...
-        if (updates.size() > 0)
+        if (!_runs.empty())
         {
-            chunkPosWriteIter = arrayPosIter->updateChunk().getIterator(query,
-                                                                        ChunkIterator::APPEND_CHUNK |
-                                                                        ChunkIterator::NO_EMPTY_CHECK);
-            while (updates.size() > 0)
+            _redimChunkSize = redimensioned->getArrayDesc().getDimensions()[0].getChunkInterval();
+        }
+        for (size_t k = 0; k < _runs.size(); ++k)
+        {
+            Run& run = _runs[k];
+            run.row = partition.spilledRuns[k].first;
+            run.end = run.row + partition.spilledRuns[k].second;
+            run.arrayIters.resize(nAttrs+1);
+            run.chunkIters.resize(nAttrs+1);
+            for (size_t i = 0; i <= nAttrs; ++i)
             {
-                Coordinates updatePos(1);
-                Value updateVal;
+                run.arrayIters[i] = redimensioned->getConstIterator(i);
+            }
+            seek(run);
+            _heads.push(Head(getPosition(run), k));
+        }
+    }
 
-                updatePos[0] = updates.front().first;
-                updateVal.setInt64(updates.front().second);
-                chunkPosWriteIter->setPosition(updatePos);
-                chunkPosWriteIter->writeItem(updateVal);
+    bool end() const
+    {
+        return _heads.empty();
+    }
+
+    /// @return the position in the chunk of the current record
+    position_t getPosition() const
+    {
+        return _heads.top().first;
+    }
 
-                updates.pop();
+    /// @param[out] item the values of the current record
+    void getItem(vector<Value>& item) const
+    {
+        size_t const source = _heads.top().second;
+        if (source == _runs.size())
+        {
+            Value const* values = &_partition.values[_order[_next].second * _nAttrs];
+            for (size_t i = 0; i < _nAttrs; ++i)
+            {
+                item[i] = values[i];
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < _nAttrs; ++i)
+            {
+                item[i] = _runs[source].chunkIters[i]->getItem();
             }
-            chunkPosWriteIter->flush();
-            chunkPosWriteIter.reset();
         }
+    }
 
-        // Goto next chunk
-        ++(*arrayPosIter);
-        ++(*arrayChunkIdIter);
-        if (!arrayChunkIdIter->end())
+    void operator ++()
+    {
+        size_t const source = _heads.top().second;
+        _heads.pop();
+        if (source == _runs.size())
+        {
+            if (++_next < _order.size())
+            {
+                _heads.push(Head(_order[_next].first, source));
+            }
+            return;
+        }
+        Run& run = _runs[source];
+        if (++run.row == run.end)
+        {
+            // unpin its chunks
+            run.chunkIters.clear();
+            run.arrayIters.clear();
+            return;
+        }
+        if (run.row % _redimChunkSize == 0)
+        {
+            seek(run);
+        }
+        else
         {
-            chunkChunkIdIter = arrayChunkIdIter->getChunk().getConstIterator();
-            chunkPosReadIter = arrayPosIter->getChunk().getConstIterator();
+            for (size_t i = 0; i <= _nAttrs; ++i)
+            {
+                ++(*run.chunkIters[i]);
+            }
         }
+        _heads.push(Head(getPosition(run), source));
     }
 
-    return needsResort;
-}
+private:
+    /// a run of rows of the 'redimensioned' array, read in order
+    struct Run
+    {
+        size_t row;
+        size_t end;
+        vector< shared_ptr<ConstArrayIterator> > arrayIters;
+        vector< shared_ptr<ConstChunkIterator> > chunkIters;
+    };
+
+    /// the position of the next record of a source, and the source: a run, or the in-memory records after the runs
+    typedef pair<position_t, size_t> Head;
+
+    void seek(Run& run)
+    {
+        Coordinates row(1, run.row);
+        for (size_t i = 0; i <= _nAttrs; ++i)
+        {
+            if (!run.arrayIters[i]->setPosition(row))
+            {
+                throw SYSTEM_EXCEPTION(SCIDB_SE_INTERNAL, SCIDB_LE_OPERATION_FAILED) << "setPosition";
+            }
+            run.chunkIters[i] = run.arrayIters[i]->getChunk().getConstIterator();
+            if (!run.chunkIters[i]->setPosition(row))
+            {
+                throw SYSTEM_EXCEPTION(SCIDB_SE_INTERNAL, SCIDB_LE_OPERATION_FAILED) << "setPosition";
+            }
+        }
+    }
+
+    position_t getPosition(Run const& run) const
+    {
+        return run.chunkIters[_nAttrs]->getItem().getInt64();
+    }
+
+    ChunkPartition const& _partition;
+    size_t const _nAttrs;
+    size_t _redimChunkSize;
+    vector<Run> _runs;
+    vector< pair<position_t, size_t> > _order;  // the in-memory records, by position then input order
+    size_t _next;                                // next in-memory record, in _order
+    priority_queue<Head, vector<Head>, greater<Head> > _heads;
+};
 
 
 void RedimensionCommon::appendItemToBeforeRedistribution(ArrayCoordinatesMapper const& coordMapper,
@@ -476,7 +635,18 @@ shared_ptr<Array> RedimensionCommon::redimensionArray(shared_ptr<Array> const& s
         }
     }
 
-    // Initialize 'redimensioned' array
+    // The records are scattered into one partition per destination chunk, rather than written to a single
+    // array and sorted by (chunk, position). Each partition is sorted on its own when its chunk is written.
+    // When the partitions outgrow the merge-sort buffer (or what is left of the query's memory budget), their records are
+    // moved to a 1-D MemArray called 'redimensioned' (which may be swapped out) as sorted runs, and the runs of a partition
+    // are merged when its chunk is written, so that no partition needs to fit into memory.
+    // With aggregates and no synthetic dimension, the records of a cell are collapsed into one as they arrive,
+    // so that a skewed input takes the memory of its distinct cells rather than of its records.
+    ChunkPartitions partitions;
+    bool const collapse = hasAggregate && !hasSynthetic;
+    size_t memUsage = 0;
+    size_t const memLimit = query->getSpillThreshold(Config::getInstance()->getOption<int>(CONFIG_MERGE_SORT_BUFFER)*MiB);
+
     shared_ptr<MemArray> redimensioned;
     vector< shared_ptr<ArrayIterator> > redimArrayIters;
     vector< shared_ptr<ChunkIterator> > redimChunkIters;
@@ -489,20 +659,11 @@ shared_ptr<Array> RedimensionCommon::redimensionArray(shared_ptr<Array> const& s
     if (redimChunkSize < redimMinChunkSize)
         redimChunkSize = redimMinChunkSize;
 
-    redimensioned = initializeRedimensionedArray(query,
-                                                 srcAttrs,
-                                                 destAttrs,
-                                                 attrMapping,
-                                                 aggregates,
-                                                 redimArrayIters,
-                                                 redimChunkIters,
-                                                 redimCount,
-                                                 redimChunkSize);
-
-    // Iterate through the input array, generate the output data, and append to the MemArray.
+    // Iterate through the input array, generate the output records, and scatter them into the partitions
+    // of their destination chunks.
     // Note: For an aggregate field, its source value (in the input array) is used.
     // Note: The synthetic dimension is not handled here. That is, multiple records, that will be differentiated along the synthetic dimension,
-    //       are all appended to the 'redimensioned' array with the same 'position'.
+    //       are all added to the partition with the same 'position'.
     //
     size_t iterAttr = 0;    // one of the attributes from the input array that needs to be iterated
 
@@ -538,6 +699,7 @@ shared_ptr<Array> RedimensionCommon::redimensionArray(shared_ptr<Array> const& s
     // Start scanning the input
     ArrayCoordinatesMapper arrayCoordinatesMapper(destDims);
     ChunkIdMaps arrayChunkIdMaps;
+    vector<Value> valuesInRedimArray(destAttrs.size());
 
     while (!srcArrayIterators[iterAttr]->end())
     {
@@ -550,12 +712,13 @@ shared_ptr<Array> RedimensionCommon::redimensionArray(shared_ptr<Array> const& s
 
         // Initialize the dest
         Coordinates chunkPos;
+        Coordinates partitionPos;
+        ChunkPartition* partition = NULL;
 
         // Loop through the chunks content
         while (!srcChunkIterators[iterAttr]->end()) {
             Coordinates const& srcPos = srcChunkIterators[iterAttr]->getPosition();
             Coordinates destPos(destDims.size());
-            vector<Value> valuesInRedimArray(destAttrs.size()+2);
 
             // Get the destPos for this item -- for the SYNTHETIC dim, use the same value (dimStartSynthetic) for all.
             for (size_t i = 0; i < destDims.size(); i++) {
@@ -582,7 +745,7 @@ shared_ptr<Array> RedimensionCommon::redimensionArray(shared_ptr<Array> const& s
             chunkPos = destPos;
             _schema.getChunkPositionFor(chunkPos);
 
-            // Build data (except the last two fields, i.e. position/chunkid) to be written
+            // Build data to be written
             for (size_t i = 0; i < destAttrs.size(); i++) {
                 size_t j = attrMapping[i];
                 if ( isFlipped(j) ) { // if flipped from a dim
@@ -592,36 +755,50 @@ shared_ptr<Array> RedimensionCommon::redimensionArray(shared_ptr<Array> const& s
                 }
             }
 
-            // Set the last two fields of the data, and append to the redimensioned array
+            // Add the record to the partition of every chunk it belongs to
             if (hasOverlap) {
                 OverlappingChunksIterator allChunks(destDims, destPos);
                 while (!allChunks.end()) {
                     Coordinates const& overlappingChunkPos = allChunks.getPosition();
                     position_t pos = arrayCoordinatesMapper.coord2pos(overlappingChunkPos, destPos);
-                    valuesInRedimArray[destAttrs.size()].setInt64(pos);
-                    position_t chunkId = mapChunkPosToId(overlappingChunkPos, arrayChunkIdMaps);
-                    valuesInRedimArray[destAttrs.size()+1].setInt64(chunkId);
-                    appendItemToRedimArray(valuesInRedimArray,
-                                           query,
-                                           redimArrayIters,
-                                           redimChunkIters,
-                                           redimCount,
-                                           redimChunkSize);
+                    appendItemToPartition(partitions[overlappingChunkPos], pos, valuesInRedimArray,
+                                          aggregates, collapse, memUsage);
 
                     // Must increment after overlappingChunkPos is no longer needed, because the increment will modify overlappingChunkPos.
                     ++allChunks;
                 }
             } else {
+                // Consecutive input cells tend to go to the same chunk; skip the map lookup for them.
+                if (partition == NULL || chunkPos != partitionPos) {
+                    partition = &partitions[chunkPos];
+                    partitionPos = chunkPos;
+                }
                 position_t pos = arrayCoordinatesMapper.coord2pos(chunkPos, destPos);
-                valuesInRedimArray[destAttrs.size()].setInt64(pos);
-                position_t chunkId = mapChunkPosToId(chunkPos, arrayChunkIdMaps);
-                valuesInRedimArray[destAttrs.size()+1].setInt64(chunkId);
-                appendItemToRedimArray(valuesInRedimArray,
-                                       query,
-                                       redimArrayIters,
-                                       redimChunkIters,
-                                       redimCount,
-                                       redimChunkSize);
+                appendItemToPartition(*partition, pos, valuesInRedimArray, aggregates, collapse, memUsage);
+            }
+
+            if (memUsage > memLimit) {
+                if (!redimensioned) {
+                    redimensioned = initializeRedimensionedArray(query,
+                                                                 srcAttrs,
+                                                                 destAttrs,
+                                                                 attrMapping,
+                                                                 aggregates,
+                                                                 collapse,
+                                                                 redimArrayIters,
+                                                                 redimChunkIters,
+                                                                 redimCount,
+                                                                 redimChunkSize);
+                }
+                spillPartitions(partitions,
+                                arrayChunkIdMaps,
+                                destAttrs.size(),
+                                query,
+                                redimArrayIters,
+                                redimChunkIters,
+                                redimCount,
+                                redimChunkSize);
+                memUsage = 0;
             }
 
             // Advance chunk iterators
@@ -642,69 +819,12 @@ shared_ptr<Array> RedimensionCommon::redimensionArray(shared_ptr<Array> const& s
         }
     } // while
 
-    // If there are leftover values, flush the output iters one last time
-    if (redimCount % redimChunkSize != 0)
-    {
-        for (size_t i = 0; i < redimChunkIters.size(); ++i)
-        {
-            redimChunkIters[i]->flush();
-            redimChunkIters[i].reset();
-        }
-    }
     for (size_t i = 0; i < redimArrayIters.size(); ++i)
     {
         redimArrayIters[i].reset();
     }
 
-    timing.logTiming(logger, "[RedimStore] inputArray --> redimensioned");
-
-    // LOG4CXX_DEBUG(logger, "[RedimStore] redimensioned values: ");
-    // redimensioned->printArrayToLogger();
-
-    // Sort the redimensioned array based on the chunkid, followed by the position in the chunk
-    //
-    vector<Key> keys(2);
-    Key k;
-    k.columnNo = destAttrs.size() + 1;
-    k.ascent = true;
-    keys[0] = k;
-    k.columnNo = destAttrs.size();
-    k.ascent = true;
-    keys[1] = k;
-
-    SortArray sorter(redimensioned->getArrayDesc());
-    shared_ptr<TupleComparator> tcomp(new TupleComparator(keys, redimensioned->getArrayDesc()));
-    if (redimCount)
-    {
-        shared_ptr<MemArray> sortedRedimensioned = sorter.getSortedArray(redimensioned, query, tcomp);
-        redimensioned = sortedRedimensioned;
-    }
-
-    timing.logTiming(logger, "[RedimStore] redimensioned sorted");
-
-    // LOG4CXX_DEBUG(logger, "[RedimStore] redimensioned sorted values: ");
-    // redimensioned->printArrayToLogger();
-
-    // If hasSynthetic, each record with the same position get assigned a distinct value in the synthetic dimension, effectively
-    // assigning a distinct position to every record.  After updating the redimensioned array, it will need to be re-sorted.
-    //
-    if (hasSynthetic && redimCount)
-    {
-        if (updateSyntheticDimForRedimArray(query,
-                                            arrayCoordinatesMapper,
-                                            arrayChunkIdMaps,
-                                            dimSynthetic,
-                                            redimensioned))
-        {
-            shared_ptr<MemArray> sortedRedimSynthetic = sorter.getSortedArray(redimensioned, query, tcomp);
-            redimensioned = sortedRedimSynthetic;
-        }
-
-        // LOG4CXX_DEBUG(logger, "[RedimStore] redimensioned after update synthetic: ");
-        // redimensioned->printArrayToLogger();
-    }
-
-    timing.logTiming(logger, "[RedimStore] synthetic dimension populated");
+    timing.logTiming(logger, "[RedimStore] inputArray --> partitions");
 
     // Create a MemArray call 'beforeRedistribution'.
     //
@@ -714,6 +834,7 @@ shared_ptr<Array> RedimensionCommon::redimensionArray(shared_ptr<Array> const& s
     // The data is computed as follows:
     //    (a) For an aggregate field, the aggregate state, among all records with the same position, is stored.
     //    (b) If !hasAggregate and !hasSynthetic, for duplicates, only one record is kept.
+    //    (c) If hasSynthetic, each record with the same position get assigned a distinct value in the synthetic dimension.
     //
     // Also, the MemArray has the empty tag, regardless to what the input array has.
     //
@@ -735,10 +856,7 @@ shared_ptr<Array> RedimensionCommon::redimensionArray(shared_ptr<Array> const& s
     shared_ptr<MemArray> beforeRedistribution = make_shared<MemArray>(
               ArrayDesc(_schema.getName(), addEmptyTagAttribute(attrsBeforeRedistribution), _schema.getDimensions() ),query);
 
-    // Write data from the 'redimensioned' array to the 'beforeRedistribution' array
-    //
-
-    // Initialize iterators
+    // Write the partitions to the 'beforeRedistribution' array, one chunk at a time
     //
     vector<shared_ptr<ArrayIterator> > arrayItersBeforeRedistribution(attrsBeforeRedistribution.size());
     vector<shared_ptr<ChunkIterator> > chunkItersBeforeRedistribution(attrsBeforeRedistribution.size());
@@ -746,106 +864,89 @@ shared_ptr<Array> RedimensionCommon::redimensionArray(shared_ptr<Array> const& s
     {
         arrayItersBeforeRedistribution[i] = beforeRedistribution->getIterator(i);
     }
-    SCIDB_ASSERT(redimArrayIters.size() == destAttrs.size() + 2);
-    vector< shared_ptr<ConstArrayIterator> > redimArrayConstIters(redimArrayIters.size());
-    vector< shared_ptr<ConstChunkIterator> > redimChunkConstIters(redimChunkIters.size());
-    for (size_t i = 0; i < redimArrayConstIters.size(); ++i)
-    {
-        redimArrayConstIters[i] = redimensioned->getConstIterator(i);
-    }
 
-    // Initialize current chunk id to a value that is never in the map
-    //
-    size_t chunkIdAttr = redimArrayConstIters.size() - 1;
-    size_t positionAttr = redimArrayConstIters.size() - 2;
-    size_t nDestAttrs = _schema.getDimensions().size();
-    size_t chunkId = arrayChunkIdMaps._chunkPosToIdMap.size();
-    Coordinates lows(nDestAttrs), intervals(nDestAttrs);
-    Coordinates outputCoord(nDestAttrs);
-
-    // Init state vector and prev position
+    size_t const nAttrs = destAttrs.size();
+    size_t const nDestDims = destDims.size();
+    Coordinates lows(nDestDims), intervals(nDestDims);
+    Coordinates outputCoord(nDestDims);
     StateVector stateVector(aggregates, 0);
-    position_t prevPosition = 0;
+    vector<Value> destItem(nAttrs);
 
-    // Scan through the items, aggregate (if apply), and write to the MemArray.
-    //
-    while (!redimArrayConstIters[0]->end())
+    for (ChunkPartitions::iterator it = partitions.begin(); it != partitions.end(); ++it)
     {
-        // Set up chunk iters for the input chunk
-        for (size_t i = 0; i < redimChunkConstIters.size(); ++i)
+        Coordinates const& chunkPos = it->first;
+
+        // Read the records by position. Ties keep the input order, so the first record of a cell wins.
+        //
+        PartitionReader reader(it->second, redimensioned, nAttrs);
+        if (reader.end())
         {
-            redimChunkConstIters[i] = redimArrayConstIters[i]->getChunk().getConstIterator(i);
+            continue;
         }
 
-        while (!redimChunkConstIters[0]->end())
+        arrayCoordinatesMapper.chunkPos2LowsAndIntervals(chunkPos, lows, intervals);
+
+        // Create new chunks and get the iterators.
+        // The first non-empty-tag attribute does NOT use NO_EMPTY_CHECK (so as to help take care of the empty tag); Others do.
+        //
+        int iterMode = 0;
+        for (size_t i=0; i<nAttrs; ++i)
         {
-            // Have we found a new output chunk?
-            //
-            size_t nextChunkId = redimChunkConstIters[chunkIdAttr]->getItem().getInt64();
-            if (chunkId != nextChunkId)
-            {
-                // Write the left-over stateVector
-                //
-                appendItemToBeforeRedistribution(arrayCoordinatesMapper,
-                                                 lows,
-                                                 intervals,
-                                                 prevPosition,
-                                                 chunkItersBeforeRedistribution,
-                                                 stateVector);
+            Chunk& chunk = arrayItersBeforeRedistribution[i]->newChunk(chunkPos);
+            chunkItersBeforeRedistribution[i] = chunk.getIterator(query, iterMode);
+            iterMode |= ConstChunkIterator::NO_EMPTY_CHECK;
+        }
+
+        // When seeing the first item with a new position, the attribute values in the item are populated into the destItem as follows.
+        //  - For a scalar field, the value is copied.
+        //  - For an aggregate field, the value is initialized and accumulated.
+        //
+        // When seeing subsequent items with the same position, the attribute values in the item are populated as follows.
+        //  - If hasSynthetic, the item goes to the next free cell along the synthetic dimension.
+        //  - Otherwise, for a scalar field, the value is ignored (just select the first item),
+        //    and for an aggregate field, the value is accumulated.
+        //
+        // With collapsed records, the aggregate attributes of an item hold states, which are merged rather than accumulated.
+        //
+        position_t prevPosition = 0;
+        stateVector.init();
+        for (size_t k = 0; !reader.end(); ++k, ++reader)
+        {
+            reader.getItem(destItem);
+            position_t currPosition = reader.getPosition();
 
-                // Flush current output iters
-                //
-                for (size_t i = 0; i < destAttrs.size(); ++i)
+            if (hasSynthetic)
+            {
+                if (k != 0 && currPosition == prevPosition)
                 {
-                    if (chunkItersBeforeRedistribution[i].get())
+                    // found a duplicate --- move it to the next cell along the synthetic dimension
+                    outputCoord[dimSynthetic]++;
+                    if ((outputCoord[dimSynthetic] - lows[dimSynthetic]) >= intervals[dimSynthetic])
                     {
-                        chunkItersBeforeRedistribution[i]->flush();
-                        chunkItersBeforeRedistribution[i].reset();
+                        throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_OP_REDIMENSION_STORE_ERROR7);
                     }
                 }
-
-                // Init the coordinate mapper for the new chunk
-                //
-                chunkId = nextChunkId;
-                arrayCoordinatesMapper.chunkPos2LowsAndIntervals(mapIdToChunkPos(chunkId, arrayChunkIdMaps),
-                                                                 lows,
-                                                                 intervals);
-
-                // Create new chunks and get the iterators.
-                // The first non-empty-tag attribute does NOT use NO_EMPTY_CHECK (so as to help take care of the empty tag); Others do.
-                //
-                int iterMode = 0;
-                for (size_t i=0; i<destAttrs.size(); ++i)
+                else
                 {
-                    Chunk& chunk = arrayItersBeforeRedistribution[i]->newChunk(mapIdToChunkPos(chunkId, arrayChunkIdMaps));
-                    chunkItersBeforeRedistribution[i] = chunk.getIterator(query, iterMode);
-                    iterMode |= ConstChunkIterator::NO_EMPTY_CHECK;
+                    arrayCoordinatesMapper.pos2coordWithLowsAndIntervals(lows, intervals, currPosition, outputCoord);
                 }
-
-                // Update prevPosition, reset state vector
-                //
-                prevPosition = 0;
                 stateVector.init();
+                stateVector.accumulate(destItem);
+                appendItemToBeforeRedistribution(arrayCoordinatesMapper,
+                                                 lows,
+                                                 intervals,
+                                                 arrayCoordinatesMapper.coord2posWithLowsAndIntervals(lows, intervals, outputCoord),
+                                                 chunkItersBeforeRedistribution,
+                                                 stateVector);
+                prevPosition = currPosition;
             }
-
-            // When seeing the first item with a new position, the attribute values in the item are populated into the destItem as follows.
-            //  - For a scalar field, the value is copied.
-            //  - For an aggregate field, the value is initialized and accumulated.
-            //
-            // When seeing subsequent items with the same position, the attribute values in the item are populated as follows.
-            //  - For a scalar field, the value is ignored (just select the first item).
-            //  - For an aggregate field, the value is accumulated.
-            //
-            vector<Value> destItem(destAttrs.size());
-            for (size_t i = 0; i < destAttrs.size(); ++i)
-            {
-                destItem[i] = redimChunkConstIters[i]->getItem();
-            }
-
-            position_t currPosition = redimChunkConstIters[positionAttr]->getItem().getInt64();
-            if (currPosition == prevPosition)
+            else if (currPosition == prevPosition)
             {
-                stateVector.accumulate(destItem);
+                if (collapse) {
+                    stateVector.merge(destItem);
+                } else {
+                    stateVector.accumulate(destItem);
+                }
             }
             else
             {
@@ -862,47 +963,41 @@ shared_ptr<Array> RedimensionCommon::redimensionArray(shared_ptr<Array> const& s
 
                 // Init and accumulate with the current item.
                 stateVector.init();
-                stateVector.accumulate(destItem);
-            }
-
-            // Advance chunk iterators
-            for (size_t i = 0; i < redimChunkConstIters.size(); ++i)
-            {
-                ++(*redimChunkConstIters[i]);
+                if (collapse) {
+                    stateVector.merge(destItem);
+                } else {
+                    stateVector.accumulate(destItem);
+                }
             }
-        } // while chunk iterator
+        }
 
-        // Advance array iterators
-        for (size_t i = 0; i < redimArrayConstIters.size(); ++i)
+        // Flush the leftover statevector
+        if (!hasSynthetic)
         {
-            ++(*redimArrayConstIters[i]);
+            appendItemToBeforeRedistribution(arrayCoordinatesMapper,
+                                             lows,
+                                             intervals,
+                                             prevPosition,
+                                             chunkItersBeforeRedistribution,
+                                             stateVector);
         }
-    } // while array iterator
-
-    // Flush the leftover statevector
-    appendItemToBeforeRedistribution(arrayCoordinatesMapper,
-                                     lows,
-                                     intervals,
-                                     prevPosition,
-                                     chunkItersBeforeRedistribution,
-                                     stateVector);
 
-    // Flush the chunks one last time
-    for (size_t i=0; i<destAttrs.size(); ++i)
-    {
-        if (chunkItersBeforeRedistribution[i].get())
+        // Flush current output iters
+        for (size_t i=0; i<nAttrs; ++i)
         {
             chunkItersBeforeRedistribution[i]->flush();
+            chunkItersBeforeRedistribution[i].reset();
         }
-        chunkItersBeforeRedistribution[i].reset();
     }
+    partitions.clear();
+    redimensioned.reset();
 
     for (size_t i=0; i<destAttrs.size(); ++i) {
         arrayItersBeforeRedistribution[i].reset();
         chunkItersBeforeRedistribution[i].reset();
     }
 
-    timing.logTiming(logger, "[RedimStore] redimensioned --> beforeRedistribution");
+    timing.logTiming(logger, "[RedimStore] partitions --> beforeRedistribution");
 
     if( !hasAggregate && !redistributionRequired)
     {
@@ -32,6 +32,7 @@
 
 #include <util/FileIO.h>
 #include <boost/make_shared.hpp>
+#include <boost/unordered_map.hpp>
 
 #include "query/Operator.h"
 #include "query/QueryProcessor.h"
@@ -138,6 +139,26 @@ public:
         _valid = true;
     }
 
+    /**
+     * Merge an item of aggregate states into the state vector.
+     * For the aggregate attributes, call the aggregate pointer's merge() method, a null state being empty;
+     * For the scalar attributes, keep the first one that was merged.
+     *
+     * @param item   The item to merge, holding a state for every aggregate attribute.
+     */
+    void merge(vector<Value> const& item) {
+        assert(_destItem.size() + _numItemsToIgnoreAtTheEnd == item.size());
+        for (size_t i=0; i<_destItem.size(); ++i) {
+            if (!_valid || (_aggregates[i] && _destItem[i].isNull())) {
+                _destItem[i] = item[i];
+            }
+            else if (_aggregates[i] && !item[i].isNull()) {
+                _aggregates[i]->merge(_destItem[i], item[i]);
+            }
+        }
+        _valid = true;
+    }
+
     /**
      * Return the state vector.
      * @pre _valid must be true.
@@ -276,6 +297,7 @@ private:
                                                       Attributes const& destAttrs,
                                                       vector<size_t> const& attrMapping,
                                                       vector<AggregatePtr> const& aggregates,
+                                                      bool collapse,
                                                       vector< shared_ptr<ArrayIterator> >& redimArrayIters,
                                                       vector< shared_ptr<ChunkIterator> >& redimChunkIters,
                                                       size_t& redimCount,
@@ -286,11 +308,56 @@ private:
                                 vector< shared_ptr<ChunkIterator> >& redimChunkIters,
                                 size_t& redimCount,
                                 size_t const& redimChunkSize);
-    bool updateSyntheticDimForRedimArray(shared_ptr<Query> const& query,
-                                         ArrayCoordinatesMapper const& coordMapper,
-                                         ChunkIdMaps& chunkIdMaps,
-                                         size_t dimSynthetic,
-                                         shared_ptr<MemArray>& redimensioned);
+    void flushRedimArray(vector< shared_ptr<ChunkIterator> >& redimChunkIters,
+                         size_t& redimCount,
+                         size_t const& redimChunkSize);
+
+    /* Private interface to scatter the records into per-chunk partitions
+     */
+
+    /**
+     * The records bound for one chunk of the destination array, in input order.
+     * A record holds one value per destination attribute: the source value for an aggregate attribute or,
+     * when the records of a cell are collapsed, the aggregate state of the cell.
+     * Records that did not fit into memory are kept in the 'redimensioned' array as runs of rows,
+     * every run sorted by position.
+     */
+    struct ChunkPartition
+    {
+        typedef boost::unordered_map<position_t, size_t> CellIndex;
+
+        vector<position_t> positions;               // position in the chunk of each in-memory record
+        vector<Value> values;                       // positions.size() records, back to back
+        CellIndex cells;                            // in-memory record of each position, when collapsing
+        vector< pair<size_t, size_t> > spilledRuns; // (first row, number of rows) in the 'redimensioned' array
+    };
+    typedef map<Coordinates, ChunkPartition, CoordinatesLess> ChunkPartitions;
+
+    /**
+     * Reads the records of a partition in order of position, merging its spilled runs
+     * with its in-memory records. Ties are returned in input order.
+     */
+    class PartitionReader;
+
+    /**
+     * Add a record to a partition.
+     * @param collapse  when true, the records of a position are combined into one as they arrive:
+     *                  the aggregate attributes hold the state of the cell, the scalar attributes the first value
+     */
+    void appendItemToPartition(ChunkPartition& partition,
+                               position_t pos,
+                               vector<Value> const& item,
+                               vector<AggregatePtr> const& aggregates,
+                               bool collapse,
+                               size_t& memUsage);
+    void spillPartitions(ChunkPartitions& partitions,
+                         ChunkIdMaps& chunkIdMaps,
+                         size_t nAttrs,
+                         shared_ptr<Query> const& query,
+                         vector< shared_ptr<ArrayIterator> >& redimArrayIters,
+                         vector< shared_ptr<ChunkIterator> >& redimChunkIters,
+                         size_t& redimCount,
+                         size_t const& redimChunkSize);
 
     /* Helper function to append data to 'beforeRedistribution' array
      */
@@ -31,6 +31,7 @@
 #include "array/Metadata.h"
 #include "network/NetworkManager.h"
 #include "array/DelegateArray.h"
+#include "array/MemArray.h"
 #include "../redimension/RedimensionCommon.h"
 
 using namespace std;
@@ -41,6 +42,11 @@ namespace scidb {
 class PhysicalRepart : public RedimensionCommon
 {
 public:
+    static bool isMemoryHungry()
+    {
+        return true;
+    }
+
     PhysicalRepart(string const& logicalName,
                    string const& physicalName,
                    Parameters const& parameters,
@@ -69,6 +75,91 @@ public:
         return true;
     }
 
+    /**
+     * True if every result chunk lies within a single source chunk: the result has no overlap
+     * and each result chunk interval divides the source chunk interval. The chunk grids share
+     * the dimension starts, so the result grid then refines the source grid.
+     */
+    bool isAlignedSplit(ArrayDesc const& inputSchema) const
+    {
+        Dimensions const& source = inputSchema.getDimensions();
+        Dimensions const& result = _schema.getDimensions();
+        for (size_t i = 0, count = source.size(); i < count; ++i)
+        {
+            if (result[i].getChunkOverlap() != 0 ||
+                source[i].getChunkInterval() % result[i].getChunkInterval() != 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Cut every source chunk into the result chunks it contains.
+     * A source chunk is scanned in row-major order, which is also the row-major order
+     * within each of its result chunks, so all of them are written sequentially at once.
+     */
+    shared_ptr<Array> splitChunks(shared_ptr<Array> const& input, shared_ptr<Query> const& query)
+    {
+        typedef map<Coordinates, shared_ptr<ChunkIterator>, CoordinatesLess> ChunkIterators;
+
+        shared_ptr<MemArray> result = make_shared<MemArray>(_schema, query);
+        size_t const nAttrs = _schema.getAttributes(true).size(); // true = exclude empty tag.
+        vector< shared_ptr<ConstArrayIterator> > srcArrayIters(nAttrs);
+        vector< shared_ptr<ArrayIterator> > dstArrayIters(nAttrs);
+        for (size_t i = 0; i < nAttrs; ++i)
+        {
+            srcArrayIters[i] = input->getConstIterator(i);
+            dstArrayIters[i] = result->getIterator(i);
+        }
+
+        Coordinates chunkPos;
+        while (!srcArrayIters[0]->end())
+        {
+            for (size_t i = 0; i < nAttrs; ++i)
+            {
+                // The first attribute takes care of the empty tag; the others use NO_EMPTY_CHECK.
+                int const mode = ChunkIterator::SEQUENTIAL_WRITE | (i == 0 ? 0 : ChunkIterator::NO_EMPTY_CHECK);
+                ConstChunk const& srcChunk = srcArrayIters[i]->getChunk();
+                shared_ptr<ConstChunkIterator> src =
+                    srcChunk.getConstIterator(ChunkIterator::IGNORE_EMPTY_CELLS | ChunkIterator::IGNORE_OVERLAPS);
+                ChunkIterators dst;
+                ChunkIterators::iterator current = dst.end();
+                while (!src->end())
+                {
+                    Coordinates const& pos = src->getPosition();
+                    chunkPos = pos;
+                    _schema.getChunkPositionFor(chunkPos);
+                    if (current == dst.end() || current->first != chunkPos)
+                    {
+                        current = dst.find(chunkPos);
+                        if (current == dst.end())
+                        {
+                            Chunk& chunk = dstArrayIters[i]->newChunk(chunkPos, srcChunk.getCompressionMethod());
+                            current = dst.insert(make_pair(chunkPos, chunk.getIterator(query, mode))).first;
+                        }
+                    }
+                    if (!current->second->setPosition(pos))
+                    {
+                        throw USER_EXCEPTION(SCIDB_SE_EXECUTION, SCIDB_LE_OPERATION_FAILED) << "setPosition";
+                    }
+                    current->second->writeItem(src->getItem());
+                    ++(*src);
+                }
+                for (ChunkIterators::iterator it = dst.begin(); it != dst.end(); ++it)
+                {
+                    it->second->flush();
+                }
+            }
+            for (size_t i = 0; i < nAttrs; ++i)
+            {
+                ++(*srcArrayIters[i]);
+            }
+        }
+        return result;
+    }
+
     virtual bool changesDistribution(vector<ArrayDesc> const& inputSchemas) const
     {
         return !isNoop(inputSchemas[0]);
@@ -102,6 +193,10 @@ public:
         {
             return shared_ptr<Array> (new DelegateArray(_schema, input, true) );
         }
+        if (isAlignedSplit(input->getArrayDesc()))
+        {
+            return splitChunks(input, query);
+        }
 
         Attributes const& destAttrs = _schema.getAttributes(true); // true = exclude empty tag.
 
@@ -50,6 +50,11 @@ static log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("scidb.query.ops.sor
 class PhysicalSort: public PhysicalOperator
 {
 public:
+    static bool isMemoryHungry()
+    {
+        return true;
+    }
+
     PhysicalSort(const string& logicalName, const string& physicalName, const Parameters& parameters, const ArrayDesc& schema):
         PhysicalOperator(logicalName, physicalName, parameters, schema)
 	{
@@ -39,6 +39,11 @@ namespace scidb
 class PhysicalSort2 : public  PhysicalOperator
 {
 public:
+    static bool isMemoryHungry()
+    {
+        return true;
+    }
+
     PhysicalSort2(std::string const& logicalName,
                   std::string const& physicalName,
                   Parameters const& parameters,
@@ -60,6 +60,11 @@ class PhysicalStore: public PhysicalOperator
    shared_ptr<SystemCatalog::LockDesc> _lock;
 
   public:
+    static bool isMemoryHungry()
+    {
+        return true;
+    }
+
    PhysicalStore(const string& logicalName, const string& physicalName, const Parameters& parameters, const ArrayDesc& schema):
         PhysicalOperator(logicalName, physicalName, parameters, schema),
         _arrayUAID(0),
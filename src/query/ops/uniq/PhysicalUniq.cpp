@@ -274,6 +274,11 @@ private:
         size_t _marshalledSize; //maintained as data is added
 
     public:
+    static bool isMemoryHungry()
+    {
+        return true;
+    }
+
         typedef typename arena::managed::map<Coordinate, Element>::const_iterator const_iterator;
 
         MarshallableMap():
@@ -204,6 +204,11 @@ private:
         vector<Value> _stubs;
 
     public:
+    static bool isMemoryHungry()
+    {
+        return true;
+    }
+
         AttributeWriter( unordered_map<Coordinates, size_t> const& chunkCounts,
                          shared_ptr<MemArray> const& dstArray,
                          int64_t maxSize,
@@ -24,6 +24,7 @@
 
 #include <array/Compressor.h>
 #include <query/ParsingContext.h>
+#include <query/QueryProcessor.h>
 #include <query/Serialize.h>
 #include "AST.h"
 
@@ -107,6 +108,7 @@ class Translator
             bool              astHasUngroupedReferences       (const Node*,const set<string>&)const;
             bool              astHasAggregates                (const Node*)                   const;
             bool              matchOperatorParam              (const Node*,const OperatorParamPlaceholders &,vector<ArrayDesc> &inputSchemas,vector<LQPNPtr> &inputs,shared_ptr<OperatorParam> &param);
+    const   QueryParamMap::Param* findQueryParameter              (const Node*)const;
 
  private:                  // Expressions
             LEPtr             onNull              (const Node*);
@@ -280,6 +282,11 @@ Value Translator::passConstantExpression(const Node* ast,TypeId targetType)
         fail(SYNTAX(SCIDB_LE_CONSTANT_EXPRESSION_EXPECTED,ast));
     }
 
+    if (pExpr.hasParameters() && _qry)
+    {
+        _qry->markParameterValuesUsed();
+    }
+
     return pExpr.evaluate();
 }
 
@@ -725,10 +732,19 @@ bool Translator::matchOperatorParam(const Node* ast,
         shared_ptr<OperatorParam> &param)
 {
     int matched = 0;
+    const bool isQueryParameter = findQueryParameter(ast) != 0;
 
     //Each operator parameter from AST can match several placeholders. We trying to catch best one.
     BOOST_FOREACH(const shared_ptr<OperatorParamPlaceholder>& placeholder, placeholders)
     {
+        //A bound $placeholder is a constant, whatever names it might look like
+        if (isQueryParameter
+         && placeholder->getPlaceholderType() != PLACEHOLDER_CONSTANT
+         && placeholder->getPlaceholderType() != PLACEHOLDER_EXPRESSION)
+        {
+            continue;
+        }
+
         switch (placeholder->getPlaceholderType())
         {
             case PLACEHOLDER_INPUT:
@@ -896,7 +912,8 @@ bool Translator::matchOperatorParam(const Node* ast,
                  || ast->is(creal)
                  || ast->is(cstring)
                  || ast->is(cboolean)
-                 || ast->is(cinteger))
+                 || ast->is(cinteger)
+                 || isQueryParameter)
                 {
                     LEPtr lExpr;
                     shared_ptr<Expression> pExpr = make_shared<Expression>();
@@ -1216,12 +1233,21 @@ bool Translator::resolveParamDimensionReference(const vector<ArrayDesc> &inputSc
 
 shared_ptr<OperatorParamAggregateCall> Translator::passAggregateCall(const Node* ast, const vector<ArrayDesc> &inputSchemas)
 {
-    if (ast->get(applicationArgOperands)->getSize() != 1)
+    const Node* const operands = ast->get(applicationArgOperands);
+
+    if (operands->getSize() < 1)
     {
         fail(SYNTAX(SCIDB_LE_WRONG_AGGREGATE_ARGUMENTS_COUNT,ast));
     }
 
-    const Node* const arg = ast->get(applicationArgOperands)->get(listArg0);
+    const Node* const arg = operands->get(listArg0);
+
+    // The operands after the input attribute are constants the aggregate takes, e.g. approxquantile(a, 0.9)
+    vector<double> arguments;
+    for (size_t i = 1; i < operands->getSize(); i++)
+    {
+        arguments.push_back(passConstantExpression(operands->getList()[i],TID_DOUBLE).getDouble());
+    }
 
     shared_ptr<OperatorParam> opParam;
 
@@ -1250,7 +1276,8 @@ shared_ptr<OperatorParamAggregateCall> Translator::passAggregateCall(const Node*
             newParsingContext(ast),
             getStringApplicationArgName(ast),
             opParam,
-            getString(ast,applicationArgAlias));
+            getString(ast,applicationArgAlias),
+            arguments);
 }
 
 bool Translator::placeholdersVectorContainType(const vector<shared_ptr<OperatorParamPlaceholder> > &placeholders,
@@ -3504,6 +3531,11 @@ LEPtr Translator::onAttributeReference(const Node* ast)
 {
     assert(ast->is(reference));
 
+    if (const QueryParamMap::Param* p = findQueryParameter(ast))
+    {
+        return make_shared<Parameter>(newParsingContext(ast),getStringReferenceArgName(ast) + 1,p->value,p->type);
+    }
+
     if (ast->has(referenceArgVersion))
     {
         fail(SYNTAX(SCIDB_LE_REFERENCE_EXPECTED,ast->get(referenceArgVersion)));
@@ -3520,6 +3552,25 @@ LEPtr Translator::onAttributeReference(const Node* ast)
             getStringReferenceArgName(ast));
 }
 
+/**
+ *  Return the value bound to the query parameter the reference 'ast' names, if
+ *  it is of the form $name and the client bound a value to the placeholder.
+ */
+const QueryParamMap::Param* Translator::findQueryParameter(const Node* ast) const
+{
+    if (!ast->is(reference) || !_qry || !_qry->queryParams
+     || ast->has(referenceArgArray)
+     || ast->has(referenceArgVersion)
+     || ast->has(referenceArgOrder))
+    {
+        return 0;
+    }
+
+    chars name = getStringReferenceArgName(ast);
+
+    return name[0] == '$' ? _qry->queryParams->find(name + 1) : 0;
+}
+
 /****************************************************************************/
 
 LEPtr translate(Factory& f,Log& l,const StringPtr& s,Node* n)
@@ -58,6 +58,8 @@ namespace scidb
 
     const size_t HEADER_SIZE = 4*KiB;  // align header on page boundary to allow aligned IO operations
     const size_t N_LATCHES = 101;      // XXX TODO: figure out if latching is still necessary after removing clone logic
+    const size_t MAX_VERSIONS_TO_WALK = 8; // longer runs of newer chunk versions are skipped with a map lookup
+    const uint64_t CHUNK_MAP_PAGE_SIZE = 1*MiB; // bytes of chunk descriptors read and decoded at once when loading the chunk map
 
     /**
      * Position of chunk in the storage
@@ -194,13 +196,28 @@ namespace scidb
     };
 
     /**
-     * Chunk header + coordinates
+     * Chunk header + coordinates.
+     * In the storage header a descriptor takes getSlotSize() bytes: its header is followed
+     * by the coordinates the chunk has, not by MAX_NUM_DIMS_SUPPORTED of them.
      */
     struct ChunkDescriptor
     {
         ChunkHeader hdr;
         Coordinate  coords[MAX_NUM_DIMS_SUPPORTED];
 
+        /**
+         * @return the size on disk of the descriptor of a chunk with nCoordinates coordinates
+         */
+        static size_t getSlotSize(size_t nCoordinates)
+        {
+            return sizeof(ChunkHeader) + nCoordinates * sizeof(Coordinate);
+        }
+
+        size_t getSlotSize() const
+        {
+            return getSlotSize(hdr.nCoordinates);
+        }
+
         void getAddress(StorageAddress& addr) const;
         std::string toString() const
         {
@@ -330,6 +347,7 @@ namespace scidb
         int getAccessCount() const { return _accessCount; }
         bool isTemporary() const;
         void setAddress(const ArrayDesc& ad, const ChunkDescriptor& desc);
+        void setAddress(const ArrayDesc& ad, const ChunkHeader& hdr, const StorageAddress& addr);
         void setAddress(const ArrayDesc& ad, const StorageAddress& firstElem, int compressionMethod);
 
         boost::shared_ptr<ConstRLEEmptyBitmap> getEmptyBitmap() const;
@@ -686,14 +704,19 @@ namespace scidb
 
         /**
          * Entry in the inner chunkmap.  It is either a) a shared pointer to a persistent chunk, or
-         * b) a tombstone.  If it is a tombstone, the chunk pointer will be NULL and the position
-         * of the tombstone descriptor will be stored.
+         * b) a tombstone, or c) a stored chunk not materialized in memory (see CONFIG_LAZY_CHUNK_MAP).
+         * If it is a tombstone or a stored chunk, the chunk pointer will be NULL and the position
+         * of its descriptor will be stored.
          */
         class InnerChunkMapEntry
         {
         public:
+            InnerChunkMapEntry()
+            : _hdrpos(0), _instanceId(INVALID_INSTANCE), _stored(false)
+            {}
+
             /**
-             * Return pointer to chunk
+             * Return pointer to chunk, NULL for a tombstone or a stored chunk
              */
             boost::shared_ptr<PersistentChunk>& getChunk()
                 { return _chunk; }
@@ -702,14 +725,40 @@ namespace scidb
              * Is this a tombstone?
              */
             bool isTombstone()
-                { return _chunk == NULL; }
+                { return _chunk == NULL && !_stored; }
+
+            /**
+             * Is this a live chunk with no PersistentChunk in memory?
+             */
+            bool isStored()
+                { return _chunk == NULL && _stored; }
 
             /**
              * Set the tomstone position
              * @param pos new tomstone position
              */
             void setTombstonePos(uint64_t pos)
-                { _hdrpos = pos; }
+                { _hdrpos = pos; _stored = false; }
+
+            /**
+             * Drop the in-memory chunk, keeping what is needed to find it and materialize it again
+             * @param pos position of the chunk descriptor in the storage header
+             * @param instanceId the instance of the primary replica of the chunk
+             */
+            void setStored(uint64_t pos, InstanceID instanceId)
+                { _chunk.reset(); _hdrpos = pos; _instanceId = instanceId; _stored = true; }
+
+            /**
+             * Return position of the descriptor of a stored chunk
+             */
+            uint64_t getStoredPos()
+                { return _hdrpos; }
+
+            /**
+             * Return the instance of the primary replica of a stored chunk
+             */
+            InstanceID getStoredInstanceId()
+                { return _instanceId; }
 
             /**
              * Return position of tombstone
@@ -718,8 +767,10 @@ namespace scidb
                 { return _hdrpos; }
 
         private:
-            uint64_t _hdrpos;                           // if this is a tombstone, position in storage header
-            boost::shared_ptr<PersistentChunk> _chunk;  // pointer to chunk, NULL if tombstone
+            uint64_t _hdrpos;                           // if this is a tombstone or a stored chunk, position in storage header
+            InstanceID _instanceId;                     // if this is a stored chunk, instance of its primary replica
+            bool _stored;                               // true if this is a stored chunk (or was one)
+            boost::shared_ptr<PersistentChunk> _chunk;  // pointer to chunk, NULL if tombstone or stored
         };
 
     private:
@@ -764,13 +815,36 @@ namespace scidb
         uint64_t _logSizeLimit;      // transaciton log size limit
         uint64_t _logSize;
         int _currLog;
+
+        /*
+         * Group commit of the transaction log: writers append their records to _pendingLogRecords
+         * under _mutex and one of them writes and syncs the whole batch with the mutex released.
+         * Records are numbered from 1 in the order of their appending.
+         */
+        std::vector<TransLogRecord> _pendingLogRecords; // records not yet written to the log
+        uint64_t _logAppended;       // number of records appended so far
+        uint64_t _logSynced;         // number of records known to be durable in the log
+        bool _logSyncing;            // true while a batch is being written
+        Event _logSyncEvent;         // event to notify threads waiting for a log sync
+
+        /*
+         * Chunk data is written with _mutex released. Rollback waits for the writes in progress
+         * to the arrays it undoes before it frees their space.
+         */
+        std::map<ArrayUAID, size_t> _writesInProgress;
+        Event _writesDoneEvent;
         int _redundancy;
         int _nInstances;
-        bool _syncReplication;
+        bool _syncReplication;       // wait for the replicas of every chunk rather than at commit
+        bool _compressReplicas;      // zlib the replicas of the chunks stored uncompressed
         bool _enableDeltaEncoding;
+        bool _lazyChunkMap;          // keep only the chunks in use (or cached) materialized
+
+        /// Chunk lookups per array, counted under _mutex (entries, positions and tombstones are not used)
+        std::map<ArrayUAID, ChunkMapStatistics> _lookupStatistics;
 
         RWLock _latches[N_LATCHES];  //XXX TODO: figure out if latches are necessary after removal of clone logic
-        set<uint64_t> _freeHeaders;
+        std::map<uint16_t, set<uint64_t> > _freeHeaders; // free descriptor slots by number of coordinates
 
         /// Cached RM pointer
         ReplicationManager* _replicationManager;
@@ -787,6 +861,30 @@ namespace scidb
          */
         void initChunkMap();
 
+        /**
+         * Rewrite a storage header of the last format with fixed-size chunk descriptors
+         * with descriptors sized by the rank of their arrays, dropping the free slots.
+         * Called once the transaction logs have been replayed: they are emptied since their
+         * records point to the old descriptor positions.
+         */
+        void upgradeStorageHeader();
+
+        /**
+         * Read the chunk descriptor stored at a position of the storage header
+         */
+        void readChunkDescriptor(ChunkDescriptor& desc, uint64_t hdrPos);
+
+        /**
+         * Find a slot for the descriptor of a chunk, reusing a free slot of the same size if any,
+         * and set hdr.pos.hdrPos to it
+         */
+        void allocateChunkDescriptor(ChunkHeader& hdr);
+
+        /**
+         * Return the slot of a chunk descriptor to the free list
+         */
+        void freeChunkDescriptor(ChunkHeader const& hdr);
+
         /**
          * Perform metadata/lock recovery and storage rollback as part of the intialization.
          * It may block waiting for the remote coordinator recovery to occur.
@@ -805,6 +903,17 @@ namespace scidb
          */
         void waitForReplicas(std::vector<boost::shared_ptr<ReplicationManager::Item> >& replicas);
 
+        /**
+         * Wait for the replica items of a chunk write, or with async-replication defer the wait
+         * to the replication sync at the end of the query
+         * @param arrId the array of the chunk
+         * @param replicas a list of replica items
+         * @param query the query writing the chunk
+         */
+        void finishReplicas(ArrayID arrId,
+                            std::vector<boost::shared_ptr<ReplicationManager::Item> >& replicas,
+                            boost::shared_ptr<Query>& query);
+
         /**
          * Abort any outstanding replica items (in case of errors)
          * @param replicas a list of replica items to abort
@@ -859,6 +968,42 @@ namespace scidb
          */
         void writeChunkToDataStore(DataStore& ds, PersistentChunk& chunk, void const* data);
 
+        /**
+         * Append a record to the transaction log.
+         * @pre _mutex is locked
+         * @return the number of the record, to be passed to syncLog()
+         */
+        uint64_t appendLogRecord(TransLogRecord const& record);
+
+        /**
+         * Wait until the log record with the given number (and all the records before it) is durable,
+         * writing and syncing the pending batch of records if no other thread is doing so.
+         * @pre _mutex is locked exactly once by the calling thread; it is released while waiting
+         * and during the log I/O
+         */
+        void syncLog(uint64_t lsn);
+
+        /**
+         * Count a chunk write to the given array in progress with _mutex released.
+         */
+        void beginWrite(ArrayUAID uaId);
+
+        /**
+         * Uncount a chunk write started by beginWrite() and wake up waitForWrites().
+         */
+        void endWrite(ArrayUAID uaId);
+
+        /**
+         * Wait for the chunk writes in progress to the given arrays.
+         * @pre _mutex is locked exactly once by the calling thread
+         */
+        void waitForWrites(std::map<ArrayID, VersionID> const& uaIds);
+
+        /**
+         * Write the in-memory storage header to the header file.
+         */
+        void writeStorageHeader();
+
         /**
          * Read chunk data from the disk
          * Exception is thrown if read fails
@@ -887,7 +1032,24 @@ namespace scidb
         /**
          * Check if chunk should be considered by DBArraIterator
          */
-        bool isResponsibleFor(ArrayDesc const& desc, PersistentChunk const& chunk, boost::shared_ptr<Query> const& query);
+        bool isResponsibleFor(ArrayDesc const& desc,
+                              InnerChunkMapEntry& entry,
+                              StorageAddress const& addr,
+                              boost::shared_ptr<Query> const& query);
+
+        /**
+         * Create the PersistentChunk of a stored chunk map entry from its descriptor.
+         * @pre _mutex is locked
+         * @return the chunk of the entry
+         */
+        boost::shared_ptr<PersistentChunk>& materializeChunk(ArrayDesc const& desc, InnerChunkMapEntry& entry);
+
+        /**
+         * Drop the PersistentChunk of a chunk evicted from the cache if nothing else refers to it
+         * and CONFIG_LAZY_CHUNK_MAP is set.
+         * @pre _mutex is locked
+         */
+        void dematerializeChunk(PersistentChunk& chunk);
 
         /**
          * Determine if a given chunk is a primary replica on this instance
@@ -1065,6 +1227,11 @@ namespace scidb
          */
         void listChunkMap(ListChunkMapArrayBuilder& builder);
 
+        /**
+         * @see Storage::listChunkMapStatistics
+         */
+        void listChunkMapStatistics(ListChunkMapStatisticsArrayBuilder& builder);
+
         /**
          * @see Storage::findNextChunk
          */
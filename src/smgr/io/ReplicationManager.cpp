@@ -50,6 +50,10 @@ void ReplicationManager::start(const boost::shared_ptr<JobQueue>& jobQueue)
     // this queue is single-threaded because the order of replicas is important (per source)
     // and CachedStorage serializes everything anyway via THE mutex.
     _inboundReplicationQ = boost::make_shared<WorkQueue>(jobQueue, 1, size);
+
+    // the remote instances take no more than that many replicas at a time anyway
+    const int window = Config::getInstance()->getOption<int>(CONFIG_REPLICATION_SEND_QUEUE_SIZE);
+    _deferWindow = (window<1) ? 1 : window;
     InjectedErrorListener<ReplicaSendInjectedError>::start();
     InjectedErrorListener<ReplicaWaitInjectedError>::start();
 }
@@ -77,9 +81,60 @@ void ReplicationManager::send(const boost::shared_ptr<Item>& item)
         ri = shared_ptr<RepItems>(new RepItems);
     }
     ri->push_back(item);
-    if (ri->size() == 1) {
-        assert(ri->front() == item);
-        sendItem(*ri);
+    // stream out whatever the remote instance has room for, not just this item
+    sendItems(*ri);
+}
+
+void ReplicationManager::defer(QueryID queryId, ArrayID arrId, const std::vector<boost::shared_ptr<Item> >& items)
+{
+    vector<shared_ptr<Item> > toWait;
+    {
+        ScopedMutexLock cs(_repMutex);
+        RepItems& deferred = _deferred[make_pair(queryId, arrId)];
+        deferred.insert(deferred.end(), items.begin(), items.end());
+        while (!deferred.empty()) {
+            const shared_ptr<Item>& item = deferred.front();
+            if (item->isDone()) {
+                item->validate();
+            } else if (deferred.size() > _deferWindow) {
+                toWait.push_back(item);
+            } else {
+                break;
+            }
+            deferred.pop_front();
+        }
+    }
+    // _repMutex must NOT be locked
+    for (size_t i = 0; i < toWait.size(); ++i) {
+        wait(toWait[i]);
+    }
+}
+
+void ReplicationManager::waitForDeferred(QueryID queryId, ArrayID arrId)
+{
+    RepItems toWait;
+    {
+        ScopedMutexLock cs(_repMutex);
+        DeferredItems::iterator iter = _deferred.find(make_pair(queryId, arrId));
+        if (iter == _deferred.end()) {
+            return;
+        }
+        toWait.swap(iter->second);
+        _deferred.erase(iter);
+    }
+    LOG4CXX_TRACE(logger, "ReplicationManager::waitForDeferred: waiting for " << toWait.size()
+                  << " replicas of array ID=" << arrId << ", query (" << queryId << ")");
+    for (RepItems::iterator i = toWait.begin(); i != toWait.end(); ++i) {
+        wait(*i);
+    }
+}
+
+void ReplicationManager::discardDeferred(QueryID queryId)
+{
+    ScopedMutexLock cs(_repMutex);
+    DeferredItems::iterator iter = _deferred.lower_bound(make_pair(queryId, ArrayID(0)));
+    while (iter != _deferred.end() && iter->first.first == queryId) {
+        _deferred.erase(iter++);
     }
 }
 
@@ -161,6 +216,13 @@ void ReplicationManager::handleConnectionStatus(Notification<NetworkManager::Con
     _repEvent.signal();
 }
 
+void ReplicationManager::sendItems(RepItems& ri)
+{
+    ScopedMutexLock cs(_repMutex);
+    while (!ri.empty() && sendItem(ri)) {
+    }
+}
+
 bool ReplicationManager::sendItem(RepItems& ri)
 {
     ScopedMutexLock cs(_repMutex);
@@ -205,6 +267,7 @@ void ReplicationManager::clear()
         }
     }
     _repQueue.clear();
+    _deferred.clear();
     _repEvent.signal();
 }
 
@@ -31,6 +31,7 @@
 
 #include <deque>
 #include <map>
+#include <vector>
 #include <network/NetworkManager.h>
 #include <util/Event.h>
 #include <util/Mutex.h>
@@ -111,8 +112,9 @@ class ReplicationManager;
     typedef std::deque<boost::shared_ptr<Item> > RepItems;
     // XXX TODO: convert this to a set
     typedef std::map<InstanceID, boost::shared_ptr<RepItems> > RepQueue;
+    typedef std::map<std::pair<QueryID, ArrayID>, RepItems> DeferredItems;
  public:
-    ReplicationManager() {}
+    ReplicationManager() : _deferWindow(0) {}
     virtual ~ReplicationManager() {}
     /// start the operations
     void start(const boost::shared_ptr<JobQueue>& jobQueue);
@@ -122,6 +124,17 @@ class ReplicationManager;
     void send(const boost::shared_ptr<Item>& item);
     /// wait until the item is sent to network manager
     void wait(const boost::shared_ptr<Item>& item);
+    /**
+     * Leave the wait for sent items to waitForDeferred(), at the commit of the query.
+     * Only a window of replication-send-queue-size items per query and array is kept in flight,
+     * the older items are waited for here.
+     * @throw if one of the items already done has failed
+     */
+    void defer(QueryID queryId, ArrayID arrId, const std::vector<boost::shared_ptr<Item> >& items);
+    /// wait for the items deferred by the query for the array
+    void waitForDeferred(QueryID queryId, ArrayID arrId);
+    /// forget the items deferred by the query, e.g. when it is destroyed
+    void discardDeferred(QueryID queryId);
     /// discard the item 
     void abort(const boost::shared_ptr<Item>& item)
     {
@@ -204,6 +217,7 @@ class ReplicationManager;
 
     void handleConnectionStatus(Notification<NetworkManager::ConnectionStatus>::MessageTypePtr connStatus);
     bool sendItem(RepItems& ri);
+    void sendItems(RepItems& ri);
     void clear();
     static bool checkItemState(const boost::shared_ptr<Item>& item)
     {
@@ -219,6 +233,8 @@ class ReplicationManager;
     ReplicationManager& operator=(const ReplicationManager&);
 
     RepQueue _repQueue;
+    DeferredItems _deferred;
+    size_t   _deferWindow;
     Mutex    _repMutex;
     Event    _repEvent;
     Notification<NetworkManager::ConnectionStatus>::ListenerID _lsnrId;
@@ -33,6 +33,7 @@
 
 #include <sys/time.h>
 #include <inttypes.h>
+#include <zlib.h>
 #include <map>
 #include <boost/unordered_set.hpp>
 #include <boost/tuple/tuple.hpp>
@@ -46,6 +47,8 @@
 #include <query/Operator.h>
 #include <boost/make_shared.hpp>
 #include <util/FileIO.h>
+#include <util/Job.h>
+#include <util/JobQueue.h>
 #include <query/ops/list/ListArrayBuilder.h>
 #include <system/Cluster.h>
 #include <system/Utils.h>
@@ -54,6 +57,7 @@
 #include <system/Exceptions.h>
 #include <system/SystemCatalog.h>
 #include <util/Platform.h>
+#include <util/Tracer.h>
 #include <array/TileIteratorAdaptors.h>
 #include <smgr/io/InternalStorage.h>
 
@@ -93,6 +97,14 @@ const uint32_t SCIDB_STORAGE_HEADER_MAGIC = 0x5C1DB123;
  *
  * Revision history:
  *
+ * SCIDB_STORAGE_FORMAT_VERSION = 8:
+ *    Author: agent
+ *    Date: 10/18/26
+ *    Ticket: TBD
+ *    Note: A chunk descriptor takes the size of its header and of the coordinates its chunk has,
+ *          rather than room for MAX_NUM_DIMS_SUPPORTED coordinates. A storage header of version 7
+ *          is rewritten in this format when the instance starts (see upgradeStorageHeader).
+ *
  * SCIDB_STORAGE_FORMAT_VERSION = 7:
  *    Author: Steve F.
  *    Date: 7/11/14
@@ -125,7 +137,8 @@ const uint32_t SCIDB_STORAGE_HEADER_MAGIC = 0x5C1DB123;
  *    Ticket: ??
  *    Note: Initial implementation dating back some time
  */
-const uint32_t SCIDB_STORAGE_FORMAT_VERSION = 7;
+const uint32_t SCIDB_STORAGE_FORMAT_VERSION = 8;
+const uint32_t SCIDB_STORAGE_FORMAT_FIXED_DESCRIPTORS = 7; // last version with fixed-size chunk descriptors, upgraded on startup
 
 const size_t DEFAULT_TRANS_LOG_LIMIT = 1024; // default limit of transaction log file (in mebibytes)
 const size_t MAX_CFG_LINE_LENGTH = 1*KiB;
@@ -186,6 +199,80 @@ static void collectArraysToRollback(boost::shared_ptr<std::map<ArrayID, VersionI
     (*arrsToRollback.get())[baseArrayId] = lastVersion;
 }
 
+///////////////////////////////////////////////////////////////////
+/// ChunkDescriptorPage
+///////////////////////////////////////////////////////////////////
+
+/**
+ * A page of the storage header: the job reads the chunk descriptors starting in [start, end)
+ * and decodes their headers and addresses. initChunkMap() runs it in the background for the
+ * next page while it adds the current one to the chunk map.
+ * A descriptor whose header does not give its own position is not trusted with its size either:
+ * the decoding resumes at the next Coordinate boundary holding a valid header, and the bytes
+ * skipped are reported as a gap.
+ */
+class ChunkDescriptorPage : public Job
+{
+  public:
+    ChunkDescriptorPage(File::FilePtr const& hd, uint64_t start, uint64_t end)
+    : Job(boost::shared_ptr<Query>()), _hd(hd), _start(start), _end(end), _next(start)
+    {
+    }
+
+    virtual void run()
+    {
+        vector<char> buf(std::min(_end - _start, CHUNK_MAP_PAGE_SIZE));
+        const size_t rc = _hd->read(&buf[0], buf.size(), _start);
+        size_t offs = 0;
+        while (offs + sizeof(ChunkHeader) <= rc)
+        {
+            ChunkDescriptor const* desc = reinterpret_cast<ChunkDescriptor const*>(&buf[offs]);
+            const uint64_t pos = _start + offs;
+            if (desc->hdr.pos.hdrPos != pos || desc->hdr.nCoordinates >= MAX_NUM_DIMS_SUPPORTED)
+            {
+                if (_gaps.empty() || _gaps.back().second != pos)
+                {
+                    _gaps.push_back(make_pair(pos, pos));
+                }
+                _gaps.back().second = pos + sizeof(Coordinate);
+                offs += sizeof(Coordinate);
+                continue;
+            }
+            if (offs + desc->getSlotSize() > rc)
+            {
+                break;
+            }
+            headers.push_back(desc->hdr);
+            addresses.push_back(StorageAddress());
+            desc->getAddress(addresses.back());
+            offs += desc->getSlotSize();
+        }
+        _next = _start + offs;
+    }
+
+    /// @return the position of the first descriptor not decoded, _start if none was
+    uint64_t getNext() const
+    {
+        return _next;
+    }
+
+    /// @return the ranges of bytes skipped for holding no valid descriptor
+    vector<pair<uint64_t, uint64_t> > const& getGaps() const
+    {
+        return _gaps;
+    }
+
+    vector<ChunkHeader> headers;
+    vector<StorageAddress> addresses;
+
+  private:
+    File::FilePtr _hd;
+    const uint64_t _start;
+    const uint64_t _end;
+    uint64_t _next;
+    vector<pair<uint64_t, uint64_t> > _gaps;
+};
+
 ///////////////////////////////////////////////////////////////////
 /// ChunkDescriptor
 ///////////////////////////////////////////////////////////////////
@@ -293,10 +380,11 @@ CachedStorage::initChunkMap()
 
     _redundancy = Config::getInstance()->getOption<int> (CONFIG_REDUNDANCY);
     _syncReplication = !Config::getInstance()->getOption<bool> (CONFIG_ASYNC_REPLICATION);
+    _compressReplicas = Config::getInstance()->getOption<bool> (CONFIG_REPLICATION_COMPRESSION);
+    _lazyChunkMap = Config::getInstance()->getOption<bool> (CONFIG_LAZY_CHUNK_MAP);
 
-    ChunkDescriptor desc;
     uint64_t chunkPos = HEADER_SIZE;
-    StorageAddress addr;
+    uint64_t nChunks = 0;
     unordered_set<CloneOffset, CloneHash> clones;
     set<ArrayID> removedArrays;
     typedef map<ArrayID, ArrayID> ArrayMap;
@@ -304,50 +392,68 @@ CachedStorage::initChunkMap()
     typedef map<ArrayID, boost::shared_ptr<ArrayDesc> > ArrayDescCache;
     ArrayDescCache existentArrays;
 
-    for (size_t i = 0; i < _hdr.nChunks; i++, chunkPos += sizeof(ChunkDescriptor))
+    /* The descriptors are read and decoded a page at a time by a background thread,
+       which decodes the next page while the current one is added to the map
+     */
+    shared_ptr<JobQueue> loaderQueue(new JobQueue());
+    loaderQueue->setName("chunk map loader");
+    ThreadPool loader(1, loaderQueue);
+    loader.start();
+    _hd->fadvise(HEADER_SIZE, 0, POSIX_FADV_SEQUENTIAL);
+
+    shared_ptr<ChunkDescriptorPage> nextPage;
+    if (chunkPos < _hdr.currPos)
     {
-        size_t rc = _hd->read(&desc, sizeof(ChunkDescriptor), chunkPos);
-        if (rc != sizeof(ChunkDescriptor))
+        nextPage = make_shared<ChunkDescriptorPage>(_hd, chunkPos, _hdr.currPos);
+        loaderQueue->pushJob(nextPage);
+    }
+    while (nextPage)
+    {
+        shared_ptr<ChunkDescriptorPage> page = nextPage;
+        nextPage.reset();
+        page->wait(true);
+        if (page->getNext() == chunkPos)
         {
-            LOG4CXX_ERROR(logger, "Inconsistency in storage header: rc="
-                          << rc << ", chunkPos="
-                          << chunkPos << ", i="
-                          << i << ", hdr.nChunks="
+            LOG4CXX_ERROR(logger, "Inconsistency in storage header: no chunk descriptor at position "
+                          << chunkPos << ", hdr.nChunks="
                           << _hdr.nChunks << ", hdr.currPos="
                           << _hdr.currPos);
             _hdr.currPos = chunkPos;
-            _hdr.nChunks = i;
             break;
         }
-        if (desc.hdr.pos.hdrPos != chunkPos)
+        if (page->getNext() < _hdr.currPos)
         {
-            LOG4CXX_ERROR(logger, "Invalid chunk header " << i << " at position " << chunkPos
-                          << " desc.hdr.pos.hdrPos=" << desc.hdr.pos.hdrPos
-                          << " arrayID=" << desc.hdr.arrId
-                          << " hdr.nChunks=" << _hdr.nChunks);
-            _freeHeaders.insert(chunkPos);
+            nextPage = make_shared<ChunkDescriptorPage>(_hd, page->getNext(), _hdr.currPos);
+            loaderQueue->pushJob(nextPage);
         }
-        else
+        chunkPos = page->getNext();
+        for (size_t i = 0; i < page->getGaps().size(); i++)
         {
-            assert(desc.hdr.nCoordinates < MAX_NUM_DIMS_SUPPORTED);
-
-            LOG4CXX_TRACE(logger, "smgr open:  found chunk desc " << desc.toString());
+            LOG4CXX_ERROR(logger, "Invalid chunk headers from position " << page->getGaps()[i].first
+                          << " to " << page->getGaps()[i].second << " skipped");
+        }
 
-            if (desc.hdr.arrId != 0)
+        for (size_t i = 0; i < page->headers.size(); i++)
+        {
+            ChunkHeader& hdr = page->headers[i];
+            StorageAddress const& addr = page->addresses[i];
+            const uint64_t hdrPos = hdr.pos.hdrPos;
+            nChunks += 1;
+            if (hdr.arrId != 0)
             {
                 /* Check if unversioned array exists
                  */
-                ArrayDescCache::iterator it = existentArrays.find(desc.hdr.pos.dsGuid);
+                ArrayDescCache::iterator it = existentArrays.find(hdr.pos.dsGuid);
                 if (it == existentArrays.end())
                 {
-                    if (removedArrays.count(desc.hdr.pos.dsGuid) == 0)
+                    if (removedArrays.count(hdr.pos.dsGuid) == 0)
                     {
                         try
                         {
                             boost::shared_ptr<ArrayDesc> ad =
-                                SystemCatalog::getInstance()->getArrayDesc(desc.hdr.pos.dsGuid);
+                                SystemCatalog::getInstance()->getArrayDesc(hdr.pos.dsGuid);
                             it = existentArrays.insert(
-                                ArrayDescCache::value_type(desc.hdr.pos.dsGuid, ad)
+                                ArrayDescCache::value_type(hdr.pos.dsGuid, ad)
                                 ).first;
                         }
                         catch (SystemException const& x)
@@ -356,9 +462,9 @@ CachedStorage::initChunkMap()
                             {
                                 /* Try to remove the datastore if it is there
                                  */
-                                _datastores.closeDataStore(desc.hdr.pos.dsGuid,
+                                _datastores.closeDataStore(hdr.pos.dsGuid,
                                                            true /* remove from disk */);
-                                removedArrays.insert(desc.hdr.pos.dsGuid);
+                                removedArrays.insert(hdr.pos.dsGuid);
                             }
                             else
                             {
@@ -372,12 +478,12 @@ CachedStorage::initChunkMap()
                  */
                 if (it == existentArrays.end())
                 {
-                    desc.hdr.arrId = 0;
+                    hdr.arrId = 0;
                     LOG4CXX_TRACE(logger, "ChunkDesc: Remove chunk descriptor for non-existent "
-                                  << "array at position " << chunkPos);
-                    _hd->writeAll(&desc.hdr, sizeof(ChunkHeader), chunkPos);
-                    assert(desc.hdr.nCoordinates < MAX_NUM_DIMS_SUPPORTED);
-                    _freeHeaders.insert(chunkPos);
+                                  << "array at position " << hdrPos);
+                    _hd->writeAll(&hdr, sizeof(ChunkHeader), hdrPos);
+                    assert(hdr.nCoordinates < MAX_NUM_DIMS_SUPPORTED);
+                    freeChunkDescriptor(hdr);
                     continue;
                 }
 
@@ -388,7 +494,7 @@ CachedStorage::initChunkMap()
                     /* Init array descriptor
                      */
                     ArrayDesc& adesc = *it->second;
-                    assert(adesc.getUAId() == desc.hdr.pos.dsGuid);
+                    assert(adesc.getUAId() == hdr.pos.dsGuid);
 
                     /* Find/init the inner chunk map
                      */
@@ -409,7 +515,6 @@ CachedStorage::initChunkMap()
                         oldestVersions[adesc.getUAId()] =
                             SystemCatalog::getInstance()->getOldestArrayVersion(adesc.getUAId());
                     }
-                    desc.getAddress(addr);
                     StorageAddress oldestVersionAddr = addr;
                     oldestVersionAddr.arrId = oldestVersions[adesc.getUAId()];
                     StorageAddress oldestLiveChunkAddr;
@@ -430,18 +535,25 @@ CachedStorage::initChunkMap()
                     /* Chunk is live if and only if arrayID of chunk is > arrayID of chunk
                        currently pointed to by oldest version
                     */
-                    if (desc.hdr.arrId > oldestLiveChunkAddr.arrId)
+                    if (hdr.arrId > oldestLiveChunkAddr.arrId)
                     {
                         /* Chunk is live, put it in the map
                          */
-                        shared_ptr<PersistentChunk>& chunk =(*innerMap)[addr].getChunk();
-                        if (!desc.hdr.is<ChunkHeader::TOMBSTONE>())
+                        InnerChunkMapEntry& entry = (*innerMap)[addr];
+                        if (!hdr.is<ChunkHeader::TOMBSTONE>())
                         {
-                            chunk.reset(new PersistentChunk());
-                            chunk->setAddress(adesc, desc);
+                            if (_lazyChunkMap)
+                            {
+                                entry.setStored(hdr.pos.hdrPos, hdr.instanceId);
+                            }
+                            else
+                            {
+                                entry.getChunk().reset(new PersistentChunk());
+                                entry.getChunk()->setAddress(adesc, hdr, addr);
+                            }
                             bool isUnique =
-                                clones.insert(make_tuple(chunk->_hdr.pos.dsGuid,
-                                                         chunk->_hdr.pos.offs)).second;
+                                clones.insert(make_tuple(hdr.pos.dsGuid,
+                                                         hdr.pos.offs)).second;
                             if (!isUnique) {
                                 assert(false);
                                 throw SYSTEM_EXCEPTION(SCIDB_SE_STORAGE,
@@ -450,18 +562,18 @@ CachedStorage::initChunkMap()
                         }
                         else
                         {
-                            (*innerMap)[addr].setTombstonePos(desc.hdr.pos.hdrPos);
+                            entry.setTombstonePos(hdr.pos.hdrPos);
                         }
 
                         /* Now check if by inserting this chunk we made the previous one dead...
                          */
                         if (oldestLiveChunkAddr.arrId &&
-                            desc.hdr.arrId <= oldestVersionAddr.arrId)
+                            hdr.arrId <= oldestVersionAddr.arrId)
                         {
                             /* The oldestLiveChunk is now dead... wipe it out
                              */
                             shared_ptr<DataStore> ds =
-                                _datastores.getDataStore(desc.hdr.pos.dsGuid);
+                                _datastores.getDataStore(hdr.pos.dsGuid);
                             markChunkAsFree(oldestLiveChunk->second, ds);
                             innerMap->erase(oldestLiveChunk);
                         }
@@ -471,33 +583,137 @@ CachedStorage::initChunkMap()
                         /* Chunk is dead, wipe it out
                          */
                         shared_ptr<DataStore> ds =
-                            _datastores.getDataStore(desc.hdr.pos.dsGuid);
-                        desc.hdr.arrId = 0;
+                            _datastores.getDataStore(hdr.pos.dsGuid);
+                        hdr.arrId = 0;
                         LOG4CXX_TRACE(logger, "ChunkDesc: Remove chunk descriptor for non-existent "
-                                      << "array at position " << chunkPos);
-                        _hd->writeAll(&desc.hdr, sizeof(ChunkHeader), chunkPos);
-                        assert(desc.hdr.nCoordinates < MAX_NUM_DIMS_SUPPORTED);
-                        _freeHeaders.insert(chunkPos);
-                        ds->freeChunk(desc.hdr.pos.offs, desc.hdr.allocatedSize);
+                                      << "array at position " << hdrPos);
+                        _hd->writeAll(&hdr, sizeof(ChunkHeader), hdrPos);
+                        assert(hdr.nCoordinates < MAX_NUM_DIMS_SUPPORTED);
+                        freeChunkDescriptor(hdr);
+                        ds->freeChunk(hdr.pos.offs, hdr.allocatedSize);
                     }
                 }
             }
             else
             {
-                _freeHeaders.insert(chunkPos);
+                freeChunkDescriptor(hdr);
             }
         }
     }
 
-    if (chunkPos != _hdr.currPos)
+    if (nChunks != _hdr.nChunks)
+    {
+        LOG4CXX_ERROR(logger, "Storage header is not consistent: " << nChunks << " chunk descriptors vs. " << _hdr.nChunks);
+        _hdr.nChunks = nChunks;
+    }
+}
+
+void
+CachedStorage::upgradeStorageHeader()
+{
+    LOG4CXX_INFO(logger, "Upgrading storage header " << _databaseHeader << " from format "
+                 << SCIDB_STORAGE_FORMAT_FIXED_DESCRIPTORS << " to "
+                 << SCIDB_STORAGE_FORMAT_VERSION << ", nchunks " << _hdr.nChunks);
+
+    /* The new header is written aside and renamed over the old one once complete:
+       after a crash the old header is still there to upgrade again
+     */
+    const string upgradePath = _databaseHeader + ".upgrade";
+    File::FilePtr upgraded = FileManager::getInstance()->openFileObj(upgradePath.c_str(),
+                                                                     O_LARGEFILE | O_RDWR | O_CREAT | O_TRUNC);
+    if (!upgraded)
+        throw SYSTEM_EXCEPTION(SCIDB_SE_STORAGE, SCIDB_LE_CANT_OPEN_FILE) << upgradePath << errno;
+
+    union
+    {
+        StorageHeader hdr;
+        char          filler[HEADER_SIZE];
+    } header;
+    memset(&header, 0, sizeof(header));
+    header.hdr = _hdr;
+    header.hdr.versionLowerBound = SCIDB_STORAGE_FORMAT_VERSION;
+    header.hdr.versionUpperBound = SCIDB_STORAGE_FORMAT_VERSION;
+    header.hdr.currPos = HEADER_SIZE;
+    header.hdr.nChunks = 0;
+
+    /* Copy the descriptors in use a page at a time, dropping the free and invalid slots
+     */
+    const uint64_t pageSize = CHUNK_MAP_PAGE_SIZE / sizeof(ChunkDescriptor);
+    vector<ChunkDescriptor> page(std::min(_hdr.nChunks, pageSize));
+    vector<char> out;
+    uint64_t outPos = HEADER_SIZE;
+    uint64_t chunkPos = HEADER_SIZE;
+    for (uint64_t i = 0; i < _hdr.nChunks; i += pageSize)
     {
-        LOG4CXX_ERROR(logger, "Storage header is not consistent: " << chunkPos << " vs. " << _hdr.currPos);
-        // throw SYSTEM_EXCEPTION(SCIDB_SE_STORAGE, SCIDB_LE_DATABASE_HEADER_CORRUPTED);
-        if (chunkPos > _hdr.currPos)
+        const size_t nDescs = std::min(_hdr.nChunks - i, pageSize);
+        const size_t rc = _hd->read(&page[0], nDescs * sizeof(ChunkDescriptor), chunkPos);
+        for (size_t j = 0; j < rc / sizeof(ChunkDescriptor); j++, chunkPos += sizeof(ChunkDescriptor))
         {
-            _hdr.currPos = chunkPos;
+            ChunkDescriptor& desc = page[j];
+            if (desc.hdr.pos.hdrPos != chunkPos || desc.hdr.arrId == 0 ||
+                desc.hdr.nCoordinates >= MAX_NUM_DIMS_SUPPORTED)
+            {
+                continue;
+            }
+            desc.hdr.pos.hdrPos = header.hdr.currPos;
+            const char* slot = reinterpret_cast<const char*>(&desc);
+            out.insert(out.end(), slot, slot + desc.getSlotSize());
+            header.hdr.currPos += desc.getSlotSize();
+            header.hdr.nChunks += 1;
+        }
+        if (!out.empty())
+        {
+            upgraded->writeAll(&out[0], out.size(), outPos);
+            outPos += out.size();
+            out.clear();
+        }
+        if (rc != nDescs * sizeof(ChunkDescriptor))
+        {
+            LOG4CXX_ERROR(logger, "Inconsistency in storage header: rc="
+                          << rc << ", chunkPos="
+                          << chunkPos << ", hdr.nChunks="
+                          << _hdr.nChunks << ", hdr.currPos="
+                          << _hdr.currPos);
+            break;
         }
     }
+    upgraded->writeAll(&header, HEADER_SIZE, 0);
+    if (upgraded->fsync() != 0)
+        throw SYSTEM_EXCEPTION(SCIDB_SE_STORAGE, SCIDB_LE_OPERATION_FAILED_WITH_ERRNO) << "fsync" << errno;
+    upgraded.reset();
+
+    /* The undo records give the old descriptor positions, and they have all been replayed
+     */
+    for (int i = 0; i < 2; i++)
+    {
+        if (_log[i]->ftruncate(0) != 0 || _log[i]->fsync() != 0)
+            throw SYSTEM_EXCEPTION(SCIDB_SE_STORAGE, SCIDB_LE_OPERATION_FAILED_WITH_ERRNO) << "ftruncate" << errno;
+    }
+    _logSize = 0;
+    _currLog = 0;
+
+    if (::rename(upgradePath.c_str(), _databaseHeader.c_str()) != 0)
+        throw SYSTEM_EXCEPTION(SCIDB_SE_STORAGE, SCIDB_LE_OPERATION_FAILED_WITH_ERRNO) << "rename" << errno;
+
+    File::FilePtr hd = FileManager::getInstance()->openFileObj(_databaseHeader.c_str(), O_LARGEFILE | O_RDWR);
+    if (!hd)
+        throw SYSTEM_EXCEPTION(SCIDB_SE_STORAGE, SCIDB_LE_CANT_OPEN_FILE) << _databaseHeader << errno;
+
+    struct flock flc;
+    flc.l_type = F_WRLCK;
+    flc.l_whence = SEEK_SET;
+    flc.l_start = 0;
+    flc.l_len = 1;
+
+    if (hd->fsetlock(&flc))
+        throw SYSTEM_EXCEPTION(SCIDB_SE_STORAGE, SCIDB_LE_CANT_LOCK_DATABASE);
+
+    _hd = hd;
+    _hdr = header.hdr;
+    _freeHeaders.clear();
+
+    LOG4CXX_INFO(logger, "Storage header upgraded: " << _hdr.nChunks << " chunk descriptors in "
+                 << _hdr.currPos << " bytes");
 }
 
 /* Read the storage description file to find path for chunk map file.
@@ -536,18 +752,23 @@ CachedStorage::open(const string& storageDescriptorFilePath, size_t cacheSizeByt
     if (_hd->fsetlock(&flc))
         throw SYSTEM_EXCEPTION(SCIDB_SE_STORAGE, SCIDB_LE_CANT_LOCK_DATABASE);
 
+    /* The logs are synced explicitly, once per group of records (see syncLog)
+     */
     _log[0] = FileManager::getInstance()->openFileObj((_databaseLog + "_1").c_str(),
-                                                      O_LARGEFILE | O_SYNC | O_RDWR | O_CREAT);
+                                                      O_LARGEFILE | O_RDWR | O_CREAT);
     if (!_log[0])
         throw SYSTEM_EXCEPTION(SCIDB_SE_STORAGE, SCIDB_LE_CANT_OPEN_FILE) << (_databaseLog + "_1") << errno;
 
     _log[1] = FileManager::getInstance()->openFileObj((_databaseLog + "_2").c_str(),
-                                                      O_LARGEFILE | O_SYNC | O_RDWR | O_CREAT);
+                                                      O_LARGEFILE | O_RDWR | O_CREAT);
     if (!_log[1])
         throw SYSTEM_EXCEPTION(SCIDB_SE_STORAGE, SCIDB_LE_CANT_OPEN_FILE) << (_databaseLog + "_2") << errno;
 
     _logSize = 0;
     _currLog = 0;
+    _logAppended = 0;
+    _logSynced = 0;
+    _logSyncing = false;
 
     /* Initialize the data stores
      */
@@ -592,10 +813,14 @@ CachedStorage::open(const string& storageDescriptorFilePath, size_t cacheSizeByt
         }
 
         /* At the moment, both upper and lower bound versions in the file must equal to the
-           current version in the code.
+           current version in the code, or to the last version with fixed-size descriptors
+           which is upgraded below.
          */
-        if (_hdr.versionLowerBound != SCIDB_STORAGE_FORMAT_VERSION ||
-            _hdr.versionUpperBound != SCIDB_STORAGE_FORMAT_VERSION)
+        const bool upgrade = _hdr.versionLowerBound == SCIDB_STORAGE_FORMAT_FIXED_DESCRIPTORS &&
+                             _hdr.versionUpperBound == SCIDB_STORAGE_FORMAT_FIXED_DESCRIPTORS;
+        if (!upgrade &&
+            (_hdr.versionLowerBound != SCIDB_STORAGE_FORMAT_VERSION ||
+             _hdr.versionUpperBound != SCIDB_STORAGE_FORMAT_VERSION))
         {
             throw SYSTEM_EXCEPTION(SCIDB_SE_STORAGE, SCIDB_LE_MISMATCHED_STORAGE_FORMAT_VERSION)
                   << _hdr.versionLowerBound
@@ -607,6 +832,14 @@ CachedStorage::open(const string& storageDescriptorFilePath, size_t cacheSizeByt
          */
         doTxnRecoveryOnStartup();
 
+        /* Rollback only rewrites the headers of descriptors in place, so it is done
+           with the old format before the descriptors are moved
+         */
+        if (upgrade)
+        {
+            upgradeStorageHeader();
+        }
+
         /* Database is initialized: read information about all locally available chunks in map
          */
         initChunkMap();
@@ -699,7 +932,12 @@ void CachedStorage::addChunkToCache(PersistentChunk& chunk)
                 break;
             }
         }
-        internalFreeChunk(*_lru._prev);
+        PersistentChunk& victim = *_lru._prev;
+        internalFreeChunk(victim);
+        if (&victim != &chunk)
+        {
+            dematerializeChunk(victim);
+        }
     }
     _cacheUsed += chunk._hdr.size;
 }
@@ -715,7 +953,7 @@ CachedStorage::lookupChunk(ArrayDesc const& desc, StorageAddress const& addr)
         InnerChunkMap::iterator innerIter = innerMap->find(addr);
         if (innerIter != innerMap->end())
         {
-            shared_ptr<PersistentChunk>& chunk = innerIter->second.getChunk();
+            shared_ptr<PersistentChunk>& chunk = materializeChunk(desc, innerIter->second);
             if (chunk)
             {
                 chunk->beginAccess();
@@ -727,6 +965,47 @@ CachedStorage::lookupChunk(ArrayDesc const& desc, StorageAddress const& addr)
     return emptyChunk;
 }
 
+shared_ptr<PersistentChunk>&
+CachedStorage::materializeChunk(ArrayDesc const& desc, InnerChunkMapEntry& entry)
+{
+    if (entry.isStored())
+    {
+        ChunkDescriptor cdesc;
+        readChunkDescriptor(cdesc, entry.getStoredPos());
+        assert(cdesc.hdr.pos.hdrPos == entry.getStoredPos());
+        LOG4CXX_TRACE(logger, "ChunkDesc: Materialize chunk descriptor at position " << entry.getStoredPos());
+        entry.getChunk().reset(new PersistentChunk());
+        entry.getChunk()->setAddress(desc, cdesc);
+    }
+    return entry.getChunk();
+}
+
+void CachedStorage::dematerializeChunk(PersistentChunk& chunk)
+{
+    if (!_lazyChunkMap || chunk._accessCount != 0 || chunk._raw || chunk._hdr.pos.hdrPos == 0)
+    {
+        return;
+    }
+    ChunkMap::iterator iter = _chunkMap.find(chunk._hdr.pos.dsGuid);
+    if (iter == _chunkMap.end())
+    {
+        return;
+    }
+    InnerChunkMap::iterator innerIter = iter->second->find(chunk._addr);
+    if (innerIter == iter->second->end())
+    {
+        return;
+    }
+    InnerChunkMapEntry& entry = innerIter->second;
+
+    /* The chunk map must hold the only reference to the chunk (no iterator is positioned on it)
+     */
+    if (entry.getChunk().get() == &chunk && entry.getChunk().unique())
+    {
+        entry.setStored(chunk._hdr.pos.hdrPos, chunk._hdr.instanceId);
+    }
+}
+
 void CachedStorage::decompressChunk(ArrayDesc const& desc, PersistentChunk* chunk, CompressedBuffer const& buf)
 {
     chunk->allocate(buf.getDecompressedSize());
@@ -734,6 +1013,7 @@ void CachedStorage::decompressChunk(ArrayDesc const& desc, PersistentChunk* chun
     DBArrayChunkInternal intChunk(desc, chunk);
     if (buf.getSize() != buf.getDecompressedSize())
     {
+        TraceScope trace(Tracer::CHUNK_DECOMPRESS, buf.getSize());
         _compressors[buf.getCompressionMethod()]->decompress(buf.getData(), buf.getSize(), intChunk);
     }
     else
@@ -807,18 +1087,20 @@ int CachedStorage::chooseCompressionMethod(ArrayDesc const& desc,
 }
 
 inline bool CachedStorage::isResponsibleFor(ArrayDesc const& desc,
-                                            PersistentChunk const& chunk,
+                                            InnerChunkMapEntry& entry,
+                                            StorageAddress const& addr,
                                             boost::shared_ptr<Query> const& query)
 {
     ScopedMutexLock cs(_mutex);
     Query::validateQueryPtr(query);
-    assert(chunk._hdr.instanceId < size_t(_nInstances));
+    const InstanceID instanceId = entry.getChunk() ? entry.getChunk()->_hdr.instanceId : entry.getStoredInstanceId();
+    assert(instanceId < size_t(_nInstances));
 
-    if (chunk._hdr.instanceId == _hdr.instanceId)
+    if (instanceId == _hdr.instanceId)
     {
         return true;
     }
-    if (!query->isPhysicalInstanceDead(chunk._hdr.instanceId))
+    if (!query->isPhysicalInstanceDead(instanceId))
     {
         return false;
     }
@@ -827,7 +1109,7 @@ inline bool CachedStorage::isResponsibleFor(ArrayDesc const& desc,
         return true;
     }
     InstanceID replicas[MAX_REDUNDANCY + 1];
-    getReplicasInstanceId(replicas, desc, chunk.getAddress());
+    getReplicasInstanceId(replicas, desc, addr);
     for (int i = 1; i <= _redundancy; i++)
     {
         if (replicas[i] == _hdr.instanceId)
@@ -980,11 +1262,30 @@ void CachedStorage::removeVersions(QueryID queryId,
         StorageAddress const& address = *i;
         innerMap->erase(address);
     }
+    if (lastLiveArrId)
+    {
+        /* A tombstone left without an older chunk to hide is useless, remove it as well
+         */
+        InnerChunkMap::iterator i = innerMap->begin();
+        while (i != innerMap->end())
+        {
+            InnerChunkMap::iterator next = i;
+            ++next;
+            if (i->second.isTombstone() &&
+                (next == innerMap->end() || !next->first.sameBaseAddr(i->first)))
+            {
+                markChunkAsFree(i->second, ds);
+                innerMap->erase(i);
+            }
+            i = next;
+        }
+    }
     ds->flush();
     if (!lastLiveArrId)
     {
         assert(innerMap->size() == 0);
         _chunkMap.erase(uaId);
+        _lookupStatistics.erase(uaId);
         _datastores.closeDataStore(uaId, true /* remove from disk */);
     }
 }
@@ -1020,6 +1321,7 @@ void CachedStorage::removeVersionFromMemory(ArrayUAID uaId, ArrayID arrId)
     if (innerMap->size() == 0)
     {
        _chunkMap.erase(uaId);
+       _lookupStatistics.erase(uaId);
     }
 }
 
@@ -1065,25 +1367,39 @@ void CachedStorage::replicate(ArrayDesc const& desc,
                               boost::shared_ptr<Query>& query,
                               vector<boost::shared_ptr<ReplicationManager::Item> >& replicasVec)
 {
-    ScopedMutexLock cs(_mutex);
-    Query::validateQueryPtr(query);
+    {
+        ScopedMutexLock cs(_mutex);
+        Query::validateQueryPtr(query);
 
-    if (_redundancy <= 0 || (chunk && !isPrimaryReplica(chunk)))
-    { // self chunk
-        return;
+        if (_redundancy <= 0 || (chunk && !isPrimaryReplica(chunk)))
+        { // self chunk
+            return;
+        }
     }
-    replicasVec.reserve(_redundancy);
-    InstanceID replicas[MAX_REDUNDANCY + 1];
-    getReplicasInstanceId(replicas, desc, addr);
-
     QueryID queryId = query->getQueryID();
     assert(queryId != 0);
+
+    /* Build the message without the mutex: the copy (or the compression) of the chunk
+     * is the bulk of the work
+     */
     boost::shared_ptr<MessageDesc> chunkMsg;
+    int wireCompressionMethod = -1;
     if (chunk && data)
     {
         boost::shared_ptr<CompressedBuffer> buffer = boost::make_shared<CompressedBuffer>();
         buffer->allocate(compressedSize);
-        memcpy(buffer->getData(), data, compressedSize);
+        uLongf packedSize = compressedSize;
+        if (_compressReplicas && compressedSize == decompressedSize
+            && compress2((Bytef*)buffer->getData(), &packedSize, (Bytef const*)data, compressedSize, Z_BEST_SPEED) == Z_OK
+            && packedSize < compressedSize)
+        { // the chunk is stored uncompressed, spare the network
+            buffer->reallocate(packedSize);
+            wireCompressionMethod = CompressorFactory::ZLIB_COMPRESSOR;
+        }
+        else
+        {
+            memcpy(buffer->getData(), data, compressedSize);
+        }
         chunkMsg = boost::make_shared<MessageDesc>(mtChunkReplica, buffer);
     }
     else
@@ -1107,6 +1423,9 @@ void CachedStorage::replicate(ArrayDesc const& desc,
         chunkRecord->set_compression_method(chunk->getCompressionMethod());
         chunkRecord->set_decompressed_size(decompressedSize);
         chunkRecord->set_count(0);
+        if (wireCompressionMethod >= 0) {
+            chunkRecord->set_wire_compression_method(wireCompressionMethod);
+        }
         LOG4CXX_TRACE(logger, "Replicate chunk of array ID=" << addr.arrId << " attribute ID=" << addr.attId);
         assert(data != NULL); //TODO: need an exception ?
     }
@@ -1115,6 +1434,14 @@ void CachedStorage::replicate(ArrayDesc const& desc,
         chunkRecord->set_tombstone(true);
     }
 
+    ScopedMutexLock cs(_mutex);
+    if (_redundancy <= 0) {
+        return;
+    }
+    replicasVec.reserve(_redundancy);
+    InstanceID replicas[MAX_REDUNDANCY + 1];
+    getReplicasInstanceId(replicas, desc, addr);
+
     for (int i = 1; i <= _redundancy; i++)
     {
         boost::shared_ptr<ReplicationManager::Item> item = make_shared <ReplicationManager::Item>(replicas[i], chunkMsg, query);
@@ -1136,6 +1463,22 @@ void CachedStorage::abortReplicas(vector<boost::shared_ptr<ReplicationManager::I
     }
 }
 
+void CachedStorage::finishReplicas(ArrayID arrId,
+                                   vector<boost::shared_ptr<ReplicationManager::Item> >& replicasVec,
+                                   boost::shared_ptr<Query>& query)
+{
+    // _mutex must NOT be locked
+    if (replicasVec.empty()) {
+        return;
+    }
+    if (_syncReplication) {
+        waitForReplicas(replicasVec);
+    } else {
+        // ReplicationContext::replicationSync() waits for them at the end of the query
+        _replicationManager->defer(query->getQueryID(), arrId, replicasVec);
+    }
+}
+
 void CachedStorage::waitForReplicas(vector<boost::shared_ptr<ReplicationManager::Item> >& replicasVec)
 {
     // _mutex must NOT be locked
@@ -1280,9 +1623,11 @@ bool CachedStorage::findNextChunk(ArrayDesc const& desc, boost::shared_ptr<Query
         address.coords[address.coords.size()-1] += desc.getDimensions()[desc.getDimensions().size() - 1].getChunkInterval();
     }
     address.arrId = desc.getId();
+    ChunkMapStatistics& stats = _lookupStatistics[desc.getUAId()];
     InnerChunkMap::iterator innerIter = innerMap->lower_bound(address);
     while (true)
     {
+        ++stats.visits;
         if (innerIter == innerMap->end() || innerIter->first.attId != address.attId)
         {
             address.coords.clear();
@@ -1290,10 +1635,11 @@ bool CachedStorage::findNextChunk(ArrayDesc const& desc, boost::shared_ptr<Query
         }
         if(innerIter->first.arrId <= desc.getId())
         {
-            if(innerIter->second.getChunk() && isResponsibleFor( desc, *(innerIter->second.getChunk()), query))
+            if(!innerIter->second.isTombstone() && isResponsibleFor(desc, innerIter->second, innerIter->first, query))
             {
                 address.arrId = innerIter->first.arrId;
                 address.coords = innerIter->first.coords;
+                ++stats.lookups;
                 return true;
             }
             else
@@ -1304,9 +1650,22 @@ bool CachedStorage::findNextChunk(ArrayDesc const& desc, boost::shared_ptr<Query
                 innerIter = innerMap->lower_bound(address);
             }
         }
+        /* Skip the versions newer than the one we read, jumping over long version chains
+           rather than walking them
+        */
+        size_t nWalked = 0;
         while(innerIter != innerMap->end() && innerIter->first.arrId > address.arrId && innerIter->first.attId == address.attId)
         {
-            ++innerIter;
+            ++stats.visits;
+            if (++nWalked <= MAX_VERSIONS_TO_WALK)
+            {
+                ++innerIter;
+            }
+            else
+            {
+                innerIter = innerMap->lower_bound(StorageAddress(address.arrId, address.attId, innerIter->first.coords));
+                nWalked = 0;
+            }
         }
     }
 }
@@ -1333,8 +1692,11 @@ bool CachedStorage::findChunk(ArrayDesc const& desc, boost::shared_ptr<Query> co
 
     assert(innerIter->first.arrId <= address.arrId && innerIter->first.coords == address.coords);
     // XXX empty query used? to represent what ? NID chunk ?
-    if(innerIter->second.getChunk() && (!query || isResponsibleFor(desc, *(innerIter->second.getChunk()), query)))
+    if(!innerIter->second.isTombstone() && (!query || isResponsibleFor(desc, innerIter->second, innerIter->first, query)))
     {
+        ChunkMapStatistics& stats = _lookupStatistics[desc.getUAId()];
+        ++stats.lookups;
+        ++stats.visits;
         address.arrId = innerIter->first.arrId;
         return true;
     }
@@ -1400,14 +1762,15 @@ CachedStorage::writeChunk(ArrayDesc const& adesc, PersistentChunk* newChunk, boo
     func.clear();
     replicate(adesc, chunk._addr, &chunk, deflated, compressedSize, chunk.getSize(), query, replicasVec);
 
-    /* Write chunk locally into storage
+    /* Reserve the space and the descriptor slot of the chunk and log the reservation
      */
+    const AttributeDesc& attrDesc = adesc.getAttributes()[chunk.getAddress().attId];
+    shared_ptr<DataStore> ds = _datastores.getDataStore(adesc.getUAId());
+    uint64_t lsn = 0;
     {
         ScopedMutexLock cs(_mutex);
         assert(chunk.isRaw()); // new chunk is raw
         Query::validateQueryPtr(query);
-        const AttributeDesc& attrDesc = adesc.getAttributes()[chunk.getAddress().attId];
-        shared_ptr<DataStore> ds = _datastores.getDataStore(adesc.getUAId());
 
         /* Fill in the chunk descriptor
          */
@@ -1418,44 +1781,20 @@ CachedStorage::writeChunk(ArrayDesc const& adesc, PersistentChunk* newChunk, boo
 
         /* Locate spot for chunk descriptor
          */
-        if (_freeHeaders.empty())
-        {
-            chunk._hdr.pos.hdrPos = _hdr.currPos;
-            _hdr.currPos += sizeof(ChunkDescriptor);
-            _hdr.nChunks += 1;
-        }
-        else
-        {
-            set<uint64_t>::iterator i = _freeHeaders.begin();
-            chunk._hdr.pos.hdrPos = *i;
-            assert(chunk._hdr.pos.hdrPos != 0);
-            _freeHeaders.erase(i);
-        }
+        allocateChunkDescriptor(chunk._hdr);
 
         /* Write ahead UNDO log
          */
         if (dstVersion != 0)
         {
-            TransLogRecord transLogRecord[2];
-            transLogRecord->arrayUAID = adesc.getUAId();
-            transLogRecord->arrayId = chunk._addr.arrId;
-            transLogRecord->version = dstVersion;
-            transLogRecord->hdr = chunk._hdr;
-            transLogRecord->oldSize = 0;
-            transLogRecord->hdrCRC = calculateCRC32(transLogRecord, sizeof(TransLogRecordHeader));
-            memset(&transLogRecord[1], 0, sizeof(TransLogRecord)); // end of log marker
-
-            if (_logSize + sizeof(TransLogRecord) > _logSizeLimit)
-            {
-                _logSize = 0;
-                _currLog ^= 1;
-            }
-            LOG4CXX_TRACE(logger, "ChunkDesc: Write in log chunk header " << transLogRecord->hdr.pos.offs << " at position " << _logSize);
-
-            /* Write the transaction... log is opened O_SYNC so no flush is necessary
-             */
-            _log[_currLog]->writeAll(transLogRecord, sizeof(TransLogRecord) * 2, _logSize);
-            _logSize += sizeof(TransLogRecord);
+            TransLogRecord transLogRecord;
+            transLogRecord.arrayUAID = adesc.getUAId();
+            transLogRecord.arrayId = chunk._addr.arrId;
+            transLogRecord.version = dstVersion;
+            transLogRecord.hdr = chunk._hdr;
+            transLogRecord.oldSize = 0;
+            transLogRecord.hdrCRC = calculateCRC32(&transLogRecord, sizeof(TransLogRecordHeader));
+            lsn = appendLogRecord(transLogRecord);
         }
 
         /* Update value count in Chunk Header
@@ -1476,13 +1815,32 @@ CachedStorage::writeChunk(ArrayDesc const& adesc, PersistentChunk* newChunk, boo
                             Config::getInstance()->
                             getOption<double>(CONFIG_SPARSE_CHUNK_THRESHOLD));
         }
+        beginWrite(adesc.getUAId());
+    }
 
-        /* Write chunk data
-         */
+    /* Write chunk data into the reserved space, concurrently with the other writers
+     */
+    {
+        func = boost::bind(&CachedStorage::endWrite, this, adesc.getUAId());
+        Destructor<boost::function<void()> > writeEnder(func);
+        func.clear();
         writeChunkToDataStore(*ds, chunk, deflated);
         buf.reset();
+    }
+
+    {
+        ScopedMutexLock cs(_mutex);
+
+        /* The descriptor may only reach the disk after its undo record
+         */
+        if (lsn != 0)
+        {
+            syncLog(lsn);
+        }
+        Query::validateQueryPtr(query);
 
-        /* Write chunk descriptor in storage header
+        /* Write chunk descriptor in storage header, the storage header itself
+         * (for nchunks field) is written by flush() at commit
          */
         ChunkDescriptor cdesc;
         cdesc.hdr = chunk._hdr;
@@ -1495,11 +1853,7 @@ CachedStorage::writeChunk(ArrayDesc const& adesc, PersistentChunk* newChunk, boo
         LOG4CXX_TRACE(logger, "ChunkDesc: Write chunk descriptor at position " << chunk._hdr.pos.hdrPos);
         LOG4CXX_TRACE(logger, "Chunk descriptor to write: " << cdesc.toString());
 
-        _hd->writeAll(&cdesc, sizeof(ChunkDescriptor), chunk._hdr.pos.hdrPos);
-
-        /* Update storage header (for nchunks field)
-         */
-        _hd->writeAll(&_hdr, HEADER_SIZE, 0);
+        _hd->writeAll(&cdesc, cdesc.getSlotSize(), chunk._hdr.pos.hdrPos);
 
         InjectedErrorListener<WriteChunkInjectedError>::check();
 
@@ -1511,12 +1865,116 @@ CachedStorage::writeChunk(ArrayDesc const& adesc, PersistentChunk* newChunk, boo
         } // else chunkCleaner will dec accessCount and free
     }
 
-    /* Wait for replication to complete
+    /* Wait for replication to complete, or leave it to the end of the query
      */
-    waitForReplicas(replicasVec);
+    finishReplicas(chunk._addr.arrId, replicasVec, query);
     replicasCleaner.disarm();
 }
 
+uint64_t CachedStorage::appendLogRecord(TransLogRecord const& record)
+{
+    _pendingLogRecords.push_back(record);
+    return ++_logAppended;
+}
+
+/* Group commit of the transaction log: the first thread to find unwritten records writes all
+   the pending records with a single write and sync, the others wait for it.
+ */
+void CachedStorage::syncLog(uint64_t lsn)
+{
+    assert(lsn <= _logAppended);
+    while (_logSynced < lsn)
+    {
+        if (_logSyncing)
+        {
+            Event::ErrorChecker noopEc;
+            _logSyncEvent.wait(_mutex, noopEc);
+            continue;
+        }
+
+        /* Reserve the space for the batch in the current log (switching logs if needed)
+         */
+        vector<TransLogRecord> batch;
+        batch.swap(_pendingLogRecords);
+        const uint64_t batchEnd = _logAppended;
+        const size_t batchSize = batch.size() * sizeof(TransLogRecord);
+        const uint64_t prevLogSize = _logSize;
+        const int prevLog = _currLog;
+        if (_logSize + batchSize > _logSizeLimit)
+        {
+            _logSize = 0;
+            _currLog ^= 1;
+        }
+        File::FilePtr log = _log[_currLog];
+        const uint64_t pos = _logSize;
+        _logSize += batchSize;
+        _logSyncing = true;
+
+        TransLogRecord endOfLog;
+        memset(&endOfLog, 0, sizeof(TransLogRecord)); // end of log marker
+        batch.push_back(endOfLog);
+
+        LOG4CXX_TRACE(logger, "ChunkDesc: Write " << batch.size() - 1 << " log records at position " << pos);
+
+        int rc = 0;
+        _mutex.unlock();
+        try
+        {
+            log->writeAll(&batch[0], batchSize + sizeof(TransLogRecord), pos);
+            rc = log->fdatasync();
+        }
+        catch (...)
+        {
+            rc = -1;
+        }
+        _mutex.lock();
+
+        _logSyncing = false;
+        _logSyncEvent.signal();
+        if (rc != 0)
+        {
+            /* Give the records and their space back, so that their writers retry (and fail) on their own
+             */
+            _logSize = prevLogSize;
+            _currLog = prevLog;
+            batch.pop_back();
+            _pendingLogRecords.insert(_pendingLogRecords.begin(), batch.begin(), batch.end());
+            throw SYSTEM_EXCEPTION(SCIDB_SE_STORAGE, SCIDB_LE_OPERATION_FAILED_WITH_ERRNO) << "fdatasync" << errno;
+        }
+        _logSynced = batchEnd;
+    }
+}
+
+void CachedStorage::beginWrite(ArrayUAID uaId)
+{
+    ScopedMutexLock cs(_mutex);
+    _writesInProgress[uaId] += 1;
+}
+
+void CachedStorage::endWrite(ArrayUAID uaId)
+{
+    ScopedMutexLock cs(_mutex);
+    map<ArrayUAID, size_t>::iterator i = _writesInProgress.find(uaId);
+    assert(i != _writesInProgress.end() && i->second > 0);
+    if (--i->second == 0)
+    {
+        _writesInProgress.erase(i);
+        _writesDoneEvent.signal();
+    }
+}
+
+void CachedStorage::waitForWrites(std::map<ArrayID, VersionID> const& uaIds)
+{
+    for (std::map<ArrayID, VersionID>::const_iterator i = uaIds.begin(); i != uaIds.end(); ++i)
+    {
+        while (_writesInProgress.find(i->first) != _writesInProgress.end())
+        {
+            Event::ErrorChecker noopEc;
+            _writesDoneEvent.wait(_mutex, noopEc);
+        }
+    }
+}
+
 /* Mark a chunk as free in the on-disk and in-memory chunk map.  Also mark it as free
    in the datastore.
  */
@@ -1527,13 +1985,15 @@ void CachedStorage::markChunkAsFree(InnerChunkMapEntry& entry, shared_ptr<DataSt
 
     if (!chunk)
     {
-        /* Handle tombstone chunks
+        /* Handle tombstone and stored chunks
          */
         int rc = _hd->read(&header, sizeof(ChunkHeader), entry.getTombstonePos());
         if (rc != 0 && rc != sizeof(ChunkHeader)) {
             throw SYSTEM_EXCEPTION(SCIDB_SE_STORAGE,
                                    SCIDB_LE_OPERATION_FAILED_WITH_ERRNO) << "read" << errno;
         }
+        if (ds && entry.isStored())
+            ds->freeChunk(header.pos.offs, header.allocatedSize);
     }
     else
     {
@@ -1550,7 +2010,39 @@ void CachedStorage::markChunkAsFree(InnerChunkMapEntry& entry, shared_ptr<DataSt
     LOG4CXX_TRACE(logger, "ChunkDesc: Free chunk descriptor at position " << header.pos.hdrPos);
     _hd->writeAll(&header, sizeof(ChunkHeader), header.pos.hdrPos);
     assert(header.nCoordinates < MAX_NUM_DIMS_SUPPORTED);
-    _freeHeaders.insert(header.pos.hdrPos);
+    freeChunkDescriptor(header);
+}
+
+void CachedStorage::readChunkDescriptor(ChunkDescriptor& desc, uint64_t hdrPos)
+{
+    const size_t rc = _hd->read(&desc, sizeof(ChunkDescriptor), hdrPos);
+    if (rc < sizeof(ChunkHeader) || rc < desc.getSlotSize())
+    {
+        throw SYSTEM_EXCEPTION(SCIDB_SE_STORAGE, SCIDB_LE_DATABASE_HEADER_CORRUPTED);
+    }
+}
+
+void CachedStorage::allocateChunkDescriptor(ChunkHeader& hdr)
+{
+    map<uint16_t, set<uint64_t> >::iterator slots = _freeHeaders.find(hdr.nCoordinates);
+    if (slots == _freeHeaders.end() || slots->second.empty())
+    {
+        hdr.pos.hdrPos = _hdr.currPos;
+        _hdr.currPos += ChunkDescriptor::getSlotSize(hdr.nCoordinates);
+        _hdr.nChunks += 1;
+    }
+    else
+    {
+        set<uint64_t>::iterator i = slots->second.begin();
+        hdr.pos.hdrPos = *i;
+        assert(hdr.pos.hdrPos != 0);
+        slots->second.erase(i);
+    }
+}
+
+void CachedStorage::freeChunkDescriptor(ChunkHeader const& hdr)
+{
+    _freeHeaders[hdr.nCoordinates].insert(hdr.pos.hdrPos);
 }
 
 void CachedStorage::removeDeadChunks(ArrayDesc const& arrayDesc,
@@ -1590,7 +2082,7 @@ void CachedStorage::removeChunkVersion(ArrayDesc const& arrayDesc,
     StorageAddress addr(arrayDesc.getId(), 0, coords);
     replicate(arrayDesc, addr, NULL, NULL, 0, 0, query, replicasVec);
     removeLocalChunkVersion(arrayDesc, coords, query);
-    waitForReplicas(replicasVec);
+    finishReplicas(addr.arrId, replicasVec, query);
     replicasCleaner.disarm();
 }
 
@@ -1622,12 +2114,13 @@ void CachedStorage::removeLocalChunkVersion(ArrayDesc const& arrayDesc,
         tombstoneDesc.coords[i] = coords[i];
     }
     //WAL
-    TransLogRecord transLogRecord[2];
-    transLogRecord->arrayUAID = arrayDesc.getUAId();
-    transLogRecord->arrayId = arrayDesc.getId();
-    transLogRecord->version = dstVersion;
-    transLogRecord->oldSize = 0;
-    memset(&transLogRecord[1], 0, sizeof(TransLogRecord)); // end of log marker
+    TransLogRecord transLogRecord;
+    transLogRecord.arrayUAID = arrayDesc.getUAId();
+    transLogRecord.arrayId = arrayDesc.getId();
+    transLogRecord.version = dstVersion;
+    transLogRecord.oldSize = 0;
+    uint64_t lsn = 0;
+    vector<ChunkDescriptor> tombstones;
     ChunkMap::iterator iter = _chunkMap.find(arrayDesc.getUAId());
     if(iter == _chunkMap.end())
     {
@@ -1636,47 +2129,34 @@ void CachedStorage::removeLocalChunkVersion(ArrayDesc const& arrayDesc,
     shared_ptr<InnerChunkMap> inner = iter->second;
     for (AttributeID i =0; i<arrayDesc.getAttributes().size(); i++)
     {
-        query->validate();
+        Query::validateQueryPtr(query);
 
         tombstoneDesc.hdr.attId = i;
         StorageAddress addr (arrayDesc.getId(), i, coords);
-        if( (*inner)[addr].getChunk() != NULL)
+        if( !(*inner)[addr].isTombstone())
         {
             throw SYSTEM_EXCEPTION(SCIDB_SE_STORAGE, SCIDB_LE_CHUNK_ALREADY_EXISTS);
         }
-        if (_freeHeaders.empty())
-        {
-            tombstoneDesc.hdr.pos.hdrPos = _hdr.currPos;
-            _hdr.currPos += sizeof(ChunkDescriptor);
-            _hdr.nChunks += 1;
-        }
-        else
-        {
-            set<uint64_t>::iterator i = _freeHeaders.begin();
-            tombstoneDesc.hdr.pos.hdrPos = *i;
-            assert( tombstoneDesc.hdr.pos.hdrPos != 0);
-            _freeHeaders.erase(i);
-        }
+        allocateChunkDescriptor(tombstoneDesc.hdr);
         (*inner)[addr].setTombstonePos(tombstoneDesc.hdr.pos.hdrPos);
-        transLogRecord->hdr = tombstoneDesc.hdr;
-        transLogRecord->hdrCRC = calculateCRC32(transLogRecord, sizeof(TransLogRecordHeader));
-        if (_logSize + sizeof(TransLogRecord) > _logSizeLimit)
-        {
-            _logSize = 0;
-            _currLog ^= 1;
-        }
-        LOG4CXX_TRACE(logger, "ChunkDesc: Write in log chunk tombstone header " << transLogRecord->hdr.pos.offs
-                      << " at position " << _logSize);
-
-        _log[_currLog]->writeAll(transLogRecord, sizeof(TransLogRecord) * 2, _logSize);
-        _logSize += sizeof(TransLogRecord);
+        transLogRecord.hdr = tombstoneDesc.hdr;
+        transLogRecord.hdrCRC = calculateCRC32(&transLogRecord, sizeof(TransLogRecordHeader));
+        lsn = appendLogRecord(transLogRecord);
+        tombstones.push_back(tombstoneDesc);
+    }
 
-        LOG4CXX_TRACE(logger, "ChunkDesc: Write chunk tombstone descriptor at position " <<  tombstoneDesc.hdr.pos.hdrPos);
-        LOG4CXX_TRACE(logger, "Chunk tombstone descriptor to write: " << tombstoneDesc.toString());
+    /* The descriptors may only reach the disk after their undo records,
+     * the storage header is written by flush() at commit
+     */
+    syncLog(lsn);
+    Query::validateQueryPtr(query);
+    for (size_t i = 0; i < tombstones.size(); i++)
+    {
+        LOG4CXX_TRACE(logger, "ChunkDesc: Write chunk tombstone descriptor at position " << tombstones[i].hdr.pos.hdrPos);
+        LOG4CXX_TRACE(logger, "Chunk tombstone descriptor to write: " << tombstones[i].toString());
 
-        _hd->writeAll(&tombstoneDesc, sizeof(ChunkDescriptor), tombstoneDesc.hdr.pos.hdrPos);
+        _hd->writeAll(&tombstones[i], tombstones[i].getSlotSize(), tombstones[i].hdr.pos.hdrPos);
     }
-    _hd->writeAll(&_hdr, HEADER_SIZE, 0);
     InjectedErrorListener<WriteChunkInjectedError>::check();
 }
 
@@ -1687,6 +2167,12 @@ void CachedStorage::removeLocalChunkVersion(ArrayDesc const& arrayDesc,
 void CachedStorage::rollback(std::map<ArrayID, VersionID> const& undoUpdates)
 {
     LOG4CXX_DEBUG(logger, "Performing rollback");
+    {
+        /* The query is in error state, so no new writes to its arrays can start
+         */
+        ScopedMutexLock cs(_mutex);
+        waitForWrites(undoUpdates);
+    }
 
     for(std::map<ArrayID, VersionID>::const_iterator it = undoUpdates.begin();
         it != undoUpdates.end();
@@ -1700,6 +2186,11 @@ void CachedStorage::rollback(std::map<ArrayID, VersionID> const& undoUpdates)
         LOG4CXX_TRACE(logger, "Rolling back arrId = "<< it->first << ", version = "<<it->second);
     }
     ScopedMutexLock cs(_mutex);
+
+    /* Make all the appended records visible in the logs
+     */
+    syncLog(_logAppended);
+
     for (int i = 0; i < 2; i++)
     {
         uint64_t pos = 0;
@@ -1746,19 +2237,22 @@ void CachedStorage::rollback(std::map<ArrayID, VersionID> const& undoUpdates)
                         InnerChunkMap::iterator innerMapIt = innerMap->find(addr);
                         if (innerMapIt != innerMap->end())
                         {
-                            PersistentChunk* clone =  innerMapIt->second.getChunk().get();
-
-                            //XXX TODO: figure out if latching is still necessary
-                            // after removing the clone logic
-                            RWLock::ErrorChecker noopEc;
-                            ScopedRWLockWrite cloneWriter(getChunkLatch(clone), noopEc);
-
-                            clone->_hdr.compressedSize = transLogRecord.hdr.compressedSize;
-                            clone->_hdr.size = transLogRecord.hdr.size;
-                            clone->_hdr.flags = transLogRecord.hdr.flags;
-                            if (clone->_data != NULL)
+                            // a stored chunk has nothing in memory to restore
+                            PersistentChunk* clone = innerMapIt->second.getChunk().get();
+                            if (clone != NULL)
                             {
-                                internalFreeChunk(*clone);
+                                //XXX TODO: figure out if latching is still necessary
+                                // after removing the clone logic
+                                RWLock::ErrorChecker noopEc;
+                                ScopedRWLockWrite cloneWriter(getChunkLatch(clone), noopEc);
+
+                                clone->_hdr.compressedSize = transLogRecord.hdr.compressedSize;
+                                clone->_hdr.size = transLogRecord.hdr.size;
+                                clone->_hdr.flags = transLogRecord.hdr.flags;
+                                if (clone->_data != NULL)
+                                {
+                                    internalFreeChunk(*clone);
+                                }
                             }
                         }
                     }
@@ -1796,7 +2290,11 @@ void CachedStorage::rollback(std::map<ArrayID, VersionID> const& undoUpdates)
                 LOG4CXX_TRACE(logger, "ChunkDesc: Undo chunk descriptor creation at position "
                               << transLogRecord.hdr.pos.hdrPos);
                 _hd->writeAll(&transLogRecord.hdr, sizeof(ChunkHeader), transLogRecord.hdr.pos.hdrPos);
-                _freeHeaders.insert(transLogRecord.hdr.pos.hdrPos);
+                if (transLogRecord.hdr.pos.hdrPos < _hdr.currPos)
+                {
+                    // after a crash, the storage header may not cover the descriptors of the lost query
+                    freeChunkDescriptor(transLogRecord.hdr);
+                }
 
                 /* Update the free list for the data store
                  */
@@ -1887,8 +2385,9 @@ CachedStorage::flush(ArrayUAID uaId)
 {
     int rc;
 
-    /* flush the chunk map file
+    /* flush the chunk map file, with the storage header left behind by the chunk writes
      */
+    writeStorageHeader();
     rc = _hd->fsync();
     if (rc != 0)
     {
@@ -1908,6 +2407,15 @@ CachedStorage::flush(ArrayUAID uaId)
     }
 }
 
+void
+CachedStorage::writeStorageHeader()
+{
+    /* Written under the mutex so that concurrent flushes cannot store an older header last
+     */
+    ScopedMutexLock cs(_mutex);
+    _hd->writeAll(&_hdr, HEADER_SIZE, 0);
+}
+
 boost::shared_ptr<ArrayIterator> CachedStorage::getArrayIterator(boost::shared_ptr<const Array>& arr,
                                                                  AttributeID attId,
                                                                  boost::shared_ptr<Query>& query)
@@ -1925,6 +2433,7 @@ boost::shared_ptr<ConstArrayIterator> CachedStorage::getConstArrayIterator(boost
 void CachedStorage::fetchChunk(ArrayDesc const& desc, PersistentChunk& chunk)
 {
     ChunkInitializer guard(this, chunk);
+    TraceScope trace(Tracer::CHUNK_FETCH, chunk.getCompressedSize());
     shared_ptr<DataStore> ds = _datastores.getDataStore(desc.getUAId());
     if (chunk._hdr.pos.hdrPos == 0)
     {
@@ -1943,6 +2452,7 @@ void CachedStorage::fetchChunk(ArrayDesc const& desc, PersistentChunk& chunk)
         }
         readChunkFromDataStore(*ds, chunk, buf.get());
         DBArrayChunkInternal intChunk(desc, &chunk);
+        TraceScope decompressTrace(Tracer::CHUNK_DECOMPRESS, bufSize);
         size_t rc = _compressors[chunk.getCompressionMethod()]->decompress(buf.get(), chunk.getCompressedSize(), intChunk);
         if (rc != chunk.getSize())
             throw SYSTEM_EXCEPTION(SCIDB_SE_STORAGE, SCIDB_LE_CANT_DECOMPRESS_CHUNK);
@@ -2039,11 +2549,24 @@ void CachedStorage::listChunkDescriptors(ListChunkDescriptorsArrayBuilder& build
     ScopedMutexLock cs(_mutex);
     pair<ChunkDescriptor, bool> element;
     uint64_t chunkPos = HEADER_SIZE;
-    for (size_t i = 0; i < _hdr.nChunks; i++, chunkPos += sizeof(ChunkDescriptor))
+    while (chunkPos < _hdr.currPos)
     {
-        _hd->readAll(&element.first, sizeof(ChunkDescriptor), chunkPos);
-        element.second = _freeHeaders.count(chunkPos);
-        builder.listElement(element);
+        ChunkDescriptorPage page(_hd, chunkPos, _hdr.currPos);
+        page.run();
+        if (page.getNext() == chunkPos)
+        {
+            break;
+        }
+        chunkPos = page.getNext();
+        for (size_t i = 0; i < page.headers.size(); i++)
+        {
+            ChunkHeader const& hdr = page.headers[i];
+            element.first.hdr = hdr;
+            std::copy(page.addresses[i].coords.begin(), page.addresses[i].coords.end(), element.first.coords);
+            map<uint16_t, set<uint64_t> >::const_iterator slots = _freeHeaders.find(hdr.nCoordinates);
+            element.second = slots != _freeHeaders.end() && slots->second.count(hdr.pos.hdrPos);
+            builder.listElement(element);
+        }
     }
 }
 
@@ -2055,11 +2578,52 @@ void CachedStorage::listChunkMap(ListChunkMapArrayBuilder& builder)
         ArrayUAID uaid = i->first;
         for (InnerChunkMap::iterator j = i->second->begin(); j != i->second->end(); ++j)
         {
+            if (j->second.isStored())
+            {
+                /* List the descriptor of a stored chunk without materializing it
+                 */
+                ChunkDescriptor cdesc;
+                readChunkDescriptor(cdesc, j->second.getStoredPos());
+                PersistentChunk stored;
+                stored.init();
+                stored._hdr = cdesc.hdr;
+                builder.listElement(ChunkMapEntry(uaid, j->first, &stored));
+                continue;
+            }
             builder.listElement(ChunkMapEntry(uaid, j->first, j->second.getChunk().get()));
         }
     }
 }
 
+void CachedStorage::listChunkMapStatistics(ListChunkMapStatisticsArrayBuilder& builder)
+{
+    ScopedMutexLock cs(_mutex);
+    for (ChunkMap::iterator i = _chunkMap.begin(); i != _chunkMap.end(); ++i)
+    {
+        ChunkMapStatistics stats(i->first);
+        map<ArrayUAID, ChunkMapStatistics>::const_iterator lookups = _lookupStatistics.find(i->first);
+        if (lookups != _lookupStatistics.end())
+        {
+            stats.lookups = lookups->second.lookups;
+            stats.visits = lookups->second.visits;
+        }
+        InnerChunkMap::iterator prev = i->second->end();
+        for (InnerChunkMap::iterator j = i->second->begin(); j != i->second->end(); prev = j++)
+        {
+            stats.entries += 1;
+            if (prev == i->second->end() || !prev->first.sameBaseAddr(j->first))
+            {
+                stats.positions += 1;
+            }
+            if (j->second.isTombstone())
+            {
+                stats.tombstones += 1;
+            }
+        }
+        builder.listElement(stats);
+    }
+}
+
 ///////////////////////////////////////////////////////////////////
 /// DBArrayIterator
 ///////////////////////////////////////////////////////////////////
@@ -2789,6 +3353,14 @@ void PersistentChunk::setAddress(const ArrayDesc& ad, const ChunkDescriptor& des
     calculateBoundaries(ad);
 }
 
+void PersistentChunk::setAddress(const ArrayDesc& ad, const ChunkHeader& hdr, const StorageAddress& addr)
+{
+    init();
+    _hdr = hdr;
+    _addr = addr;
+    calculateBoundaries(ad);
+}
+
 int PersistentChunk::getCompressionMethod() const
 {
     return _hdr.compressionMethod;
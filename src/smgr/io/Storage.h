@@ -178,6 +178,26 @@ namespace scidb
 
     class ListChunkDescriptorsArrayBuilder;
     class ListChunkMapArrayBuilder;
+    class ListChunkMapStatisticsArrayBuilder;
+
+    /**
+     * Statistics of the chunk map of an array on one instance, as shown by list('chunk map statistics').
+     * The read amplification of the array is visits / lookups: the number of chunk map entries (older
+     * versions, tombstones) examined to find each chunk read.
+     */
+    struct ChunkMapStatistics
+    {
+        ArrayUAID uaId;
+        uint64_t entries;    /**< chunk map entries of all the versions */
+        uint64_t positions;  /**< distinct (attribute, coordinates) */
+        uint64_t tombstones;
+        uint64_t lookups;    /**< chunks found by findChunk/findNextChunk since startup */
+        uint64_t visits;     /**< chunk map entries examined by these lookups */
+
+        ChunkMapStatistics(ArrayUAID id = 0)
+        : uaId(id), entries(0), positions(0), tombstones(0), lookups(0), visits(0)
+        {}
+    };
     class PersistentChunk;
     class DataStores;
 
@@ -309,6 +329,15 @@ namespace scidb
             throw SYSTEM_EXCEPTION(SCIDB_SE_INTERNAL, SCIDB_LE_ILLEGAL_OPERATION) << "chunk map retrieval is not supported by this storage type.";
         }
 
+        /**
+         * Method for creating a list of the chunk map statistics of the arrays. Implemented by LocalStorage.
+         * @param builder a class that creates a list array
+         */
+        virtual void listChunkMapStatistics(ListChunkMapStatisticsArrayBuilder& builder)
+        {
+            throw SYSTEM_EXCEPTION(SCIDB_SE_INTERNAL, SCIDB_LE_ILLEGAL_OPERATION) << "chunk map retrieval is not supported by this storage type.";
+        }
+
         /**
          * Decompress chunk from the specified buffer
          * @param chunk destination chunk to receive decompressed data
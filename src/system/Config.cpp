@@ -842,6 +842,10 @@ std::string Config::setOptionValue(std::string const& name, std::string const& n
       default:
         SCIDB_UNREACHABLE();
     }
+    BOOST_FOREACH(void (*hook)(int32_t), _hooks)
+    {
+        hook(i->second);
+    }
     return oldValue;
 }
 
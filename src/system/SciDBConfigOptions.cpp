@@ -25,6 +25,7 @@
 #include "system/Config.h"
 #include "system/Constants.h"
 #include "SciDBConfigOptions.h"
+#include "util/Tracer.h"
 #include <unistd.h>
 
 using namespace std;
@@ -32,22 +33,37 @@ using namespace std;
 namespace scidb
 {
 
+/**
+ * Set once the options are parsed: then the hooks only see the changes made by setopt()
+ */
+static bool configParsed = false;
+
 void configHook(int32_t configOption)
 {
     switch (configOption)
     {
+        case CONFIG_TRACE:
+            Tracer::setEnabled(Config::getInstance()->getOption<bool>(CONFIG_TRACE));
+            break;
+
         case CONFIG_CONFIGURATION_FILE:
             Config::getInstance()->setConfigFileName(
                 Config::getInstance()->getOption<string>(CONFIG_CONFIGURATION_FILE));
             break;
 
         case CONFIG_HELP:
+            if (configParsed) {
+                break;
+            }
             cout << "Available options:" << endl
                 << Config::getInstance()->getDescription() << endl;
             exit(0);
             break;
 
         case CONFIG_VERSION:
+            if (configParsed) {
+                break;
+            }
             cout << SCIDB_BUILD_INFO_STRING() << endl;
             exit(0);
             break;
@@ -188,11 +204,24 @@ void initConfig(int argc, char* argv[])
         (CONFIG_MAX_OPEN_FDS, 0, "max-open-fds", "MAX_OPEN_FDS", "", Config::INTEGER, "Maximum number of fds that will be opened by the storage manager at once", 256, false)
         (CONFIG_PREALLOCATE_SHM, 0, "preallocate-shared-mem", "PREALLOCATE_SHM", "", Config::BOOLEAN, "Make sure shared memory backing (e.g. /dev/shm) is preallocated", true, false)
         (CONFIG_INSTALL_ROOT, 0, "install_root", "INSTALL_ROOT", "", Config::STRING, "The installation directory from which SciDB runs", string(SCIDB_INSTALL_PREFIX()), false)
+        (CONFIG_FLAT_AGGREGATE_LIMIT, 0, "flat-aggregate-limit", "FLAT_AGGREGATE_LIMIT", "", Config::INTEGER, "Maximal size of the per-group flat state arrays used by grouped aggregate() and regrid() (MiB). Larger group spaces use the chunked state array. 0 disables flat states.", 64, false)
+        (CONFIG_ADMISSION_MEMORY_LIMIT, 0, "admission-memory-limit", "ADMISSION_MEMORY_LIMIT", "", Config::INTEGER, "Memory the client queries running on the coordinator may reserve together (mebibytes). Queries that do not fit wait for admission, interactive queries ahead of batch ones. 0 disables admission control. The default, -1, uses max-memory-limit, whose own default of -1 means no limit, so admission control is off unless one of the two is set.", -1, false)
+        (CONFIG_QUERY_MEMORY_BUDGET, 0, "query-memory-budget", "QUERY_MEMORY_BUDGET", "", Config::INTEGER, "Memory budget of a single query (mebibytes). Batch queries reserve it on admission, and spill-capable operators spill earlier when the query gets close to it. 0 means unlimited.", 0, false)
+        (CONFIG_NUMA_AFFINITY, 0, "numa-affinity", "NUMA_AFFINITY", "", Config::BOOLEAN, "Spread the operator threads over the NUMA nodes and bind them to their node; a job spawned by an operator thread stays on its node unless a thread of another node runs out of work. No effect on single-node hosts.", true, false)
+        (CONFIG_GEMM_IN_PROCESS_LIMIT, 0, "gemm-in-process-limit", "GEMM_IN_PROCESS_LIMIT", "", Config::INTEGER, "gemm() multiplies matrices whose combined size is at most this (mebibytes) inside the instances instead of in ScaLAPACK MPI slaves, which cost more to launch than such small products take. 0 always uses ScaLAPACK.", 16, false)
+        (CONFIG_PLAN_CACHE_SIZE, 0, "plan-cache-size", "PLAN_CACHE_SIZE", "", Config::INTEGER, "Number of optimized physical plans of read-only client queries the coordinator keeps for reuse by later executions of the same query text. 0 disables the plan cache.", 256, false)
+        (CONFIG_CATALOG_CACHE_SIZE, 0, "catalog-cache-size", "CATALOG_CACHE_SIZE", "", Config::INTEGER, "Number of array descriptors, versions and boundaries each instance keeps in memory instead of reading them from the system catalog. The cache is dropped whenever the catalog is updated. 0 disables the catalog cache.", 1024, false)
+        (CONFIG_LAZY_CHUNK_MAP, 0, "lazy-chunk-map", "LAZY_CHUNK_MAP", "", Config::BOOLEAN, "Keep in memory only the chunk objects of the chunks in use or cached, the other entries of the chunk map just locate the chunk descriptor in the storage header", false, false)
+        (CONFIG_REPLICATION_COMPRESSION, 0, "replication-compression", "REPLICATION_COMPRESSION", "", Config::BOOLEAN, "Compress on the wire the replicas of the chunks stored without compression", true, false)
+        (CONFIG_PROFILE_QUERIES, 0, "profile-queries", "PROFILE_QUERIES", "", Config::BOOLEAN, "Count the chunks and cells pulled between the operators of the queries and the time spent producing them, and return the profile of every executed plan (explain analyze) with the query result. Can be changed with setopt().", false, false)
+        (CONFIG_TRACE, 0, "trace", "TRACE", "", Config::BOOLEAN, "Record lock waits, jobs, chunk reads, network sends and spills in per-thread ring buffers, and write the events of every query to trace-path as Chrome trace JSON when it ends. Can be changed with setopt().", false, false)
+        (CONFIG_TRACE_PATH, 0, "trace-path", "TRACE_PATH", "", Config::STRING, "Directory of the trace files written when trace is on. Empty means tmp-path.", string(""), false)
         ;
 
     cfg->addHook(configHook);
 
     cfg->parse(argc, argv, "");
+    configParsed = true;
 
     // By default redefine coordinator's port to 1239.
     if (!cfg->optionActivated(CONFIG_PORT) && cfg->getOption<bool>(CONFIG_COORDINATOR))
@@ -28,9 +28,16 @@
  * @author knizhnik@garret.ru
  */
 
+#include <assert.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/sysctl.h>
+#include <fstream>
+#include <string>
+#include <vector>
 
 #include "system/Sysinfo.h"
 #include "system/SciDBConfigOptions.h"
@@ -94,6 +101,111 @@ int Sysinfo::getCPUCacheSize(int level)
     }    
     return cache_size ? cache_size : DEFAULT_CACHE_SIZE;
 }
+
+namespace
+{
+    /**
+     * Parse a sysfs list such as "0-7,16-23".
+     * @return false if the file cannot be read
+     */
+    bool readSysfsList(std::string const& path, std::vector<int>& list)
+    {
+        std::ifstream in(path.c_str());
+        std::string text;
+        if (!in || !std::getline(in, text)) {
+            return false;
+        }
+        list.clear();
+        char const* p = text.c_str();
+        while (*p != '\0') {
+            char* end;
+            long first = strtol(p, &end, 10);
+            if (end == p) {
+                break;
+            }
+            long last = first;
+            p = end;
+            if (*p == '-') {
+                last = strtol(p + 1, &end, 10);
+                p = end;
+            }
+            for (long i = first; i <= last; i++) {
+                list.push_back(static_cast<int>(i));
+            }
+            if (*p == ',') {
+                p += 1;
+            }
+        }
+        return true;
+    }
+
+    struct NUMATopology
+    {
+        std::vector< std::vector<int> > nodeCPUs;
+        std::vector<int> cpuNode;
+
+        NUMATopology()
+        {
+            std::vector<int> nodes;
+            if (readSysfsList("/sys/devices/system/node/online", nodes)) {
+                for (size_t i = 0; i < nodes.size(); i++) {
+                    char path[64];
+                    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", nodes[i]);
+                    std::vector<int> cpus;
+                    if (readSysfsList(path, cpus) && !cpus.empty()) {
+                        nodeCPUs.push_back(cpus);
+                    }
+                }
+            }
+            if (nodeCPUs.empty()) {
+                // no NUMA information: one node with all the CPUs
+                std::vector<int> cpus;
+                long const nCPUs = sysconf(_SC_NPROCESSORS_CONF);
+                for (long i = 0; i < nCPUs; i++) {
+                    cpus.push_back(static_cast<int>(i));
+                }
+                nodeCPUs.push_back(cpus);
+            }
+            for (size_t node = 0; node < nodeCPUs.size(); node++) {
+                for (size_t i = 0; i < nodeCPUs[node].size(); i++) {
+                    int const cpu = nodeCPUs[node][i];
+                    if (cpuNode.size() <= static_cast<size_t>(cpu)) {
+                        cpuNode.resize(cpu + 1, 0);
+                    }
+                    cpuNode[cpu] = static_cast<int>(node);
+                }
+            }
+        }
+    };
+
+    NUMATopology const& getNUMATopology()
+    {
+        static NUMATopology topology;
+        return topology;
+    }
+}
+
+int Sysinfo::getNumberOfNUMANodes()
+{
+    return static_cast<int>(getNUMATopology().nodeCPUs.size());
+}
+
+std::vector<int> const& Sysinfo::getNUMANodeCPUs(int node)
+{
+    NUMATopology const& topology = getNUMATopology();
+    assert(node >= 0 && static_cast<size_t>(node) < topology.nodeCPUs.size());
+    return topology.nodeCPUs[node];
+}
+
+int Sysinfo::getCurrentNUMANode()
+{
+    NUMATopology const& topology = getNUMATopology();
+    if (topology.nodeCPUs.size() == 1) {
+        return 0;
+    }
+    int const cpu = sched_getcpu();
+    return cpu >= 0 && static_cast<size_t>(cpu) < topology.cpuNode.size() ? topology.cpuNode[cpu] : 0;
+}
     
 
 } //namespace
@@ -0,0 +1,243 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file CatalogCache.h
+ *
+ * @brief In-memory cache of the catalog metadata read by queries.
+ *
+ * Every metadata update committed to the catalog increments cluster.catalog_version in the same
+ * transaction. The coordinator of a query reads the counter before it sends out the physical plan,
+ * and the plan carries it to the workers, which validate their caches against it before they run
+ * the plan; instances also read it whenever they acquire (or read) array locks. A cache is dropped
+ * when the counter has moved. Metadata updates made by the instance itself drop the cache right away.
+ * Until the counter has been read once the cache stays empty.
+ *
+ * All the methods are thread safe. Fills and validation must additionally be done under
+ * SystemCatalog::_pgLock, so that a fill read from the catalog cannot overtake the invalidation
+ * of a later update.
+ */
+
+#ifndef CATALOG_CACHE_H_
+#define CATALOG_CACHE_H_
+
+#include <map>
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+
+#include <array/Metadata.h>
+#include <util/Mutex.h>
+
+namespace scidb
+{
+
+class CatalogCache
+{
+public:
+    /**
+     * @param capacity the maximum number of entries kept per kind of metadata, 0 disables the cache
+     */
+    explicit CatalogCache(size_t capacity)
+    : _capacity(capacity),
+      _valid(false),
+      _catalogVersion(0)
+    {
+    }
+
+    /**
+     * Drop the cache if the catalog has been updated since the last call.
+     * @param catalogVersion the current value of cluster.catalog_version
+     */
+    void validate(uint64_t catalogVersion)
+    {
+        ScopedMutexLock cs(_mutex);
+        if (!_valid || catalogVersion != _catalogVersion) {
+            _clear();
+            _catalogVersion = catalogVersion;
+            _valid = (_capacity != 0);
+        }
+    }
+
+    /**
+     * Drop the cache, e.g. on a local metadata update
+     */
+    void clear()
+    {
+        ScopedMutexLock cs(_mutex);
+        _clear();
+    }
+
+    bool getArrayDesc(const std::string& name, ArrayDesc& desc)
+    {
+        ScopedMutexLock cs(_mutex);
+        return _descsByName.find(name, desc);
+    }
+
+    void putArrayDesc(const std::string& name, const ArrayDesc& desc)
+    {
+        ScopedMutexLock cs(_mutex);
+        if (_valid) {
+            _descsByName.insert(name, desc, _capacity);
+        }
+    }
+
+    /**
+     * @return a copy of the cached descriptor, or NULL
+     */
+    boost::shared_ptr<ArrayDesc> getArrayDesc(ArrayID id)
+    {
+        ScopedMutexLock cs(_mutex);
+        boost::shared_ptr<ArrayDesc> desc;
+        if (_descsById.find(id, desc)) {
+            return boost::shared_ptr<ArrayDesc>(new ArrayDesc(*desc));
+        }
+        return boost::shared_ptr<ArrayDesc>();
+    }
+
+    void putArrayDesc(ArrayID id, const ArrayDesc& desc)
+    {
+        ScopedMutexLock cs(_mutex);
+        if (_valid) {
+            _descsById.insert(id, boost::shared_ptr<ArrayDesc>(new ArrayDesc(desc)), _capacity);
+        }
+    }
+
+    bool getArrayId(const std::string& name, ArrayID& id)
+    {
+        ScopedMutexLock cs(_mutex);
+        return _ids.find(name, id);
+    }
+
+    void putArrayId(const std::string& name, ArrayID id)
+    {
+        ScopedMutexLock cs(_mutex);
+        if (_valid) {
+            _ids.insert(name, id, _capacity);
+        }
+    }
+
+    bool getLastVersion(ArrayID id, VersionID& version)
+    {
+        ScopedMutexLock cs(_mutex);
+        return _lastVersions.find(id, version);
+    }
+
+    void putLastVersion(ArrayID id, VersionID version)
+    {
+        ScopedMutexLock cs(_mutex);
+        if (_valid) {
+            _lastVersions.insert(id, version, _capacity);
+        }
+    }
+
+    bool getBoundary(ArrayID id, bool high, Coordinates& boundary)
+    {
+        ScopedMutexLock cs(_mutex);
+        return (high ? _highBoundaries : _lowBoundaries).find(id, boundary);
+    }
+
+    void putBoundary(ArrayID id, bool high, const Coordinates& boundary)
+    {
+        ScopedMutexLock cs(_mutex);
+        if (_valid) {
+            (high ? _highBoundaries : _lowBoundaries).insert(id, boundary, _capacity);
+        }
+    }
+
+    bool getInstances(Instances& instances)
+    {
+        ScopedMutexLock cs(_mutex);
+        return _instances.find(0, instances);
+    }
+
+    void putInstances(const Instances& instances)
+    {
+        ScopedMutexLock cs(_mutex);
+        if (_valid) {
+            _instances.insert(0, instances, _capacity);
+        }
+    }
+
+private:
+    /**
+     * A map that is simply emptied when it overflows: its entries are cheap to read back.
+     */
+    template<typename K, typename V>
+    class Entries
+    {
+    public:
+        bool find(const K& key, V& value) const
+        {
+            typename std::map<K, V>::const_iterator i = _entries.find(key);
+            if (i == _entries.end()) {
+                return false;
+            }
+            value = i->second;
+            return true;
+        }
+
+        void insert(const K& key, const V& value, size_t capacity)
+        {
+            if (_entries.size() >= capacity) {
+                _entries.clear();
+            }
+            _entries[key] = value;
+        }
+
+        void clear()
+        {
+            _entries.clear();
+        }
+
+    private:
+        std::map<K, V> _entries;
+    };
+
+    void _clear()
+    {
+        _descsByName.clear();
+        _descsById.clear();
+        _ids.clear();
+        _lastVersions.clear();
+        _lowBoundaries.clear();
+        _highBoundaries.clear();
+        _instances.clear();
+    }
+
+    Mutex _mutex;
+    size_t const _capacity;
+    bool _valid;
+    uint64_t _catalogVersion;
+
+    Entries<std::string, ArrayDesc> _descsByName;
+    Entries<ArrayID, boost::shared_ptr<ArrayDesc> > _descsById;
+    Entries<std::string, ArrayID> _ids;
+    Entries<ArrayID, VersionID> _lastVersions;
+    Entries<ArrayID, Coordinates> _lowBoundaries;
+    Entries<ArrayID, Coordinates> _highBoundaries;
+    Entries<int, Instances> _instances;
+};
+
+} //namespace scidb
+
+#endif /* CATALOG_CACHE_H_ */
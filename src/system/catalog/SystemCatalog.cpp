@@ -61,6 +61,7 @@
 #include "query/Expression.h"
 #include "query/Serialize.h"
 
+#include "system/catalog/CatalogCache.h"
 #include "system/catalog/data/CatalogMetadata.h"
 
 using namespace std;
@@ -73,6 +74,20 @@ namespace scidb
 
     Mutex SystemCatalog::_pgLock;
 
+    //Not thread safe. Must be called under _pgLock in the transaction of a metadata update.
+    inline void bumpCatalogVersion(work& tr, CatalogCache& cache)
+    {
+        tr.exec("update \"cluster\" set catalog_version = catalog_version + 1");
+        cache.clear();
+    }
+
+    //Not thread safe. Must be called with active connection under _pgLock.
+    inline uint64_t readCatalogVersion(work& tr)
+    {
+        result query_res = tr.exec("select catalog_version from \"cluster\"");
+        return query_res[0].at("catalog_version").as(uint64_t());
+    }
+
 
      SystemCatalog::LockDesc::LockDesc(const std::string& arrayName,
                                       QueryID  queryId,
@@ -137,6 +152,7 @@ namespace scidb
 
             work tr(*_connection);
             tr.prepared(s)(int(ArrayDesc::INVALID))(int(ArrayDesc::TRANSIENT)).exec();
+            bumpCatalogVersion(tr, *_cache);
             tr.commit();
         }
         catch (const broken_connection &e)
@@ -179,6 +195,7 @@ namespace scidb
             _metadataVersion = query_res[0].at("version").as(int());
             assert(METADATA_VERSION == _metadataVersion);
             _initialized = true;
+            _cache->clear();
 
             tr.commit();
         }
@@ -366,6 +383,7 @@ namespace scidb
                 //dimensions for caching as for attributes.
             }
 
+            bumpCatalogVersion(tr, *_cache);
             tr.commit();
             LOG4CXX_DEBUG(logger, "Create array " << array_desc.getName() << "(" << arrId << ") in query " << Query::getCurrentQueryID());
             array_desc.setIds(arrId, uaid, vid);
@@ -503,6 +521,7 @@ namespace scidb
                     (dim.getChunkOverlap()).exec();
             }
 
+            bumpCatalogVersion(tr, *_cache);
             tr.commit();
             *oldArrayDesc = array_desc;
         }
@@ -639,6 +658,10 @@ namespace scidb
 
     ArrayID SystemCatalog::findArrayByName(const std::string &array_name)
     {
+        ArrayID array_id = INVALID_ARRAY_ID;
+        if (_cache->getArrayId(array_name, array_id)) {
+            return array_id;
+        }
         boost::function<ArrayID()> work = boost::bind(&SystemCatalog::_findArrayByName,
                 this, cref(array_name));
         return Query::runRestartableWork<ArrayID, broken_connection>(work, _reconnectTries);
@@ -661,7 +684,9 @@ namespace scidb
             _connection->prepare(sql1, sql1)("varchar", treat_string);
             result query_res1 = tr.prepared(sql1)(array_name).exec();
             if (query_res1.size() != 0) {
-                return query_res1[0].at("id").as(int64_t());
+                ArrayID array_id = query_res1[0].at("id").as(int64_t());
+                _cache->putArrayId(array_name, array_id);
+                return array_id;
             }
         }
         catch (const broken_connection &e)
@@ -729,6 +754,9 @@ namespace scidb
                                      const bool throwException,
                                      boost::shared_ptr<Exception> &exception)
     {
+        if (_cache->getArrayDesc(array_name, array_desc)) {
+            return;
+        }
         boost::function<void()> work = boost::bind(&SystemCatalog::_getArrayDesc,
                 this, cref(array_name), ref(array_desc), throwException, ref(exception));
         return Query::runRestartableWork<void, broken_connection>(work, _reconnectTries);
@@ -872,6 +900,7 @@ namespace scidb
             newDesc.setPartitioningSchema((PartitioningSchema)query_res1[0].at("partitioning_schema").as(int()));
             tr.commit();
             array_desc = newDesc;
+            _cache->putArrayDesc(array_name, newDesc);
         }
         catch (const broken_connection &e)
         {
@@ -905,6 +934,10 @@ namespace scidb
 
     boost::shared_ptr<ArrayDesc> SystemCatalog::getArrayDesc(const ArrayID array_id)
     {
+        boost::shared_ptr<ArrayDesc> desc = _cache->getArrayDesc(array_id);
+        if (desc) {
+            return desc;
+        }
         boost::function<boost::shared_ptr<ArrayDesc>()> work =
                 boost::bind(&SystemCatalog::_getArrayDesc, this, array_id);
         return Query::runRestartableWork<boost::shared_ptr<ArrayDesc>, broken_connection>(work, _reconnectTries);
@@ -1023,6 +1056,7 @@ namespace scidb
                                                                  query_res1[0].at("flags").as(int())));
             newDesc->setPartitioningSchema((PartitioningSchema)query_res1[0].at("partitioning_schema").as(int()));
             tr.commit();
+            _cache->putArrayDesc(array_id, *newDesc);
         }
         catch (const broken_connection &e)
         {
@@ -1125,6 +1159,7 @@ namespace scidb
             totalNewArrays -= query_res.affected_rows();
             rc = (query_res.affected_rows() > 0);
 
+            bumpCatalogVersion(tr, *_cache);
             tr.commit();
         }
         catch (const broken_connection &e)
@@ -1178,6 +1213,7 @@ namespace scidb
                 tr.prepared("delete-array-versions")(array_name)(array_version).exec();
             totalNewArrays -= query_res.affected_rows();
             rc = (query_res.affected_rows() > 0);
+            bumpCatalogVersion(tr, *_cache);
             tr.commit();
         }
         catch (const pqxx::broken_connection &e)
@@ -1218,6 +1254,7 @@ namespace scidb
             _connection->prepare("delete-array-id", sql1)("integer", treat_direct);
             totalNewArrays -= tr.prepared("delete-array-id")(array_id).exec().affected_rows();
 
+            bumpCatalogVersion(tr, *_cache);
             tr.commit();
         }
         catch (const broken_connection &e)
@@ -1281,6 +1318,7 @@ namespace scidb
                 tr.prepared(sql1)(array_id)(version_array_id)(version_id)(timestamp).exec();
 
 
+                bumpCatalogVersion(tr, *_cache);
                 tr.commit();
             }
             catch (const broken_connection &e)
@@ -1332,6 +1370,7 @@ namespace scidb
                 ("bigint", treat_direct);
             tr.prepared("delete-version")(array_id)(version_id).exec();
             _connection->unprepare("delete-version");
+            bumpCatalogVersion(tr, *_cache);
             tr.commit();
         }
         catch (const broken_connection &e)
@@ -1359,11 +1398,65 @@ namespace scidb
 
     VersionID SystemCatalog::getLastVersion(const ArrayID array_id)
     {
+        VersionID version_id = 0;
+        if (_cache->getLastVersion(array_id, version_id)) {
+            return version_id;
+        }
         boost::function<VersionID()> work = boost::bind(&SystemCatalog::_getLastVersion,
                 this, array_id);
         return Query::runRestartableWork<VersionID, broken_connection>(work, _reconnectTries);
     }
 
+    uint64_t SystemCatalog::getCatalogVersion()
+    {
+        boost::function<uint64_t()> work = boost::bind(&SystemCatalog::_getCatalogVersion, this);
+        return Query::runRestartableWork<uint64_t, broken_connection>(work, _reconnectTries);
+    }
+
+    uint64_t SystemCatalog::_getCatalogVersion()
+    {
+        LOG4CXX_TRACE(logger, "SystemCatalog::getCatalogVersion()");
+
+        ScopedMutexLock mutexLock(_pgLock);
+        try
+        {
+            work tr(*_connection);
+            uint64_t catalogVersion = readCatalogVersion(tr);
+            _cache->validate(catalogVersion);
+            tr.commit();
+            return catalogVersion;
+        }
+        catch (const broken_connection &e)
+        {
+            throw;
+        }
+        catch (const sql_error &e)
+        {
+            throw SYSTEM_EXCEPTION(SCIDB_SE_SYSCAT, SCIDB_LE_PG_QUERY_EXECUTION_FAILED) << e.query() << e.what();
+        }
+        catch (const Exception &e)
+        {
+            throw;
+        }
+        catch (const std::exception &e)
+        {
+            throw SYSTEM_EXCEPTION(SCIDB_SE_SYSCAT, SCIDB_LE_UNKNOWN_ERROR) << e.what();
+        }
+        catch (...)
+        {
+            throw SYSTEM_EXCEPTION(SCIDB_SE_SYSCAT, SCIDB_LE_UNKNOWN_ERROR) <<
+                "Unknown exception when getting the catalog version";
+        }
+        return 0;
+    }
+
+    void SystemCatalog::validateCache(uint64_t catalogVersion)
+    {
+        // Under _pgLock, so that no fill read before the update behind catalogVersion lands after it
+        ScopedMutexLock mutexLock(_pgLock);
+        _cache->validate(catalogVersion);
+    }
+
     ArrayID SystemCatalog::getOldestArrayVersion(const ArrayID id)
     {
         boost::function<VersionID()> work = boost::bind(&SystemCatalog::_getOldestArrayVersion,
@@ -1397,6 +1490,7 @@ namespace scidb
             result query_res = tr.prepared("select-last-version")(array_id).exec();
             VersionID version_id = query_res[0].at("vid").as(uint64_t());
             tr.commit();
+            _cache->putLastVersion(array_id, version_id);
             return version_id;
         }
         catch (const broken_connection &e)
@@ -1562,6 +1656,10 @@ namespace scidb
 
     Coordinates SystemCatalog::getHighBoundary(const ArrayID array_id)
     {
+        Coordinates highBoundary;
+        if (_cache->getBoundary(array_id, true, highBoundary)) {
+            return highBoundary;
+        }
         boost::function<Coordinates()> work = boost::bind(&SystemCatalog::_getHighBoundary,
                 this, array_id);
         return Query::runRestartableWork<Coordinates, broken_connection>(work, _reconnectTries);
@@ -1592,6 +1690,7 @@ namespace scidb
                 throw USER_EXCEPTION(SCIDB_SE_SYSCAT, SCIDB_LE_ARRAYID_DOESNT_EXIST) <<array_id ;
             }
             tr.commit();
+            _cache->putBoundary(array_id, true, highBoundary);
             return highBoundary;
         }
         catch (const broken_connection &e)
@@ -1620,6 +1719,10 @@ namespace scidb
 
     Coordinates SystemCatalog::getLowBoundary(const ArrayID array_id)
     {
+        Coordinates lowBoundary;
+        if (_cache->getBoundary(array_id, false, lowBoundary)) {
+            return lowBoundary;
+        }
         boost::function<Coordinates()> work = boost::bind(&SystemCatalog::_getLowBoundary,
                 this, array_id);
         return Query::runRestartableWork<Coordinates, broken_connection>(work, _reconnectTries);
@@ -1650,6 +1753,7 @@ namespace scidb
                 throw USER_EXCEPTION(SCIDB_SE_SYSCAT, SCIDB_LE_ARRAYID_DOESNT_EXIST) <<array_id ;
             }
             tr.commit();
+            _cache->putBoundary(array_id, false, lowBoundary);
             return lowBoundary;
         }
         catch (const broken_connection &e)
@@ -1711,6 +1815,7 @@ namespace scidb
                 tr.prepared("update-low-boundary")(low[i])(array_id)(i).exec();
                 tr.prepared("update-high-boundary")(high[i])(array_id)(i).exec();
             }
+            bumpCatalogVersion(tr, *_cache);
             tr.commit();
         }
         catch (const broken_connection &e)
@@ -1814,6 +1919,7 @@ namespace scidb
                 ("varchar", treat_string);
             tr.prepared(sql1)(instance_id)(instance.getHost())(instance.getPort())(instance.getPath()).exec();
 
+            bumpCatalogVersion(tr, *_cache);
             tr.commit();
         }
         catch (const broken_connection &e)
@@ -1841,6 +1947,11 @@ namespace scidb
 
     void SystemCatalog::getInstances(Instances &instances)
     {
+        Instances cached;
+        if (_cache->getInstances(cached)) {
+            instances.insert(instances.end(), cached.begin(), cached.end());
+            return;
+        }
         boost::function<void()> work = boost::bind(&SystemCatalog::_getInstances,
                 this, ref(instances));
         Query::runRestartableWork<void, broken_connection>(work, _reconnectTries);
@@ -1879,6 +1990,7 @@ namespace scidb
             }
 
             tr.commit();
+            _cache->putInstances(Instances(instances.end() - query_res.size(), instances.end()));
         }
         catch (const broken_connection &e)
         {
@@ -1990,6 +2102,7 @@ namespace scidb
 
             tr.prepared(sql)(host)(port)(instance_id).exec();
 
+            bumpCatalogVersion(tr, *_cache);
             tr.commit();
         }
         catch (const broken_connection &e)
@@ -2038,6 +2151,7 @@ namespace scidb
 
             tr.prepared(sql)(instance_id).exec();
 
+            bumpCatalogVersion(tr, *_cache);
             tr.commit();
         }
         catch (const broken_connection &e)
@@ -2106,6 +2220,7 @@ namespace scidb
 
             tr.prepared(sql)(compressionMethod)(array_id)(attr_id).exec();
 
+            bumpCatalogVersion(tr, *_cache);
             tr.commit();
         }
         catch (const broken_connection &e)
@@ -2418,6 +2533,7 @@ namespace scidb
     _connection(NULL),
     _uuid(""),
     _metadataVersion(-1),
+    _cache(new CatalogCache(std::max(Config::getInstance()->getOption<int>(CONFIG_CATALOG_CACHE_SIZE), 0))),
     _reconnectTries(Config::getInstance()->getOption<int>(CONFIG_CATALOG_RECONNECT_TRIES))
     {
 
@@ -2441,6 +2557,7 @@ namespace scidb
                 LOG4CXX_DEBUG(logger, "Error when disconnecting from PostgreSQL.");
             }
         }
+        delete _cache;
     }
 
 int SystemCatalog::getMetadataVersion() const
@@ -2708,6 +2825,8 @@ bool SystemCatalog::_lockArray(const boost::shared_ptr<LockDesc>& lockDesc, Erro
               assert(false);
           }
           if (query_res.affected_rows() == 1) {
+              // The metadata this query is about to read may have been updated by other instances
+              _cache->validate(readCatalogVersion(tr));
               tr.commit();
               lockDesc->setLocked(true);
               LOG4CXX_DEBUG(logger, "SystemCatalog::lockArray: locked "<<lockDesc->toString());
@@ -2940,6 +3059,7 @@ void SystemCatalog::_readArrayLocks(const InstanceID instanceId,
          }
          LOG4CXX_TRACE(logger, lock->toString());
       }
+      _cache->validate(readCatalogVersion(tr));
       tr.commit();
    }
    catch (const broken_connection &e)
@@ -3175,6 +3295,7 @@ void SystemCatalog::_renameArray(const string &old_array_name, const string &new
       if (!rc) {
           throw SYSTEM_EXCEPTION(SCIDB_SE_SYSCAT, SCIDB_LE_ARRAY_DOESNT_EXIST) << old_array_name;
       }
+      bumpCatalogVersion(tr, *_cache);
       tr.commit();
    }
    catch (const broken_connection &e)
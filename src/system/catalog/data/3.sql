@@ -0,0 +1,7 @@
+--upgrade from 2 to 3
+
+-- Incremented by every metadata update, so that the instances know when to drop their catalog cache
+alter table "cluster"
+    add column catalog_version bigint not null default 0;
+
+update "cluster" set metadata_version = 3;
@@ -51,7 +51,8 @@ create sequence "libraries_id_seq";
 create table "cluster"
 (
   cluster_uuid uuid,
-  metadata_version integer
+  metadata_version integer,
+  catalog_version bigint not null default 0
 );
 --
 --  Table: "array"  (public.array) List of arrays in the SciDB installation.
@@ -346,7 +347,7 @@ as '$libdir/uuid-ossp', 'uuid_generate_v1'
 volatile strict language C;
 
 
--- The version number (2) corresponds to the var METADATA_VERSION from Constants.h
+-- The version number (3) corresponds to the var METADATA_VERSION from Constants.h
 -- If we start and find that cluster.metadata_version is less than METADATA_VERSION
 -- upgrade. The upgrade files are provided as sql scripts in 
 -- src/system/catalog/data/[NUMBER].sql. They are converted to string 
@@ -354,7 +355,7 @@ volatile strict language C;
 -- and then linked in at build time. 
 -- @see SystemCatalog::connect(const string&, bool)
 -- Note: there is no downgrade path at the moment.
-insert into "cluster" values (uuid_generate_v1(), 2);
+insert into "cluster" values (uuid_generate_v1(), 3);
 
 create function get_cluster_uuid() returns uuid as $$
 declare t uuid;
@@ -209,7 +209,8 @@ DataStore::allocateSpace(size_t requestedSize, size_t& allocatedSize)
 }
 
 /* Write bytes to the DataStore, to a location that is already
-   allocated
+   allocated.  The location belongs to the caller, so the write itself
+   is done without the lock and concurrent writers do not serialize.
  */
 void
 DataStore::writeData(off_t off,
@@ -217,8 +218,6 @@ DataStore::writeData(off_t off,
                      size_t len,
                      size_t allocatedSize)
 {
-    ScopedMutexLock sm(_dslock);
-
     DiskChunkHeader hdr(false, allocatedSize);
     struct iovec iovs[2];
 
@@ -235,6 +234,7 @@ DataStore::writeData(off_t off,
 
     /* Update the dirty flag and schedule flush if necessary
      */
+    ScopedMutexLock sm(_dslock);
     if (!_dirty)
     {
         _dirty = true;
@@ -216,6 +216,7 @@ namespace scidb
         /* Try to write the data, retrying if we are interrupted by signals
          */
         const char* src = (const char*)data;
+        const size_t totalSize = size;
         size_t nRetries = 0;
         size_t eintrRetries = 0;
         while (size != 0) {
@@ -249,8 +250,9 @@ namespace scidb
             size -= rc;
             offs += rc;
         }
-        currentStatistics->writtenSize += size;
+        currentStatistics->writtenSize += totalSize;
         currentStatistics->writtenChunks++;
+        addToCurrentProfile(OperatorProfile::BYTES_WRITTEN, totalSize);
     }
 
 
@@ -311,6 +313,7 @@ namespace scidb
         }
         currentStatistics->writtenSize += totalSize;
         currentStatistics->writtenChunks++;
+        addToCurrentProfile(OperatorProfile::BYTES_WRITTEN, totalSize);
      }
 
 
@@ -330,6 +333,7 @@ namespace scidb
         /* Try to read the data, retrying if we are interrupted by signals
          */
         char* dst = (char*)data;
+        const size_t totalSize = size;
         size_t nRetries = 0;
         size_t eintrRetries = 0;
         while (size != 0) {
@@ -365,8 +369,9 @@ namespace scidb
             size -= rc;
             offs += rc;
         }
-        currentStatistics->readSize += size;
+        currentStatistics->readSize += totalSize;
         currentStatistics->readChunks++;
+        addToCurrentProfile(OperatorProfile::BYTES_READ, totalSize);
     }
 
 
@@ -427,6 +432,7 @@ namespace scidb
         }
         currentStatistics->readSize += totalSize;
         currentStatistics->readChunks++;
+        addToCurrentProfile(OperatorProfile::BYTES_READ, totalSize);
     }
 
 
@@ -604,6 +610,22 @@ namespace scidb
         return rc;
     }
 
+    /* Advise the kernel of the expected access pattern
+     */
+    int
+    File::fadvise(uint64_t offs, uint64_t len, int advice)
+    {
+        /* Verify that the fd is open
+         */
+        checkClosedByUser();
+        FileMonitor fm(_fm, *this);
+
+        assert(_fd >= 0);
+        assert(_pin);
+
+        return ::posix_fadvise(_fd, offs, len, advice);
+    }
+
     /* Mark file to be removed on last close
      */
     void
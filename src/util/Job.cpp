@@ -32,6 +32,7 @@
 #include <util/WorkQueue.h>
 #include <query/Query.h>
 #include <util/Job.h>
+#include <util/Tracer.h>
 
 static log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("scidb.common.thread"));
 
@@ -58,6 +59,7 @@ namespace scidb
         if (!_removed) {
             const char *err_msg = "Job::execute: unhandled exception";
             try {
+                TraceScope trace(Tracer::JOB, 0, typeid(*this).name());
                 run();
 
             } catch (Exception const& x) {
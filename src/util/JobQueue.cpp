@@ -28,60 +28,612 @@
  * @brief The queue of jobs for execution in thread pool
  */
 
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <set>
+#include <vector>
+#include <boost/weak_ptr.hpp>
+#include <log4cxx/logger.h>
+
 #include "util/JobQueue.h"
 #include "util/Mutex.h"
-#include <log4cxx/logger.h>
+#include "system/Sysinfo.h"
 
 namespace scidb
 {
 
 static log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("scidb.common.thread"));
 
-JobQueue::JobQueue()
+/**
+ * A job on its way through the lock-free structures: a heap-allocated holder of the job pointer,
+ * so that it can be moved around with single-word reads, writes and CAS.
+ */
+typedef boost::shared_ptr<Job>* JobRef;
+
+/**
+ * Chase-Lev work-stealing deque (D. Chase, Y. Lev, "Dynamic Circular Work-Stealing Deque", 2005).
+ * The owner pushes and pops at the bottom, thieves take from the top. The circular array grows
+ * when full; retired arrays are kept until the deque is destroyed, since a thief may still be
+ * reading from them.
+ */
+class WorkDeque
 {
+public:
+    WorkDeque(int numaNode)
+    : node(numaNode),
+      spawned(0),
+      localPops(0),
+      steals(0),
+      nodeSteals(0),
+      _top(0),
+      _bottom(0),
+      _array(new CircularArray(INITIAL_LOG_SIZE))
+    {
+    }
+
+    ~WorkDeque()
+    {
+        for (int64_t i = _top; i < _bottom; i++) {
+            delete _array->get(i);
+        }
+        delete _array;
+        for (size_t i = 0; i < _retired.size(); i++) {
+            delete _retired[i];
+        }
+    }
+
+    /// Called by the owner only
+    void push(JobRef job)
+    {
+        int64_t const b = _bottom;
+        int64_t const t = _top;
+        CircularArray* a = _array;
+        if (b - t >= static_cast<int64_t>(a->size())) {
+            a = grow(a, b, t);
+        }
+        a->put(b, job);
+        __sync_synchronize();
+        _bottom = b + 1;
+    }
+
+    /// Called by the owner only
+    JobRef pop()
+    {
+        int64_t const b = _bottom - 1;
+        CircularArray* a = _array;
+        _bottom = b;
+        __sync_synchronize();
+        int64_t const t = _top;
+        if (t > b) {
+            _bottom = b + 1;
+            return NULL;
+        }
+        JobRef job = a->get(b);
+        if (t == b) {
+            // the last job: race the thieves for it
+            if (!__sync_bool_compare_and_swap(&_top, t, t + 1)) {
+                job = NULL;
+            }
+            _bottom = b + 1;
+        }
+        return job;
+    }
+
+    /**
+     * Called by any thread
+     * @param lost [out] set to true if another thread took the top job first
+     */
+    JobRef steal(bool& lost)
+    {
+        int64_t const t = _top;
+        __sync_synchronize();
+        int64_t const b = _bottom;
+        __sync_synchronize();
+        if (t >= b) {
+            return NULL;
+        }
+        CircularArray* a = _array;
+        JobRef job = a->get(t);
+        if (!__sync_bool_compare_and_swap(&_top, t, t + 1)) {
+            lost = true;
+            return NULL;
+        }
+        return job;
+    }
+
+    int const node;
+
+    /// Counters written by the owner only
+    uint64_t spawned;
+    uint64_t localPops;
+    uint64_t steals;
+    uint64_t nodeSteals;
+
+private:
+    static const size_t INITIAL_LOG_SIZE = 8;
+
+    class CircularArray
+    {
+    public:
+        CircularArray(size_t logSize)
+        : _logSize(logSize),
+          _mask((size_t(1) << logSize) - 1),
+          _cells(new JobRef[size_t(1) << logSize])
+        {
+        }
+
+        ~CircularArray()
+        {
+            delete[] _cells;
+        }
+
+        size_t size() const
+        {
+            return _mask + 1;
+        }
+
+        size_t logSize() const
+        {
+            return _logSize;
+        }
+
+        JobRef get(int64_t i) const
+        {
+            return _cells[static_cast<size_t>(i) & _mask];
+        }
+
+        void put(int64_t i, JobRef job)
+        {
+            _cells[static_cast<size_t>(i) & _mask] = job;
+        }
+
+    private:
+        size_t const _logSize;
+        size_t const _mask;
+        JobRef volatile* const _cells;
+    };
+
+    CircularArray* grow(CircularArray* a, int64_t b, int64_t t)
+    {
+        CircularArray* bigger = new CircularArray(a->logSize() + 1);
+        for (int64_t i = t; i < b; i++) {
+            bigger->put(i, a->get(i));
+        }
+        _retired.push_back(a);
+        __sync_synchronize();
+        _array = bigger;
+        return bigger;
+    }
+
+    // keep the ends, which thieves and the owner write, on separate cache lines
+    char _pad0[64];
+    volatile int64_t _top;
+    char _pad1[64];
+    volatile int64_t _bottom;
+    CircularArray* volatile _array;
+    std::vector<CircularArray*> _retired;
+};
+
+/**
+ * Bounded lock-free multi-producer multi-consumer ring (D. Vyukov's bounded MPMC queue).
+ * Every cell carries a sequence number telling whether it is free for the producer
+ * or filled for the consumer of a given position.
+ */
+class InjectionRing
+{
+public:
+    InjectionRing(size_t size)
+    : _mask(size - 1),
+      _cells(new Cell[size]),
+      _enqueuePos(0),
+      _dequeuePos(0)
+    {
+        assert(size >= 2 && (size & (size - 1)) == 0);
+        for (size_t i = 0; i < size; i++) {
+            _cells[i].seq = i;
+            _cells[i].job = NULL;
+        }
+    }
+
+    ~InjectionRing()
+    {
+        JobRef job;
+        while ((job = dequeue()) != NULL) {
+            delete job;
+        }
+        delete[] _cells;
+    }
+
+    /// @return false if the ring is full
+    bool enqueue(JobRef job)
+    {
+        size_t pos = _enqueuePos;
+        Cell* cell;
+        while (true) {
+            cell = &_cells[pos & _mask];
+            intptr_t const dif = static_cast<intptr_t>(cell->seq) - static_cast<intptr_t>(pos);
+            if (dif == 0) {
+                if (__sync_bool_compare_and_swap(&_enqueuePos, pos, pos + 1)) {
+                    break;
+                }
+                pos = _enqueuePos;
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = _enqueuePos;
+            }
+        }
+        cell->job = job;
+        __sync_synchronize();
+        cell->seq = pos + 1;
+        return true;
+    }
+
+    /// @return NULL if the ring is empty
+    JobRef dequeue()
+    {
+        size_t pos = _dequeuePos;
+        Cell* cell;
+        while (true) {
+            cell = &_cells[pos & _mask];
+            intptr_t const dif = static_cast<intptr_t>(cell->seq) - static_cast<intptr_t>(pos + 1);
+            if (dif == 0) {
+                if (__sync_bool_compare_and_swap(&_dequeuePos, pos, pos + 1)) {
+                    break;
+                }
+                pos = _dequeuePos;
+            } else if (dif < 0) {
+                return NULL;
+            } else {
+                pos = _dequeuePos;
+            }
+        }
+        JobRef job = cell->job;
+        __sync_synchronize();
+        cell->seq = pos + _mask + 1;
+        return job;
+    }
+
+private:
+    struct Cell
+    {
+        volatile size_t seq;
+        JobRef volatile job;
+    };
+
+    size_t const _mask;
+    Cell* const _cells;
+    char _pad0[64];
+    volatile size_t _enqueuePos;
+    char _pad1[64];
+    volatile size_t _dequeuePos;
+};
+
+namespace
+{
+    /// The queue (by id, ids are never reused) and the deque of the calling pool thread
+    __thread uint64_t tlsQueueId = 0;
+    __thread WorkDeque* tlsDeque = NULL;
+    /// The job the calling thread took last from a queue, i.e. the one it is running
+    __thread boost::weak_ptr<Job>* tlsRunningJob = NULL;
+    pthread_key_t runningJobKey;
+    pthread_once_t runningJobKeyOnce = PTHREAD_ONCE_INIT;
+
+    void deleteRunningJob(void* job)
+    {
+        delete static_cast<boost::weak_ptr<Job>*>(job);
+    }
+
+    void createRunningJobKey()
+    {
+        pthread_key_create(&runningJobKey, deleteRunningJob);
+    }
+
+    /// A weak pointer, so that a new job allocated where a finished one was is not taken for it
+    boost::weak_ptr<Job>& runningJob()
+    {
+        if (tlsRunningJob == NULL) {
+            pthread_once(&runningJobKeyOnce, createRunningJobKey);
+            tlsRunningJob = new boost::weak_ptr<Job>();
+            pthread_setspecific(runningJobKey, tlsRunningJob);
+        }
+        return *tlsRunningJob;
+    }
+    /// Where the calling thread starts looking for a victim
+    __thread size_t tlsStealStart = 0;
+
+    volatile uint64_t nextQueueId = 0;
+
+    Mutex& getRegistryMutex()
+    {
+        static Mutex mutex;
+        return mutex;
+    }
 
+    std::set<JobQueue*>& getRegistry()
+    {
+        static std::set<JobQueue*> registry;
+        return registry;
+    }
+
+    /// Number of times an idle thread looks for work again before going to sleep
+    const int IDLE_SPINS = 16;
+
+    /// Longest pause of an idle thread waiting for a job that is on its way into the queue
+    const useconds_t MAX_IDLE_PAUSE_USEC = 1000;
+}
+
+const size_t JobQueue::MAX_WORKERS;
+const size_t JobQueue::INJECTION_RING_SIZE;
+
+JobQueue::JobQueue(size_t nNodes)
+: _nNodes(std::max(nNodes, size_t(1))),
+  _size(0),
+  _nWorkers(0),
+  _injected(0),
+  _sleeps(0),
+  _sleepers(0)
+{
+    _id = __sync_add_and_fetch(&nextQueueId, 1);
+    for (size_t i = 0; i < MAX_WORKERS; i++) {
+        _workers[i] = NULL;
+    }
+    for (size_t p = 0; p < NUM_PRIORITIES; p++) {
+        _rings[p] = new InjectionRing(INJECTION_RING_SIZE);
+        _overflowSize[p] = 0;
+    }
+    ScopedMutexLock cs(getRegistryMutex());
+    getRegistry().insert(this);
+}
+
+JobQueue::~JobQueue()
+{
+    {
+        ScopedMutexLock cs(getRegistryMutex());
+        getRegistry().erase(this);
+    }
+    size_t const nWorkers = std::min(static_cast<size_t>(_nWorkers), MAX_WORKERS);
+    for (size_t i = 0; i < nWorkers; i++) {
+        delete _workers[i];
+    }
+    for (size_t p = 0; p < NUM_PRIORITIES; p++) {
+        delete _rings[p];
+    }
+}
+
+void JobQueue::attachWorker()
+{
+    if (tlsQueueId == _id) {
+        return;
+    }
+    size_t const slot = __sync_fetch_and_add(&_nWorkers, 1);
+    if (slot >= MAX_WORKERS) {
+        LOG4CXX_WARN(logger, "JobQueue::attachWorker: Q ("<<this<<") has more than " << MAX_WORKERS
+                     << " workers, the extra ones take jobs from the other workers only");
+        return;
+    }
+    WorkDeque* deque = new WorkDeque(_nNodes > 1 ? Sysinfo::getCurrentNUMANode() : 0);
+    __sync_synchronize();
+    _workers[slot] = deque;
+    tlsQueueId = _id;
+    tlsDeque = deque;
+    tlsStealStart = slot + 1;
+}
+
+void JobQueue::wakeUp()
+{
+    // pairs with the increment of _sleepers in sleep(): either the pusher sees the sleeper,
+    // or the sleeper sees the job
+    __sync_synchronize();
+    if (_sleepers == 0) {
+        return;
+    }
+    ScopedMutexLock cs(_sleepMutex);
+    if (!_idle.empty()) {
+        Semaphore* sleeper = _idle.back();
+        _idle.pop_back();
+        __sync_sub_and_fetch(&_sleepers, 1);
+        sleeper->release();
+    }
+}
+
+void JobQueue::sleep()
+{
+    Semaphore wake;
+    {
+        ScopedMutexLock cs(_sleepMutex);
+        _idle.push_back(&wake);
+        __sync_add_and_fetch(&_sleepers, 1);
+        if (_size != 0) {
+            // nobody else takes from _idle while we hold the mutex
+            _idle.pop_back();
+            __sync_sub_and_fetch(&_sleepers, 1);
+            return;
+        }
+        __sync_add_and_fetch(&_sleeps, 1);
+    }
+    wake.enter();
+    // the waker releases the semaphore under the mutex; wait for it to let go before destroying it
+    ScopedMutexLock cs(_sleepMutex);
 }
 
 // Add new job to the end of queue
 void JobQueue::pushJob(boost::shared_ptr<Job> job)
 {
-    { // scope
-        ScopedMutexLock scopedMutexLock(_queueMutex);
-        _queue.push_back(job);
+    if (tlsQueueId == _id && tlsDeque != NULL && runningJob().lock() != job) {
+        // a job spawned by a pool thread: keep it local
+        __sync_add_and_fetch(&_size, 1);
+        tlsDeque->push(new boost::shared_ptr<Job>(job));
+        ++tlsDeque->spawned;
         LOG4CXX_TRACE(logger, "JobQueue::pushJob: Q ("<<this<<") size = "<<getSize());
+        wakeUp();
+        return;
     }
-    // We are releasing semaphore after unlocking mutex to
-    // prevent unwanted _queueMutex sleeping in popJob.
-    _queueSemaphore.release();
+    inject(job, NORMAL_PRIORITY);
+    LOG4CXX_TRACE(logger, "JobQueue::pushJob: Q ("<<this<<") size = "<<getSize());
 }
 
-// Add new job to the end of queue
+// Add new job to the beginning of queue
 void JobQueue::pushHighPriorityJob(boost::shared_ptr<Job> job)
 {
-    { // scope
-        ScopedMutexLock scopedMutexLock(_queueMutex);
-        _queue.push_front(job);
-        LOG4CXX_TRACE(logger, "JobQueue::pushHighPriorityJob: Q ("<<this<<") size = "<<getSize());
+    inject(job, HIGH_PRIORITY);
+    LOG4CXX_TRACE(logger, "JobQueue::pushHighPriorityJob: Q ("<<this<<") size = "<<getSize());
+}
+
+void JobQueue::inject(boost::shared_ptr<Job> const& job, Priority priority)
+{
+    __sync_add_and_fetch(&_size, 1);
+    __sync_add_and_fetch(&_injected, 1);
+    JobRef ref = new boost::shared_ptr<Job>(job);
+    // once jobs have overflowed, the later ones follow them until the overflow list drains
+    if (_overflowSize[priority] != 0 || !_rings[priority]->enqueue(ref)) {
+        delete ref;
+        ScopedMutexLock cs(_overflowMutex);
+        _overflow[priority].push_back(job);
+        ++_overflowSize[priority];
+    }
+    wakeUp();
+}
+
+JobRef JobQueue::popInjected(Priority priority)
+{
+    JobRef ref = _rings[priority]->dequeue();
+    if (ref != NULL || _overflowSize[priority] == 0) {
+        return ref;
+    }
+    ScopedMutexLock cs(_overflowMutex);
+    if (_overflow[priority].empty()) {
+        return NULL;
+    }
+    ref = new boost::shared_ptr<Job>(_overflow[priority].front());
+    _overflow[priority].pop_front();
+    --_overflowSize[priority];
+    return ref;
+}
+
+JobRef JobQueue::steal(WorkDeque* thief)
+{
+    size_t const nWorkers = std::min(static_cast<size_t>(_nWorkers), MAX_WORKERS);
+    if (nWorkers == 0) {
+        return NULL;
     }
-    // We are releasing semaphore after unlocking mutex to
-    // prevent unwanted _queueMutex sleeping in popJob.
-    _queueSemaphore.release();
+    size_t const start = tlsStealStart++;
+    // first pass over the thief's own NUMA node, the second one over the rest
+    bool const byNode = (_nNodes > 1 && thief != NULL);
+    for (int pass = byNode ? 0 : 1; pass < 2; pass++) {
+        for (size_t i = 0; i < nWorkers; i++) {
+            WorkDeque* victim = _workers[(start + i) % nWorkers];
+            if (victim == NULL || victim == thief) {
+                continue;
+            }
+            bool const sameNode = (byNode && victim->node == thief->node);
+            if (pass == 0 && !sameNode) {
+                continue;
+            }
+            if (pass == 1 && sameNode) {
+                continue;
+            }
+            while (true) {
+                bool lost = false;
+                JobRef ref = victim->steal(lost);
+                if (ref != NULL) {
+                    if (thief != NULL) {
+                        ++thief->steals;
+                        if (sameNode) {
+                            ++thief->nodeSteals;
+                        }
+                    }
+                    return ref;
+                }
+                if (!lost) {
+                    break;
+                }
+            }
+        }
+    }
+    return NULL;
 }
 
+JobRef JobQueue::tryPop(WorkDeque* self)
+{
+    JobRef ref = popInjected(HIGH_PRIORITY);
+    if (ref != NULL) {
+        return ref;
+    }
+    if (self != NULL && (ref = self->pop()) != NULL) {
+        ++self->localPops;
+        return ref;
+    }
+    if ((ref = popInjected(NORMAL_PRIORITY)) != NULL) {
+        return ref;
+    }
+    return steal(self);
+}
 
-// Get next job from the beginning of the queue
-// If there is next element the method waits
+// Get next job
+// If there is none the method waits
 boost::shared_ptr<Job> JobQueue::popJob()
 {
-    _queueSemaphore.enter();
-    { // scope
-        ScopedMutexLock scopedMutexLock(_queueMutex);
-        assert(!_queue.empty());
+    WorkDeque* self = (tlsQueueId == _id) ? tlsDeque : NULL;
+    runningJob().reset();
+    int spins = 0;
+    useconds_t pause = 1;
+    while (true) {
+        JobRef ref = tryPop(self);
+        if (ref != NULL) {
+            __sync_sub_and_fetch(&_size, 1);
+            boost::shared_ptr<Job> job(*ref);
+            delete ref;
+            runningJob() = job;
+            LOG4CXX_TRACE(logger, "JobQueue::popJob: Q ("<<this<<") size = "<<getSize());
+            return job;
+        }
+        if (++spins < IDLE_SPINS) {
+            // a job may soon arrive
+            sched_yield();
+            continue;
+        }
+        if (_size != 0) {
+            // a job is on its way into the queue: back off instead of spinning
+            usleep(pause);
+            pause = std::min(pause * 2, MAX_IDLE_PAUSE_USEC);
+            continue;
+        }
+        spins = 0;
+        pause = 1;
+        sleep();
+    }
+}
+
+JobQueue::Statistics JobQueue::getStatistics() const
+{
+    Statistics stats;
+    stats.depth = getSize();
+    stats.workers = std::min(static_cast<size_t>(_nWorkers), MAX_WORKERS);
+    stats.injected = _injected;
+    stats.spawned = 0;
+    stats.localPops = 0;
+    stats.steals = 0;
+    stats.nodeSteals = 0;
+    stats.sleeps = _sleeps;
+    for (size_t i = 0; i < stats.workers; i++) {
+        WorkDeque const* worker = _workers[i];
+        if (worker != NULL) {
+            stats.spawned += worker->spawned;
+            stats.localPops += worker->localPops;
+            stats.steals += worker->steals;
+            stats.nodeSteals += worker->nodeSteals;
+        }
+    }
+    return stats;
+}
 
-        boost::shared_ptr<Job> job = _queue.front();
-        _queue.pop_front();
-        LOG4CXX_TRACE(logger, "JobQueue::popJob: Q ("<<this<<") size = "<<getSize());
-        return job;
+void JobQueue::listQueues(boost::function<void(JobQueue const&)> const& visitor)
+{
+    ScopedMutexLock cs(getRegistryMutex());
+    for (std::set<JobQueue*>::const_iterator q = getRegistry().begin(); q != getRegistry().end(); ++q) {
+        visitor(**q);
     }
 }
 
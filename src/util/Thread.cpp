@@ -130,6 +130,8 @@ void Thread::_threadFunction()
     LOG4CXX_TRACE(logger, "Thread::threadFunction: begin tid = "
                   << pthread_self()
                   << ", pool = " << tp);
+    _threadPool.bindToNUMANode(_index);
+    _threadPool.getQueue()->attachWorker();
     while (true)
     {
         try
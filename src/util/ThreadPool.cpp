@@ -30,14 +30,18 @@
 #include "util/Thread.h"
 #include "system/Config.h"
 #include "system/SciDBConfigOptions.h"
+#include <log4cxx/logger.h>
 
 namespace scidb
 {
 
-ThreadPool::ThreadPool(size_t threadCount, boost::shared_ptr<JobQueue> queue)
+static log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("scidb.common.thread"));
+
+ThreadPool::ThreadPool(size_t threadCount, boost::shared_ptr<JobQueue> queue, bool numaAffinity)
 : _queue(queue),
   _currentJobs(threadCount),
   _threadCount(threadCount),
+  _numaAffinity(numaAffinity && Sysinfo::getNumberOfNUMANodes() > 1),
   _terminatedThreads(boost::make_shared<Semaphore>())
 {
     _shutdown = false;
@@ -71,6 +75,25 @@ void ThreadPool::start()
     }
 }
 
+void ThreadPool::bindToNUMANode(size_t index)
+{
+    if (!_numaAffinity) {
+        return;
+    }
+    int const node = static_cast<int>(index % Sysinfo::getNumberOfNUMANodes());
+    std::vector<int> const& cpus = Sysinfo::getNUMANodeCPUs(node);
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (size_t i = 0; i < cpus.size(); i++) {
+        CPU_SET(cpus[i], &cpuSet);
+    }
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+    if (rc != 0) {
+        LOG4CXX_WARN(logger, "ThreadPool::bindToNUMANode: pthread_setaffinity_np: " << rc
+                     << ", thread " << index << " stays unbound");
+    }
+}
+
 bool ThreadPool::isStarted()
 {
     ScopedMutexLock lock(_mutex);
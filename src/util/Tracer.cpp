@@ -0,0 +1,238 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file Tracer.cpp
+ *
+ * @brief Per-thread ring buffers of trace events.
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include <algorithm>
+#include <ostream>
+#include <vector>
+
+#include <util/Tracer.h>
+
+using namespace std;
+
+namespace scidb
+{
+
+namespace
+{
+
+struct TraceEvent
+{
+    uint64_t start;
+    uint64_t duration;
+    uint64_t queryID;
+    uint64_t arg;
+    const char* label;
+    uint32_t type;
+    uint32_t tid;
+};
+
+/**
+ * The ring buffer of a thread. Only the owner writes, publishing an event by incrementing head.
+ * A reader copies the events below head, then drops those the owner may have overwritten meanwhile.
+ */
+struct TraceBuffer
+{
+    static const uint64_t CAPACITY = 16384; // 768KiB per thread, a power of 2
+    static const uint64_t MASK = CAPACITY - 1;
+
+    TraceEvent events[CAPACITY];
+    volatile uint64_t head;
+    volatile bool inUse;
+
+    TraceBuffer() : head(0), inUse(true)
+    {
+    }
+};
+
+/*
+ * The buffers are kept after their thread exits, so that its events can still be dumped,
+ * and are reused by the next threads. The list is never destroyed: threads may trace until exit.
+ * The lock is a raw pthread mutex because Mutex traces its waits.
+ */
+pthread_mutex_t buffersMutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_once_t bufferKeyOnce = PTHREAD_ONCE_INIT;
+pthread_key_t bufferKey;
+
+vector<TraceBuffer*>& getBuffers()
+{
+    static vector<TraceBuffer*>* buffers = new vector<TraceBuffer*>();
+    return *buffers;
+}
+
+__thread TraceBuffer* threadBuffer = NULL;
+__thread uint32_t threadID = 0;
+__thread uint64_t threadQueryID = 0;
+
+void releaseBuffer(void* buffer)
+{
+    threadBuffer = NULL;
+    static_cast<TraceBuffer*>(buffer)->inUse = false;
+}
+
+void createBufferKey()
+{
+    pthread_key_create(&bufferKey, releaseBuffer);
+}
+
+TraceBuffer* acquireBuffer()
+{
+    pthread_once(&bufferKeyOnce, createBufferKey);
+    TraceBuffer* buffer = NULL;
+    pthread_mutex_lock(&buffersMutex);
+    vector<TraceBuffer*>& buffers = getBuffers();
+    for (size_t i = 0; i < buffers.size(); i++) {
+        if (!buffers[i]->inUse) {
+            buffer = buffers[i];
+            buffer->inUse = true;
+            break;
+        }
+    }
+    if (!buffer) {
+        buffer = new TraceBuffer();
+        buffers.push_back(buffer);
+    }
+    pthread_mutex_unlock(&buffersMutex);
+
+    pthread_setspecific(bufferKey, buffer);
+    threadID = static_cast<uint32_t>(syscall(SYS_gettid));
+    return buffer;
+}
+
+/**
+ * Copy the events of a buffer still present once copied.
+ */
+void copyEvents(TraceBuffer const& buffer, vector<TraceEvent>& events)
+{
+    const uint64_t head = buffer.head;
+    __sync_synchronize();
+    const uint64_t first = head > TraceBuffer::CAPACITY ? head - TraceBuffer::CAPACITY : 0;
+    const size_t base = events.size();
+    for (uint64_t i = first; i < head; i++) {
+        events.push_back(buffer.events[i & TraceBuffer::MASK]);
+    }
+    __sync_synchronize();
+
+    // The owner may be writing the event head + CAPACITY past the oldest one copied
+    const uint64_t after = buffer.head;
+    if (after + 1 > first + TraceBuffer::CAPACITY) {
+        const size_t overwritten = std::min(after + 1 - first - TraceBuffer::CAPACITY, head - first);
+        events.erase(events.begin() + base, events.begin() + base + overwritten);
+    }
+}
+
+} //namespace
+
+volatile bool Tracer::_enabled = false;
+
+void Tracer::setEnabled(bool enabled)
+{
+    _enabled = enabled;
+}
+
+void Tracer::setCurrentQueryID(uint64_t queryID)
+{
+    threadQueryID = queryID;
+}
+
+void Tracer::record(EventType type, uint64_t start, uint64_t end, uint64_t arg, const char* label)
+{
+    TraceBuffer* buffer = threadBuffer;
+    if (!buffer) {
+        buffer = threadBuffer = acquireBuffer();
+    }
+    const uint64_t head = buffer->head;
+    TraceEvent& event = buffer->events[head & TraceBuffer::MASK];
+    event.start = start;
+    event.duration = end > start ? end - start : 0;
+    event.queryID = threadQueryID;
+    event.arg = arg;
+    event.label = label;
+    event.type = type;
+    event.tid = threadID;
+    __sync_synchronize();
+    buffer->head = head + 1;
+}
+
+void Tracer::dump(std::ostream& out, uint64_t queryID, uint64_t from, uint64_t pid)
+{
+    vector<TraceBuffer*> buffers;
+    pthread_mutex_lock(&buffersMutex);
+    buffers = getBuffers();
+    pthread_mutex_unlock(&buffersMutex);
+
+    vector<TraceEvent> events;
+    for (size_t i = 0; i < buffers.size(); i++) {
+        copyEvents(*buffers[i], events);
+    }
+
+    out << "[{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid
+        << ",\"args\":{\"name\":\"instance " << pid << "\"}}";
+    for (size_t i = 0; i < events.size(); i++) {
+        TraceEvent const& event = events[i];
+        if (event.queryID != queryID &&
+            (event.queryID != 0 || event.start + event.duration < from)) {
+            continue;
+        }
+        out << ",\n{\"name\":\"" << getEventName(EventType(event.type))
+            << "\",\"cat\":\"scidb\",\"ph\":\"X\",\"ts\":" << event.start
+            << ",\"dur\":" << event.duration
+            << ",\"pid\":" << pid
+            << ",\"tid\":" << event.tid
+            << ",\"args\":{\"query\":" << event.queryID
+            << ",\"arg\":" << event.arg;
+        if (event.label) {
+            out << ",\"label\":\"" << event.label << "\"";
+        }
+        out << "}}";
+    }
+    out << "]\n";
+}
+
+const char* Tracer::getEventName(EventType type)
+{
+    static const char* names[NUM_EVENT_TYPES] =
+    {
+        "job",
+        "mutex wait",
+        "rwlock wait",
+        "chunk fetch",
+        "chunk decompress",
+        "sg send",
+        "sg receive",
+        "spill"
+    };
+    assert(type < NUM_EVENT_TYPES);
+    return names[type];
+}
+
+} //namespace scidb
@@ -0,0 +1,147 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file JobQueueBenchmark.cpp
+ *
+ * @brief Throughput of the work-stealing JobQueue against the single-lock queue it replaced.
+ *
+ * Two workloads (see JobTreeWorkload.h) are run with 32 and 64 worker threads, or the thread counts
+ * given on the command line:
+ * - inject: the main thread pushes a large number of tiny jobs, as the message handlers do;
+ * - spawn: jobs recursively push sub-jobs from the workers, as parallel operators do.
+ * The same workloads, with the online processors as workers, are the job_queue benchmarks
+ * of micro_benchmarks, whose results compare_benchmarks.py tracks.
+ *
+ * Usage: jobqueue_benchmark [nThreads ...]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/time.h>
+#include <vector>
+#include <list>
+
+#include <boost/shared_ptr.hpp>
+
+#include <util/Job.h>
+#include <util/JobQueue.h>
+#include <util/Mutex.h>
+#include <util/Semaphore.h>
+
+#include "JobTreeWorkload.h"
+
+using namespace std;
+using namespace boost;
+using namespace scidb;
+
+namespace
+{
+
+/**
+ * The JobQueue as it was before work stealing: one list under one mutex, a semaphore for the waiters.
+ */
+class LockedJobQueue
+{
+public:
+    void attachWorker()
+    {
+    }
+
+    void pushJob(shared_ptr<Job> const& job)
+    {
+        {
+            ScopedMutexLock cs(_mutex);
+            _queue.push_back(job);
+        }
+        _semaphore.release();
+    }
+
+    shared_ptr<Job> popJob()
+    {
+        _semaphore.enter();
+        ScopedMutexLock cs(_mutex);
+        shared_ptr<Job> job = _queue.front();
+        _queue.pop_front();
+        return job;
+    }
+
+private:
+    list<shared_ptr<Job> > _queue;
+    Mutex _mutex;
+    Semaphore _semaphore;
+};
+
+double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/**
+ * Run roots jobs each spawning a binary tree of the given depth.
+ * @return jobs executed per second
+ */
+template <class Queue>
+double run(size_t nThreads, size_t roots, int depth)
+{
+    JobTreeWorkload<Queue> workload(nThreads);
+    double const start = now();
+    uint64_t const total = workload.push(roots, depth);
+    workload.wait(total);
+    return total / (now() - start);
+}
+
+void report(char const* workload, size_t nThreads, double locked, double stealing)
+{
+    printf("%-8s threads=%-4lu locked=%12.0f jobs/s  work-stealing=%12.0f jobs/s  speedup=%.2f\n",
+           workload, (unsigned long) nThreads, locked, stealing, stealing / locked);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    vector<size_t> threadCounts;
+    for (int i = 1; i < argc; i++) {
+        threadCounts.push_back(atoi(argv[i]));
+    }
+    if (threadCounts.empty()) {
+        threadCounts.push_back(32);
+        threadCounts.push_back(64);
+    }
+    size_t const INJECTED_JOBS = 1000000;
+    size_t const SPAWN_ROOTS = 64;
+    int const SPAWN_DEPTH = 13;
+
+    for (size_t i = 0; i < threadCounts.size(); i++) {
+        size_t const n = threadCounts[i];
+        report("inject", n,
+               run<LockedJobQueue>(n, INJECTED_JOBS, 0),
+               run<JobQueue>(n, INJECTED_JOBS, 0));
+        report("spawn", n,
+               run<LockedJobQueue>(n, SPAWN_ROOTS, SPAWN_DEPTH),
+               run<JobQueue>(n, SPAWN_ROOTS, SPAWN_DEPTH));
+    }
+    return 0;
+}
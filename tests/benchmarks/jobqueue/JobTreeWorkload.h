@@ -0,0 +1,151 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file JobTreeWorkload.h
+ *
+ * @brief The JobQueue workload of jobqueue_benchmark and of the job_queue benchmarks of micro_benchmarks.
+ *
+ * Root jobs pushed by the main thread each spawn a binary tree of jobs from the workers:
+ * with depth 0 this is the injection of tiny jobs done by the message handlers,
+ * deeper trees are the sub-jobs pushed by parallel operators.
+ */
+
+#ifndef JOB_TREE_WORKLOAD_H_
+#define JOB_TREE_WORKLOAD_H_
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <util/Job.h>
+
+namespace scidb
+{
+
+/**
+ * Worker threads popping jobs from a Queue, which has the pushJob(), popJob() and attachWorker()
+ * of JobQueue. The workers are started by the constructor and stopped by the destructor.
+ */
+template <class Queue>
+class JobTreeWorkload
+{
+public:
+    explicit JobTreeWorkload(size_t nThreads) : _executed(0), _threads(nThreads)
+    {
+        for (size_t i = 0; i < _threads.size(); i++) {
+            pthread_create(&_threads[i], NULL, &work, &_queue);
+        }
+    }
+
+    ~JobTreeWorkload()
+    {
+        for (size_t i = 0; i < _threads.size(); i++) {
+            _queue.pushJob(boost::shared_ptr<Job>(new StopJob()));
+        }
+        for (size_t i = 0; i < _threads.size(); i++) {
+            pthread_join(_threads[i], NULL);
+        }
+    }
+
+    /**
+     * Push roots jobs each spawning a binary tree of the given depth.
+     * @return the number of jobs this adds to those to execute
+     */
+    uint64_t push(size_t roots, int depth)
+    {
+        for (size_t i = 0; i < roots; i++) {
+            _queue.pushJob(boost::shared_ptr<Job>(new TreeJob(this, depth)));
+        }
+        return roots * ((uint64_t(1) << (depth + 1)) - 1);
+    }
+
+    /**
+     * Wait until the number of jobs executed since the construction reaches total.
+     */
+    void wait(uint64_t total)
+    {
+        while (_executed < total) {
+            sched_yield();
+        }
+    }
+
+private:
+    class TreeJob : public Job
+    {
+    public:
+        TreeJob(JobTreeWorkload* workload, int depth)
+        : Job(boost::shared_ptr<Query>()), _workload(workload), _depth(depth)
+        {
+        }
+
+        virtual void run()
+        {
+            __sync_add_and_fetch(&_workload->_executed, 1);
+            if (_depth > 0) {
+                _workload->_queue.pushJob(boost::shared_ptr<Job>(new TreeJob(_workload, _depth - 1)));
+                _workload->_queue.pushJob(boost::shared_ptr<Job>(new TreeJob(_workload, _depth - 1)));
+            }
+        }
+
+    private:
+        JobTreeWorkload* _workload;
+        int _depth;
+    };
+
+    /** Makes a worker return */
+    class StopJob : public Job
+    {
+    public:
+        StopJob() : Job(boost::shared_ptr<Query>())
+        {
+        }
+
+        virtual void run()
+        {
+        }
+    };
+
+    static void* work(void* arg)
+    {
+        Queue* queue = static_cast<Queue*>(arg);
+        queue->attachWorker();
+        while (true) {
+            boost::shared_ptr<Job> job = queue->popJob();
+            if (dynamic_cast<StopJob*>(job.get())) {
+                return NULL;
+            }
+            job->execute();
+        }
+    }
+
+    Queue _queue;
+    volatile uint64_t _executed;
+    std::vector<pthread_t> _threads;
+};
+
+} //namespace scidb
+
+#endif /* JOB_TREE_WORKLOAD_H_ */
@@ -0,0 +1,356 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file ArrayBenchmarks.cpp
+ *
+ * @brief Benchmarks of RLEPayload, ConstRLEEmptyBitmap, the chunk compressors and TupleComparator.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <array/Compressor.h>
+#include <array/MemChunk.h>
+#include <array/Metadata.h>
+#include <array/RLE.h>
+#include <array/TupleArray.h>
+#include <query/TypeSystem.h>
+#include <util/iqsort.h>
+
+#include "Benchmark.h"
+
+using namespace std;
+using namespace boost;
+
+namespace scidb
+{
+namespace bench
+{
+
+namespace
+{
+
+const size_t PAYLOAD_SIZE = 64 * 1024;      // values of a payload or a chunk
+const position_t BITMAP_SIZE = 1024 * 1024; // logical positions of a bitmap
+const size_t SORTED_TUPLES = 64 * 1024;
+
+/**
+ * Runs of 64 equal values alternating with runs of 256 distinct values, so that payloads
+ * have both kinds of segments and the compressors have something to find.
+ */
+void makeValues(vector<int64_t>& values, size_t n)
+{
+    values.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        values[i] = (i / 256) % 2 == 0 ? int64_t(i / 64) : int64_t((i * 2654435761ULL) % 1000003);
+    }
+}
+
+void makePayload(RLEPayload& payload, vector<int64_t> const& values)
+{
+    RLEPayload::append_iterator appender(&payload);
+    appender.add(reinterpret_cast<char const*>(&values[0]), NULL, values.size());
+    appender.flush();
+}
+
+/**
+ * A bitmap whose positions p are set when (p + offset) % period < length.
+ */
+void makeBitmap(RLEEmptyBitmap& bitmap, position_t period, position_t length, position_t offset)
+{
+    position_t pPos = 0;
+    for (position_t lPos = 0; lPos < BITMAP_SIZE; lPos++) {
+        if ((lPos + offset) % period < length) {
+            bitmap.addPositionPair(lPos, pPos++);
+        }
+    }
+}
+
+void rlePayloadAppendValue(BenchmarkState& state)
+{
+    Type const& type = TypeLibrary::getType(TID_INT64);
+    vector<int64_t> values;
+    makeValues(values, PAYLOAD_SIZE);
+    Value value(type);
+    while (state.keepRunning()) {
+        RLEPayload payload(type);
+        RLEPayload::append_iterator appender(&payload);
+        for (size_t i = 0; i < values.size(); i++) {
+            value.setInt64(values[i]);
+            appender.add(value);
+        }
+        appender.flush();
+        doNotOptimize(payload.count());
+    }
+    state.setItemsProcessed(state.getIterations() * values.size());
+}
+
+void rlePayloadAppendBulk(BenchmarkState& state)
+{
+    Type const& type = TypeLibrary::getType(TID_INT64);
+    vector<int64_t> values;
+    makeValues(values, PAYLOAD_SIZE);
+    while (state.keepRunning()) {
+        RLEPayload payload(type);
+        makePayload(payload, values);
+        doNotOptimize(payload.count());
+    }
+    state.setItemsProcessed(state.getIterations() * values.size());
+}
+
+void rlePayloadIterateValues(BenchmarkState& state)
+{
+    vector<int64_t> values;
+    makeValues(values, PAYLOAD_SIZE);
+    RLEPayload payload(TypeLibrary::getType(TID_INT64));
+    makePayload(payload, values);
+    Value value;
+    while (state.keepRunning()) {
+        int64_t sum = 0;
+        for (ConstRLEPayload::iterator i(&payload); !i.end(); ++i) {
+            i.getItem(value);
+            sum += value.getInt64();
+        }
+        doNotOptimize(sum);
+    }
+    state.setItemsProcessed(state.getIterations() * values.size());
+}
+
+void rlePayloadIterateSegments(BenchmarkState& state)
+{
+    vector<int64_t> values;
+    makeValues(values, PAYLOAD_SIZE);
+    RLEPayload payload(TypeLibrary::getType(TID_INT64));
+    makePayload(payload, values);
+    while (state.keepRunning()) {
+        int64_t sum = 0;
+        for (ConstRLEPayload::iterator i(&payload); !i.end(); i.toNextSegment()) {
+            int64_t const* data = reinterpret_cast<int64_t const*>(i.getFixedValues());
+            uint64_t const length = i.getSegLength();
+            if (i.isSame()) {
+                sum += *data * int64_t(length);
+            } else {
+                for (uint64_t j = 0; j < length; j++) {
+                    sum += data[j];
+                }
+            }
+        }
+        doNotOptimize(sum);
+    }
+    state.setItemsProcessed(state.getIterations() * values.size());
+}
+
+void rlePayloadPack(BenchmarkState& state)
+{
+    vector<int64_t> values;
+    makeValues(values, PAYLOAD_SIZE);
+    RLEPayload payload(TypeLibrary::getType(TID_INT64));
+    makePayload(payload, values);
+    vector<char> buffer(payload.packedSize());
+    while (state.keepRunning()) {
+        payload.pack(&buffer[0]);
+        doNotOptimize(buffer[0]);
+    }
+    state.setBytesProcessed(state.getIterations() * buffer.size());
+}
+
+void rleBitmapBuild(BenchmarkState& state)
+{
+    while (state.keepRunning()) {
+        RLEEmptyBitmap bitmap;
+        makeBitmap(bitmap, 150, 100, 0);
+        doNotOptimize(bitmap.count());
+    }
+    state.setItemsProcessed(state.getIterations() * BITMAP_SIZE);
+}
+
+void rleBitmapIterate(BenchmarkState& state)
+{
+    RLEEmptyBitmap bitmap;
+    makeBitmap(bitmap, 150, 100, 0);
+    while (state.keepRunning()) {
+        position_t sum = 0;
+        for (ConstRLEEmptyBitmap::iterator i(&bitmap); !i.end(); ++i) {
+            sum += i.getLPos();
+        }
+        doNotOptimize(sum);
+    }
+    state.setItemsProcessed(state.getIterations() * bitmap.count());
+}
+
+/**
+ * merge() is the intersection of two bitmaps, join() their union.
+ */
+void rleBitmapCombine(BenchmarkState& state, bool intersect)
+{
+    RLEEmptyBitmap left;
+    makeBitmap(left, 150, 100, 0);
+    RLEEmptyBitmap right;
+    makeBitmap(right, 70, 40, 25);
+    while (state.keepRunning()) {
+        shared_ptr<RLEEmptyBitmap> result = intersect ? left.merge(right) : left.join(right);
+        doNotOptimize(result->count());
+    }
+    state.setItemsProcessed(state.getIterations() * (left.nSegments() + right.nSegments()));
+}
+
+ArrayDesc makeArrayDesc(TypeId type)
+{
+    Attributes attributes(1);
+    attributes[0] = AttributeDesc(0, "value", type, 0, 0);
+    Dimensions dimensions(1);
+    dimensions[0] = DimensionDesc("i", 0, PAYLOAD_SIZE - 1, PAYLOAD_SIZE, 0);
+    return ArrayDesc("micro_benchmark", attributes, dimensions);
+}
+
+/**
+ * Make a dense chunk of int64 values, stored without RLE so that the format sensitive
+ * compressors have a go at it.
+ */
+void makeChunk(MemChunk& chunk, ArrayDesc const& desc, int compressionMethod)
+{
+    vector<int64_t> values;
+    makeValues(values, PAYLOAD_SIZE);
+    chunk.initialize(NULL, &desc, Address(0, Coordinates(1, 0)), compressionMethod);
+    chunk.setRLE(false);
+    chunk.allocate(values.size() * sizeof(int64_t));
+    memcpy(chunk.getData(), &values[0], chunk.getSize());
+}
+
+string formatRatio(size_t size, size_t compressed)
+{
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "ratio %.2f", double(size) / compressed);
+    return buffer;
+}
+
+void compress(BenchmarkState& state, Compressor* compressor)
+{
+    ArrayDesc const desc = makeArrayDesc(TID_INT64);
+    MemChunk chunk;
+    makeChunk(chunk, desc, compressor->getType());
+    vector<char> buffer(chunk.getSize());
+    size_t compressed = 0;
+    while (state.keepRunning()) {
+        compressed = compressor->compress(&buffer[0], chunk);
+    }
+    state.setBytesProcessed(state.getIterations() * chunk.getSize());
+    state.setLabel(formatRatio(chunk.getSize(), compressed));
+}
+
+void decompress(BenchmarkState& state, Compressor* compressor)
+{
+    ArrayDesc const desc = makeArrayDesc(TID_INT64);
+    MemChunk chunk;
+    makeChunk(chunk, desc, compressor->getType());
+    vector<char> buffer(chunk.getSize());
+    size_t const compressed = compressor->compress(&buffer[0], chunk);
+    if (compressed >= chunk.getSize()) {
+        state.skip("the chunk is stored uncompressed");
+        return;
+    }
+    MemChunk output;
+    output.initialize(NULL, &desc, Address(0, Coordinates(1, 0)), compressor->getType());
+    output.setRLE(false);
+    output.allocate(chunk.getSize());
+    size_t decompressed = 0;
+    while (state.keepRunning()) {
+        decompressed = compressor->decompress(&buffer[0], compressed, output);
+    }
+    if (decompressed != chunk.getSize() || memcmp(output.getData(), chunk.getData(), chunk.getSize()) != 0) {
+        state.skip("the chunk does not decompress to its data");
+        return;
+    }
+    state.setBytesProcessed(state.getIterations() * chunk.getSize());
+    state.setLabel(formatRatio(chunk.getSize(), compressed));
+}
+
+/**
+ * Sort tuples of (int64 key, double) as sort() does, by key then by value.
+ */
+void tupleSort(BenchmarkState& state)
+{
+    Attributes attributes(2);
+    attributes[0] = AttributeDesc(0, "key", TID_INT64, 0, 0);
+    attributes[1] = AttributeDesc(1, "value", TID_DOUBLE, 0, 0);
+    Dimensions dimensions(1);
+    dimensions[0] = DimensionDesc("i", 0, SORTED_TUPLES - 1, SORTED_TUPLES, 0);
+    ArrayDesc const desc("micro_benchmark", attributes, dimensions);
+
+    vector<Key> keys(2);
+    keys[0].columnNo = 0;
+    keys[0].ascent = true;
+    keys[1].columnNo = 1;
+    keys[1].ascent = false;
+    TupleComparator comparator(keys, desc);
+
+    vector<shared_ptr<Tuple> > tuples(SORTED_TUPLES);
+    uint64_t random = 1;
+    for (size_t i = 0; i < tuples.size(); i++) {
+        random = random * 6364136223846793005ULL + 1442695040888963407ULL;
+        tuples[i] = shared_ptr<Tuple>(new Tuple(2));
+        (*tuples[i])[0].setInt64(int64_t(random >> 48));
+        (*tuples[i])[1].setDouble(double(random & 0xFFFF) / 7);
+    }
+
+    vector<shared_ptr<Tuple> > sorted;
+    while (state.keepRunning()) {
+        state.pauseTiming();
+        sorted = tuples;
+        state.resumeTiming();
+        iqsort(&sorted[0], sorted.size(), comparator);
+    }
+    state.setItemsProcessed(state.getIterations() * tuples.size());
+}
+
+}
+
+void registerArrayBenchmarks(Benchmarks& benchmarks)
+{
+    benchmarks.add("rle_payload/append_value", &rlePayloadAppendValue);
+    benchmarks.add("rle_payload/append_bulk", &rlePayloadAppendBulk);
+    benchmarks.add("rle_payload/iterate_values", &rlePayloadIterateValues);
+    benchmarks.add("rle_payload/iterate_segments", &rlePayloadIterateSegments);
+    benchmarks.add("rle_payload/pack", &rlePayloadPack);
+
+    benchmarks.add("rle_bitmap/build", &rleBitmapBuild);
+    benchmarks.add("rle_bitmap/iterate", &rleBitmapIterate);
+    benchmarks.add("rle_bitmap/merge", bind(&rleBitmapCombine, _1, true));
+    benchmarks.add("rle_bitmap/join", bind(&rleBitmapCombine, _1, false));
+
+    vector<Compressor*> const& compressors = CompressorFactory::getInstance().getCompressors();
+    for (size_t i = 0; i < compressors.size(); i++) {
+        string const name = compressors[i]->getName();
+        benchmarks.add("compress/" + name, bind(&compress, _1, compressors[i]));
+        benchmarks.add("decompress/" + name, bind(&decompress, _1, compressors[i]));
+    }
+
+    benchmarks.add("tuple_comparator/sort", &tupleSort);
+}
+
+} //namespace bench
+} //namespace scidb
@@ -0,0 +1,234 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file Benchmark.cpp
+ *
+ * @brief Calibration, repetition and reporting of the micro benchmarks.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include "Benchmark.h"
+
+using namespace std;
+
+namespace scidb
+{
+namespace bench
+{
+
+namespace
+{
+
+const uint64_t MAX_ITERATIONS = 1000000000;
+
+string formatRate(double perSecond, char const* unit)
+{
+    static char const* const prefixes[] = { "", "k", "M", "G", "T" };
+    size_t i = 0;
+    while (perSecond >= 1000 && i < sizeof(prefixes) / sizeof(prefixes[0]) - 1) {
+        perSecond /= 1000;
+        i++;
+    }
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.2f %s%s/s", perSecond, prefixes[i], unit);
+    return buffer;
+}
+
+void writeJsonString(ostream& out, string const& str)
+{
+    out << '"';
+    for (size_t i = 0; i < str.size(); i++) {
+        char const c = str[i];
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out << ' ';
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+bool lessNsPerOp(pair<double, BenchmarkState> const& a, pair<double, BenchmarkState> const& b)
+{
+    return a.first < b.first;
+}
+
+}
+
+void Benchmarks::add(string const& name, Function const& function)
+{
+    _benchmarks.push_back(make_pair(name, function));
+}
+
+Benchmarks::Result Benchmarks::measure(string const& name, Function const& function, BenchmarkOptions const& options)
+{
+    Result result;
+    result.name = name;
+    result.iterations = 0;
+    result.nsPerOp = result.minNsPerOp = 0;
+    result.itemsPerSecond = result.bytesPerSecond = 0;
+    result.skipped = false;
+
+    // Grow the iterations until a run lasts the minimum time
+    uint64_t iterations = 1;
+    while (true) {
+        BenchmarkState state(iterations);
+        function(state);
+        if (state.isSkipped()) {
+            result.skipped = true;
+            result.label = state.getLabel();
+            return result;
+        }
+        double const seconds = state.getElapsed() / 1e9;
+        if (seconds >= options.minTime || iterations >= MAX_ITERATIONS) {
+            break;
+        }
+        double const multiplier = seconds > 0 ? std::min(options.minTime * 1.4 / seconds, 100.0) : 100.0;
+        iterations = std::min(MAX_ITERATIONS, std::max(iterations + 1, uint64_t(iterations * multiplier)));
+    }
+
+    vector<pair<double, BenchmarkState> > runs;
+    for (size_t i = 0; i < std::max(options.repetitions, size_t(1)); i++) {
+        BenchmarkState state(iterations);
+        function(state);
+        if (state.isSkipped()) {
+            result.skipped = true;
+            result.label = state.getLabel();
+            return result;
+        }
+        runs.push_back(make_pair(double(state.getElapsed()) / iterations, state));
+    }
+    sort(runs.begin(), runs.end(), lessNsPerOp);
+
+    BenchmarkState const& median = runs[runs.size() / 2].second;
+    double const seconds = median.getElapsed() / 1e9;
+    result.iterations = iterations;
+    result.nsPerOp = runs[runs.size() / 2].first;
+    result.minNsPerOp = runs[0].first;
+    result.itemsPerSecond = seconds > 0 ? median.getItemsProcessed() / seconds : 0;
+    result.bytesPerSecond = seconds > 0 ? median.getBytesProcessed() / seconds : 0;
+    result.label = median.getLabel();
+    return result;
+}
+
+int Benchmarks::run(BenchmarkOptions const& options)
+{
+    if (options.list) {
+        for (size_t i = 0; i < _benchmarks.size(); i++) {
+            cout << _benchmarks[i].first << endl;
+        }
+        return 0;
+    }
+#ifndef NDEBUG
+    cerr << "WARNING: this is a debug build, its timings are not representative" << endl;
+#endif
+
+    vector<Result> results;
+    for (size_t i = 0; i < _benchmarks.size(); i++) {
+        string const& name = _benchmarks[i].first;
+        if (name.find(options.filter) == string::npos) {
+            continue;
+        }
+        Result const result = measure(name, _benchmarks[i].second, options);
+        if (result.skipped) {
+            printf("%-36s skipped: %s\n", name.c_str(), result.label.c_str());
+        } else {
+            printf("%-36s %14.1f ns/op %12llu iterations %16s %16s  %s\n",
+                   name.c_str(), result.nsPerOp, (unsigned long long) result.iterations,
+                   result.itemsPerSecond > 0 ? formatRate(result.itemsPerSecond, "items").c_str() : "",
+                   result.bytesPerSecond > 0 ? formatRate(result.bytesPerSecond, "B").c_str() : "",
+                   result.label.c_str());
+        }
+        fflush(stdout);
+        results.push_back(result);
+    }
+
+    if (!options.jsonPath.empty()) {
+        if (!writeJson(options.jsonPath, options, results)) {
+            cerr << "Cannot write " << options.jsonPath << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+bool Benchmarks::writeJson(string const& path, BenchmarkOptions const& options, vector<Result> const& results)
+{
+    ofstream out(path.c_str());
+    if (!out) {
+        return false;
+    }
+    out.precision(10);
+    char host[256] = "";
+    gethostname(host, sizeof(host) - 1);
+    char date[64] = "";
+    time_t const t = time(NULL);
+    struct tm tm;
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime_r(&t, &tm));
+
+    out << "{\n  \"context\": {\n    \"date\": ";
+    writeJsonString(out, date);
+    out << ",\n    \"host\": ";
+    writeJsonString(out, host);
+    out << ",\n    \"num_cpus\": " << sysconf(_SC_NPROCESSORS_ONLN)
+#ifdef NDEBUG
+        << ",\n    \"build\": \"release\""
+#else
+        << ",\n    \"build\": \"debug\""
+#endif
+        << ",\n    \"min_time\": " << options.minTime
+        << ",\n    \"repetitions\": " << options.repetitions
+        << "\n  },\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        Result const& result = results[i];
+        out << (i ? ",\n" : "\n") << "    {\"name\": ";
+        writeJsonString(out, result.name);
+        if (result.skipped) {
+            out << ", \"skipped\": true";
+        } else {
+            out << ", \"iterations\": " << result.iterations
+                << ", \"ns_per_op\": " << result.nsPerOp
+                << ", \"min_ns_per_op\": " << result.minNsPerOp
+                << ", \"items_per_second\": " << result.itemsPerSecond
+                << ", \"bytes_per_second\": " << result.bytesPerSecond;
+        }
+        out << ", \"label\": ";
+        writeJsonString(out, result.label);
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+    out.close();
+    return !out.fail();
+}
+
+} //namespace bench
+} //namespace scidb
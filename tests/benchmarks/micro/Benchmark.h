@@ -0,0 +1,248 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file Benchmark.h
+ *
+ * @brief A minimal in-process benchmark harness.
+ *
+ * A benchmark is a function running its measured code in a keepRunning() loop:
+ * @code
+ * void rlePayloadPack(BenchmarkState& state)
+ * {
+ *     RLEPayload payload = ...;           // setup, not measured
+ *     while (state.keepRunning()) {
+ *         payload.pack(buffer);           // measured
+ *     }
+ *     state.setBytesProcessed(state.getIterations() * payload.packedSize());
+ * }
+ * @endcode
+ * The harness first calibrates the number of iterations so that a run lasts at least the minimum
+ * time, then repeats the run and reports the median time per iteration.
+ */
+
+#ifndef MICRO_BENCHMARK_H_
+#define MICRO_BENCHMARK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+#include <boost/function.hpp>
+
+namespace scidb
+{
+namespace bench
+{
+
+/**
+ * Keep the compiler from optimizing a computed value away.
+ */
+template <class T>
+inline void doNotOptimize(T const& value)
+{
+    __asm__ __volatile__("" : : "g"(&value) : "memory");
+}
+
+class BenchmarkState
+{
+public:
+    explicit BenchmarkState(uint64_t iterations)
+    : _iterations(iterations),
+      _done(0),
+      _start(0),
+      _elapsed(0),
+      _items(0),
+      _bytes(0),
+      _skipped(false)
+    {
+    }
+
+    /**
+     * @return true while iterations remain. The clock starts with the first call.
+     */
+    bool keepRunning()
+    {
+        if (_done < _iterations && !_skipped) {
+            if (_done++ == 0) {
+                _start = now();
+            }
+            return true;
+        }
+        if (_start) {
+            _elapsed += now() - _start;
+            _start = 0;
+        }
+        return false;
+    }
+
+    /**
+     * Stop the clock, e.g. to restore the input of the next iteration.
+     */
+    void pauseTiming()
+    {
+        _elapsed += now() - _start;
+        _start = 0;
+    }
+
+    void resumeTiming()
+    {
+        _start = now();
+    }
+
+    uint64_t getIterations() const
+    {
+        return _iterations;
+    }
+
+    void setItemsProcessed(uint64_t items)
+    {
+        _items = items;
+    }
+
+    void setBytesProcessed(uint64_t bytes)
+    {
+        _bytes = bytes;
+    }
+
+    /**
+     * Set a note reported with the result, e.g. a compression ratio.
+     */
+    void setLabel(std::string const& label)
+    {
+        _label = label;
+    }
+
+    /**
+     * Give up the benchmark: it is reported as skipped with the reason.
+     */
+    void skip(std::string const& reason)
+    {
+        _skipped = true;
+        _label = reason;
+    }
+
+    /**
+     * @return the measured nanoseconds
+     */
+    uint64_t getElapsed() const
+    {
+        return _elapsed;
+    }
+
+    uint64_t getItemsProcessed() const
+    {
+        return _items;
+    }
+
+    uint64_t getBytesProcessed() const
+    {
+        return _bytes;
+    }
+
+    std::string const& getLabel() const
+    {
+        return _label;
+    }
+
+    bool isSkipped() const
+    {
+        return _skipped;
+    }
+
+private:
+    static uint64_t now()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    uint64_t _iterations;
+    uint64_t _done;
+    uint64_t _start;
+    uint64_t _elapsed;
+    uint64_t _items;
+    uint64_t _bytes;
+    std::string _label;
+    bool _skipped;
+};
+
+struct BenchmarkOptions
+{
+    std::string filter;     /**< run the benchmarks whose name contains it */
+    std::string jsonPath;   /**< write the results there as JSON, unless empty */
+    double minTime;         /**< the minimum seconds of a run */
+    size_t repetitions;     /**< the runs measured after calibration */
+    bool list;              /**< only list the benchmarks */
+
+    BenchmarkOptions() : minTime(0.5), repetitions(3), list(false)
+    {
+    }
+};
+
+class Benchmarks
+{
+public:
+    typedef boost::function<void (BenchmarkState&)> Function;
+
+    /**
+     * @param name the name of the benchmark, "<component>/<operation>"
+     */
+    void add(std::string const& name, Function const& function);
+
+    /**
+     * Run the benchmarks selected by the options, print their results, and write them as JSON.
+     * @return the exit code of the program
+     */
+    int run(BenchmarkOptions const& options);
+
+private:
+    struct Result
+    {
+        std::string name;
+        uint64_t iterations;
+        double nsPerOp;         // median of the repetitions
+        double minNsPerOp;
+        double itemsPerSecond;  // at the median
+        double bytesPerSecond;
+        std::string label;
+        bool skipped;
+    };
+
+    Result measure(std::string const& name, Function const& function, BenchmarkOptions const& options);
+    bool writeJson(std::string const& path, BenchmarkOptions const& options, std::vector<Result> const& results);
+
+    std::vector<std::pair<std::string, Function> > _benchmarks;
+};
+
+void registerArrayBenchmarks(Benchmarks& benchmarks);
+void registerQueryBenchmarks(Benchmarks& benchmarks);
+void registerUtilBenchmarks(Benchmarks& benchmarks);
+void registerNetworkBenchmarks(Benchmarks& benchmarks);
+
+} //namespace bench
+} //namespace scidb
+
+#endif /* MICRO_BENCHMARK_H_ */
@@ -0,0 +1,119 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file MicroBenchmarks.cpp
+ *
+ * @brief In-process benchmarks of the data structures and kernels on the hot paths.
+ *
+ * Unlike the query scripts of perf-study and ss-db, these need no cluster: every benchmark
+ * runs one component in a loop, so that a change to it can be judged on one machine.
+ * Save the results of the baseline and of the change with --json, then compare them with
+ * compare_benchmarks.py.
+ *
+ * Usage: micro_benchmarks [--filter substring] [--json file] [--min-time seconds]
+ *                         [--repetitions n] [--list] [-- scidb options]
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <log4cxx/logger.h>
+#include <log4cxx/basicconfigurator.h>
+
+#include <query/FunctionLibrary.h>
+#include <query/TypeSystem.h>
+#include <system/Config.h>
+#include <system/SciDBConfigOptions.h>
+
+#include "Benchmark.h"
+
+using namespace std;
+using namespace scidb;
+using namespace scidb::bench;
+
+namespace
+{
+
+void usage(char const* program)
+{
+    cerr << "Usage: " << program << " [--filter substring] [--json file] [--min-time seconds]" << endl
+         << "       [--repetitions n] [--list] [-- scidb options]" << endl;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    BenchmarkOptions options;
+    // The benchmarks never connect to the catalog, which the configuration requires
+    vector<char*> configArgs;
+    configArgs.push_back(argv[0]);
+    configArgs.push_back(const_cast<char*>("--catalog"));
+    configArgs.push_back(const_cast<char*>("none"));
+
+    for (int i = 1; i < argc; i++) {
+        string const arg = argv[i];
+        if (arg == "--") {
+            configArgs.insert(configArgs.end(), argv + i + 1, argv + argc);
+            break;
+        } else if (arg == "--list") {
+            options.list = true;
+        } else if (i + 1 < argc && arg == "--filter") {
+            options.filter = argv[++i];
+        } else if (i + 1 < argc && arg == "--json") {
+            options.jsonPath = argv[++i];
+        } else if (i + 1 < argc && arg == "--min-time") {
+            options.minTime = atof(argv[++i]);
+        } else if (i + 1 < argc && arg == "--repetitions") {
+            options.repetitions = atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    try
+    {
+        log4cxx::BasicConfigurator::configure();
+        log4cxx::Logger::getRootLogger()->setLevel(log4cxx::Level::getWarn());
+
+        TypeLibrary::registerBuiltInTypes();
+        FunctionLibrary::getInstance()->registerBuiltInFunctions();
+        initConfig(configArgs.size(), &configArgs[0]);
+
+        Benchmarks benchmarks;
+        registerArrayBenchmarks(benchmarks);
+        registerQueryBenchmarks(benchmarks);
+        registerUtilBenchmarks(benchmarks);
+        registerNetworkBenchmarks(benchmarks);
+        return benchmarks.run(options);
+    }
+    catch(const std::exception& e)
+    {
+        cerr << "Unhandled std::exception: " << e.what() << endl;
+        return 1;
+    }
+}
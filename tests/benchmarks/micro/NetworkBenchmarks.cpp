@@ -0,0 +1,132 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file NetworkBenchmarks.cpp
+ *
+ * @brief Benchmarks of the serialization of chunk messages.
+ */
+
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <array/Array.h>
+#include <network/BaseConnection.h>
+#include <network/proto/scidb_msg.pb.h>
+
+#include "Benchmark.h"
+
+using namespace std;
+using namespace boost;
+
+namespace scidb
+{
+namespace bench
+{
+
+namespace
+{
+
+const size_t CHUNK_BYTES = 64 * 1024;   // binary part of a message
+const size_t CHUNK_RANK = 3;
+
+shared_ptr<MessageDesc> makeChunkMessage(shared_ptr<SharedBuffer> const& buffer, int64_t position)
+{
+    shared_ptr<MessageDesc> message(new MessageDesc(mtChunk, buffer));
+    shared_ptr<scidb_msg::Chunk> record = message->getRecord<scidb_msg::Chunk>();
+    record->set_eof(false);
+    record->set_sparse(false);
+    record->set_rle(true);
+    record->set_compression_method(0);
+    record->set_attribute_id(1);
+    record->set_array_id(42);
+    record->set_decompressed_size(CHUNK_BYTES);
+    record->set_count(CHUNK_BYTES / 8);
+    for (size_t i = 0; i < CHUNK_RANK; i++) {
+        record->add_coordinates(position + int64_t(i) * 1000);
+    }
+    message->setQueryID(1234567);
+    return message;
+}
+
+shared_ptr<SharedBuffer> makeBuffer()
+{
+    shared_ptr<SharedBuffer> buffer(new CompressedBuffer());
+    buffer->allocate(CHUNK_BYTES);
+    memset(buffer->getData(), 1, CHUNK_BYTES);
+    return buffer;
+}
+
+/**
+ * Build a chunk message and lay it out for sending, as the scatter/gather senders do.
+ */
+void messageSerializeChunk(BenchmarkState& state)
+{
+    shared_ptr<SharedBuffer> buffer = makeBuffer();
+    vector<asio::const_buffer> constBuffers;
+    int64_t position = 0;
+    while (state.keepRunning()) {
+        shared_ptr<MessageDesc> message = makeChunkMessage(buffer, position++);
+        constBuffers.clear();
+        message->writeConstBuffers(constBuffers);
+        doNotOptimize(constBuffers[0]);
+    }
+    state.setItemsProcessed(state.getIterations());
+}
+
+/**
+ * Parse the record of a chunk message into a new descriptor, as a connection does on receipt.
+ * The record stream of MessageDesc is private to the connections, so the record is parsed
+ * from a flat buffer with the same protobuf code.
+ */
+void messageParseChunk(BenchmarkState& state)
+{
+    shared_ptr<MessageDesc> sent = makeChunkMessage(makeBuffer(), 0);
+    string serialized;
+    sent->getRecord<scidb_msg::Chunk>()->SerializeToString(&serialized);
+    while (state.keepRunning()) {
+        MessageDesc received(mtChunk);
+        shared_ptr<scidb_msg::Chunk> record = received.getRecord<scidb_msg::Chunk>();
+        if (!record->ParseFromArray(serialized.data(), serialized.size()) || !received.validate()) {
+            state.skip("the chunk record does not parse");
+            return;
+        }
+        doNotOptimize(record->coordinates_size());
+    }
+    state.setItemsProcessed(state.getIterations());
+    state.setBytesProcessed(state.getIterations() * serialized.size());
+}
+
+}
+
+void registerNetworkBenchmarks(Benchmarks& benchmarks)
+{
+    benchmarks.add("message/serialize_chunk", &messageSerializeChunk);
+    benchmarks.add("message/parse_chunk", &messageParseChunk);
+}
+
+} //namespace bench
+} //namespace scidb
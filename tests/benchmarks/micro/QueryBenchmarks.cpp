@@ -0,0 +1,159 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file QueryBenchmarks.cpp
+ *
+ * @brief Benchmarks of Expression::evaluate and Aggregate::accumulatePayload.
+ */
+
+#include <string>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <array/RLE.h>
+#include <query/Aggregate.h>
+#include <query/Expression.h>
+#include <query/LogicalExpression.h>
+#include <query/Parser.h>
+#include <query/TypeSystem.h>
+
+#include "Benchmark.h"
+
+using namespace std;
+using namespace boost;
+
+namespace scidb
+{
+namespace bench
+{
+
+namespace
+{
+
+const size_t TILE_SIZE = 8192;           // values of a tile, in tile mode
+const size_t PAYLOAD_SIZE = 64 * 1024;   // values accumulated by an aggregate
+
+/**
+ * Evaluate a polynomial one cell at a time, as filter() and apply() do without tiles.
+ */
+void expressionEvaluate(BenchmarkState& state)
+{
+    vector<string> names;
+    names.push_back("a");
+    names.push_back("b");
+    names.push_back("c");
+    names.push_back("x");
+    vector<TypeId> types(names.size(), TID_INT64);
+    Expression e;
+    e.compile("a*x*x+b*x+c", names, types);
+    ExpressionContext ec(e);
+    ec[0].setInt64(5);
+    ec[1].setInt64(10);
+    ec[2].setInt64(15);
+    int64_t x = 0;
+    while (state.keepRunning()) {
+        ec[3].setInt64(x++);
+        doNotOptimize(e.evaluate(ec).getInt64());
+    }
+    state.setItemsProcessed(state.getIterations());
+}
+
+/**
+ * Evaluate a+b*c over tiles of distinct values.
+ */
+void expressionEvaluateTile(BenchmarkState& state)
+{
+    shared_ptr<LogicalExpression> le = parseExpression("a+b*c");
+    Expression e;
+    e.addVariableInfo("a", TID_INT64);
+    e.addVariableInfo("b", TID_INT64);
+    e.addVariableInfo("c", TID_INT64);
+    shared_ptr<Query> emptyQuery;
+    e.compile(le, emptyQuery, true);
+    ExpressionContext ec(e);
+
+    RLEPayload::Segment segment;
+    segment._pPosition = 0;
+    segment._same = false;
+    segment._null = false;
+    for (int i = 0; i < 3; i++) {
+        RLEPayload* tile = ec[i].getTile();
+        segment._valueIndex = tile->addRawValues(TILE_SIZE);
+        tile->addSegment(segment);
+        tile->flush(TILE_SIZE);
+        int64_t* values = reinterpret_cast<int64_t*>(tile->getRawValue(0));
+        for (size_t j = 0; j < TILE_SIZE; j++) {
+            values[j] = int64_t(j * (i + 1));
+        }
+    }
+    while (state.keepRunning()) {
+        Value const& result = e.evaluate(ec);
+        doNotOptimize(result.getTile()->count());
+    }
+    state.setItemsProcessed(state.getIterations() * TILE_SIZE);
+}
+
+/**
+ * Accumulate a payload of distinct int64 values, as aggregate() does with tiles.
+ */
+void aggregateAccumulatePayload(BenchmarkState& state, string const& name)
+{
+    Type const& type = TypeLibrary::getType(TID_INT64);
+    AggregatePtr aggregate = AggregateLibrary::getInstance()->createAggregate(name, type);
+
+    vector<int64_t> values(PAYLOAD_SIZE);
+    for (size_t i = 0; i < values.size(); i++) {
+        values[i] = int64_t((i * 2654435761ULL) % 1000003);
+    }
+    RLEPayload payload(type);
+    RLEPayload::append_iterator appender(&payload);
+    appender.add(reinterpret_cast<char const*>(&values[0]), NULL, values.size());
+    appender.flush();
+
+    Value accumulated(aggregate->getStateType());
+    while (state.keepRunning()) {
+        aggregate->initializeState(accumulated);
+        aggregate->accumulatePayload(accumulated, &payload);
+        doNotOptimize(accumulated);
+    }
+    state.setItemsProcessed(state.getIterations() * values.size());
+}
+
+}
+
+void registerQueryBenchmarks(Benchmarks& benchmarks)
+{
+    benchmarks.add("expression/evaluate", &expressionEvaluate);
+    benchmarks.add("expression/evaluate_tile", &expressionEvaluateTile);
+
+    char const* const aggregates[] = { "sum", "avg", "min", "max", "count" };
+    for (size_t i = 0; i < sizeof(aggregates) / sizeof(aggregates[0]); i++) {
+        benchmarks.add(string("aggregate/") + aggregates[i],
+                       bind(&aggregateAccumulatePayload, _1, string(aggregates[i])));
+    }
+}
+
+} //namespace bench
+} //namespace scidb
@@ -0,0 +1,126 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file UtilBenchmarks.cpp
+ *
+ * @brief Benchmarks of DataStore space management and JobQueue throughput.
+ *
+ * The JobQueue workloads are shared with jobqueue_benchmark (tests/benchmarks/jobqueue),
+ * which also compares the queue with one under a single lock.
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <util/DataStore.h>
+#include <util/JobQueue.h>
+
+#include "Benchmark.h"
+#include "../jobqueue/JobTreeWorkload.h"
+
+using namespace std;
+using namespace boost;
+
+namespace scidb
+{
+namespace bench
+{
+
+namespace
+{
+
+const size_t ALLOCATED_CHUNKS = 64;      // chunks allocated then freed by an iteration
+const DataStore::Guid DATA_STORE_GUID = 1;
+const size_t JOBS_PER_ITERATION = 1024;  // roots pushed by an iteration of job_queue/inject
+const size_t SPAWN_ROOTS = 8;
+const int SPAWN_DEPTH = 7;               // 255 jobs per root
+
+/**
+ * Allocate chunks of mixed sizes in a data store, then free them.
+ */
+void dataStoreAllocateFree(BenchmarkState& state)
+{
+    char path[] = "/tmp/scidb_micro_benchmark.XXXXXX";
+    if (!mkdtemp(path)) {
+        state.skip("cannot create a temporary directory");
+        return;
+    }
+    {
+        DataStores dataStores;
+        dataStores.initDataStores(path);
+        shared_ptr<DataStore> store = dataStores.getDataStore(DATA_STORE_GUID);
+
+        vector<size_t> sizes(ALLOCATED_CHUNKS);
+        for (size_t i = 0; i < sizes.size(); i++) {
+            sizes[i] = (size_t(4) << (i % 9)) * 1024 + (i * 7919) % 4096;
+        }
+        vector<off_t> offsets(ALLOCATED_CHUNKS);
+        vector<size_t> allocated(ALLOCATED_CHUNKS);
+        while (state.keepRunning()) {
+            for (size_t i = 0; i < sizes.size(); i++) {
+                offsets[i] = store->allocateSpace(sizes[i], allocated[i]);
+            }
+            for (size_t i = 0; i < sizes.size(); i++) {
+                store->freeChunk(offsets[i], allocated[i]);
+            }
+        }
+        store.reset();
+        dataStores.closeDataStore(DATA_STORE_GUID, true);
+    }
+    rmdir(path);
+    state.setItemsProcessed(state.getIterations() * ALLOCATED_CHUNKS);
+}
+
+/**
+ * Push roots jobs each spawning a binary tree of the given depth, and wait for all of them.
+ * The workers are the online processors.
+ */
+void jobQueueRun(BenchmarkState& state, size_t roots, int depth)
+{
+    JobTreeWorkload<JobQueue> workload(std::max(sysconf(_SC_NPROCESSORS_ONLN), 1L));
+    uint64_t jobsPerIteration = 0;
+    uint64_t total = 0;
+    while (state.keepRunning()) {
+        jobsPerIteration = workload.push(roots, depth);
+        total += jobsPerIteration;
+        workload.wait(total);
+    }
+    state.setItemsProcessed(state.getIterations() * jobsPerIteration);
+}
+
+}
+
+void registerUtilBenchmarks(Benchmarks& benchmarks)
+{
+    benchmarks.add("data_store/allocate_free", &dataStoreAllocateFree);
+    benchmarks.add("job_queue/inject", bind(&jobQueueRun, _1, JOBS_PER_ITERATION, 0));
+    benchmarks.add("job_queue/spawn", bind(&jobQueueRun, _1, SPAWN_ROOTS, SPAWN_DEPTH));
+}
+
+} //namespace bench
+} //namespace scidb
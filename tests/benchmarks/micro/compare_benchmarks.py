@@ -0,0 +1,102 @@
+#!/usr/bin/env python
+#
+# BEGIN_COPYRIGHT
+#
+# This file is part of SciDB.
+# Copyright (C) 2008-2014 SciDB, Inc.
+#
+# SciDB is free software: you can redistribute it and/or modify
+# it under the terms of the AFFERO GNU General Public License as published by
+# the Free Software Foundation.
+#
+# SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+# INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+# NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+# the AFFERO GNU General Public License for the complete license terms.
+#
+# You should have received a copy of the AFFERO GNU General Public License
+# along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+#
+# END_COPYRIGHT
+#
+
+"""
+Compare two result files of micro_benchmarks --json.
+
+Prints the change of the median time per operation of every benchmark, and exits
+with 1 when a benchmark got slower than the threshold, so that it can gate a change:
+
+    micro_benchmarks --json baseline.json          # before the change
+    micro_benchmarks --json current.json           # after the change
+    compare_benchmarks.py baseline.json current.json --threshold 10
+"""
+
+import json
+import sys
+from optparse import OptionParser
+
+
+def load(path):
+    with open(path) as f:
+        results = json.load(f)
+    benchmarks = {}
+    order = []
+    for b in results["benchmarks"]:
+        benchmarks[b["name"]] = b
+        order.append(b["name"])
+    return results.get("context", {}), benchmarks, order
+
+
+def main():
+    parser = OptionParser(usage="%prog [options] baseline.json current.json")
+    parser.add_option("-t", "--threshold", type="float", default=10.0,
+                      help="percentage of slowdown reported as a regression [default: %default]")
+    parser.add_option("-a", "--all", action="store_true", default=False,
+                      help="show every benchmark, not only the changes above the threshold")
+    (options, args) = parser.parse_args()
+    if len(args) != 2:
+        parser.error("expected the baseline and the current result files")
+
+    baseContext, base, _ = load(args[0])
+    currContext, curr, order = load(args[1])
+
+    for key in ("host", "num_cpus", "build"):
+        if baseContext.get(key) != currContext.get(key):
+            sys.stderr.write("WARNING: the %s differs: %s vs %s\n"
+                             % (key, baseContext.get(key), currContext.get(key)))
+
+    regressions = []
+    print("%-36s %14s %14s %9s" % ("benchmark", "baseline ns", "current ns", "change"))
+    for name in order:
+        c = curr[name]
+        b = base.get(name)
+        if b is None:
+            print("%-36s %14s %14s %9s" % (name, "-", c.get("ns_per_op", "skipped"), "new"))
+            continue
+        if b.get("skipped") or c.get("skipped"):
+            if options.all:
+                print("%-36s %14s %14s %9s" % (name, b.get("ns_per_op", "skipped"),
+                                               c.get("ns_per_op", "skipped"), "-"))
+            continue
+        change = (c["ns_per_op"] / b["ns_per_op"] - 1.0) * 100.0 if b["ns_per_op"] > 0 else 0.0
+        status = ""
+        if change > options.threshold:
+            status = "REGRESSION"
+            regressions.append(name)
+        elif change < -options.threshold:
+            status = "improvement"
+        if status or options.all:
+            print("%-36s %14.1f %14.1f %+8.1f%% %s" % (name, b["ns_per_op"], c["ns_per_op"], change, status))
+    for name in sorted(set(base) - set(curr)):
+        print("%-36s %14s %14s %9s" % (name, base[name].get("ns_per_op", "skipped"), "-", "removed"))
+
+    if regressions:
+        print("%d benchmark(s) slower by more than %g%%: %s"
+              % (len(regressions), options.threshold, ", ".join(regressions)))
+        return 1
+    print("No benchmark slower by more than %g%%" % options.threshold)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
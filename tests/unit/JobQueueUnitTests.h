@@ -0,0 +1,280 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* This file is part of SciDB.
+* Copyright (C) 2008-2014 SciDB, Inc.
+*
+* SciDB is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* SciDB is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with SciDB.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+#ifndef JOB_QUEUE_UNIT_TESTS
+#define JOB_QUEUE_UNIT_TESTS
+
+/****************************************************************************/
+
+#include <pthread.h>
+#include <sched.h>
+#include <vector>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <boost/shared_ptr.hpp>
+#include <util/JobQueue.h>
+
+/****************************************************************************/
+
+/**
+ * Exercise the structures of the work-stealing JobQueue through its public interface:
+ * the Chase-Lev deque of a pool thread (popped by its owner, stolen by the others),
+ * the lock-free injection rings and their overflow lists, and all of them at once under
+ * contention. The jobs are only popped, never run.
+ */
+class JobQueueTests : public CppUnit::TestFixture
+{
+ private:
+    class NumberedJob : public scidb::Job
+    {
+     public:
+        NumberedJob(size_t n) : scidb::Job(boost::shared_ptr<scidb::Query>()), number(n) {}
+        size_t const number;
+     protected:
+        void run() {}
+    };
+
+    typedef boost::shared_ptr<scidb::Job> JobPtr;
+
+    static JobPtr job(size_t n)
+    {
+        return JobPtr(new NumberedJob(n));
+    }
+
+    static size_t number(JobPtr const& j)
+    {
+        return static_cast<NumberedJob*>(j.get())->number;
+    }
+
+    /// A thread running fn(arg), which the test joins before checking the outcome
+    static pthread_t spawn(void* (*fn)(void*), void* arg)
+    {
+        pthread_t thread;
+        CPPUNIT_ASSERT(pthread_create(&thread, NULL, fn, arg) == 0);
+        return thread;
+    }
+
+    struct Popper
+    {
+        scidb::JobQueue* queue;
+        size_t count;
+        std::vector<size_t> numbers;
+    };
+
+    static void* popAll(void* arg)
+    {
+        Popper& p = *static_cast<Popper*>(arg);
+        for (size_t i = 0; i < p.count; i++) {
+            p.numbers.push_back(number(p.queue->popJob()));
+        }
+        return NULL;
+    }
+
+    static const size_t N_THREADS = 4;
+    static const size_t JOBS_PER_PRODUCER = 20000;
+    static const size_t SPAWN_EVERY = 3;       // a worker pushes a child for every SPAWN_EVERY-th job
+    static const size_t STOP = size_t(-1);     // tells a worker to return
+
+    struct Shared
+    {
+        scidb::JobQueue* queue;
+        size_t producerNo;
+        volatile size_t nextChild;
+        volatile size_t popped;
+    };
+
+    static void* produce(void* arg)
+    {
+        Shared& s = *static_cast<Shared*>(arg);
+        size_t const producer = __sync_fetch_and_add(&s.producerNo, 1);
+        for (size_t i = 0; i < JOBS_PER_PRODUCER; i++) {
+            s.queue->pushJob(job(producer * JOBS_PER_PRODUCER + i));
+        }
+        return NULL;
+    }
+
+    static void* work(void* arg)
+    {
+        Shared& s = *static_cast<Shared*>(arg);
+        s.queue->attachWorker();
+        std::vector<size_t>* numbers = new std::vector<size_t>();
+        while (true) {
+            size_t const n = number(s.queue->popJob());
+            if (n == STOP) {
+                break;
+            }
+            numbers->push_back(n);
+            __sync_add_and_fetch(&s.popped, 1);
+            if (n < N_THREADS * JOBS_PER_PRODUCER && n % SPAWN_EVERY == 0) {
+                s.queue->pushJob(job(__sync_fetch_and_add(&s.nextChild, 1)));
+            }
+        }
+        return numbers;
+    }
+
+ public:
+    /// The owner of a deque pops the jobs it pushed, most recent first
+    void ownerPopsLastPushed()
+    {
+        scidb::JobQueue queue;
+        queue.attachWorker();
+        for (size_t i = 0; i < 1000; i++) {
+            queue.pushJob(job(i));
+        }
+        CPPUNIT_ASSERT(queue.getSize() == 1000);
+        for (size_t i = 1000; i-- > 0; ) {
+            CPPUNIT_ASSERT(number(queue.popJob()) == i);
+        }
+        CPPUNIT_ASSERT(queue.getSize() == 0);
+        CPPUNIT_ASSERT(queue.getStatistics().localPops == 1000);
+    }
+
+    /// Another thread steals the jobs of a deque oldest first, across the growth of its array
+    void thiefStealsOldest()
+    {
+        scidb::JobQueue queue;
+        queue.attachWorker();
+        for (size_t i = 0; i < 1000; i++) {
+            queue.pushJob(job(i));
+        }
+        Popper thief;
+        thief.queue = &queue;
+        thief.count = 1000;
+        pthread_join(spawn(&popAll, &thief), NULL);
+        for (size_t i = 0; i < 1000; i++) {
+            CPPUNIT_ASSERT(thief.numbers[i] == i);
+        }
+        CPPUNIT_ASSERT(queue.getStatistics().localPops == 0);
+    }
+
+    /// A job pushed again by the thread running it queues behind the jobs already waiting
+    void repushedJobQueuesBehind()
+    {
+        scidb::JobQueue queue;
+        queue.attachWorker();
+        queue.pushJob(job(0));
+        queue.pushJob(job(1));
+        JobPtr running = queue.popJob();
+        CPPUNIT_ASSERT(number(running) == 1);
+        queue.pushJob(running);
+        queue.pushJob(job(2));
+        CPPUNIT_ASSERT(number(queue.popJob()) == 2);
+        CPPUNIT_ASSERT(number(queue.popJob()) == 0);
+        CPPUNIT_ASSERT(number(queue.popJob()) == 1);
+    }
+
+    /// Jobs pushed from outside the pool come out in order, beyond what the rings hold
+    void injectedJobsKeepOrder()
+    {
+        scidb::JobQueue queue;
+        size_t const nJobs = 10000;     // more than twice the ring size
+        for (size_t i = 0; i < nJobs; i++) {
+            queue.pushJob(job(i));
+            if (i % 2 == 0) {
+                queue.pushHighPriorityJob(job(nJobs + i));
+            }
+        }
+        for (size_t i = 0; i < nJobs; i += 2) {
+            CPPUNIT_ASSERT(number(queue.popJob()) == nJobs + i);
+        }
+        // popping frees ring cells while the overflow list is not empty; pushes must still queue behind it
+        for (size_t i = 0; i < nJobs / 2; i++) {
+            CPPUNIT_ASSERT(number(queue.popJob()) == i);
+            queue.pushJob(job(nJobs * 2 + i));
+        }
+        for (size_t i = nJobs / 2; i < nJobs; i++) {
+            CPPUNIT_ASSERT(number(queue.popJob()) == i);
+        }
+        for (size_t i = 0; i < nJobs / 2; i++) {
+            CPPUNIT_ASSERT(number(queue.popJob()) == nJobs * 2 + i);
+        }
+        CPPUNIT_ASSERT(queue.getSize() == 0);
+    }
+
+    /// Producers inject, workers pop, spawn children onto their deques and steal from each other:
+    /// every job must come out exactly once
+    void concurrentJobsComeOutOnce()
+    {
+        scidb::JobQueue queue;
+        size_t const nInjected = N_THREADS * JOBS_PER_PRODUCER;
+        size_t nChildren = 0;
+        for (size_t i = 0; i < nInjected; i += SPAWN_EVERY) {
+            nChildren++;
+        }
+        Shared shared;
+        shared.queue = &queue;
+        shared.producerNo = 0;
+        shared.nextChild = nInjected;
+        shared.popped = 0;
+
+        std::vector<pthread_t> workers, producers;
+        for (size_t i = 0; i < N_THREADS; i++) {
+            workers.push_back(spawn(&work, &shared));
+        }
+        for (size_t i = 0; i < N_THREADS; i++) {
+            producers.push_back(spawn(&produce, &shared));
+        }
+        for (size_t i = 0; i < N_THREADS; i++) {
+            pthread_join(producers[i], NULL);
+        }
+        // the children are pushed by the workers; wait until they have all been taken
+        while (shared.popped != nInjected + nChildren) {
+            sched_yield();
+        }
+        for (size_t i = 0; i < N_THREADS; i++) {
+            queue.pushJob(job(STOP));
+        }
+
+        std::vector<size_t> seen(nInjected + nChildren, 0);
+        for (size_t i = 0; i < N_THREADS; i++) {
+            void* result = NULL;
+            pthread_join(workers[i], &result);
+            std::vector<size_t>* numbers = static_cast<std::vector<size_t>*>(result);
+            for (size_t j = 0; j < numbers->size(); j++) {
+                CPPUNIT_ASSERT((*numbers)[j] < seen.size());
+                seen[(*numbers)[j]]++;
+            }
+            delete numbers;
+        }
+        for (size_t i = 0; i < seen.size(); i++) {
+            CPPUNIT_ASSERT(seen[i] == 1);
+        }
+        CPPUNIT_ASSERT(queue.getSize() == 0);
+    }
+
+ public:
+    CPPUNIT_TEST_SUITE(JobQueueTests);
+    CPPUNIT_TEST(ownerPopsLastPushed);
+    CPPUNIT_TEST(thiefStealsOldest);
+    CPPUNIT_TEST(repushedJobQueuesBehind);
+    CPPUNIT_TEST(injectedJobsKeepOrder);
+    CPPUNIT_TEST(concurrentJobsComeOutOnce);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+/****************************************************************************/
+
+CPPUNIT_TEST_SUITE_REGISTRATION(JobQueueTests);
+
+/****************************************************************************/
+#endif
+/****************************************************************************/
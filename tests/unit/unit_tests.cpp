@@ -61,9 +61,14 @@
 #include "query/AggregateUnitTests.h"
 #include "array/BitmaskUnitTests.h"
 #include "query/AuxUnitTests.h"
+#include "query/TileOperatorUnitTests.h"
+#include "query/ProfileUnitTests.h"
+#include "array/ChunkWriteUnitTests.h"
+#include "dense_linear_algebra/array/ArrayExtractOpUnitTests.h"
 //#include "system/ExceptionUnitTests.h"
 #include "PointerRangeUnitTests.h"
 #include "ArenaUnitTests.h"
+#include "JobQueueUnitTests.h"
 
 using namespace std;
 
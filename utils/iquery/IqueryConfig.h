@@ -53,7 +53,8 @@ enum
     CONFIG_PLUGINS_DIRECTORY,
     CONFIG_HELP,
     CONFIG_VERSION,
-    CONFIG_IGNORE_ERRORS
+    CONFIG_IGNORE_ERRORS,
+    CONFIG_PARAMETERS
 };
 
 }
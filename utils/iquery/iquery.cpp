@@ -35,6 +35,7 @@
 #include <stdio.h>
 #include <fstream>
 #include <algorithm>
+#include <stdexcept>
 #include <signal.h>
 
 // include log4cxx header files.
@@ -103,6 +104,7 @@ struct _iqueryState
     bool ignoreErrors;
 
     std::string format;
+    scidb::QueryParameters parameters;
 } iqueryState;
 
 void saveHistory()
@@ -236,6 +238,9 @@ void executePreparedSciDBQuery(const string &queryString, scidb::QueryResult& qu
             cout << "Query execution time: " << queryResult.executionTime << "ms" << endl;
             cout << "Logical plan: " << endl << queryResult.explainLogical << endl;
             cout << "Physical plans: " << endl << queryResult.explainPhysical << endl;
+            if (!queryResult.explainAnalyze.empty()) {
+                cout << "Operator profiles: " << endl << queryResult.explainAnalyze << endl;
+            }
         }
     }
     else
@@ -260,7 +265,7 @@ void executeSciDBQuery(const string &queryString)
     const scidb::SciDB& sciDB = scidb::getSciDB();
     string const& format = iqueryState.format;
 
-    sciDB.prepareQuery(queryString, !iqueryState.aql, "", queryResult, iqueryState.connection);
+    sciDB.prepareQuery(queryString, !iqueryState.aql, "", iqueryState.parameters, queryResult, iqueryState.connection);
 
     iqueryState.currentQueryID = queryResult.queryID;
 
@@ -531,6 +536,8 @@ int main(int argc, char* argv[])
                 "Show version info", false, false)
             (CONFIG_IGNORE_ERRORS, 0, "ignore-errors", "", "", scidb::Config::BOOLEAN,
                 "Ignore execution errors in batch mode", false, false)
+            (CONFIG_PARAMETERS, 'P', "param", "", "", scidb::Config::STRING_LIST,
+                "Values bound to the $placeholders of the queries, as name=value", vector<string>(), false)
             ;
 
         cfg->addHook(configHook);
@@ -551,6 +558,17 @@ int main(int argc, char* argv[])
         iqueryState.ignoreErrors = cfg->getOption<bool>(CONFIG_IGNORE_ERRORS);
         iqueryState.format = cfg->getOption<string>(CONFIG_RESULT_FORMAT);
 
+        const vector<string>& parameters = cfg->getOption<vector<string> >(CONFIG_PARAMETERS);
+        for (vector<string>::const_iterator p = parameters.begin(); p != parameters.end(); ++p)
+        {
+            const size_t eq = p->find('=');
+            if (eq == 0 || eq == string::npos)
+            {
+                throw std::invalid_argument("expected name=value as a query parameter: " + *p);
+            }
+            iqueryState.parameters[p->substr(0, eq)] = p->substr(eq + 1);
+        }
+
         if (!queryString.empty())
         {
         	queries = queryString;